@@ -23,7 +23,9 @@
 
 #include "util/util_algorithm.h"
 #include "util/util_boundbox.h"
+#include "util/util_tbb.h"
 #include "util/util_types.h"
+#include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -97,71 +99,29 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   scale = rcp(cent_bounds_.size()) * make_float3((float)num_bins);
 
   /* initialize binning counter and bounds */
-  BoundBox bin_bounds[MAX_BINS][4]; /* bounds for every bin in every dimension */
-  int4 bin_count[MAX_BINS];         /* number of primitives mapped to bin */
+  Bins bins;
+  bins.reset(num_bins);
 
-  for (size_t i = 0; i < num_bins; i++) {
-    bin_count[i] = make_int4(0);
-    bin_bounds[i][0] = bin_bounds[i][1] = bin_bounds[i][2] = BoundBox::empty;
+  /* map geometry to bins */
+  if (size() < BVHParams::PARALLEL_SPLIT_MIN_SIZE) {
+    bin_primitives(prims, 0, size(), bins);
   }
-
-  /* map geometry to bins, unrolled once */
-  {
-    ssize_t i;
-
-    for (i = 0; i < ssize_t(size()) - 1; i += 2) {
-      prefetch_L2(&prims[start() + i + 8]);
-
-      /* map even and odd primitive to bin */
-      const BVHReference &prim0 = prims[start() + i + 0];
-      const BVHReference &prim1 = prims[start() + i + 1];
-
-      BoundBox bounds0 = get_prim_bounds(prim0);
-      BoundBox bounds1 = get_prim_bounds(prim1);
-
-      int4 bin0 = get_bin(bounds0);
-      int4 bin1 = get_bin(bounds1);
-
-      /* increase bounds for bins for even primitive */
-      int b00 = (int)extract<0>(bin0);
-      bin_count[b00][0]++;
-      bin_bounds[b00][0].grow(bounds0);
-      int b01 = (int)extract<1>(bin0);
-      bin_count[b01][1]++;
-      bin_bounds[b01][1].grow(bounds0);
-      int b02 = (int)extract<2>(bin0);
-      bin_count[b02][2]++;
-      bin_bounds[b02][2].grow(bounds0);
-
-      /* increase bounds of bins for odd primitive */
-      int b10 = (int)extract<0>(bin1);
-      bin_count[b10][0]++;
-      bin_bounds[b10][0].grow(bounds1);
-      int b11 = (int)extract<1>(bin1);
-      bin_count[b11][1]++;
-      bin_bounds[b11][1].grow(bounds1);
-      int b12 = (int)extract<2>(bin1);
-      bin_count[b12][2]++;
-      bin_bounds[b12][2].grow(bounds1);
-    }
-
-    /* for uneven number of primitives */
-    if (i < ssize_t(size())) {
-      /* map primitive to bin */
-      const BVHReference &prim0 = prims[start() + i];
-      BoundBox bounds0 = get_prim_bounds(prim0);
-      int4 bin0 = get_bin(bounds0);
-
-      /* increase bounds of bins */
-      int b00 = (int)extract<0>(bin0);
-      bin_count[b00][0]++;
-      bin_bounds[b00][0].grow(bounds0);
-      int b01 = (int)extract<1>(bin0);
-      bin_count[b01][1]++;
-      bin_bounds[b01][1].grow(bounds0);
-      int b02 = (int)extract<2>(bin0);
-      bin_count[b02][2]++;
-      bin_bounds[b02][2].grow(bounds0);
+  else {
+    /* Every block is binned separately, and merged in a fixed order. */
+    const size_t num_blocks = divide_up(size(), BVHParams::PARALLEL_SPLIT_BLOCK_SIZE);
+    vector<Bins> block_bins(num_blocks);
+
+    parallel_for(blocked_range<size_t>(0, num_blocks, 1), [&](const blocked_range<size_t> &r) {
+      for (size_t block = r.begin(); block != r.end(); block++) {
+        const size_t begin = block * BVHParams::PARALLEL_SPLIT_BLOCK_SIZE;
+        const size_t end = min(begin + BVHParams::PARALLEL_SPLIT_BLOCK_SIZE, size_t(size()));
+        block_bins[block].reset(num_bins);
+        bin_primitives(prims, begin, end, block_bins[block]);
+      }
+    });
+
+    for (size_t block = 0; block < num_blocks; block++) {
+      bins.merge(block_bins[block], num_bins);
     }
   }
 
@@ -175,14 +135,14 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   BoundBox bz = BoundBox::empty;
 
   for (size_t i = num_bins - 1; i > 0; i--) {
-    count = count + bin_count[i];
+    count = count + bins.count[i];
     r_count[i] = blocks(count);
 
-    bx = merge(bx, bin_bounds[i][0]);
+    bx = merge(bx, bins.bounds[i][0]);
     r_area[i][0] = bx.half_area();
-    by = merge(by, bin_bounds[i][1]);
+    by = merge(by, bins.bounds[i][1]);
     r_area[i][1] = by.half_area();
-    bz = merge(bz, bin_bounds[i][2]);
+    bz = merge(bz, bins.bounds[i][2]);
     r_area[i][2] = bz.half_area();
     r_area[i][3] = r_area[i][2];
   }
@@ -199,13 +159,13 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   bz = BoundBox::empty;
 
   for (size_t i = 1; i < num_bins; i++, ii += make_int4(1)) {
-    count = count + bin_count[i - 1];
+    count = count + bins.count[i - 1];
 
-    bx = merge(bx, bin_bounds[i - 1][0]);
+    bx = merge(bx, bins.bounds[i - 1][0]);
     float Ax = bx.half_area();
-    by = merge(by, bin_bounds[i - 1][1]);
+    by = merge(by, bins.bounds[i - 1][1]);
     float Ay = by.half_area();
-    bz = merge(bz, bin_bounds[i - 1][2]);
+    bz = merge(bz, bins.bounds[i - 1][2]);
     float Az = bz.half_area();
 
     float4 lCount = blocks(count);
@@ -226,6 +186,149 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   leafSAH = bounds_.half_area() * blocks(size());
 }
 
+void BVHObjectBinning::Bins::reset(size_t num_bins)
+{
+  for (size_t i = 0; i < num_bins; i++) {
+    count[i] = make_int4(0);
+    bounds[i][0] = bounds[i][1] = bounds[i][2] = BoundBox::empty;
+  }
+}
+
+void BVHObjectBinning::Bins::merge(const Bins &other, size_t num_bins)
+{
+  for (size_t i = 0; i < num_bins; i++) {
+    count[i] = count[i] + other.count[i];
+    bounds[i][0].grow(other.bounds[i][0]);
+    bounds[i][1].grow(other.bounds[i][1]);
+    bounds[i][2].grow(other.bounds[i][2]);
+  }
+}
+
+void BVHObjectBinning::bin_primitives(const BVHReference *prims,
+                                      size_t begin,
+                                      size_t end,
+                                      Bins &bins) const
+{
+  for (size_t i = begin; i < end; i++) {
+    prefetch_L2(&prims[start() + i + 8]);
+
+    /* map primitive to bin */
+    const BVHReference &prim = prims[start() + i];
+    BoundBox bounds = get_prim_bounds(prim);
+    int4 bin = get_bin(bounds);
+
+    /* increase bounds of bins */
+    int b0 = (int)extract<0>(bin);
+    bins.count[b0][0]++;
+    bins.bounds[b0][0].grow(bounds);
+    int b1 = (int)extract<1>(bin);
+    bins.count[b1][1]++;
+    bins.bounds[b1][1].grow(bounds);
+    int b2 = (int)extract<2>(bin);
+    bins.count[b2][2]++;
+    bins.bounds[b2][2].grow(bounds);
+  }
+}
+
+size_t BVHObjectBinning::split_parallel(BVHReference *prims,
+                                        BoundBox &lgeom_bounds,
+                                        BoundBox &lcent_bounds,
+                                        BoundBox &rgeom_bounds,
+                                        BoundBox &rcent_bounds) const
+{
+  struct BlockInfo {
+    size_t num_left;
+    size_t left_offset;
+    size_t right_offset;
+    BoundBox lgeom_bounds, lcent_bounds;
+    BoundBox rgeom_bounds, rcent_bounds;
+  };
+
+  const size_t N = size();
+  const size_t block_size = BVHParams::PARALLEL_SPLIT_BLOCK_SIZE;
+  const size_t num_blocks = divide_up(N, block_size);
+  vector<BlockInfo> blocks(num_blocks);
+  vector<uint8_t> is_left(N);
+
+  /* Classify primitives and gather per-block statistics. */
+  parallel_for(blocked_range<size_t>(0, num_blocks, 1), [&](const blocked_range<size_t> &r) {
+    for (size_t block = r.begin(); block != r.end(); block++) {
+      BlockInfo &info = blocks[block];
+      info.num_left = 0;
+      info.lgeom_bounds = info.lcent_bounds = BoundBox::empty;
+      info.rgeom_bounds = info.rcent_bounds = BoundBox::empty;
+
+      const size_t end = min((block + 1) * block_size, N);
+      for (size_t i = block * block_size; i < end; i++) {
+        const BVHReference &prim = prims[start() + i];
+        BoundBox unaligned_bounds = get_prim_bounds(prim);
+        float3 unaligned_center = unaligned_bounds.center2();
+        float3 center = prim.bounds().center2();
+
+        if (get_bin(unaligned_center)[dim] < pos) {
+          info.lgeom_bounds.grow(prim.bounds());
+          info.lcent_bounds.grow(center);
+          info.num_left++;
+          is_left[i] = 1;
+        }
+        else {
+          info.rgeom_bounds.grow(prim.bounds());
+          info.rcent_bounds.grow(center);
+          is_left[i] = 0;
+        }
+      }
+    }
+  });
+
+  /* Compute where every block writes its primitives to. */
+  size_t num_left = 0;
+  for (size_t block = 0; block < num_blocks; block++) {
+    blocks[block].left_offset = num_left;
+    num_left += blocks[block].num_left;
+  }
+  size_t num_right = 0;
+  for (size_t block = 0; block < num_blocks; block++) {
+    BlockInfo &info = blocks[block];
+    info.right_offset = num_left + num_right;
+    num_right += min((block + 1) * block_size, N) - block * block_size - info.num_left;
+
+    lgeom_bounds.grow(info.lgeom_bounds);
+    lcent_bounds.grow(info.lcent_bounds);
+    rgeom_bounds.grow(info.rgeom_bounds);
+    rcent_bounds.grow(info.rcent_bounds);
+  }
+
+  if (num_left == 0 || num_right == 0) {
+    return num_left;
+  }
+
+  /* Scatter primitives into a temporary array, and copy them back. The
+   * partition is stable, which keeps it deterministic. */
+  vector<BVHReference> partitioned(N);
+
+  parallel_for(blocked_range<size_t>(0, num_blocks, 1), [&](const blocked_range<size_t> &r) {
+    for (size_t block = r.begin(); block != r.end(); block++) {
+      size_t left_offset = blocks[block].left_offset;
+      size_t right_offset = blocks[block].right_offset;
+
+      const size_t end = min((block + 1) * block_size, N);
+      for (size_t i = block * block_size; i < end; i++) {
+        partitioned[is_left[i] ? left_offset++ : right_offset++] = prims[start() + i];
+      }
+    }
+  });
+
+  parallel_for(blocked_range<size_t>(0, num_blocks, 1), [&](const blocked_range<size_t> &r) {
+    for (size_t block = r.begin(); block != r.end(); block++) {
+      const size_t begin = block * block_size;
+      const size_t end = min(begin + block_size, N);
+      std::copy(&partitioned[0] + begin, &partitioned[0] + end, prims + start() + begin);
+    }
+  });
+
+  return num_left;
+}
+
 void BVHObjectBinning::split(BVHReference *prims,
                              BVHObjectBinning &left_o,
                              BVHObjectBinning &right_o) const
@@ -237,34 +340,44 @@ void BVHObjectBinning::split(BVHReference *prims,
   BoundBox lcent_bounds = BoundBox::empty;
   BoundBox rcent_bounds = BoundBox::empty;
 
-  ssize_t l = 0, r = N - 1;
-
-  while (l <= r) {
-    prefetch_L2(&prims[start() + l + 8]);
-    prefetch_L2(&prims[start() + r - 8]);
-
-    BVHReference prim = prims[start() + l];
-    BoundBox unaligned_bounds = get_prim_bounds(prim);
-    float3 unaligned_center = unaligned_bounds.center2();
-    float3 center = prim.bounds().center2();
+  size_t num_left;
 
-    if (get_bin(unaligned_center)[dim] < pos) {
-      lgeom_bounds.grow(prim.bounds());
-      lcent_bounds.grow(center);
-      l++;
-    }
-    else {
-      rgeom_bounds.grow(prim.bounds());
-      rcent_bounds.grow(center);
-      swap(prims[start() + l], prims[start() + r]);
-      r--;
+  if (N >= BVHParams::PARALLEL_SPLIT_MIN_SIZE) {
+    num_left = split_parallel(prims, lgeom_bounds, lcent_bounds, rgeom_bounds, rcent_bounds);
+  }
+  else {
+    ssize_t l = 0, r = N - 1;
+
+    while (l <= r) {
+      prefetch_L2(&prims[start() + l + 8]);
+      prefetch_L2(&prims[start() + r - 8]);
+
+      BVHReference prim = prims[start() + l];
+      BoundBox unaligned_bounds = get_prim_bounds(prim);
+      float3 unaligned_center = unaligned_bounds.center2();
+      float3 center = prim.bounds().center2();
+
+      if (get_bin(unaligned_center)[dim] < pos) {
+        lgeom_bounds.grow(prim.bounds());
+        lcent_bounds.grow(center);
+        l++;
+      }
+      else {
+        rgeom_bounds.grow(prim.bounds());
+        rcent_bounds.grow(center);
+        swap(prims[start() + l], prims[start() + r]);
+        r--;
+      }
     }
+
+    num_left = l;
   }
+
   /* finish */
-  if (l != 0 && N - 1 - r != 0) {
-    right_o = BVHObjectBinning(BVHRange(rgeom_bounds, rcent_bounds, start() + l, N - 1 - r),
-                               prims);
-    left_o = BVHObjectBinning(BVHRange(lgeom_bounds, lcent_bounds, start(), l), prims);
+  if (num_left != 0 && num_left != N) {
+    right_o = BVHObjectBinning(
+        BVHRange(rgeom_bounds, rcent_bounds, start() + num_left, N - num_left), prims);
+    left_o = BVHObjectBinning(BVHRange(lgeom_bounds, lcent_bounds, start(), num_left), prims);
     return;
   }
 
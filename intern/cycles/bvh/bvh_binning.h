@@ -27,12 +27,15 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuild;
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
- * by testing for each dimension multiple partitionings for regular spaced
- * partition locations. A partitioning for a partition location is computed,
- * by putting primitives whose centroid is on the left and right of the split
- * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+/* Object binner. Finds the split with the best SAH heuristic by testing for
+ * each dimension multiple partitionings for regular spaced partition
+ * locations. A partitioning for a partition location is computed, by putting
+ * primitives whose centroid is on the left and right of the split location to
+ * different sets. The SAH is evaluated by computing the number of blocks
+ * occupied by the primitives in the partitions.
+ *
+ * Large ranges are binned and partitioned using multiple threads, see
+ * BVHParams::PARALLEL_SPLIT_MIN_SIZE. */
 
 class BVHObjectBinning : public BVHRange {
  public:
@@ -71,6 +74,26 @@ class BVHObjectBinning : public BVHRange {
   enum { MAX_BINS = 32 };
   enum { LOG_BLOCK_SIZE = 2 };
 
+  /* Per-bin primitive counts and bounds, for every dimension. */
+  struct Bins {
+    BoundBox bounds[MAX_BINS][4];
+    int4 count[MAX_BINS];
+
+    void reset(size_t num_bins);
+    void merge(const Bins &other, size_t num_bins);
+  };
+
+  /* Map primitives [begin, end[ of the range to bins. */
+  void bin_primitives(const BVHReference *prims, size_t begin, size_t end, Bins &bins) const;
+
+  /* Partition the range around the best split using multiple threads.
+   * Returns the number of primitives which ended up on the left side. */
+  size_t split_parallel(BVHReference *prims,
+                        BoundBox &lgeom_bounds,
+                        BoundBox &lcent_bounds,
+                        BoundBox &rgeom_bounds,
+                        BoundBox &rcent_bounds) const;
+
   /* computes the bin numbers for each dimension for a box. */
   __forceinline int4 get_bin(const BoundBox &box) const
   {
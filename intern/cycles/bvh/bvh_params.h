@@ -94,6 +94,12 @@ class BVHParams {
   /* fixed parameters */
   enum { MAX_DEPTH = 64, MAX_SPATIAL_DEPTH = 48, NUM_SPATIAL_BINS = 32 };
 
+  /* Ranges with at least this many references are binned and partitioned by
+   * multiple threads, in blocks of fixed size so the result does not depend
+   * on the number of threads. Smaller ranges are handled by a single thread,
+   * with parallelism coming from building independent subtrees. */
+  enum { PARALLEL_SPLIT_MIN_SIZE = 65536, PARALLEL_SPLIT_BLOCK_SIZE = 8192 };
+
   BVHParams()
   {
     use_spatial_split = true;
@@ -289,6 +295,13 @@ struct BVHSpatialBin {
   }
 };
 
+/* Spatial bins of all dimensions, used to bin blocks of references in
+ * parallel before merging them. */
+
+struct BVHSpatialBins {
+  BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+};
+
 /* BVH Spatial Storage
  *
  * The idea of this storage is have thread-specific storage for the spatial
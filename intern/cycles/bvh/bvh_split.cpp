@@ -25,6 +25,7 @@
 #include "render/object.h"
 
 #include "util/util_algorithm.h"
+#include "util/util_tbb.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -157,46 +158,40 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild &builder,
 
   float3 origin = range_bounds.min;
   float3 binSize = (range_bounds.max - origin) * (1.0f / (float)BVHParams::NUM_SPATIAL_BINS);
-  float3 invBinSize = 1.0f / binSize;
 
-  for (int dim = 0; dim < 3; dim++) {
-    for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-      BVHSpatialBin &bin = storage_->bins[dim][i];
-
-      bin.bounds = BoundBox::empty;
-      bin.enter = 0;
-      bin.exit = 0;
-    }
-  }
+  reset_bins(storage_->bins);
 
   /* chop references into bins. */
-  for (unsigned int refIdx = range.start(); refIdx < range.end(); refIdx++) {
-    const BVHReference &ref = references_->at(refIdx);
-    BoundBox prim_bounds = get_prim_bounds(ref);
-    float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
-    float3 lastBinf = (prim_bounds.max - origin) * invBinSize;
-    int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
-    int3 lastBin = make_int3((int)lastBinf.x, (int)lastBinf.y, (int)lastBinf.z);
-
-    firstBin = clamp(firstBin, 0, BVHParams::NUM_SPATIAL_BINS - 1);
-    lastBin = clamp(lastBin, firstBin, BVHParams::NUM_SPATIAL_BINS - 1);
-
-    for (int dim = 0; dim < 3; dim++) {
-      BVHReference currRef(
-          get_prim_bounds(ref), ref.prim_index(), ref.prim_object(), ref.prim_type());
-
-      for (int i = firstBin[dim]; i < lastBin[dim]; i++) {
-        BVHReference leftRef, rightRef;
-
-        split_reference(
-            builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
-        storage_->bins[dim][i].bounds.grow(leftRef.bounds());
-        currRef = rightRef;
+  if (range.size() < BVHParams::PARALLEL_SPLIT_MIN_SIZE) {
+    bin_references(builder, range.start(), range.end(), origin, binSize, storage_->bins);
+  }
+  else {
+    /* Clipping references against bin planes is the most expensive part of
+     * the build near the root, so chop blocks of references in parallel and
+     * merge their bins in a fixed order. */
+    const size_t num_blocks = divide_up(range.size(), BVHParams::PARALLEL_SPLIT_BLOCK_SIZE);
+    vector<BVHSpatialBins> block_bins(num_blocks);
+
+    parallel_for(blocked_range<size_t>(0, num_blocks, 1), [&](const blocked_range<size_t> &r) {
+      for (size_t block = r.begin(); block != r.end(); block++) {
+        const int begin = range.start() + block * BVHParams::PARALLEL_SPLIT_BLOCK_SIZE;
+        const int end = min(begin + (int)BVHParams::PARALLEL_SPLIT_BLOCK_SIZE, range.end());
+        reset_bins(block_bins[block].bins);
+        bin_references(builder, begin, end, origin, binSize, block_bins[block].bins);
+      }
+    });
+
+    for (size_t block = 0; block < num_blocks; block++) {
+      for (int dim = 0; dim < 3; dim++) {
+        for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+          BVHSpatialBin &bin = storage_->bins[dim][i];
+          const BVHSpatialBin &block_bin = block_bins[block].bins[dim][i];
+
+          bin.bounds.grow(block_bin.bounds);
+          bin.enter += block_bin.enter;
+          bin.exit += block_bin.exit;
+        }
       }
-
-      storage_->bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
-      storage_->bins[dim][firstBin[dim]].enter++;
-      storage_->bins[dim][lastBin[dim]].exit++;
     }
   }
 
@@ -233,6 +228,59 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild &builder,
   }
 }
 
+void BVHSpatialSplit::reset_bins(BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS])
+{
+  for (int dim = 0; dim < 3; dim++) {
+    for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+      BVHSpatialBin &bin = bins[dim][i];
+
+      bin.bounds = BoundBox::empty;
+      bin.enter = 0;
+      bin.exit = 0;
+    }
+  }
+}
+
+void BVHSpatialSplit::bin_references(const BVHBuild &builder,
+                                     int begin,
+                                     int end,
+                                     const float3 &origin,
+                                     const float3 &binSize,
+                                     BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS])
+{
+  float3 invBinSize = 1.0f / binSize;
+
+  for (int refIdx = begin; refIdx < end; refIdx++) {
+    const BVHReference &ref = references_->at(refIdx);
+    BoundBox prim_bounds = get_prim_bounds(ref);
+    float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
+    float3 lastBinf = (prim_bounds.max - origin) * invBinSize;
+    int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
+    int3 lastBin = make_int3((int)lastBinf.x, (int)lastBinf.y, (int)lastBinf.z);
+
+    firstBin = clamp(firstBin, 0, BVHParams::NUM_SPATIAL_BINS - 1);
+    lastBin = clamp(lastBin, firstBin, BVHParams::NUM_SPATIAL_BINS - 1);
+
+    for (int dim = 0; dim < 3; dim++) {
+      BVHReference currRef(
+          get_prim_bounds(ref), ref.prim_index(), ref.prim_object(), ref.prim_type());
+
+      for (int i = firstBin[dim]; i < lastBin[dim]; i++) {
+        BVHReference leftRef, rightRef;
+
+        split_reference(
+            builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
+        bins[dim][i].bounds.grow(leftRef.bounds());
+        currRef = rightRef;
+      }
+
+      bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
+      bins[dim][firstBin[dim]].enter++;
+      bins[dim][lastBin[dim]].exit++;
+    }
+  }
+}
+
 void BVHSpatialSplit::split(BVHBuild *builder,
                             BVHRange &left,
                             BVHRange &right,
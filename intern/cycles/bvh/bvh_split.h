@@ -102,6 +102,15 @@ class BVHSpatialSplit {
   const BVHUnaligned *unaligned_heuristic_;
   const Transform *aligned_space_;
 
+  /* Clear bins, and chop references [begin, end[ into them. */
+  static void reset_bins(BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS]);
+  void bin_references(const BVHBuild &builder,
+                      int begin,
+                      int end,
+                      const float3 &origin,
+                      const float3 &binSize,
+                      BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS]);
+
   /* Lower-level functions which calculates boundaries of left and right nodes
    * needed for spatial split.
    *
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh_build.h"
+#include "bvh/bvh_node.h"
+#include "bvh/bvh_params.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_hash.h"
+#include "util/util_progress.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Enough triangles for the top levels of the tree to be binned and split by
+ * multiple threads. */
+const int NUM_TRIANGLES = 4 * BVHParams::PARALLEL_SPLIT_MIN_SIZE;
+
+struct BuildResult {
+  double time;
+  float sah_cost;
+  size_t num_references;
+};
+
+/* Soup of small randomly placed and oriented triangles. */
+Mesh *create_triangle_soup(int num_triangles)
+{
+  Mesh *mesh = new Mesh();
+  mesh->reserve_mesh(num_triangles * 3, num_triangles);
+
+  for (int i = 0; i < num_triangles; i++) {
+    const float3 center = make_float3(hash_uint2_to_float(i, 0),
+                                      hash_uint2_to_float(i, 1),
+                                      hash_uint2_to_float(i, 2)) *
+                          100.0f;
+    for (int j = 0; j < 3; j++) {
+      const float3 offset = make_float3(hash_uint2_to_float(i, 3 + j * 3),
+                                        hash_uint2_to_float(i, 4 + j * 3),
+                                        hash_uint2_to_float(i, 5 + j * 3)) -
+                            make_float3(0.5f);
+      mesh->add_vertex(center + offset);
+    }
+    mesh->add_triangle(i * 3, i * 3 + 1, i * 3 + 2, 0, false);
+  }
+
+  return mesh;
+}
+
+BuildResult build_bvh(Object *object, const BVHParams &params, int num_threads)
+{
+  TaskScheduler::init(num_threads);
+
+  vector<Object *> objects;
+  objects.push_back(object);
+
+  array<int> prim_type, prim_index, prim_object;
+  array<float2> prim_time;
+  Progress progress;
+
+  BVHBuild build(objects, prim_type, prim_index, prim_object, prim_time, params, progress);
+
+  BuildResult result;
+  const double start_time = time_dt();
+  BVHNode *root = build.run();
+  result.time = time_dt() - start_time;
+  result.sah_cost = root->computeSubtreeSAHCost(params);
+  result.num_references = prim_index.size();
+  root->deleteSubtree();
+
+  TaskScheduler::exit();
+
+  return result;
+}
+
+/* Compare single threaded build with build using all threads. Since the
+ * threaded build only changes how work is scheduled, the resulting trees
+ * are expected to have the same cost. */
+void test_build(bool use_spatial_split)
+{
+  Mesh *mesh = create_triangle_soup(NUM_TRIANGLES);
+  Object *object = new Object();
+  object->geometry = mesh;
+  object->tfm = transform_identity();
+
+  BVHParams params;
+  params.use_spatial_split = use_spatial_split;
+
+  const BuildResult single = build_bvh(object, params, 1);
+  const BuildResult threaded = build_bvh(object, params, 0);
+
+  printf("%s build of %d triangles:\n",
+         use_spatial_split ? "Spatial split" : "Binning",
+         NUM_TRIANGLES);
+  printf("  1 thread:  %.3fs, SAH cost %f, %zu references\n",
+         single.time,
+         (double)single.sah_cost,
+         single.num_references);
+  printf("  threaded:  %.3fs, SAH cost %f, %zu references\n",
+         threaded.time,
+         (double)threaded.sah_cost,
+         threaded.num_references);
+
+  EXPECT_EQ(single.num_references, threaded.num_references);
+  EXPECT_FLOAT_EQ(single.sah_cost, threaded.sah_cost);
+  if (!use_spatial_split) {
+    EXPECT_EQ(single.num_references, (size_t)NUM_TRIANGLES);
+  }
+
+  delete object;
+  delete mesh;
+}
+
+}  // namespace
+
+TEST(bvh_build, binning)
+{
+  test_build(false);
+}
+
+TEST(bvh_build, spatial_split)
+{
+  test_build(true);
+}
+
+CCL_NAMESPACE_END
@@ -189,7 +189,7 @@ template<class T> class MEM_CacheLimiter {
   {
     size_t max = MEM_CacheLimiter_get_maximum();
     bool is_disabled = MEM_CacheLimiter_is_disabled();
-    size_t mem_in_use, cur_size;
+    size_t mem_in_use;
 
     if (is_disabled) {
       return;
@@ -205,28 +205,17 @@ template<class T> class MEM_CacheLimiter {
       return;
     }
 
-    while (!queue.empty() && mem_in_use > max) {
-      MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
-
-      if (!elem)
-        break;
+    shrink(mem_in_use, max);
+  }
 
-      if (data_size_func) {
-        cur_size = data_size_func(elem->get()->get_data());
-      }
-      else {
-        cur_size = mem_in_use;
-      }
+  /* Destroy elements until the given amount of memory is freed, regardless of the maximum.
+   * Returns the amount of memory actually freed. */
+  size_t free_memory(size_t memory_to_free)
+  {
+    size_t mem_in_use = get_memory_in_use();
+    size_t max = (mem_in_use > memory_to_free) ? mem_in_use - memory_to_free : 0;
 
-      if (elem->destroy_if_possible()) {
-        if (data_size_func) {
-          mem_in_use -= cur_size;
-        }
-        else {
-          mem_in_use -= cur_size - MEM_get_memory_in_use();
-        }
-      }
-    }
+    return mem_in_use - shrink(mem_in_use, max);
   }
 
   void touch(MEM_CacheLimiterHandle<T> *handle)
@@ -259,6 +248,38 @@ template<class T> class MEM_CacheLimiter {
   typedef std::vector<MEM_CacheElementPtr, MEM_Allocator<MEM_CacheElementPtr>> MEM_CacheQueue;
   typedef typename MEM_CacheQueue::iterator iterator;
 
+  /* Destroy least priority elements until no more than max memory is used,
+   * returns memory used afterwards. */
+  size_t shrink(size_t mem_in_use, size_t max)
+  {
+    size_t cur_size;
+
+    while (!queue.empty() && mem_in_use > max) {
+      MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
+
+      if (!elem)
+        break;
+
+      if (data_size_func) {
+        cur_size = data_size_func(elem->get()->get_data());
+      }
+      else {
+        cur_size = mem_in_use;
+      }
+
+      if (elem->destroy_if_possible()) {
+        if (data_size_func) {
+          mem_in_use -= cur_size;
+        }
+        else {
+          mem_in_use -= cur_size - MEM_get_memory_in_use();
+        }
+      }
+    }
+
+    return mem_in_use;
+  }
+
   /* Check whether element can be destroyed when enforcing cache limits */
   bool can_destroy_element(MEM_CacheElementPtr &elem)
   {
@@ -90,6 +90,16 @@ MEM_CacheLimiterHandleC *MEM_CacheLimiter_insert(MEM_CacheLimiterC *This, void *
 
 void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This);
 
+/**
+ * Free objects until the given amount of memory is freed, used when the system is running
+ * out of memory.
+ *
+ * \param This: "This" pointer.
+ * \return Amount of memory actually freed.
+ */
+
+size_t MEM_CacheLimiter_free_memory(MEM_CacheLimiterC *This, size_t memory_to_free);
+
 /**
  * Unmanage object previously inserted object.
  * Does _not_ delete managed object!
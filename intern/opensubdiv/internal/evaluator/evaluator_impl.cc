@@ -35,6 +35,11 @@
 #include <opensubdiv/osd/types.h>
 #include <opensubdiv/version.h>
 
+#ifdef WITH_TBB
+#  include <tbb/blocked_range.h>
+#  include <tbb/parallel_for.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "internal/base/type.h"
@@ -183,6 +188,62 @@ class ConstPatchCoordWrapperBuffer : public RawDataWrapperVertexBuffer<const Pat
   }
 };
 
+// Evaluate stencils of the given table, reading coarse values from the beginning of the buffer
+// and writing refined values at the destination descriptor.
+template<typename EVAL_VERTEX_BUFFER,
+         typename STENCIL_TABLE,
+         typename EVALUATOR,
+         typename DEVICE_CONTEXT>
+void evalStencils(EVAL_VERTEX_BUFFER *data,
+                  const BufferDescriptor &src_desc,
+                  const BufferDescriptor &dst_desc,
+                  const STENCIL_TABLE *stencils,
+                  const EVALUATOR *eval_instance,
+                  DEVICE_CONTEXT *device_context)
+{
+  EVALUATOR::EvalStencils(data, src_desc, data, dst_desc, stencils, eval_instance, device_context);
+}
+
+#ifdef WITH_TBB
+// Stencils of intermediate levels and local points are factorized down to the coarse vertices
+// (the default of StencilTableFactory), so every stencil only reads coarse values and ranges
+// of stencils can be evaluated independently from multiple threads.
+template<>
+void evalStencils<CpuVertexBuffer, StencilTable, CpuEvaluator, void>(
+    CpuVertexBuffer *data,
+    const BufferDescriptor &src_desc,
+    const BufferDescriptor &dst_desc,
+    const StencilTable *stencils,
+    const CpuEvaluator * /*eval_instance*/,
+    void * /*device_context*/)
+{
+  const int num_stencils = stencils->GetNumStencils();
+  if (num_stencils == 0) {
+    return;
+  }
+  float *buffer = data->BindCpuBuffer();
+  const int *sizes = &stencils->GetSizes()[0];
+  const int *offsets = &stencils->GetOffsets()[0];
+  const int *indices = &stencils->GetControlIndices()[0];
+  const float *weights = &stencils->GetWeights()[0];
+  // Stencils are cheap to evaluate, keep chunks big enough to amortize scheduling.
+  const int grain_size = 2048;
+  tbb::parallel_for(tbb::blocked_range<int>(0, num_stencils, grain_size),
+                    [&](const tbb::blocked_range<int> &range) {
+                      CpuEvaluator::EvalStencils(buffer,
+                                                 src_desc,
+                                                 buffer,
+                                                 dst_desc,
+                                                 sizes,
+                                                 offsets,
+                                                 indices,
+                                                 weights,
+                                                 range.begin(),
+                                                 range.end());
+                    });
+}
+#endif
+
 template<typename EVAL_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
@@ -232,13 +293,12 @@ class FaceVaryingVolatileEval {
                                     src_face_varying_desc_.stride;
     const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
         evaluator_cache_, src_face_varying_desc_, dst_face_varying_desc, device_context_);
-    EVALUATOR::EvalStencils(src_face_varying_data_,
-                            src_face_varying_desc_,
-                            src_face_varying_data_,
-                            dst_face_varying_desc,
-                            face_varying_stencils_,
-                            eval_instance,
-                            device_context_);
+    evalStencils(src_face_varying_data_,
+                 src_face_varying_desc_,
+                 dst_face_varying_desc,
+                 face_varying_stencils_,
+                 eval_instance,
+                 device_context_);
   }
 
   // NOTE: face_varying must point to a memory of at least float[2]*num_patch_coords.
@@ -391,26 +451,19 @@ class VolatileEvalOutput {
     dst_desc.offset += num_coarse_vertices_ * src_desc_.stride;
     const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
         evaluator_cache_, src_desc_, dst_desc, device_context_);
-    EVALUATOR::EvalStencils(src_data_,
-                            src_desc_,
-                            src_data_,
-                            dst_desc,
-                            vertex_stencils_,
-                            eval_instance,
-                            device_context_);
+    evalStencils(src_data_, src_desc_, dst_desc, vertex_stencils_, eval_instance, device_context_);
     // Evaluate varying data.
     if (hasVaryingData()) {
       BufferDescriptor dst_varying_desc = src_varying_desc_;
       dst_varying_desc.offset += num_coarse_vertices_ * src_varying_desc_.stride;
       eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
           evaluator_cache_, src_varying_desc_, dst_varying_desc, device_context_);
-      EVALUATOR::EvalStencils(src_varying_data_,
-                              src_varying_desc_,
-                              src_varying_data_,
-                              dst_varying_desc,
-                              varying_stencils_,
-                              eval_instance,
-                              device_context_);
+      evalStencils(src_varying_data_,
+                   src_varying_desc_,
+                   dst_varying_desc,
+                   varying_stencils_,
+                   eval_instance,
+                   device_context_);
     }
     // Evaluate face-varying data.
     if (hasFaceVaryingData()) {
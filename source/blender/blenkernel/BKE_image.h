@@ -252,6 +252,8 @@ bool BKE_image_is_multiview(struct Image *ima);
 bool BKE_image_is_stereo(struct Image *ima);
 struct RenderResult *BKE_image_acquire_renderresult(struct Scene *scene, struct Image *ima);
 void BKE_image_release_renderresult(struct Scene *scene, struct Image *ima);
+/* Multilayer images read the pixels of a layer when first used, read all of them. */
+void BKE_image_multilayer_load_passes(struct Image *ima);
 
 /* for multilayer images as well as for singlelayer */
 bool BKE_image_is_openexr(struct Image *ima);
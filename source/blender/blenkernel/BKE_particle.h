@@ -38,6 +38,7 @@
 extern "C" {
 #endif
 
+struct ParticleDistributionCache;
 struct ParticleKey;
 struct ParticleSettings;
 struct ParticleSystem;
@@ -59,6 +60,7 @@ struct Main;
 struct ModifierData;
 struct Object;
 struct RNG;
+struct SPHGrid;
 struct Scene;
 
 #define PARTICLE_COLLISION_MAX_COLLISIONS 10
@@ -433,7 +435,7 @@ void psys_apply_child_modifiers(struct ParticleThreadContext *ctx,
 
 void psys_sph_init(struct ParticleSimulationData *sim, struct SPHData *sphdata);
 void psys_sph_finalize(struct SPHData *sphdata);
-void psys_sph_density(struct BVHTree *tree, struct SPHData *data, float co[3], float vars[2]);
+void psys_sph_grid_free(struct SPHGrid *grid);
 
 /* for anim.c */
 void psys_get_dupli_texture(struct ParticleSystem *psys,
@@ -579,6 +581,7 @@ void psys_particle_on_dm(struct Mesh *mesh_final,
 
 /* particle_system.c */
 void distribute_particles(struct ParticleSimulationData *sim, int from);
+void psys_distribution_cache_free(struct ParticleDistributionCache *cache);
 void init_particle(struct ParticleSimulationData *sim, struct ParticleData *pa);
 void psys_calc_dmcache(struct Object *ob,
                        struct Mesh *mesh_final,
@@ -321,6 +321,8 @@ void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context,
                                  short *do_update,
                                  float *num_frames_prefetched);
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
+/* Movie strips only decode and encode their own files, several of them can be rebuilt at once. */
+bool BKE_sequencer_proxy_rebuild_is_threadsafe(const struct SeqIndexBuildContext *context);
 
 void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
 /* **********************************************************************
@@ -29,7 +29,9 @@
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
+#include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
@@ -47,6 +49,8 @@
 
 typedef struct BVHCacheItem {
   bool is_filled;
+  /** The tree is owned by the shared cache, see #bvhcache_shared_ensure. */
+  bool is_shared;
   BVHTree *tree;
 } BVHCacheItem;
 
@@ -55,6 +59,8 @@ typedef struct BVHCache {
   ThreadMutex mutex;
 } BVHCache;
 
+static void bvhcache_shared_release(BVHTree *tree);
+
 /**
  * Queries a bvhcache for the cache bvhtree of the request type
  *
@@ -153,7 +159,12 @@ void bvhcache_free(BVHCache *bvh_cache)
 {
   for (BVHCacheType index = 0; index < BVHTREE_MAX_ITEM; index++) {
     BVHCacheItem *item = &bvh_cache->items[index];
-    BLI_bvhtree_free(item->tree);
+    if (item->is_shared) {
+      bvhcache_shared_release(item->tree);
+    }
+    else {
+      BLI_bvhtree_free(item->tree);
+    }
     item->tree = NULL;
   }
   BLI_mutex_end(&bvh_cache->mutex);
@@ -1408,6 +1419,362 @@ static BLI_bitmap *looptri_no_hidden_map_get(const MPoly *mpoly,
   return looptri_mask;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Shared BVHCache
+ *
+ * A #BVHCache lives in the mesh runtime and is freed with every evaluated copy of the mesh.
+ * Trees of whole meshes (vertices and looptris) are additionally kept in a global list, with a
+ * copy of the geometry they were built from. A later copy with the same geometry reuses the
+ * tree, a copy with the same topology but moved vertices refits an unused tree instead of
+ * building.
+ *
+ * Unused trees are kept up to #BVHCACHE_SHARED_UNUSED_MEMORY_MAX and freed when a depsgraph is
+ * rebuilt or freed, which includes loading a file.
+ * \{ */
+
+/* Memory of trees without users kept for later evaluations. */
+#define BVHCACHE_SHARED_UNUSED_MEMORY_MAX ((size_t)256 * 1024 * 1024)
+
+typedef struct BVHSharedKey {
+  BVHCacheType type;
+  int tree_type;
+  int elems_len;
+  int verts_len;
+  /* Hashes of the data below, only used to reject items quickly. */
+  uint topology_hash;
+  uint positions_hash;
+} BVHSharedKey;
+
+typedef struct BVHSharedItem {
+  struct BVHSharedItem *next, *prev;
+  BVHSharedKey key;
+  /* Copy of the geometry the tree was built from, a hit compares it exactly. */
+  float (*positions)[3];
+  /* Vertices of every looptri, looptri trees only. */
+  uint (*tri_verts)[3];
+  BVHTree *tree;
+  /* Memory of the tree and the geometry copy. */
+  size_t memory;
+  /* Number of #BVHCache using the tree, only trees without users can be refit. */
+  int users;
+} BVHSharedItem;
+
+/* Items are ordered from least to most recently released. */
+static ListBase bvh_shared_items = {NULL, NULL};
+static size_t bvh_shared_unused_memory = 0;
+static ThreadMutex bvh_shared_mutex = BLI_MUTEX_INITIALIZER;
+
+BLI_INLINE void bvhcache_shared_tri_verts(const Mesh *mesh, const MLoopTri *lt, uint r_verts[3])
+{
+  r_verts[0] = mesh->mloop[lt->tri[0]].v;
+  r_verts[1] = mesh->mloop[lt->tri[1]].v;
+  r_verts[2] = mesh->mloop[lt->tri[2]].v;
+}
+
+static void bvhcache_shared_key_init(BVHSharedKey *key,
+                                     Mesh *mesh,
+                                     const BVHCacheType type,
+                                     const int tree_type)
+{
+  BLI_HashMurmur2A mm2;
+
+  key->type = type;
+  key->tree_type = tree_type;
+  key->verts_len = mesh->totvert;
+
+  BLI_hash_mm2a_init(&mm2, 0);
+  if (type == BVHTREE_FROM_LOOPTRI) {
+    const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+    key->elems_len = BKE_mesh_runtime_looptri_len(mesh);
+
+    for (int i = 0; i < key->elems_len; i++) {
+      uint verts[3];
+      bvhcache_shared_tri_verts(mesh, &looptri[i], verts);
+      BLI_hash_mm2a_add(&mm2, (const uchar *)verts, sizeof(verts));
+    }
+  }
+  else {
+    key->elems_len = mesh->totvert;
+  }
+  key->topology_hash = BLI_hash_mm2a_end(&mm2);
+
+  BLI_hash_mm2a_init(&mm2, 0);
+  for (int i = 0; i < mesh->totvert; i++) {
+    BLI_hash_mm2a_add(&mm2, (const uchar *)mesh->mvert[i].co, sizeof(mesh->mvert[i].co));
+  }
+  key->positions_hash = BLI_hash_mm2a_end(&mm2);
+}
+
+static bool bvhcache_shared_item_topology_eq(const BVHSharedItem *item,
+                                             const BVHSharedKey *key,
+                                             Mesh *mesh)
+{
+  const BVHSharedKey *item_key = &item->key;
+
+  if (!(item_key->type == key->type && item_key->tree_type == key->tree_type &&
+        item_key->elems_len == key->elems_len && item_key->verts_len == key->verts_len &&
+        item_key->topology_hash == key->topology_hash)) {
+    return false;
+  }
+
+  if (key->type == BVHTREE_FROM_LOOPTRI) {
+    const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+    for (int i = 0; i < key->elems_len; i++) {
+      uint verts[3];
+      bvhcache_shared_tri_verts(mesh, &looptri[i], verts);
+      if (memcmp(verts, item->tri_verts[i], sizeof(verts)) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Only valid for items with the same topology. */
+static bool bvhcache_shared_item_positions_eq(const BVHSharedItem *item,
+                                              const BVHSharedKey *key,
+                                              const Mesh *mesh)
+{
+  if (item->key.positions_hash != key->positions_hash) {
+    return false;
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    if (memcmp(item->positions[i], mesh->mvert[i].co, sizeof(item->positions[i])) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Copy the geometry of the mesh into the item, the topology only for new items. */
+static void bvhcache_shared_item_geometry_store(BVHSharedItem *item, Mesh *mesh)
+{
+  const BVHSharedKey *key = &item->key;
+
+  if (item->positions == NULL) {
+    item->positions = MEM_malloc_arrayN(
+        (size_t)key->verts_len, sizeof(*item->positions), __func__);
+  }
+  for (int i = 0; i < key->verts_len; i++) {
+    copy_v3_v3(item->positions[i], mesh->mvert[i].co);
+  }
+
+  if (key->type == BVHTREE_FROM_LOOPTRI && item->tri_verts == NULL) {
+    const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+    item->tri_verts = MEM_malloc_arrayN(
+        (size_t)key->elems_len, sizeof(*item->tri_verts), __func__);
+    for (int i = 0; i < key->elems_len; i++) {
+      bvhcache_shared_tri_verts(mesh, &looptri[i], item->tri_verts[i]);
+    }
+  }
+
+  item->memory = BLI_bvhtree_get_memory_size(item->tree) + MEM_allocN_len(item->positions) +
+                 (item->tri_verts ? MEM_allocN_len(item->tri_verts) : 0);
+}
+
+static BVHTree *bvhcache_shared_tree_create(Mesh *mesh,
+                                            const BVHCacheType type,
+                                            const int tree_type)
+{
+  if (type == BVHTREE_FROM_LOOPTRI) {
+    return bvhtree_from_mesh_looptri_create_tree(0.0f,
+                                                 tree_type,
+                                                 6,
+                                                 mesh->mvert,
+                                                 mesh->mloop,
+                                                 BKE_mesh_runtime_looptri_ensure(mesh),
+                                                 BKE_mesh_runtime_looptri_len(mesh),
+                                                 NULL,
+                                                 -1);
+  }
+  return bvhtree_from_mesh_verts_create_tree(
+      0.0f, tree_type, 6, mesh->mvert, mesh->totvert, NULL, -1);
+}
+
+/* Leaves were inserted in element order without a mask, so leaf and element indices match. */
+static void bvhcache_shared_tree_refit(BVHTree *tree, Mesh *mesh, const BVHCacheType type)
+{
+  const MVert *mvert = mesh->mvert;
+
+  if (type == BVHTREE_FROM_LOOPTRI) {
+    const MLoop *mloop = mesh->mloop;
+    const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+    const int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
+
+    for (int i = 0; i < looptri_len; i++) {
+      float co[3][3];
+      copy_v3_v3(co[0], mvert[mloop[looptri[i].tri[0]].v].co);
+      copy_v3_v3(co[1], mvert[mloop[looptri[i].tri[1]].v].co);
+      copy_v3_v3(co[2], mvert[mloop[looptri[i].tri[2]].v].co);
+      BLI_bvhtree_update_node(tree, i, co[0], NULL, 3);
+    }
+  }
+  else {
+    for (int i = 0; i < mesh->totvert; i++) {
+      BLI_bvhtree_update_node(tree, i, mvert[i].co, NULL, 1);
+    }
+  }
+  BLI_bvhtree_update_tree(tree);
+}
+
+static void bvhcache_shared_item_use(BVHSharedItem *item)
+{
+  if (item->users++ == 0) {
+    bvh_shared_unused_memory -= item->memory;
+  }
+}
+
+static void bvhcache_shared_item_free(BVHSharedItem *item)
+{
+  BLI_remlink(&bvh_shared_items, item);
+  BLI_bvhtree_free(item->tree);
+  MEM_SAFE_FREE(item->positions);
+  MEM_SAFE_FREE(item->tri_verts);
+  MEM_freeN(item);
+}
+
+/* Free the least recently released trees until the unused ones fit in `memory_max`. */
+static void bvhcache_shared_unused_trim(const size_t memory_max)
+{
+  BVHSharedItem *item = bvh_shared_items.first;
+  while (item && bvh_shared_unused_memory > memory_max) {
+    BVHSharedItem *item_next = item->next;
+    if (item->users == 0) {
+      bvh_shared_unused_memory -= item->memory;
+      bvhcache_shared_item_free(item);
+    }
+    item = item_next;
+  }
+}
+
+/**
+ * Get a tree of the whole mesh from the shared cache, building or refitting it when needed.
+ * The caller gets a user of the tree and must give it back with #bvhcache_shared_release.
+ */
+static BVHTree *bvhcache_shared_ensure(Mesh *mesh, const BVHCacheType type, const int tree_type)
+{
+  BLI_assert(ELEM(type, BVHTREE_FROM_VERTS, BVHTREE_FROM_LOOPTRI));
+
+  BVHSharedKey key;
+  bvhcache_shared_key_init(&key, mesh, type, tree_type);
+
+  if (key.elems_len == 0) {
+    return NULL;
+  }
+
+  BVHSharedItem *item_refit = NULL;
+
+  BLI_mutex_lock(&bvh_shared_mutex);
+  LISTBASE_FOREACH (BVHSharedItem *, item, &bvh_shared_items) {
+    if (!bvhcache_shared_item_topology_eq(item, &key, mesh)) {
+      continue;
+    }
+    if (bvhcache_shared_item_positions_eq(item, &key, mesh)) {
+      bvhcache_shared_item_use(item);
+      BLI_mutex_unlock(&bvh_shared_mutex);
+      return item->tree;
+    }
+    if (item->users == 0 && item_refit == NULL) {
+      item_refit = item;
+    }
+  }
+  if (item_refit) {
+    /* Unlink while refitting, so other threads can't use the tree with outdated bounds. */
+    bvhcache_shared_item_use(item_refit);
+    BLI_remlink(&bvh_shared_items, item_refit);
+  }
+  BLI_mutex_unlock(&bvh_shared_mutex);
+
+  BVHSharedItem *item = item_refit;
+  if (item) {
+    bvhcache_shared_tree_refit(item->tree, mesh, type);
+  }
+  else {
+    item = MEM_callocN(sizeof(*item), __func__);
+    item->tree = bvhcache_shared_tree_create(mesh, type, tree_type);
+    item->users = 1;
+  }
+  item->key = key;
+  bvhcache_shared_item_geometry_store(item, mesh);
+
+  BLI_mutex_lock(&bvh_shared_mutex);
+  BLI_addtail(&bvh_shared_items, item);
+  BLI_mutex_unlock(&bvh_shared_mutex);
+
+  return item->tree;
+}
+
+static void bvhcache_shared_release(BVHTree *tree)
+{
+  if (tree == NULL) {
+    return;
+  }
+
+  BLI_mutex_lock(&bvh_shared_mutex);
+  LISTBASE_FOREACH (BVHSharedItem *, item, &bvh_shared_items) {
+    if (item->tree != tree) {
+      continue;
+    }
+    BLI_assert(item->users > 0);
+    if (--item->users == 0) {
+      BLI_remlink(&bvh_shared_items, item);
+      BLI_addtail(&bvh_shared_items, item);
+      bvh_shared_unused_memory += item->memory;
+    }
+    break;
+  }
+  bvhcache_shared_unused_trim(BVHCACHE_SHARED_UNUSED_MEMORY_MAX);
+  BLI_mutex_unlock(&bvh_shared_mutex);
+}
+
+/**
+ * Look the tree up in the mesh #BVHCache, falling back to the shared cache.
+ * Returns true when the tree was found or added to the mesh cache.
+ */
+static bool bvhcache_shared_find(BVHCache **bvh_cache_p,
+                                 ThreadMutex *mesh_eval_mutex,
+                                 Mesh *mesh,
+                                 const BVHCacheType type,
+                                 const int tree_type,
+                                 BVHTree **r_tree)
+{
+  bool lock_started = false;
+  if (!bvhcache_find(bvh_cache_p, type, r_tree, &lock_started, mesh_eval_mutex)) {
+    BVHCache *bvh_cache = *bvh_cache_p;
+    *r_tree = bvhcache_shared_ensure(mesh, type, tree_type);
+    bvhcache_insert(bvh_cache, *r_tree, type);
+    bvh_cache->items[type].is_shared = true;
+  }
+  bvhcache_unlock(*bvh_cache_p, lock_started);
+  return true;
+}
+
+/**
+ * Free the trees of the shared cache which no evaluated mesh uses.
+ * Called when the depsgraph changes, their meshes are unlikely to come back.
+ */
+void bvhcache_shared_free_unused(void)
+{
+  BLI_mutex_lock(&bvh_shared_mutex);
+  bvhcache_shared_unused_trim(0);
+  BLI_mutex_unlock(&bvh_shared_mutex);
+}
+
+/**
+ * Free all trees of the shared cache, trees still in use are freed too.
+ */
+void bvhcache_shared_free(void)
+{
+  BLI_mutex_lock(&bvh_shared_mutex);
+  while (bvh_shared_items.first) {
+    bvhcache_shared_item_free(bvh_shared_items.first);
+  }
+  bvh_shared_unused_memory = 0;
+  BLI_mutex_unlock(&bvh_shared_mutex);
+}
+
+/** \} */
+
 /**
  * Builds or queries a bvhcache for the cache bvhtree of the request type.
  */
@@ -1422,6 +1789,11 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
 
   bool is_cached = bvhcache_find(bvh_cache_p, bvh_cache_type, &tree, NULL, NULL);
 
+  if (is_cached == false && ELEM(bvh_cache_type, BVHTREE_FROM_VERTS, BVHTREE_FROM_LOOPTRI)) {
+    is_cached = bvhcache_shared_find(
+        bvh_cache_p, mesh_eval_mutex, mesh, bvh_cache_type, tree_type, &tree);
+  }
+
   if (is_cached && tree == NULL) {
     memset(data, 0, sizeof(*data));
     return tree;
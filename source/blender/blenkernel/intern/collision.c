@@ -31,6 +31,7 @@
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
+#include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_edgehash.h"
 #include "BLI_linklist.h"
@@ -74,6 +75,14 @@ typedef struct SelfColDetectData {
   bool collided;
 } SelfColDetectData;
 
+typedef struct SelfOverlapData {
+  ClothModifierData *clmd;
+  /* Triangles with self collision disabled for all their vertices. */
+  BLI_bitmap *tri_noselfcoll;
+  /* Triangles with a vertex on a sewing edge, NULL when sewing is disabled. */
+  BLI_bitmap *tri_sewn;
+} SelfOverlapData;
+
 /***********************************
  * Collision modifier code start
  ***********************************/
@@ -1061,6 +1070,7 @@ static void cloth_collision(void *__restrict userdata,
   }
 }
 
+#ifdef DEBUG
 static bool cloth_bvh_selfcollision_is_active(const Cloth *cloth,
                                               const MVertTri *tri_a,
                                               const MVertTri *tri_b,
@@ -1090,6 +1100,31 @@ static bool cloth_bvh_selfcollision_is_active(const Cloth *cloth,
 
   return true;
 }
+#endif
+
+/**
+ * Whether the bounds of two triangles are further apart than \a dist along an axis,
+ * which is much cheaper to test than their distance.
+ */
+BLI_INLINE bool cloth_tri_tri_separated(const float a1[3],
+                                        const float a2[3],
+                                        const float a3[3],
+                                        const float b1[3],
+                                        const float b2[3],
+                                        const float b3[3],
+                                        const float dist)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    const float a_min = min_fff(a1[axis], a2[axis], a3[axis]);
+    const float a_max = max_fff(a1[axis], a2[axis], a3[axis]);
+    const float b_min = min_fff(b1[axis], b2[axis], b3[axis]);
+    const float b_max = max_fff(b1[axis], b2[axis], b3[axis]);
+    if ((a_min > b_max + dist) || (b_min > a_max + dist)) {
+      return true;
+    }
+  }
+  return false;
+}
 
 static void cloth_selfcollision(void *__restrict userdata,
                                 const int index,
@@ -1113,6 +1148,18 @@ static void cloth_selfcollision(void *__restrict userdata,
   BLI_assert(cloth_bvh_selfcollision_is_active(clmd->clothObject, tri_a, tri_b, sewing_active));
 #endif
 
+  /* The overlap is found once for all collision rounds, skip pairs that moved apart since. */
+  if (cloth_tri_tri_separated(verts1[tri_a->tri[0]].tx,
+                              verts1[tri_a->tri[1]].tx,
+                              verts1[tri_a->tri[2]].tx,
+                              verts1[tri_b->tri[0]].tx,
+                              verts1[tri_b->tri[1]].tx,
+                              verts1[tri_b->tri[2]].tx,
+                              epsilon * 2.0f + ALMOST_ZERO)) {
+    collpair[index].flag = COLLISION_INACTIVE;
+    return;
+  }
+
   /* Compute distance and normal. */
   distance = compute_collision_point_tri_tri(verts1[tri_a->tri[0]].tx,
                                              verts1[tri_a->tri[1]].tx,
@@ -1411,6 +1458,8 @@ static bool cloth_bvh_selfcollisions_nearcheck(ClothModifierData *clmd,
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.use_threading = true;
+  /* Most pairs are rejected early, test them in batches. */
+  settings.min_iter_per_thread = 64;
   BLI_task_parallel_range(0, numresult, &data, cloth_selfcollision, &settings);
 
   return data.collided;
@@ -1510,23 +1559,95 @@ static int cloth_bvh_selfcollisions_resolve(ClothModifierData *clmd,
   return ret;
 }
 
+/**
+ * Compute the triangle flags used to filter self overlap, so the overlap callback doesn't have to
+ * look at the vertices of both triangles and the sewing edges for every pair.
+ */
+static void cloth_bvh_self_overlap_data_init(SelfOverlapData *data, ClothModifierData *clmd)
+{
+  const Cloth *cloth = clmd->clothObject;
+  const ClothVertex *verts = cloth->verts;
+  const uint tri_num = cloth->primitive_num;
+  BLI_bitmap *vert_sewn = NULL;
+
+  data->clmd = clmd;
+  data->tri_noselfcoll = BLI_BITMAP_NEW(tri_num, __func__);
+  data->tri_sewn = NULL;
+
+  if ((clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_SEW) && cloth->sew_edge_graph) {
+    EdgeSetIterator *esi;
+    vert_sewn = BLI_BITMAP_NEW(cloth->mvert_num, __func__);
+    for (esi = BLI_edgesetIterator_new(cloth->sew_edge_graph); !BLI_edgesetIterator_isDone(esi);
+         BLI_edgesetIterator_step(esi)) {
+      uint v1, v2;
+      BLI_edgesetIterator_getKey(esi, &v1, &v2);
+      BLI_BITMAP_ENABLE(vert_sewn, v1);
+      BLI_BITMAP_ENABLE(vert_sewn, v2);
+    }
+    BLI_edgesetIterator_free(esi);
+
+    data->tri_sewn = BLI_BITMAP_NEW(tri_num, __func__);
+  }
+
+  for (uint i = 0; i < tri_num; i++) {
+    const uint *tri = cloth->tri[i].tri;
+
+    if (verts[tri[0]].flags & verts[tri[1]].flags & verts[tri[2]].flags &
+        CLOTH_VERT_FLAG_NOSELFCOLL) {
+      BLI_BITMAP_ENABLE(data->tri_noselfcoll, i);
+    }
+
+    if (vert_sewn && (BLI_BITMAP_TEST(vert_sewn, tri[0]) || BLI_BITMAP_TEST(vert_sewn, tri[1]) ||
+                      BLI_BITMAP_TEST(vert_sewn, tri[2]))) {
+      BLI_BITMAP_ENABLE(data->tri_sewn, i);
+    }
+  }
+
+  MEM_SAFE_FREE(vert_sewn);
+}
+
+static void cloth_bvh_self_overlap_data_free(SelfOverlapData *data)
+{
+  MEM_freeN(data->tri_noselfcoll);
+  MEM_SAFE_FREE(data->tri_sewn);
+}
+
+/* Same as #cloth_bvh_selfcollision_is_active, using the precomputed triangle flags. */
 static bool cloth_bvh_self_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
 {
-  /* No need for equal combinations (eg. (0,1) & (1,0)). */
-  if (index_a < index_b) {
-    ClothModifierData *clmd = (ClothModifierData *)userdata;
-    struct Cloth *clothObject = clmd->clothObject;
-    const MVertTri *tri_a, *tri_b;
-    tri_a = &clothObject->tri[index_a];
-    tri_b = &clothObject->tri[index_b];
+  const SelfOverlapData *data = (const SelfOverlapData *)userdata;
+  const Cloth *cloth = data->clmd->clothObject;
 
-    bool sewing_active = (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_SEW);
+  if (BLI_BITMAP_TEST(data->tri_noselfcoll, index_a) ||
+      BLI_BITMAP_TEST(data->tri_noselfcoll, index_b)) {
+    return false;
+  }
 
-    if (cloth_bvh_selfcollision_is_active(clothObject, tri_a, tri_b, sewing_active)) {
-      return true;
+  const MVertTri *tri_a = &cloth->tri[index_a];
+  const MVertTri *tri_b = &cloth->tri[index_b];
+
+  /* Ignore overlap of neighboring triangles. */
+  for (uint i = 0; i < 3; i++) {
+    for (uint j = 0; j < 3; j++) {
+      if (tri_a->tri[i] == tri_b->tri[j]) {
+        return false;
+      }
     }
   }
-  return false;
+
+  /* Ignore triangles connected by a sewing edge. */
+  if (data->tri_sewn && BLI_BITMAP_TEST(data->tri_sewn, index_a) &&
+      BLI_BITMAP_TEST(data->tri_sewn, index_b)) {
+    for (uint i = 0; i < 3; i++) {
+      for (uint j = 0; j < 3; j++) {
+        if (BLI_edgeset_haskey(cloth->sew_edge_graph, tri_a->tri[i], tri_b->tri[j])) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
 }
 
 int cloth_bvh_collision(
@@ -1544,6 +1665,7 @@ int cloth_bvh_collision(
   BVHTreeOverlap **overlap_obj = NULL;
   uint coll_count_self = 0;
   BVHTreeOverlap *overlap_self = NULL;
+  CollPair *collisions_self = NULL;
 
   if ((clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_COLLOBJ) || cloth_bvh == NULL) {
     return 0;
@@ -1587,10 +1709,27 @@ int cloth_bvh_collision(
   }
 
   if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
+    SelfOverlapData self_overlap_data;
+
     bvhtree_update_from_cloth(clmd, false, true);
 
-    overlap_self = BLI_bvhtree_overlap(
-        cloth->bvhselftree, cloth->bvhselftree, &coll_count_self, cloth_bvh_self_overlap_cb, clmd);
+    /* Each pair of triangles only once, filtered with the flags of the triangles. */
+    cloth_bvh_self_overlap_data_init(&self_overlap_data, clmd);
+    overlap_self = BLI_bvhtree_overlap_ex(cloth->bvhselftree,
+                                          cloth->bvhselftree,
+                                          &coll_count_self,
+                                          cloth_bvh_self_overlap_cb,
+                                          &self_overlap_data,
+                                          0,
+                                          BVH_OVERLAP_USE_THREADING | BVH_OVERLAP_RETURN_PAIRS |
+                                              BVH_OVERLAP_SELF);
+    cloth_bvh_self_overlap_data_free(&self_overlap_data);
+
+    /* Reused by all collision rounds. */
+    if (coll_count_self && overlap_self) {
+      collisions_self = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self,
+                                                "collision array");
+    }
   }
 
   do {
@@ -1640,25 +1779,18 @@ int cloth_bvh_collision(
 
     /* Self collisions. */
     if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
-      CollPair *collisions = NULL;
-
       verts = cloth->verts;
       mvert_num = cloth->mvert_num;
 
       if (cloth->bvhselftree) {
-        if (coll_count_self && overlap_self) {
-          collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self,
-                                               "collision array");
-
+        if (collisions_self) {
           if (cloth_bvh_selfcollisions_nearcheck(
-                  clmd, collisions, coll_count_self, overlap_self)) {
-            ret += cloth_bvh_selfcollisions_resolve(clmd, collisions, coll_count_self, dt);
+                  clmd, collisions_self, coll_count_self, overlap_self)) {
+            ret += cloth_bvh_selfcollisions_resolve(clmd, collisions_self, coll_count_self, dt);
             ret2 += ret;
           }
         }
       }
-
-      MEM_SAFE_FREE(collisions);
     }
 
     /* Apply all collision resolution. */
@@ -1688,6 +1820,7 @@ int cloth_bvh_collision(
   MEM_SAFE_FREE(coll_counts_obj);
 
   MEM_SAFE_FREE(overlap_self);
+  MEM_SAFE_FREE(collisions_self);
 
   BKE_collision_objects_free(collobjs);
 
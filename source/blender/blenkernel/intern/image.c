@@ -3914,14 +3914,21 @@ static void image_add_view(Image *ima, const char *viewname, const char *filepat
 /* after imbuf load, openexr type can return with a exrhandle open */
 /* in that case we have to build a render-result */
 #ifdef WITH_OPENEXR
-static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr)
+static void image_create_multilayer(Image *ima, ImageUser *iuser, ImBuf *ibuf, int framenr)
 {
   const char *colorspace = ima->colorspace_settings.name;
   bool predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
 
   /* only load rr once for multiview */
   if (!ima->rr) {
-    ima->rr = RE_MultilayerConvert(ibuf->userdata, colorspace, predivide, ibuf->x, ibuf->y);
+    ima->rr = RE_MultilayerConvert(ibuf->userdata, ibuf->x, ibuf->y);
+
+    /* Read the layer used now while the file is open, other layers are read when first used,
+     * see image_multilayer_load_pass(). */
+    RenderLayer *rl = BLI_findlink(&ima->rr->layers, iuser ? iuser->layer : 0);
+    if (rl) {
+      RE_MultilayerLoadLayer(ima->rr, ibuf->userdata, colorspace, predivide, rl->name);
+    }
   }
 
   IMB_exr_close(ibuf->userdata);
@@ -4033,7 +4040,7 @@ static ImBuf *load_sequence_single(
       /* Handle multilayer and multiview cases, don't assign ibuf here.
        * will be set layer in BKE_image_acquire_ibuf from ima->rr. */
       if (IMB_exr_has_multilayer(ibuf->userdata)) {
-        image_create_multilayer(ima, ibuf, frame);
+        image_create_multilayer(ima, iuser, ibuf, frame);
         ima->type = IMA_TYPE_MULTILAYER;
         IMB_freeImBuf(ibuf);
         ibuf = NULL;
@@ -4109,6 +4116,85 @@ static ImBuf *image_load_sequence_file(Image *ima, ImageUser *iuser, int entry,
   return ibuf;
 }
 
+#ifdef WITH_OPENEXR
+/* Read the pixels of the passes of `layer` of a multilayer image, of all layers when NULL, from
+ * the file its render result was created from. */
+static void image_multilayer_load_layer(Image *ima, RenderLayer *layer)
+{
+  const char *colorspace = ima->colorspace_settings.name;
+  const bool predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
+  const int flag = IB_rect | IB_multilayer | imbuf_alpha_flags_for_image(ima);
+  bool has_missing_pass = false;
+  ImBuf *ibuf = NULL;
+
+  LISTBASE_FOREACH (RenderLayer *, rl, &ima->rr->layers) {
+    if (ELEM(layer, NULL, rl)) {
+      LISTBASE_FOREACH (RenderPass *, rpass, &rl->passes) {
+        has_missing_pass |= (rpass->rect == NULL);
+      }
+    }
+  }
+  if (!has_missing_pass) {
+    return;
+  }
+
+  if (BKE_image_has_packedfile(ima)) {
+    ImagePackedFile *imapf = ima->packedfiles.first;
+    if (imapf->packedfile) {
+      ibuf = IMB_ibImageFromMemory((unsigned char *)imapf->packedfile->data,
+                                   imapf->packedfile->size,
+                                   flag,
+                                   colorspace,
+                                   "<packed data>");
+    }
+  }
+  else {
+    /* The render result is created from the first view of its frame. */
+    ImageUser iuser_t = {0};
+    char filepath[FILE_MAX];
+
+    iuser_t.framenr = ima->rr->framenr;
+    BKE_image_user_file_path(&iuser_t, ima, filepath);
+    ibuf = IMB_loadiffname(filepath, flag, colorspace);
+  }
+
+  if (ibuf && ibuf->ftype == IMB_FTYPE_OPENEXR && ibuf->userdata) {
+    RE_MultilayerLoadLayer(
+        ima->rr, ibuf->userdata, colorspace, predivide, layer ? layer->name : NULL);
+    IMB_exr_close(ibuf->userdata);
+    ibuf->userdata = NULL;
+  }
+  IMB_freeImBuf(ibuf);
+}
+
+/* Read the pixels of the layer of `rpass` if needed, false when they can't be read. */
+static bool image_multilayer_load_pass(Image *ima, RenderPass *rpass)
+{
+  if (rpass->rect == NULL) {
+    LISTBASE_FOREACH (RenderLayer *, rl, &ima->rr->layers) {
+      if (BLI_findindex(&rl->passes, rpass) != -1) {
+        image_multilayer_load_layer(ima, rl);
+        break;
+      }
+    }
+  }
+  return (rpass->rect != NULL);
+}
+#endif /* WITH_OPENEXR */
+
+void BKE_image_multilayer_load_passes(Image *ima)
+{
+#ifdef WITH_OPENEXR
+  if (ima->type == IMA_TYPE_MULTILAYER && ima->rr) {
+    BLI_mutex_lock(image_mutex);
+    image_multilayer_load_layer(ima, NULL);
+    BLI_mutex_unlock(image_mutex);
+  }
+#else
+  UNUSED_VARS(ima);
+#endif
+}
+
 static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int entry, int frame)
 {
   struct ImBuf *ibuf = NULL;
@@ -4138,6 +4224,12 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int e
   if (ima->rr) {
     RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
+#ifdef WITH_OPENEXR
+    if (rpass && !image_multilayer_load_pass(ima, rpass)) {
+      rpass = NULL;
+    }
+#endif
+
     if (rpass) {
       // printf("load from pass %s\n", rpass->name);
       /* since we free  render results, we copy the rect */
@@ -4349,7 +4441,7 @@ static ImBuf *load_image_single(Image *ima,
       /* Handle multilayer and multiview cases, don't assign ibuf here.
        * will be set layer in BKE_image_acquire_ibuf from ima->rr. */
       if (IMB_exr_has_multilayer(ibuf->userdata)) {
-        image_create_multilayer(ima, ibuf, cfra);
+        image_create_multilayer(ima, iuser, ibuf, cfra);
         ima->type = IMA_TYPE_MULTILAYER;
         IMB_freeImBuf(ibuf);
         ibuf = NULL;
@@ -4469,6 +4561,12 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
   if (ima->rr) {
     RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
+#ifdef WITH_OPENEXR
+    if (rpass && !image_multilayer_load_pass(ima, rpass)) {
+      rpass = NULL;
+    }
+#endif
+
     if (rpass) {
       ibuf = IMB_allocImBuf(ima->rr->rectx, ima->rr->recty, 32, 0);
 
@@ -4984,6 +5082,8 @@ ImBuf *BKE_image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
 
   BLI_mutex_unlock(image_mutex);
 
+  IMB_moviecache_memory_pressure_check();
+
   return ibuf;
 }
 
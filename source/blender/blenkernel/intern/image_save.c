@@ -179,6 +179,7 @@ static bool image_save_single(ReportList *reports,
   }
 
   /* we need renderresult for exr and rendered multiview */
+  BKE_image_multilayer_load_passes(ima);
   rr = BKE_image_acquire_renderresult(opts->scene, ima);
   bool is_mono = rr ? BLI_listbase_count_at_most(&rr->views, 2) < 2 :
                       BLI_listbase_count_at_most(&ima->views, 2) < 2;
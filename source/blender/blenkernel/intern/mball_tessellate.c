@@ -38,6 +38,7 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -60,6 +61,7 @@
 typedef struct corner { /* corner of a cube */
   int i, j, k;          /* (i, j, k) is index within lattice */
   float co[3], value;   /* location and function value */
+  bool is_pending;      /* value is not computed yet */
   struct corner *next;
 } CORNER;
 
@@ -115,20 +117,26 @@ typedef struct process {     /* parameters, storage */
   MetaballBVHNode metaball_bvh; /* The simplest bvh */
   Box allbb;                    /* Bounding box of all metaelems */
 
-  MetaballBVHNode **bvh_queue; /* Queue used during bvh traversal */
+  const MetaballBVHNode **bvh_queue; /* Queue used during bvh traversal */
   unsigned int bvh_queue_size;
 
   CUBES *cubes;         /* stack of cubes waiting for polygonization */
   CENTERLIST **centers; /* cube center hash table */
   CORNER **corners;     /* corner value hash table */
   EDGELIST **edges;     /* edge and vertex id hash table */
+  unsigned int hashbit; /* hash bits per axis, edges table is twice as big as others */
+
+  CORNER **corners_pending;           /* corners of added cubes, waiting for their value */
+  unsigned int corners_pending_len;   /* number of pending corners */
+  unsigned int corners_pending_size;  /* memory size */
+  const CORNER *(*vertex_corners)[2]; /* corners of the edge each vertex lies on */
 
   int (*indices)[4];     /* output indices */
   unsigned int totindex; /* size of memory allocated for indices */
   unsigned int curindex; /* number of currently added indices */
 
   float (*co)[3], (*no)[3]; /* surface vertices - positions and normals */
-  unsigned int totvertex;   /* memory size */
+  unsigned int totvertex;   /* memory size of vertex_corners */
   unsigned int curvertex;   /* currently added vertices */
 
   /* memory allocation from common pool */
@@ -139,7 +147,11 @@ typedef struct process {     /* parameters, storage */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2);
 static void add_cube(PROCESS *process, int i, int j, int k);
 static void make_face(PROCESS *process, int i1, int i2, int i3, int i4);
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3]);
+static void converge(const PROCESS *process,
+                     const MetaballBVHNode **bvh_queue,
+                     const CORNER *c1,
+                     const CORNER *c2,
+                     float r_p[3]);
 
 /* ******************* SIMPLE BVH ********************* */
 
@@ -292,10 +304,13 @@ static void build_bvh_spatial(PROCESS *process,
  * (i-0.5)*size, (j-0.5)*size, (k-0.5)*size)
  */
 
-#define HASHBIT (5)
-#define HASHSIZE (size_t)(1 << (3 * HASHBIT)) /*! < hash table size (32768) */
+/* Range of hash bits per axis, picked from the lattice size of the domain. */
+#define HASHBIT_MIN 5 /* hash table size 32768 */
+#define HASHBIT_MAX 7 /* hash table size 2097152 */
 
-#define HASH(i, j, k) ((((((i)&31) << 5) | ((j)&31)) << 5) | ((k)&31))
+#define HASH_AXIS(i, bits) ((unsigned int)(i) & ((1u << (bits)) - 1))
+#define HASH(i, j, k, bits) \
+  ((((HASH_AXIS(i, bits) << (bits)) | HASH_AXIS(j, bits)) << (bits)) | HASH_AXIS(k, bits))
 
 #define MB_BIT(i, bit) (((i) >> (bit)) & 1)
 // #define FLIP(i, bit) ((i) ^ 1 << (bit)) /* flip the given bit of i */
@@ -406,25 +421,27 @@ static float densfunc(const MetaElem *ball, float x, float y, float z)
 
 /**
  * Computes density at given position form all meta-balls which contain this point in their box.
- * Traverses BVH using a queue.
+ * Traverses BVH using a queue, which must hold at least `process->bvh_queue_size` nodes.
+ * Each thread evaluating the field uses its own queue.
  */
-static float metaball(PROCESS *process, float x, float y, float z)
+static float metaball(
+    const PROCESS *process, const MetaballBVHNode **bvh_queue, float x, float y, float z)
 {
   int i;
   float dens = 0.0f;
   unsigned int front = 0, back = 0;
-  MetaballBVHNode *node;
+  const MetaballBVHNode *node;
 
-  process->bvh_queue[front++] = &process->metaball_bvh;
+  bvh_queue[front++] = &process->metaball_bvh;
 
   while (front != back) {
-    node = process->bvh_queue[back++];
+    node = bvh_queue[back++];
 
     for (i = 0; i < 2; i++) {
       if ((node->bb[i].min[0] <= x) && (node->bb[i].max[0] >= x) && (node->bb[i].min[1] <= y) &&
           (node->bb[i].max[1] >= y) && (node->bb[i].min[2] <= z) && (node->bb[i].max[2] >= z)) {
         if (node->child[i]) {
-          process->bvh_queue[front++] = node->child[i];
+          bvh_queue[front++] = node->child[i];
         }
         else {
           dens += densfunc(node->bb[i].ml, x, y, z);
@@ -443,10 +460,6 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
 {
   int *cur;
 
-#ifdef USE_ACCUM_NORMAL
-  float n[3];
-#endif
-
   if (UNLIKELY(process->totindex == process->curindex)) {
     process->totindex += 4096;
     process->indices = MEM_reallocN(process->indices, sizeof(int[4]) * process->totindex);
@@ -460,34 +473,47 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
   cur[1] = i2;
   cur[2] = i3;
   cur[3] = i4;
+}
 
 #ifdef USE_ACCUM_NORMAL
-  if (i4 == i3) {
-    normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
-    accumulate_vertex_normals_v3(process->no[i1],
-                                 process->no[i2],
-                                 process->no[i3],
-                                 NULL,
-                                 n,
-                                 process->co[i1],
-                                 process->co[i2],
-                                 process->co[i3],
-                                 NULL);
-  }
-  else {
-    normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
-    accumulate_vertex_normals_v3(process->no[i1],
-                                 process->no[i2],
-                                 process->no[i3],
-                                 process->no[i4],
-                                 n,
-                                 process->co[i1],
-                                 process->co[i2],
-                                 process->co[i3],
-                                 process->co[i4]);
+/**
+ * Accumulates face normals to vertices, once all vertex positions are known.
+ */
+static void accumulate_normals(PROCESS *process)
+{
+  float n[3];
+
+  for (unsigned int a = 0; a < process->curindex; a++) {
+    const int i1 = process->indices[a][0], i2 = process->indices[a][1];
+    const int i3 = process->indices[a][2], i4 = process->indices[a][3];
+
+    if (i4 == i3) {
+      normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
+      accumulate_vertex_normals_v3(process->no[i1],
+                                   process->no[i2],
+                                   process->no[i3],
+                                   NULL,
+                                   n,
+                                   process->co[i1],
+                                   process->co[i2],
+                                   process->co[i3],
+                                   NULL);
+    }
+    else {
+      normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
+      accumulate_vertex_normals_v3(process->no[i1],
+                                   process->no[i2],
+                                   process->no[i3],
+                                   process->no[i4],
+                                   n,
+                                   process->co[i1],
+                                   process->co[i2],
+                                   process->co[i3],
+                                   process->co[i4]);
+    }
   }
-#endif
 }
+#endif
 
 /* Frees allocated memory */
 static void freepolygonize(PROCESS *process)
@@ -505,7 +531,13 @@ static void freepolygonize(PROCESS *process)
     MEM_freeN(process->mainb);
   }
   if (process->bvh_queue) {
-    MEM_freeN(process->bvh_queue);
+    MEM_freeN((void *)process->bvh_queue);
+  }
+  if (process->corners_pending) {
+    MEM_freeN(process->corners_pending);
+  }
+  if (process->vertex_corners) {
+    MEM_freeN(process->vertex_corners);
   }
   if (process->pgn_elements) {
     BLI_memarena_free(process->pgn_elements);
@@ -670,17 +702,17 @@ static void docube(PROCESS *process, CUBE *cube)
 }
 
 /**
- * return corner with the given lattice location
- * set (and cache) its function value
+ * return corner with the given lattice location,
+ * its function value is computed later, see #corners_pending_evaluate()
  */
-static CORNER *setcorner(PROCESS *process, int i, int j, int k)
+static CORNER *addcorner(PROCESS *process, int i, int j, int k)
 {
   /* for speed, do corner value caching here */
   CORNER *c;
-  int index;
+  unsigned int index;
 
   /* does corner exist? */
-  index = HASH(i, j, k);
+  index = HASH(i, j, k, process->hashbit);
   c = process->corners[index];
 
   for (; c != NULL; c = c->next) {
@@ -698,7 +730,15 @@ static CORNER *setcorner(PROCESS *process, int i, int j, int k)
   c->k = k;
   c->co[2] = ((float)k - 0.5f) * process->size;
 
-  c->value = metaball(process, c->co[0], c->co[1], c->co[2]);
+  c->value = 0.0f;
+  c->is_pending = true;
+
+  if (UNLIKELY(process->corners_pending_len == process->corners_pending_size)) {
+    process->corners_pending_size += 4096;
+    process->corners_pending = MEM_reallocN(process->corners_pending,
+                                            sizeof(CORNER *) * process->corners_pending_size);
+  }
+  process->corners_pending[process->corners_pending_len++] = c;
 
   c->next = process->corners[index];
   process->corners[index] = c;
@@ -706,6 +746,22 @@ static CORNER *setcorner(PROCESS *process, int i, int j, int k)
   return c;
 }
 
+/**
+ * return corner with the given lattice location
+ * set (and cache) its function value
+ */
+static CORNER *setcorner(PROCESS *process, int i, int j, int k)
+{
+  CORNER *c = addcorner(process, i, j, k);
+
+  if (c->is_pending) {
+    c->value = metaball(process, process->bvh_queue, c->co[0], c->co[1], c->co[2]);
+    c->is_pending = false;
+  }
+
+  return c;
+}
+
 /**
  * return next clockwise edge from given edge around given face
  */
@@ -863,10 +919,10 @@ void BKE_mball_cubeTable_free(void)
  */
 static int setcenter(PROCESS *process, CENTERLIST *table[], const int i, const int j, const int k)
 {
-  int index;
+  unsigned int index;
   CENTERLIST *newc, *l, *q;
 
-  index = HASH(i, j, k);
+  index = HASH(i, j, k, process->hashbit);
   q = table[index];
 
   for (l = q; l != NULL; l = l->next) {
@@ -890,7 +946,7 @@ static int setcenter(PROCESS *process, CENTERLIST *table[], const int i, const i
  */
 static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, int k2, int vid)
 {
-  int index;
+  unsigned int index;
   EDGELIST *newe;
 
   if (i1 > i2 || (i1 == i2 && (j1 > j2 || (j1 == j2 && k1 > k2)))) {
@@ -904,7 +960,7 @@ static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, in
     k1 = k2;
     k2 = t;
   }
-  index = HASH(i1, j1, k1) + HASH(i2, j2, k2);
+  index = HASH(i1, j1, k1, process->hashbit) + HASH(i2, j2, k2, process->hashbit);
   newe = BLI_memarena_alloc(process->pgn_elements, sizeof(EDGELIST));
 
   newe->i1 = i1;
@@ -921,7 +977,7 @@ static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, in
 /**
  * \return vertex id for edge; return -1 if not set
  */
-static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, int k2)
+static int getedge(const PROCESS *process, int i1, int j1, int k1, int i2, int j2, int k2)
 {
   EDGELIST *q;
 
@@ -936,7 +992,7 @@ static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, in
     k1 = k2;
     k2 = t;
   }
-  q = table[HASH(i1, j1, k1) + HASH(i2, j2, k2)];
+  q = process->edges[HASH(i1, j1, k1, process->hashbit) + HASH(i2, j2, k2, process->hashbit)];
   for (; q != NULL; q = q->next) {
     if (q->i1 == i1 && q->j1 == j1 && q->k1 == k1 && q->i2 == i2 && q->j2 == j2 && q->k2 == k2) {
       return q->vid;
@@ -946,18 +1002,19 @@ static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, in
 }
 
 /**
- * Adds a vertex, expands memory if needed.
+ * Adds a vertex lying on the edge between two corners, expands memory if needed.
+ * Its position and normal are computed later, see #vertices_evaluate().
  */
-static void addtovertices(PROCESS *process, const float v[3], const float no[3])
+static void addtovertices(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
   if (process->curvertex == process->totvertex) {
     process->totvertex += 4096;
-    process->co = MEM_reallocN(process->co, process->totvertex * sizeof(float[3]));
-    process->no = MEM_reallocN(process->no, process->totvertex * sizeof(float[3]));
+    process->vertex_corners = MEM_reallocN(process->vertex_corners,
+                                           process->totvertex * sizeof(*process->vertex_corners));
   }
 
-  copy_v3_v3(process->co[process->curvertex], v);
-  copy_v3_v3(process->no[process->curvertex], no);
+  process->vertex_corners[process->curvertex][0] = c1;
+  process->vertex_corners[process->curvertex][1] = c2;
 
   process->curvertex++;
 }
@@ -968,40 +1025,34 @@ static void addtovertices(PROCESS *process, const float v[3], const float no[3])
  *
  * \note Doesn't do normalization!
  */
-static void vnormal(PROCESS *process, const float point[3], float r_no[3])
+static void vnormal(const PROCESS *process,
+                    const MetaballBVHNode **bvh_queue,
+                    const float point[3],
+                    float r_no[3])
 {
   const float delta = process->delta;
-  const float f = metaball(process, point[0], point[1], point[2]);
+  const float f = metaball(process, bvh_queue, point[0], point[1], point[2]);
 
-  r_no[0] = metaball(process, point[0] + delta, point[1], point[2]) - f;
-  r_no[1] = metaball(process, point[0], point[1] + delta, point[2]) - f;
-  r_no[2] = metaball(process, point[0], point[1], point[2] + delta) - f;
+  r_no[0] = metaball(process, bvh_queue, point[0] + delta, point[1], point[2]) - f;
+  r_no[1] = metaball(process, bvh_queue, point[0], point[1] + delta, point[2]) - f;
+  r_no[2] = metaball(process, bvh_queue, point[0], point[1], point[2] + delta) - f;
 }
 #endif /* USE_ACCUM_NORMAL */
 
 /**
  * \return the id of vertex between two corners.
  *
- * If it wasn't previously computed, does #converge() and adds vertex to process.
+ * If it wasn't previously added, adds vertex to process.
  */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
-  float v[3], no[3];
-  int vid = getedge(process->edges, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
+  int vid = getedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
 
   if (vid != -1) {
     return vid; /* previously computed */
   }
 
-  converge(process, c1, c2, v); /* position */
-
-#ifdef USE_ACCUM_NORMAL
-  zero_v3(no);
-#else
-  vnormal(process, v, no);
-#endif
-
-  addtovertices(process, v, no); /* save vertex */
+  addtovertices(process, c1, c2); /* save vertex */
   vid = (int)process->curvertex - 1;
   setedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k, vid);
 
@@ -1012,7 +1063,11 @@ static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
  * Given two corners, computes approximation of surface intersection point between them.
  * In case of small threshold, do bisection.
  */
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3])
+static void converge(const PROCESS *process,
+                     const MetaballBVHNode **bvh_queue,
+                     const CORNER *c1,
+                     const CORNER *c2,
+                     float r_p[3])
 {
   float tmp, dens;
   unsigned int i;
@@ -1034,7 +1089,7 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 
   for (i = 0; i < process->converge_res; i++) {
     interp_v3_v3v3(r_p, c1_co, c2_co, 0.5f);
-    dens = metaball(process, r_p[0], r_p[1], r_p[2]);
+    dens = metaball(process, bvh_queue, r_p[0], r_p[1], r_p[2]);
 
     if (dens > 0.0f) {
       c1_value = dens;
@@ -1069,9 +1124,9 @@ static void add_cube(PROCESS *process, int i, int j, int k)
     ncube->cube.j = j;
     ncube->cube.k = k;
 
-    /* set corners of initial cube: */
+    /* set corners of initial cube, their values are computed before the cube is processed */
     for (n = 0; n < 8; n++) {
-      ncube->cube.corners[n] = setcorner(
+      ncube->cube.corners[n] = addcorner(
           process, i + MB_BIT(n, 2), j + MB_BIT(n, 1), k + MB_BIT(n, 0));
     }
   }
@@ -1145,20 +1200,157 @@ static void find_first_points(PROCESS *process, const unsigned int em)
   }
 }
 
+/**
+ * Picks hash bits so that lattice locations of the whole domain get distinct hashes,
+ * without making hash tables much bigger than the number of cubes on the bounding boxes
+ * of all elements, which is a rough estimate of the number of cubes on the surface.
+ */
+static unsigned int hashbit_from_domain(const PROCESS *process)
+{
+  const float cells_len = max_fff(process->allbb.max[0] - process->allbb.min[0],
+                                  process->allbb.max[1] - process->allbb.min[1],
+                                  process->allbb.max[2] - process->allbb.min[2]) /
+                          process->size;
+  float cubes_len = 0.0f;
+  unsigned int bits = HASHBIT_MIN;
+
+  for (unsigned int i = 0; i < process->totelem; i++) {
+    const BoundBox *bb = process->mainb[i]->bb;
+    float dim[3];
+    sub_v3_v3v3(dim, bb->vec[6], bb->vec[0]);
+    mul_v3_fl(dim, 1.0f / process->size);
+    cubes_len += 2.0f * (dim[0] * dim[1] + dim[1] * dim[2] + dim[2] * dim[0]);
+  }
+
+  while (bits < HASHBIT_MAX && (float)(1u << bits) < cells_len &&
+         (float)(1u << (3 * bits)) < cubes_len) {
+    bits++;
+  }
+
+  return bits;
+}
+
+/**** Parallel field evaluation ****/
+
+/* Per thread data, every thread traverses the BVH with its own queue. */
+typedef struct MetaballEvalTLS {
+  const MetaballBVHNode **bvh_queue;
+} MetaballEvalTLS;
+
+static const MetaballBVHNode **metaball_eval_tls_queue(const PROCESS *process,
+                                                       MetaballEvalTLS *tls)
+{
+  if (tls->bvh_queue == NULL) {
+    tls->bvh_queue = MEM_malloc_arrayN(
+        process->bvh_queue_size, sizeof(MetaballBVHNode *), "Metaball BVH Queue");
+  }
+  return tls->bvh_queue;
+}
+
+static void metaball_eval_tls_free(const void *__restrict UNUSED(userdata),
+                                   void *__restrict chunk)
+{
+  MetaballEvalTLS *tls = chunk;
+  if (tls->bvh_queue) {
+    MEM_freeN((void *)tls->bvh_queue);
+  }
+}
+
+static void metaball_eval_settings(TaskParallelSettings *settings, MetaballEvalTLS *tls)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->min_iter_per_thread = 128;
+  settings->userdata_chunk = tls;
+  settings->userdata_chunk_size = sizeof(*tls);
+  settings->func_free = metaball_eval_tls_free;
+}
+
+static void corners_pending_evaluate_cb(void *__restrict userdata,
+                                        const int index,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  const PROCESS *process = userdata;
+  CORNER *c = process->corners_pending[index];
+
+  /* Corner might have been evaluated already by #setcorner(). */
+  if (c->is_pending) {
+    const MetaballBVHNode **bvh_queue = metaball_eval_tls_queue(process, tls->userdata_chunk);
+    c->value = metaball(process, bvh_queue, c->co[0], c->co[1], c->co[2]);
+    c->is_pending = false;
+  }
+}
+
+/**
+ * Computes function values of all corners added since the last call.
+ */
+static void corners_pending_evaluate(PROCESS *process)
+{
+  MetaballEvalTLS tls = {NULL};
+  TaskParallelSettings settings;
+  metaball_eval_settings(&settings, &tls);
+  BLI_task_parallel_range(
+      0, (int)process->corners_pending_len, process, corners_pending_evaluate_cb, &settings);
+
+  process->corners_pending_len = 0;
+}
+
+static void vertices_evaluate_cb(void *__restrict userdata,
+                                 const int index,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  PROCESS *process = userdata;
+  const CORNER *c1 = process->vertex_corners[index][0];
+  const CORNER *c2 = process->vertex_corners[index][1];
+  const MetaballBVHNode **bvh_queue = metaball_eval_tls_queue(process, tls->userdata_chunk);
+
+  converge(process, bvh_queue, c1, c2, process->co[index]); /* position */
+
+#ifdef USE_ACCUM_NORMAL
+  zero_v3(process->no[index]);
+#else
+  vnormal(process, bvh_queue, process->co[index], process->no[index]);
+#endif
+}
+
+/**
+ * Computes positions and normals of all vertices found by the polygonization.
+ */
+static void vertices_evaluate(PROCESS *process)
+{
+  process->co = MEM_malloc_arrayN(process->curvertex, sizeof(float[3]), "mball vertices");
+  process->no = MEM_malloc_arrayN(process->curvertex, sizeof(float[3]), "mball normals");
+
+  MetaballEvalTLS tls = {NULL};
+  TaskParallelSettings settings;
+  metaball_eval_settings(&settings, &tls);
+  BLI_task_parallel_range(0, (int)process->curvertex, process, vertices_evaluate_cb, &settings);
+
+#ifdef USE_ACCUM_NORMAL
+  accumulate_normals(process);
+#endif
+}
+
 /**
  * The main polygonization proc.
  * Allocates memory, makes cubetable,
  * finds starting surface points
  * and processes cubes on the stack until none left.
+ *
+ * Cubes are processed in waves: the values of all corners of the cubes added by the previous
+ * wave are computed in parallel first, then the cubes are polygonized, adding their neighbors
+ * to the next wave. Vertices only store the edge they lie on until all cubes are processed,
+ * their positions and normals are then computed in parallel as well.
  */
 static void polygonize(PROCESS *process)
 {
-  CUBE c;
+  CUBES *cubes;
   unsigned int i;
 
-  process->centers = MEM_callocN(HASHSIZE * sizeof(CENTERLIST *), "mbproc->centers");
-  process->corners = MEM_callocN(HASHSIZE * sizeof(CORNER *), "mbproc->corners");
-  process->edges = MEM_callocN(2 * HASHSIZE * sizeof(EDGELIST *), "mbproc->edges");
+  process->hashbit = hashbit_from_domain(process);
+  const size_t hash_size = (size_t)1 << (3 * process->hashbit);
+  process->centers = MEM_callocN(hash_size * sizeof(CENTERLIST *), "mbproc->centers");
+  process->corners = MEM_callocN(hash_size * sizeof(CORNER *), "mbproc->corners");
+  process->edges = MEM_callocN(2 * hash_size * sizeof(EDGELIST *), "mbproc->edges");
   process->bvh_queue = MEM_callocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size,
                                    "Metaball BVH Queue");
 
@@ -1169,10 +1361,18 @@ static void polygonize(PROCESS *process)
   }
 
   while (process->cubes != NULL) {
-    c = process->cubes->cube;
-    process->cubes = process->cubes->next;
+    corners_pending_evaluate(process);
+
+    cubes = process->cubes;
+    process->cubes = NULL;
+
+    for (; cubes != NULL; cubes = cubes->next) {
+      docube(process, &cubes->cube);
+    }
+  }
 
-    docube(process, &c);
+  if (process->curvertex > 0) {
+    vertices_evaluate(process);
   }
 }
 
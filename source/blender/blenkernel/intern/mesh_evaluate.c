@@ -565,6 +565,16 @@ MLoopNorSpace *BKE_lnor_space_create(MLoopNorSpaceArray *lnors_spacearr)
   return BLI_memarena_calloc(lnors_spacearr->mem, sizeof(MLoopNorSpace));
 }
 
+/* Allocate several spaces at once, when they are filled from multiple threads. */
+static MLoopNorSpace *lnor_spaces_create(MLoopNorSpaceArray *lnors_spacearr, const int spaces_len)
+{
+  if (spaces_len == 0) {
+    return NULL;
+  }
+  lnors_spacearr->num_spaces += spaces_len;
+  return BLI_memarena_calloc(lnors_spacearr->mem, sizeof(MLoopNorSpace) * (size_t)spaces_len);
+}
+
 /* This threshold is a bit touchy (usual float precision issue), this value seems OK. */
 #define LNOR_SPACE_TRIGO_THRESHOLD (1.0f - 1e-4f)
 
@@ -774,8 +784,6 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
   }
 }
 
-#define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
-
 typedef struct LoopSplitTaskData {
   /* Specific to each instance (each task). */
 
@@ -824,10 +832,23 @@ typedef struct LoopSplitTaskDataCommon {
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
-static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
-                                 const bool check_angle,
-                                 const float split_angle,
-                                 const bool do_sharp_edges_tag)
+/**
+ * Whether loop \a a comes before loop \a b when iterating over polygons, then their loops.
+ * Used to get the same results as a single-threaded iteration would.
+ */
+BLI_INLINE bool loop_split_loop_is_before(const int *loop_to_poly, const int a, const int b)
+{
+  return (loop_to_poly[a] < loop_to_poly[b]) || (loop_to_poly[a] == loop_to_poly[b] && a < b);
+}
+
+/* Below this many polygons, or without threads, edges are tagged in a single loop over polygons,
+ * which is much cheaper than the two parallel passes. */
+#define EDGES_SHARP_TAG_PARALLEL_MIN_POLYS 16384
+
+static void mesh_edges_sharp_tag_serial(LoopSplitTaskDataCommon *data,
+                                        const bool check_angle,
+                                        const float split_angle,
+                                        const bool do_sharp_edges_tag)
 {
   const MVert *mverts = data->mverts;
   const MEdge *medges = data->medges;
@@ -931,6 +952,183 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
   }
 }
 
+typedef struct EdgesSharpTagData {
+  LoopSplitTaskDataCommon *common_data;
+  /** Number of loops using each edge. */
+  int *edge_users;
+  float split_angle_cos;
+  bool check_angle;
+  bool do_sharp_edges_tag;
+} EdgesSharpTagData;
+
+/* While polygons are mapped, edge_to_loops holds the lowest and highest loop index using each
+ * edge plus one, zero meaning no loop yet. Keeping the extremes makes the result independent of
+ * the order in which threads reach the loops. */
+BLI_INLINE void edge_to_loops_atomic_min(int *v, const int value)
+{
+  int old = *v;
+  while (old == 0 || value < old) {
+    const int prev = atomic_cas_int32(v, old, value);
+    if (prev == old) {
+      break;
+    }
+    old = prev;
+  }
+}
+
+BLI_INLINE void edge_to_loops_atomic_max(int *v, const int value)
+{
+  int old = *v;
+  while (value > old) {
+    const int prev = atomic_cas_int32(v, old, value);
+    if (prev == old) {
+      break;
+    }
+    old = prev;
+  }
+}
+
+static void mesh_edges_sharp_tag_poly_cb(void *__restrict userdata,
+                                         const int mp_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgesSharpTagData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+
+  const MVert *mverts = common_data->mverts;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+
+  float(*loopnors)[3] = common_data->loopnors; /* Note: loopnors may be NULL here. */
+  int(*edge_to_loops)[2] = common_data->edge_to_loops;
+  int *loop_to_poly = common_data->loop_to_poly;
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+
+    loop_to_poly[ml_curr_index] = mp_index;
+
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * this way we don't have to compute those later!
+     */
+    if (loopnors) {
+      normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
+    }
+
+    atomic_fetch_and_add_int32(&data->edge_users[ml_curr->e], 1);
+    edge_to_loops_atomic_min(&edge_to_loops[ml_curr->e][0], ml_curr_index + 1);
+    edge_to_loops_atomic_max(&edge_to_loops[ml_curr->e][1], ml_curr_index + 1);
+  }
+}
+
+static void mesh_edges_sharp_tag_edge_cb(void *__restrict userdata,
+                                         const int me_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgesSharpTagData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const float(*polynors)[3] = common_data->polynors;
+  const int *loop_to_poly = common_data->loop_to_poly;
+
+  /* Only written to when tagging sharp edges, each edge from a single thread. */
+  MEdge *me = (MEdge *)&common_data->medges[me_index];
+  int *e2l = common_data->edge_to_loops[me_index];
+  const int edge_users = data->edge_users[me_index];
+
+  if (edge_users == 0) {
+    /* Loose edge, both values stay at zero. */
+    return;
+  }
+
+  e2l[0] -= 1;
+  e2l[1] -= 1;
+
+  if (edge_users > 2) {
+    /* More than two loops using this edge, tag as sharp. The lowest loop index is kept. */
+    e2l[1] = INDEX_INVALID;
+    return;
+  }
+
+  if (edge_users == 2 && loop_split_loop_is_before(loop_to_poly, e2l[1], e2l[0])) {
+    SWAP(int, e2l[0], e2l[1]);
+  }
+
+  const int mp_first_index = loop_to_poly[e2l[0]];
+  if (!(mpolys[mp_first_index].flag & ME_SMOOTH)) {
+    /* First loop of a flat face, the edge can't be smooth. */
+    e2l[1] = INDEX_INVALID;
+    return;
+  }
+  if (edge_users == 1) {
+    /* Only one loop, unset until now. */
+    e2l[1] = INDEX_UNSET;
+    return;
+  }
+
+  const int mp_index = loop_to_poly[e2l[1]];
+  const bool is_angle_sharp = (data->check_angle &&
+                               dot_v3v3(polynors[mp_first_index], polynors[mp_index]) <
+                                   data->split_angle_cos);
+
+  /* Second loop using this edge, time to test its sharpness.
+   * An edge is sharp if it is tagged as such, or its face is not smooth,
+   * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
+   * same vertex, or angle between both its polys' normals is above split_angle value.
+   */
+  if (!(mpolys[mp_index].flag & ME_SMOOTH) || (me->flag & ME_SHARP) ||
+      mloops[e2l[1]].v == mloops[e2l[0]].v || is_angle_sharp) {
+    e2l[1] = INDEX_INVALID;
+
+    /* We want to avoid tagging edges as sharp when it is already defined as such by
+     * other causes than angle threshold... */
+    if (data->do_sharp_edges_tag && is_angle_sharp) {
+      me->flag |= ME_SHARP;
+    }
+  }
+}
+
+static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
+                                 const bool check_angle,
+                                 const float split_angle,
+                                 const bool do_sharp_edges_tag)
+{
+#ifdef WITH_TBB
+  const bool use_threading = (data->numPolys >= EDGES_SHARP_TAG_PARALLEL_MIN_POLYS &&
+                              BLI_task_scheduler_num_threads() > 1);
+#else
+  const bool use_threading = false;
+#endif
+
+  if (!use_threading) {
+    mesh_edges_sharp_tag_serial(data, check_angle, split_angle, do_sharp_edges_tag);
+    return;
+  }
+
+  EdgesSharpTagData tag_data = {
+      .common_data = data,
+      .edge_users = MEM_calloc_arrayN((size_t)data->numEdges, sizeof(int), __func__),
+      .split_angle_cos = check_angle ? cosf(split_angle) : -1.0f,
+      .check_angle = check_angle,
+      .do_sharp_edges_tag = do_sharp_edges_tag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  /* Map edges to their loops, the order in which the loops are found does not matter. */
+  BLI_task_parallel_range(0, data->numPolys, &tag_data, mesh_edges_sharp_tag_poly_cb, &settings);
+  /* Check which edges are smooth, with both loops ordered as they are in polygons. */
+  BLI_task_parallel_range(0, data->numEdges, &tag_data, mesh_edges_sharp_tag_edge_cb, &settings);
+
+  MEM_freeN(tag_data.edge_users);
+}
+
 /**
  * Define sharp edges as needed to mimic 'autosmooth' from angle threshold.
  *
@@ -1316,83 +1514,53 @@ static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
-{
-  LoopSplitTaskDataCommon *common_data = BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                NULL;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A NULL ml_curr is used to tag ended data! */
-    if (data->ml_curr == NULL) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
 /**
- * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
- * Needed because cyclic smooth fans have no obvious 'entry point',
- * and yet we need to walk them once, and only once.
+ * Walk the smooth fan starting at given loop the same way #split_loop_nor_fan_do does,
+ * tagging its loops as visited. The walk stops at the first sharp edge, or at the first loop
+ * already visited by a previous walk, which can only have ended at a sharp edge.
+ * Returns true when the walk went all around the vertex, i.e. the fan is cyclic.
  */
-static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
-                                                         const MPoly *mpolys,
-                                                         const int (*edge_to_loops)[2],
-                                                         const int *loop_to_poly,
-                                                         const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
-                                                         const MLoop *ml_curr,
-                                                         const MLoop *ml_prev,
-                                                         const int ml_curr_index,
-                                                         const int ml_prev_index,
-                                                         const int mp_curr_index)
+static bool loop_split_fan_tag_visited(const LoopSplitTaskDataCommon *common_data,
+                                       const int ml_curr_index,
+                                       const int ml_prev_index,
+                                       const int mp_curr_index,
+                                       bool *loop_visited)
 {
+  const MLoop *mloops = common_data->mloops;
+  const int(*edge_to_loops)[2] = (const int(*)[2])common_data->edge_to_loops;
+  const int *loop_to_poly = common_data->loop_to_poly;
+
+  const MLoop *ml_curr = &mloops[ml_curr_index];
   const unsigned int mv_pivot_index = ml_curr->v; /* The vertex we are "fanning" around! */
   const int *e2lfan_curr;
   const MLoop *mlfan_curr;
   /* mlfan_vert_index: the loop of our current edge might not be the loop of our current vertex! */
   int mlfan_curr_index, mlfan_vert_index, mpfan_curr_index;
 
-  e2lfan_curr = e2l_prev;
-  if (IS_EDGE_SHARP(e2lfan_curr)) {
-    /* Sharp loop, so not a cyclic smooth fan... */
-    return false;
-  }
-
-  mlfan_curr = ml_prev;
+  mlfan_curr = &mloops[ml_prev_index];
+  e2lfan_curr = edge_to_loops[mlfan_curr->e];
   mlfan_curr_index = ml_prev_index;
   mlfan_vert_index = ml_curr_index;
   mpfan_curr_index = mp_curr_index;
 
-  BLI_assert(mlfan_curr_index >= 0);
-  BLI_assert(mlfan_vert_index >= 0);
-  BLI_assert(mpfan_curr_index >= 0);
+  /* The bound only guards against walking forever on invalid geometry. */
+  for (int i = 0; i < common_data->numLoops; i++) {
+    if (loop_visited[mlfan_vert_index]) {
+      return false;
+    }
+    loop_visited[mlfan_vert_index] = true;
 
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+    if (IS_EDGE_SHARP(e2lfan_curr)) {
+      return false;
+    }
+    if (mlfan_curr->e == ml_curr->e) {
+      /* We have completed a full turn around the vertex. */
+      return true;
+    }
 
-  while (true) {
     /* Find next loop of the smooth fan. */
     BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
-                                                mpolys,
+                                                common_data->mpolys,
                                                 loop_to_poly,
                                                 e2lfan_curr,
                                                 mv_pivot_index,
@@ -1402,202 +1570,188 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
                                                 &mpfan_curr_index);
 
     e2lfan_curr = edge_to_loops[mlfan_curr->e];
-
-    if (IS_EDGE_SHARP(e2lfan_curr)) {
-      /* Sharp loop/edge, so not a cyclic smooth fan... */
-      return false;
-    }
-    /* Smooth loop/edge... */
-    if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-      if (mlfan_vert_index == ml_curr_index) {
-        /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
-         * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
-        return true;
-      }
-      /* ... already checked in some previous looping, we can abort. */
-      return false;
-    }
-
-    /* ... we can skip it in future, and keep checking the smooth fan. */
-    BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
   }
+  return false;
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
-{
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
-
-  const MLoop *mloops = common_data->mloops;
-  const MPoly *mpolys = common_data->mpolys;
-  const int *loop_to_poly = common_data->loop_to_poly;
-  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
-  const int numLoops = common_data->numLoops;
-  const int numPolys = common_data->numPolys;
-
-  const MPoly *mp;
-  int mp_index;
+typedef struct LoopSplitFansData {
+  LoopSplitTaskDataCommon *common_data;
+  /** Per loop, whether it is the entry point of a fan. */
+  bool *loop_is_fan_start;
+  /** Per loop, whether a fan walk went through it. */
+  bool *loop_visited;
+  /** Per poly, number of fans starting in it, then index of its first fan. */
+  int *poly_fans_offset;
+  /** Normal space of each fan, in polygons order. */
+  MLoopNorSpace *lnor_spaces;
+} LoopSplitFansData;
+
+typedef struct LoopSplitFansTLS {
+  /* Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+} LoopSplitFansTLS;
 
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
-  int ml_curr_index;
-  int ml_prev_index;
+static void loop_split_fans_find_cb(void *__restrict userdata,
+                                    const int mp_index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitFansData *data = userdata;
+  const MLoop *mloops = data->common_data->mloops;
+  const int(*edge_to_loops)[2] = (const int(*)[2])data->common_data->edge_to_loops;
+  const MPoly *mp = &data->common_data->mpolys[mp_index];
 
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int fans_len = 0;
 
-  LoopSplitTaskData *data_buff = NULL;
-  int data_idx = 0;
+  /* Loops with a sharp edge are the entry point of their fan, cyclic fans are found later. */
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const bool is_start = IS_EDGE_SHARP(edge_to_loops[mloops[ml_curr_index].e]);
+    data->loop_is_fan_start[ml_curr_index] = is_start;
+    fans_len += is_start;
+  }
+  data->poly_fans_offset[mp_index] = fans_len;
+}
 
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = NULL;
+/**
+ * Cyclic smooth fans have no obvious 'entry point', yet we need to walk them once, and only once.
+ * Use their first loop in polygons order, which also keeps the reference vector of their normal
+ * spaces stable, custom normals depend on it. Walks stop at loops visited before, so every loop
+ * is walked once.
+ */
+static void loop_split_fans_find_cyclic(LoopSplitFansData *data)
+{
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
 
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_generator);
-#endif
+  for (int mp_index = 0; mp_index < common_data->numPolys; mp_index++) {
+    const MPoly *mp = &common_data->mpolys[mp_index];
+    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+    int ml_prev_index = ml_last_index;
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+    for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+      if (loop_split_fan_tag_visited(
+              common_data, ml_curr_index, ml_prev_index, mp_index, data->loop_visited)) {
+        data->loop_is_fan_start[ml_curr_index] = true;
+        data->poly_fans_offset[mp_index]++;
+      }
+      ml_prev_index = ml_curr_index;
     }
   }
+}
 
-  /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
-   */
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
-    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-    ml_curr_index = mp->loopstart;
-    ml_prev_index = ml_last_index;
+static void loop_split_fans_do_cb(void *__restrict userdata,
+                                  const int mp_index,
+                                  const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitFansData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  LoopSplitFansTLS *tls_data = tls->userdata_chunk;
 
-    ml_curr = &mloops[ml_curr_index];
-    ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
+  const MLoop *mloops = common_data->mloops;
+  const int(*edge_to_loops)[2] = (const int(*)[2])common_data->edge_to_loops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_prev_index = ml_last_index;
+  int fan_index = data->poly_fans_offset[mp_index];
+
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    if (data->loop_is_fan_start[ml_curr_index]) {
+      const MLoop *ml_curr = &mloops[ml_curr_index];
+      const MLoop *ml_prev = &mloops[ml_prev_index];
       const int *e2l_curr = edge_to_loops[ml_curr->e];
       const int *e2l_prev = edge_to_loops[ml_prev->e];
 
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
+      LoopSplitTaskData task_data = {
+          .ml_curr = ml_curr,
+          .ml_prev = ml_prev,
+          .ml_curr_index = ml_curr_index,
+          .mp_index = mp_index,
+      };
 
-      /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
-
-      /* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
-       * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
-       * the vert during actual computation of clnor & clnorspace. However, this would complicate
-       * the code, add more memory usage, and despite its logical complexity,
-       * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
-       * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
+      if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+        task_data.lnor = &common_data->loopnors[ml_curr_index];
       }
+      /* We *do not need* to check/tag loops as already computed!
+       * Due to the fact a loop only links to one of its two edges,
+       * a same fan *will never be walked more than once!*
+       * Since we consider edges having neighbor polys with inverted
+       * (flipped) normals as sharp, we are sure that no fan will be skipped,
+       * even only considering the case (sharp curr_edge, smooth prev_edge),
+       * and not the alternative (smooth curr_edge, sharp prev_edge).
+       * All this due/thanks to link between normals and loop ordering (i.e. winding).
+       */
       else {
-        LoopSplitTaskData *data, data_local;
-
-        //              printf("PROCESSING!\n");
+        task_data.ml_prev_index = ml_prev_index;
+        task_data.e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
 
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
-
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = NULL; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-        /* We *do not need* to check/tag loops as already computed!
-         * Due to the fact a loop only links to one of its two edges,
-         * a same fan *will never be walked more than once!*
-         * Since we consider edges having neighbor polys with inverted
-         * (flipped) normals as sharp, we are sure that no fan will be skipped,
-         * even only considering the case (sharp curr_edge, smooth prev_edge),
-         * and not the alternative (smooth curr_edge, sharp prev_edge).
-         * All this due/thanks to link between normals and loop ordering (i.e. winding).
-         */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
+        if (common_data->lnors_spacearr && tls_data->edge_vectors == NULL) {
+          tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
         }
+      }
 
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
-        }
+      if (common_data->lnors_spacearr) {
+        task_data.lnor_space = &data->lnor_spaces[fan_index++];
       }
 
-      ml_prev = ml_curr;
-      ml_prev_index = ml_curr_index;
+      loop_split_worker_do(common_data, &task_data, tls_data->edge_vectors);
     }
+    ml_prev_index = ml_curr_index;
   }
+}
 
-  /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
+static void loop_split_fans_free_cb(const void *__restrict UNUSED(userdata),
+                                    void *__restrict chunk)
+{
+  LoopSplitFansTLS *tls_data = chunk;
+  if (tls_data->edge_vectors) {
+    BLI_stack_free(tls_data->edge_vectors);
   }
+}
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
+/**
+ * Find the smooth fans of all loops, then compute their normals in parallel over polygons.
+ */
+static void loop_split_fans_compute(LoopSplitTaskDataCommon *common_data)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+  const int numPolys = common_data->numPolys;
+
+  LoopSplitFansData data = {
+      .common_data = common_data,
+      .loop_is_fan_start = MEM_malloc_arrayN(
+          (size_t)common_data->numLoops, sizeof(bool), __func__),
+      .loop_visited = MEM_calloc_arrayN((size_t)common_data->numLoops, sizeof(bool), __func__),
+      .poly_fans_offset = MEM_malloc_arrayN((size_t)numPolys, sizeof(int), __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_fans_find_cb, &settings);
+  loop_split_fans_find_cyclic(&data);
+
+  /* Normal spaces are allocated here, since memarena is not threadsafe. */
+  int fans_len = 0;
+  for (int mp_index = 0; mp_index < numPolys; mp_index++) {
+    const int poly_fans_len = data.poly_fans_offset[mp_index];
+    data.poly_fans_offset[mp_index] = fans_len;
+    fans_len += poly_fans_len;
+  }
+  if (lnors_spacearr) {
+    data.lnor_spaces = lnor_spaces_create(lnors_spacearr, fans_len);
   }
-  MEM_freeN(skip_loops);
 
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_generator);
-#endif
+  LoopSplitFansTLS tls_data = {NULL};
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = loop_split_fans_free_cb;
+
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_fans_do_cb, &settings);
+
+  MEM_freeN(data.loop_is_fan_start);
+  MEM_freeN(data.loop_visited);
+  MEM_freeN(data.poly_fans_offset);
 }
 
 /**
@@ -1714,19 +1868,8 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
-
-    loop_split_generator(task_pool, &common_data);
-
-    BLI_task_pool_work_and_wait(task_pool);
-
-    BLI_task_pool_free(task_pool);
-  }
+  /* Now, time to generate the normals. */
+  loop_split_fans_compute(&common_data);
 
   MEM_freeN(edge_to_loops);
   if (!r_loop_to_poly) {
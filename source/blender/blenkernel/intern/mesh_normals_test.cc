@@ -0,0 +1,428 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_linklist.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "BKE_mesh.h"
+
+#include "PIL_time.h"
+
+#define DO_PERF_TESTS 0
+
+namespace blender::bke::tests {
+
+/**
+ * Grid of `size * size` quads, with a bumpy surface so that some edges are sharp by angle.
+ */
+struct GridMesh {
+  int size;
+  int verts_len, edges_len, loops_len, polys_len;
+  MVert *mvert;
+  MEdge *medge;
+  MLoop *mloop;
+  MPoly *mpoly;
+  float (*poly_nors)[3];
+  float (*loop_nors)[3];
+
+  GridMesh(const int size, const float bump, const bool smooth) : size(size)
+  {
+    verts_len = (size + 1) * (size + 1);
+    edges_len = 2 * size * (size + 1);
+    polys_len = size * size;
+    loops_len = polys_len * 4;
+
+    mvert = (MVert *)MEM_calloc_arrayN(verts_len, sizeof(MVert), __func__);
+    medge = (MEdge *)MEM_calloc_arrayN(edges_len, sizeof(MEdge), __func__);
+    mloop = (MLoop *)MEM_calloc_arrayN(loops_len, sizeof(MLoop), __func__);
+    mpoly = (MPoly *)MEM_calloc_arrayN(polys_len, sizeof(MPoly), __func__);
+    poly_nors = (float(*)[3])MEM_malloc_arrayN(polys_len, sizeof(float[3]), __func__);
+    loop_nors = (float(*)[3])MEM_malloc_arrayN(loops_len, sizeof(float[3]), __func__);
+
+    RNG *rng = BLI_rng_new(0);
+    for (int y = 0; y <= size; y++) {
+      for (int x = 0; x <= size; x++) {
+        float *co = mvert[vert_index(x, y)].co;
+        co[0] = (float)x;
+        co[1] = (float)y;
+        co[2] = ((x % 5) == 0 ? bump : 0.0f) + BLI_rng_get_float(rng) * 0.1f;
+      }
+    }
+    BLI_rng_free(rng);
+
+    for (int y = 0; y <= size; y++) {
+      for (int x = 0; x < size; x++) {
+        medge[edge_x_index(x, y)].v1 = (uint)vert_index(x, y);
+        medge[edge_x_index(x, y)].v2 = (uint)vert_index(x + 1, y);
+      }
+    }
+    for (int x = 0; x <= size; x++) {
+      for (int y = 0; y < size; y++) {
+        medge[edge_y_index(x, y)].v1 = (uint)vert_index(x, y);
+        medge[edge_y_index(x, y)].v2 = (uint)vert_index(x, y + 1);
+      }
+    }
+
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        const int poly_index = y * size + x;
+        MPoly *mp = &mpoly[poly_index];
+        mp->loopstart = poly_index * 4;
+        mp->totloop = 4;
+        mp->flag = smooth ? ME_SMOOTH : 0;
+
+        MLoop *ml = &mloop[mp->loopstart];
+        ml[0].v = (uint)vert_index(x, y);
+        ml[0].e = (uint)edge_x_index(x, y);
+        ml[1].v = (uint)vert_index(x + 1, y);
+        ml[1].e = (uint)edge_y_index(x + 1, y);
+        ml[2].v = (uint)vert_index(x + 1, y + 1);
+        ml[2].e = (uint)edge_x_index(x, y + 1);
+        ml[3].v = (uint)vert_index(x, y + 1);
+        ml[3].e = (uint)edge_y_index(x, y);
+      }
+    }
+
+    BKE_mesh_calc_normals_poly(
+        mvert, NULL, verts_len, mloop, mpoly, loops_len, polys_len, poly_nors, false);
+  }
+
+  ~GridMesh()
+  {
+    MEM_freeN(mvert);
+    MEM_freeN(medge);
+    MEM_freeN(mloop);
+    MEM_freeN(mpoly);
+    MEM_freeN(poly_nors);
+    MEM_freeN(loop_nors);
+  }
+
+  int vert_index(const int x, const int y) const
+  {
+    return y * (size + 1) + x;
+  }
+  int edge_x_index(const int x, const int y) const
+  {
+    return y * size + x;
+  }
+  int edge_y_index(const int x, const int y) const
+  {
+    return size * (size + 1) + x * size + y;
+  }
+
+  void normals_loop_split(const float split_angle,
+                          MLoopNorSpaceArray *lnors_spacearr,
+                          short (*clnors)[2])
+  {
+    BKE_mesh_normals_loop_split(mvert,
+                                verts_len,
+                                medge,
+                                edges_len,
+                                mloop,
+                                loop_nors,
+                                loops_len,
+                                mpoly,
+                                poly_nors,
+                                polys_len,
+                                true,
+                                split_angle,
+                                lnors_spacearr,
+                                clnors,
+                                NULL);
+  }
+};
+
+TEST(mesh_normals, LoopSplitFlat)
+{
+  GridMesh grid(32, 1.0f, false);
+  grid.normals_loop_split((float)M_PI, NULL, NULL);
+
+  for (int i = 0; i < grid.loops_len; i++) {
+    const int poly_index = i / 4;
+    EXPECT_V3_NEAR(grid.loop_nors[i], grid.poly_nors[poly_index], 1e-6f);
+  }
+}
+
+TEST(mesh_normals, LoopSplitSmooth)
+{
+  GridMesh grid(32, 1.0f, true);
+  grid.normals_loop_split((float)M_PI, NULL, NULL);
+
+  /* Without sharp edges, all loops of a vertex form a single fan using the vertex normal. */
+  for (int i = 0; i < grid.loops_len; i++) {
+    float vert_no[3];
+    normal_short_to_float_v3(vert_no, grid.mvert[grid.mloop[i].v].no);
+    EXPECT_V3_NEAR(grid.loop_nors[i], vert_no, 1e-3f);
+  }
+}
+
+TEST(mesh_normals, LoopSplitSharpEdges)
+{
+  GridMesh grid(32, 1.0f, true);
+  const int sharp_x = 8;
+  for (int y = 0; y < grid.size; y++) {
+    grid.medge[grid.edge_y_index(sharp_x, y)].flag |= ME_SHARP;
+  }
+
+  MLoopNorSpaceArray lnors_spacearr = {NULL};
+  grid.normals_loop_split((float)M_PI, &lnors_spacearr, NULL);
+
+  for (int y = 0; y < grid.size; y++) {
+    for (int x = 0; x < grid.size; x++) {
+      const MPoly *mp = &grid.mpoly[y * grid.size + x];
+      for (int i = mp->loopstart; i < mp->loopstart + mp->totloop; i++) {
+        const MLoop *ml = &grid.mloop[i];
+        const int ml_x = (int)ml->v % (grid.size + 1);
+        const MLoopNorSpace *lnor_space = lnors_spacearr.lspacearr[i];
+        ASSERT_NE(lnor_space, nullptr);
+        EXPECT_V3_NEAR(grid.loop_nors[i], lnor_space->vec_lnor, 1e-5f);
+
+        /* Loops on the sharp column only share their fan with loops on the same side. */
+        if (ml_x == sharp_x && !(lnor_space->flags & MLNOR_SPACE_IS_SINGLE)) {
+          const bool is_left = (x < sharp_x);
+          for (LinkNode *link = lnor_space->loops; link; link = link->next) {
+            const int fan_loop = POINTER_AS_INT(link->link);
+            const int fan_x = (fan_loop / 4) % grid.size;
+            EXPECT_EQ(fan_x < sharp_x, is_left);
+          }
+        }
+      }
+    }
+  }
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+}
+
+TEST(mesh_normals, LoopSplitCustomNormals)
+{
+  GridMesh grid(32, 1.0f, true);
+
+  float(*vert_nors)[3] = (float(*)[3])MEM_malloc_arrayN(
+      grid.verts_len, sizeof(float[3]), __func__);
+  for (int i = 0; i < grid.verts_len; i++) {
+    const float tilt = (float)(i % 7) * 0.05f;
+    copy_v3_fl3(vert_nors[i], tilt, -tilt, 1.0f);
+    normalize_v3(vert_nors[i]);
+  }
+
+  short(*clnors)[2] = (short(*)[2])MEM_calloc_arrayN(grid.loops_len, sizeof(short[2]), __func__);
+  BKE_mesh_normals_loop_custom_from_vertices_set(grid.mvert,
+                                                 vert_nors,
+                                                 grid.verts_len,
+                                                 grid.medge,
+                                                 grid.edges_len,
+                                                 grid.mloop,
+                                                 grid.loops_len,
+                                                 grid.mpoly,
+                                                 grid.poly_nors,
+                                                 grid.polys_len,
+                                                 clnors);
+  grid.normals_loop_split((float)M_PI, NULL, clnors);
+
+  /* Custom normals are stored as two shorts, which limits their precision. */
+  for (int i = 0; i < grid.loops_len; i++) {
+    EXPECT_V3_NEAR(grid.loop_nors[i], vert_nors[grid.mloop[i].v], 1e-2f);
+  }
+
+  MEM_freeN(clnors);
+  MEM_freeN(vert_nors);
+}
+
+/**
+ * Cone of `size` smooth triangles around a single pole vertex, which has one loop per triangle.
+ */
+struct PoleMesh {
+  int size;
+  int verts_len, edges_len, loops_len, polys_len;
+  MVert *mvert;
+  MEdge *medge;
+  MLoop *mloop;
+  MPoly *mpoly;
+  float (*poly_nors)[3];
+  float (*loop_nors)[3];
+
+  PoleMesh(const int size) : size(size)
+  {
+    verts_len = size + 1;
+    edges_len = size * 2;
+    polys_len = size;
+    loops_len = size * 3;
+
+    mvert = (MVert *)MEM_calloc_arrayN(verts_len, sizeof(MVert), __func__);
+    medge = (MEdge *)MEM_calloc_arrayN(edges_len, sizeof(MEdge), __func__);
+    mloop = (MLoop *)MEM_calloc_arrayN(loops_len, sizeof(MLoop), __func__);
+    mpoly = (MPoly *)MEM_calloc_arrayN(polys_len, sizeof(MPoly), __func__);
+    poly_nors = (float(*)[3])MEM_malloc_arrayN(polys_len, sizeof(float[3]), __func__);
+    loop_nors = (float(*)[3])MEM_malloc_arrayN(loops_len, sizeof(float[3]), __func__);
+
+    copy_v3_fl3(mvert[0].co, 0.0f, 0.0f, 1.0f);
+    for (int i = 0; i < size; i++) {
+      const float angle = (float)(2.0 * M_PI * i / size);
+      copy_v3_fl3(mvert[i + 1].co, cosf(angle), sinf(angle), 0.0f);
+    }
+
+    for (int i = 0; i < size; i++) {
+      const int i_next = (i + 1) % size;
+      /* Spoke from the pole, then rim edge. */
+      medge[i].v1 = 0;
+      medge[i].v2 = (uint)(i + 1);
+      medge[size + i].v1 = (uint)(i + 1);
+      medge[size + i].v2 = (uint)(i_next + 1);
+
+      MPoly *mp = &mpoly[i];
+      mp->loopstart = i * 3;
+      mp->totloop = 3;
+      mp->flag = ME_SMOOTH;
+
+      MLoop *ml = &mloop[mp->loopstart];
+      ml[0].v = 0;
+      ml[0].e = (uint)i;
+      ml[1].v = (uint)(i + 1);
+      ml[1].e = (uint)(size + i);
+      ml[2].v = (uint)(i_next + 1);
+      ml[2].e = (uint)i_next;
+    }
+
+    BKE_mesh_calc_normals_poly(
+        mvert, NULL, verts_len, mloop, mpoly, loops_len, polys_len, poly_nors, false);
+  }
+
+  ~PoleMesh()
+  {
+    MEM_freeN(mvert);
+    MEM_freeN(medge);
+    MEM_freeN(mloop);
+    MEM_freeN(mpoly);
+    MEM_freeN(poly_nors);
+    MEM_freeN(loop_nors);
+  }
+
+  void normals_loop_split(MLoopNorSpaceArray *lnors_spacearr)
+  {
+    BKE_mesh_normals_loop_split(mvert,
+                                verts_len,
+                                medge,
+                                edges_len,
+                                mloop,
+                                loop_nors,
+                                loops_len,
+                                mpoly,
+                                poly_nors,
+                                polys_len,
+                                true,
+                                (float)M_PI,
+                                lnors_spacearr,
+                                NULL,
+                                NULL);
+  }
+
+  /* Number of loops sharing the normal space of the pole loop of `poly_index`. */
+  int pole_fan_len(const MLoopNorSpaceArray *lnors_spacearr, const int poly_index) const
+  {
+    const MLoopNorSpace *lnor_space = lnors_spacearr->lspacearr[mpoly[poly_index].loopstart];
+    if (lnor_space->flags & MLNOR_SPACE_IS_SINGLE) {
+      return 1;
+    }
+    return BLI_linklist_count(lnor_space->loops);
+  }
+};
+
+/* All loops of a smooth pole form a single cyclic fan. */
+TEST(mesh_normals, LoopSplitPoleCyclic)
+{
+  PoleMesh pole(4096);
+  MLoopNorSpaceArray lnors_spacearr = {NULL};
+  pole.normals_loop_split(&lnors_spacearr);
+
+  const float up[3] = {0.0f, 0.0f, 1.0f};
+  const MLoopNorSpace *lnor_space = lnors_spacearr.lspacearr[0];
+  for (int i = 0; i < pole.polys_len; i++) {
+    const int pole_loop = pole.mpoly[i].loopstart;
+    EXPECT_EQ(lnors_spacearr.lspacearr[pole_loop], lnor_space);
+    EXPECT_V3_NEAR(pole.loop_nors[pole_loop], up, 1e-3f);
+  }
+  EXPECT_EQ(pole.pole_fan_len(&lnors_spacearr, 0), pole.polys_len);
+  /* The pole and every rim vertex have one fan each. */
+  EXPECT_EQ(lnors_spacearr.num_spaces, pole.verts_len);
+
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+}
+
+/* Sharp spokes split the fan of the pole, each part starts at a sharp spoke. */
+TEST(mesh_normals, LoopSplitPoleSharp)
+{
+  PoleMesh pole(4096);
+  const int sharp_spokes[3] = {0, 1000, 3000};
+  for (const int spoke : sharp_spokes) {
+    pole.medge[spoke].flag |= ME_SHARP;
+  }
+
+  MLoopNorSpaceArray lnors_spacearr = {NULL};
+  pole.normals_loop_split(&lnors_spacearr);
+
+  /* Triangle `i` lies between spokes `i` and `i + 1`. */
+  EXPECT_EQ(pole.pole_fan_len(&lnors_spacearr, 0), 1000);
+  EXPECT_EQ(pole.pole_fan_len(&lnors_spacearr, 1000), 2000);
+  EXPECT_EQ(pole.pole_fan_len(&lnors_spacearr, 3000), 1096);
+  EXPECT_EQ(lnors_spacearr.lspacearr[pole.mpoly[0].loopstart],
+            lnors_spacearr.lspacearr[pole.mpoly[999].loopstart]);
+  EXPECT_NE(lnors_spacearr.lspacearr[pole.mpoly[999].loopstart],
+            lnors_spacearr.lspacearr[pole.mpoly[1000].loopstart]);
+
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+}
+
+#if DO_PERF_TESTS
+
+/* -------------------------------------------------------------------- */
+/* Benchmarks on a large grid, with auto-smooth and with custom normals. */
+
+TEST(mesh_normals, LoopSplitBenchmark)
+{
+  GridMesh grid(1000, 1.0f, true);
+
+  double time_start = PIL_check_seconds_timer();
+  grid.normals_loop_split(DEG2RADF(30.0f), NULL, NULL);
+  printf("%d polygons, auto-smooth: %7.2f ms\n",
+         grid.polys_len,
+         (PIL_check_seconds_timer() - time_start) * 1000.0);
+
+  short(*clnors)[2] = (short(*)[2])MEM_calloc_arrayN(grid.loops_len, sizeof(short[2]), __func__);
+  MLoopNorSpaceArray lnors_spacearr = {NULL};
+  time_start = PIL_check_seconds_timer();
+  grid.normals_loop_split((float)M_PI, &lnors_spacearr, clnors);
+  printf("%d polygons, custom normals: %7.2f ms\n",
+         grid.polys_len,
+         (PIL_check_seconds_timer() - time_start) * 1000.0);
+
+  EXPECT_GT(lnors_spacearr.num_spaces, 0);
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+  MEM_freeN(clnors);
+}
+
+#endif /* DO_PERF_TESTS */
+
+}  // namespace blender::bke::tests
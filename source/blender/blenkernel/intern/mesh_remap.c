@@ -77,6 +77,58 @@ static bool mesh_remap_bvhtree_query_nearest(BVHTreeFromMesh *treedata,
   return false;
 }
 
+/* Same as #mesh_remap_bvhtree_query_nearest for many points at once, nearby points are searched
+ * together. Items further than `max_dist_sq` keep a -1 index. */
+static BVHTreeNearest *mesh_remap_bvhtree_query_nearest_batch(BVHTreeFromMesh *treedata,
+                                                              const float (*co)[3],
+                                                              const int co_len,
+                                                              const float max_dist_sq)
+{
+  BVHTreeNearest *nearest = MEM_malloc_arrayN((size_t)co_len, sizeof(*nearest), __func__);
+
+  for (int i = 0; i < co_len; i++) {
+    nearest[i].index = -1;
+    nearest[i].dist_sq = max_dist_sq;
+  }
+  BLI_bvhtree_find_nearest_batch(
+      treedata->tree, co, co_len, nearest, treedata->nearest_callback, treedata, 0);
+
+  return nearest;
+}
+
+/* Coordinates of the vertices in tree space. */
+static float (*mesh_remap_verts_co_get(const MVert *verts,
+                                       const int numverts,
+                                       const SpaceTransform *space_transform))[3]
+{
+  float(*co)[3] = MEM_malloc_arrayN((size_t)numverts, sizeof(*co), __func__);
+
+  for (int i = 0; i < numverts; i++) {
+    copy_v3_v3(co[i], verts[i].co);
+    if (space_transform) {
+      BLI_space_transform_apply(space_transform, co[i]);
+    }
+  }
+  return co;
+}
+
+/* Coordinates of the middle of the edges in tree space. */
+static float (*mesh_remap_edges_co_get(const MVert *verts,
+                                       const MEdge *edges,
+                                       const int numedges,
+                                       const SpaceTransform *space_transform))[3]
+{
+  float(*co)[3] = MEM_malloc_arrayN((size_t)numedges, sizeof(*co), __func__);
+
+  for (int i = 0; i < numedges; i++) {
+    interp_v3_v3v3(co[i], verts[edges[i].v1].co, verts[edges[i].v2].co, 0.5f);
+    if (space_transform) {
+      BLI_space_transform_apply(space_transform, co[i]);
+    }
+  }
+  return co;
+}
+
 static bool mesh_remap_bvhtree_query_raycast(BVHTreeFromMesh *treedata,
                                              BVHTreeRayHit *rayhit,
                                              const float co[3],
@@ -517,51 +569,46 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
   }
   else {
     BVHTreeFromMesh treedata = {NULL};
-    BVHTreeNearest nearest = {0};
     BVHTreeRayHit rayhit = {0};
     float hit_dist;
     float tmp_co[3], tmp_no[3];
 
     if (mode == MREMAP_MODE_VERT_NEAREST) {
+      float(*vcos_dst)[3] = mesh_remap_verts_co_get(verts_dst, numverts_dst, space_transform);
+
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_VERTS, 2);
-      nearest.index = -1;
+      BVHTreeNearest *nearest_dst = mesh_remap_bvhtree_query_nearest_batch(
+          &treedata, (const float(*)[3])vcos_dst, numverts_dst, max_dist_sq);
 
       for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest.index, &full_weight);
+        if (nearest_dst[i].index != -1) {
+          hit_dist = sqrtf(nearest_dst[i].dist_sq);
+          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest_dst[i].index, &full_weight);
         }
         else {
           /* No source for this dest vertex! */
           BKE_mesh_remap_item_define_invalid(r_map, i);
         }
       }
+
+      MEM_freeN(nearest_dst);
+      MEM_freeN(vcos_dst);
     }
     else if (ELEM(mode, MREMAP_MODE_VERT_EDGE_NEAREST, MREMAP_MODE_VERT_EDGEINTERP_NEAREST)) {
       MEdge *edges_src = me_src->medge;
       float(*vcos_src)[3] = BKE_mesh_vert_coords_alloc(me_src, NULL);
+      float(*vcos_dst)[3] = mesh_remap_verts_co_get(verts_dst, numverts_dst, space_transform);
 
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_EDGES, 2);
-      nearest.index = -1;
+      BVHTreeNearest *nearest_dst = mesh_remap_bvhtree_query_nearest_batch(
+          &treedata, (const float(*)[3])vcos_dst, numverts_dst, max_dist_sq);
 
       for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
+        copy_v3_v3(tmp_co, vcos_dst[i]);
 
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          MEdge *me = &edges_src[nearest.index];
+        if (nearest_dst[i].index != -1) {
+          MEdge *me = &edges_src[nearest_dst[i].index];
+          hit_dist = sqrtf(nearest_dst[i].dist_sq);
           const float *v1cos = vcos_src[me->v1];
           const float *v2cos = vcos_src[me->v2];
 
@@ -592,6 +639,8 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
         }
       }
 
+      MEM_freeN(nearest_dst);
+      MEM_freeN(vcos_dst);
       MEM_freeN(vcos_src);
     }
     else if (ELEM(mode,
@@ -645,27 +694,23 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
         }
       }
       else {
-        nearest.index = -1;
+        float(*vcos_dst)[3] = mesh_remap_verts_co_get(verts_dst, numverts_dst, space_transform);
+        BVHTreeNearest *nearest_dst = mesh_remap_bvhtree_query_nearest_batch(
+            &treedata, (const float(*)[3])vcos_dst, numverts_dst, max_dist_sq);
 
         for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
-
-          /* Convert the vertex to tree coordinates, if needed. */
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-          }
-
-          if (mesh_remap_bvhtree_query_nearest(
-                  &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[nearest.index];
+          if (nearest_dst[i].index != -1) {
+            const MLoopTri *lt = &treedata.looptri[nearest_dst[i].index];
             MPoly *mp = &polys_src[lt->poly];
 
+            hit_dist = sqrtf(nearest_dst[i].dist_sq);
+
             if (mode == MREMAP_MODE_VERT_POLY_NEAREST) {
               int index;
               mesh_remap_interp_poly_data_get(mp,
                                               loops_src,
                                               (const float(*)[3])vcos_src,
-                                              nearest.co,
+                                              nearest_dst[i].co,
                                               &tmp_buff_size,
                                               &vcos,
                                               false,
@@ -680,7 +725,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
               const int sources_num = mesh_remap_interp_poly_data_get(mp,
                                                                       loops_src,
                                                                       (const float(*)[3])vcos_src,
-                                                                      nearest.co,
+                                                                      nearest_dst[i].co,
                                                                       &tmp_buff_size,
                                                                       &vcos,
                                                                       false,
@@ -697,6 +742,9 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
             BKE_mesh_remap_item_define_invalid(r_map, i);
           }
         }
+
+        MEM_freeN(nearest_dst);
+        MEM_freeN(vcos_dst);
       }
 
       MEM_freeN(vcos_src);
@@ -874,52 +922,52 @@ void BKE_mesh_remap_calc_edges_from_mesh(const int mode,
       MEM_freeN(vert_to_edge_src_map_mem);
     }
     else if (mode == MREMAP_MODE_EDGE_NEAREST) {
+      float(*ecos_dst)[3] = mesh_remap_edges_co_get(
+          verts_dst, edges_dst, numedges_dst, space_transform);
+
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_EDGES, 2);
-      nearest.index = -1;
+      BVHTreeNearest *nearest_dst = mesh_remap_bvhtree_query_nearest_batch(
+          &treedata, (const float(*)[3])ecos_dst, numedges_dst, max_dist_sq);
 
       for (i = 0; i < numedges_dst; i++) {
-        interp_v3_v3v3(tmp_co, verts_dst[edges_dst[i].v1].co, verts_dst[edges_dst[i].v2].co, 0.5f);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest.index, &full_weight);
+        if (nearest_dst[i].index != -1) {
+          hit_dist = sqrtf(nearest_dst[i].dist_sq);
+          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest_dst[i].index, &full_weight);
         }
         else {
           /* No source for this dest edge! */
           BKE_mesh_remap_item_define_invalid(r_map, i);
         }
       }
+
+      MEM_freeN(nearest_dst);
+      MEM_freeN(ecos_dst);
     }
     else if (mode == MREMAP_MODE_EDGE_POLY_NEAREST) {
       MEdge *edges_src = me_src->medge;
       MPoly *polys_src = me_src->mpoly;
       MLoop *loops_src = me_src->mloop;
       float(*vcos_src)[3] = BKE_mesh_vert_coords_alloc(me_src, NULL);
+      float(*ecos_dst)[3] = mesh_remap_edges_co_get(
+          verts_dst, edges_dst, numedges_dst, space_transform);
 
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
+      BVHTreeNearest *nearest_dst = mesh_remap_bvhtree_query_nearest_batch(
+          &treedata, (const float(*)[3])ecos_dst, numedges_dst, max_dist_sq);
 
       for (i = 0; i < numedges_dst; i++) {
-        interp_v3_v3v3(tmp_co, verts_dst[edges_dst[i].v1].co, verts_dst[edges_dst[i].v2].co, 0.5f);
+        copy_v3_v3(tmp_co, ecos_dst[i]);
 
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          const MLoopTri *lt = &treedata.looptri[nearest.index];
+        if (nearest_dst[i].index != -1) {
+          const MLoopTri *lt = &treedata.looptri[nearest_dst[i].index];
           MPoly *mp_src = &polys_src[lt->poly];
           MLoop *ml_src = &loops_src[mp_src->loopstart];
           int nloops = mp_src->totloop;
           float best_dist_sq = FLT_MAX;
           int best_eidx_src = -1;
 
+          hit_dist = sqrtf(nearest_dst[i].dist_sq);
+
           for (; nloops--; ml_src++) {
             MEdge *med_src = &edges_src[ml_src->e];
             float *co1_src = vcos_src[med_src->v1];
@@ -944,6 +992,8 @@ void BKE_mesh_remap_calc_edges_from_mesh(const int mode,
         }
       }
 
+      MEM_freeN(nearest_dst);
+      MEM_freeN(ecos_dst);
       MEM_freeN(vcos_src);
     }
     else if (mode == MREMAP_MODE_EDGE_EDGEINTERP_VNORPROJ) {
@@ -74,6 +74,8 @@
 
 #include "GPU_texture.h"
 
+#include "PIL_time.h"
+
 #ifdef WITH_OPENEXR
 #  include "intern/openexr/openexr_multi.h"
 #endif
@@ -296,6 +298,7 @@ static void get_proxy_fname(
 typedef struct MultilayerConvertContext {
   float *combined_pass;
   int num_combined_channels;
+  bool has_combined_pass;
 } MultilayerConvertContext;
 
 static void *movieclip_convert_multilayer_add_view(void *UNUSED(ctx_v),
@@ -322,6 +325,10 @@ static void movieclip_convert_multilayer_add_pass(void *UNUSED(layer),
   /* NOTE: This function must free pass pixels data if it is not used, this
    * is how IMB_exr_multilayer_convert() is working. */
   MultilayerConvertContext *ctx = ctx_v;
+  /* Passes which are not read have no pixels. */
+  if (rect == NULL) {
+    return;
+  }
   /* If we've found a first combined pass, skip all the rest ones. */
   if (ctx->combined_pass != NULL) {
     MEM_freeN(rect);
@@ -336,6 +343,24 @@ static void movieclip_convert_multilayer_add_pass(void *UNUSED(layer),
   }
 }
 
+static bool movieclip_convert_multilayer_test_pass(void *ctx_v,
+                                                   const char *UNUSED(layer_name),
+                                                   const char *pass_name,
+                                                   const char *chan_id,
+                                                   const char *UNUSED(view_name))
+{
+  /* Only read the first combined pass, the others are never used. */
+  MultilayerConvertContext *ctx = ctx_v;
+  if (ctx->has_combined_pass) {
+    return false;
+  }
+  if (STREQ(pass_name, RE_PASSNAME_COMBINED) || STREQ(chan_id, "RGBA") || STREQ(chan_id, "RGB")) {
+    ctx->has_combined_pass = true;
+    return true;
+  }
+  return false;
+}
+
 #endif /* WITH_OPENEXR */
 
 /* Will try to make image buffer usable when originating from the multi-layer
@@ -354,11 +379,13 @@ void BKE_movieclip_convert_multilayer_ibuf(struct ImBuf *ibuf)
   MultilayerConvertContext ctx;
   ctx.combined_pass = NULL;
   ctx.num_combined_channels = 0;
+  ctx.has_combined_pass = false;
   IMB_exr_multilayer_convert(ibuf->userdata,
                              &ctx,
                              movieclip_convert_multilayer_add_view,
                              movieclip_convert_multilayer_add_layer,
-                             movieclip_convert_multilayer_add_pass);
+                             movieclip_convert_multilayer_add_pass,
+                             movieclip_convert_multilayer_test_pass);
   if (ctx.combined_pass != NULL) {
     BLI_assert(ibuf->rect_float == NULL);
     ibuf->rect_float = ctx.combined_pass;
@@ -671,8 +698,13 @@ static bool has_imbuf_cache(MovieClip *clip, MovieClipUser *user, int flag)
   return false;
 }
 
-static bool put_imbuf_cache(
-    MovieClip *clip, const MovieClipUser *user, ImBuf *ibuf, int flag, bool destructive)
+/* cost is the time in seconds it took to load the frame, 0 when unknown. */
+static bool put_imbuf_cache(MovieClip *clip,
+                            const MovieClipUser *user,
+                            ImBuf *ibuf,
+                            int flag,
+                            float cost,
+                            bool destructive)
 {
   MovieClipImBufCacheKey key;
 
@@ -719,11 +751,11 @@ static bool put_imbuf_cache(
   }
 
   if (destructive) {
-    IMB_moviecache_put(clip->cache->moviecache, &key, ibuf);
+    IMB_moviecache_put_ex(clip->cache->moviecache, &key, ibuf, cost);
     return true;
   }
 
-  return IMB_moviecache_put_if_possible(clip->cache->moviecache, &key, ibuf);
+  return IMB_moviecache_put_if_possible_ex(clip->cache->moviecache, &key, ibuf, cost);
 }
 
 static bool moviecache_check_free_proxy(ImBuf *UNUSED(ibuf), void *userkey, void *UNUSED(userdata))
@@ -1101,6 +1133,7 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
   }
 
   if (!ibuf) {
+    const double start_time = PIL_check_seconds_timer();
     bool use_sequence = false;
 
     /* undistorted proxies for movies should be read as image sequence */
@@ -1115,7 +1148,7 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
     }
 
     if (ibuf && (cache_flag & MOVIECLIP_CACHE_SKIP) == 0) {
-      put_imbuf_cache(clip, user, ibuf, flag, true);
+      put_imbuf_cache(clip, user, ibuf, flag, PIL_check_seconds_timer() - start_time, true);
     }
   }
 
@@ -1136,6 +1169,8 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
 
   BLI_thread_unlock(LOCK_MOVIECLIP);
 
+  IMB_moviecache_memory_pressure_check();
+
   /* Fallback render in case proxies are not enabled or built */
   if (!ibuf && user->render_flag & MCLIP_PROXY_RENDER_USE_FALLBACK_RENDER &&
       user->render_size != MCLIP_PROXY_RENDER_SIZE_FULL) {
@@ -1795,7 +1830,7 @@ bool BKE_movieclip_put_frame_if_possible(MovieClip *clip, MovieClipUser *user, I
   bool result;
 
   BLI_thread_lock(LOCK_MOVIECLIP);
-  result = put_imbuf_cache(clip, user, ibuf, clip->flag, false);
+  result = put_imbuf_cache(clip, user, ibuf, clip->flag, 0.0f, false);
   BLI_thread_unlock(LOCK_MOVIECLIP);
 
   return result;
@@ -1466,7 +1466,7 @@ ParticleSystem *BKE_object_copy_particlesystem(ParticleSystem *psys, const int f
   psysn->pdd = NULL;
   psysn->effectors = NULL;
   psysn->tree = NULL;
-  psysn->bvhtree = NULL;
+  psysn->sph_grid = NULL;
   psysn->batch_cache = NULL;
 
   BLI_listbase_clear(&psysn->pathcachebufs);
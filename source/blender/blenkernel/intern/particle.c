@@ -39,7 +39,6 @@
 #include "DNA_scene_types.h"
 
 #include "BLI_blenlib.h"
-#include "BLI_kdopbvh.h"
 #include "BLI_kdtree.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
@@ -827,7 +826,7 @@ void psys_free(Object *ob, ParticleSystem *psys)
 
     BLI_freelistN(&psys->targets);
 
-    BLI_bvhtree_free(psys->bvhtree);
+    psys_sph_grid_free(psys->sph_grid);
     BLI_kdtree_3d_free(psys->tree);
 
     if (psys->fluid_springs) {
@@ -25,6 +25,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_jitter_2d.h"
 #include "BLI_kdtree.h"
 #include "BLI_math.h"
@@ -810,12 +811,10 @@ static void exec_distribute_child(TaskPool *__restrict UNUSED(pool), void *taskd
   int p;
 
   /* RNG skipping at the beginning */
-  cpa = psys->child;
-  for (p = 0; p < task->begin; p++, cpa++) {
-    BLI_rng_skip(task->rng, PSYS_RND_DIST_SKIP);
-  }
+  BLI_rng_skip(task->rng, PSYS_RND_DIST_SKIP * task->begin);
 
-  for (; p < task->end; p++, cpa++) {
+  cpa = psys->child + task->begin;
+  for (p = task->begin; p < task->end; p++, cpa++) {
     distribute_children_exec(task, cpa, p);
   }
 }
@@ -876,6 +875,487 @@ static void distribute_invalid(ParticleSimulationData *sim, int from)
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Distribution Weights Cache
+ *
+ * Particles are assigned to emission elements by sampling the cumulative weights of the
+ * elements (face areas and the density vertex group). Computing them is as costly as the
+ * sampling for big emitters, so they are cached in the runtime data of the particle system
+ * modifier, keyed by a hash of everything they depend on. Edits of the particle count, seed or
+ * jittering only sample again.
+ *
+ * Weights and sums are computed in chunks of a fixed size, so results don't depend on the
+ * number of threads.
+ * \{ */
+
+#define DISTRIBUTE_CHUNK_SIZE 4096
+
+typedef struct ParticleDistributionWeights {
+  bool is_valid;
+  uint32_t key[2];
+  /* Normalized cumulative weights of the elements with a weight, and their element indices. */
+  float *element_sum;
+  int *element_map;
+  int totmapped;
+  float maxweight;
+} ParticleDistributionWeights;
+
+typedef struct ParticleDistributionCache {
+  /* Parents and children (distributed on faces with area weights) have separate weights. */
+  ParticleDistributionWeights weights[2];
+} ParticleDistributionCache;
+
+static void distribute_weights_clear(ParticleDistributionWeights *weights)
+{
+  MEM_SAFE_FREE(weights->element_sum);
+  MEM_SAFE_FREE(weights->element_map);
+  weights->totmapped = 0;
+  weights->is_valid = false;
+}
+
+void psys_distribution_cache_free(ParticleDistributionCache *cache)
+{
+  if (cache) {
+    for (int i = 0; i < ARRAY_SIZE(cache->weights); i++) {
+      distribute_weights_clear(&cache->weights[i]);
+    }
+    MEM_freeN(cache);
+  }
+}
+
+static ParticleDistributionCache *distribute_cache_ensure(ParticleSystemModifierData *psmd)
+{
+  if (psmd->modifier.runtime == NULL) {
+    psmd->modifier.runtime = MEM_callocN(sizeof(ParticleDistributionCache), __func__);
+  }
+  return psmd->modifier.runtime;
+}
+
+static int distribute_chunks_len(const int tot)
+{
+  return (tot + DISTRIBUTE_CHUNK_SIZE - 1) / DISTRIBUTE_CHUNK_SIZE;
+}
+
+typedef struct DistributeHashData {
+  const unsigned char *data;
+  size_t len;
+  uint32_t (*chunk_hash)[2];
+} DistributeHashData;
+
+/* Chunks of 64 KB, in pairs of different seeds to make collisions unlikely. */
+#define DISTRIBUTE_HASH_CHUNK_SIZE (1 << 16)
+
+static void distribute_hash_cb(void *__restrict userdata,
+                               const int chunk,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DistributeHashData *data = userdata;
+  const size_t start = (size_t)chunk * DISTRIBUTE_HASH_CHUNK_SIZE;
+  const size_t len = MIN2(data->len - start, DISTRIBUTE_HASH_CHUNK_SIZE);
+  data->chunk_hash[chunk][0] = BLI_hash_mm2(data->data + start, len, 0);
+  data->chunk_hash[chunk][1] = BLI_hash_mm2(data->data + start, len, 0x9E3779B9);
+}
+
+static void distribute_hash_add(uint32_t key[2], const void *data, const size_t len)
+{
+  const int chunks_len = (int)((len + DISTRIBUTE_HASH_CHUNK_SIZE - 1) /
+                               DISTRIBUTE_HASH_CHUNK_SIZE);
+  DistributeHashData hash_data = {data, len, NULL};
+  hash_data.chunk_hash = MEM_mallocN(sizeof(*hash_data.chunk_hash) * (size_t)(chunks_len + 1),
+                                     __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, chunks_len, &hash_data, distribute_hash_cb, &settings);
+
+  hash_data.chunk_hash[chunks_len][0] = key[0];
+  hash_data.chunk_hash[chunks_len][1] = key[1];
+  const size_t hash_len = sizeof(*hash_data.chunk_hash) * (size_t)(chunks_len + 1);
+  key[0] = BLI_hash_mm2((const unsigned char *)hash_data.chunk_hash, hash_len, (uint32_t)len);
+  key[1] = BLI_hash_mm2((const unsigned char *)hash_data.chunk_hash, hash_len, key[0]);
+  MEM_freeN(hash_data.chunk_hash);
+}
+
+typedef struct DistributeWeightsData {
+  const Mesh *mesh;
+  const MFace *mface;
+  const float (*orcodata)[3];
+  float orco_loc[3], orco_size[3];
+  const float *vweight;
+  int from, totelem;
+  bool use_area;
+  float uniform_weight;
+
+  float *element_weight;
+  double *chunk_sum;
+  float *chunk_max;
+  double inv_totweight;
+  float *element_cumsum;
+  int *chunk_mapped;
+  float *element_sum;
+  int *element_map;
+} DistributeWeightsData;
+
+static void distribute_face_co(const DistributeWeightsData *data, const uint v, float r_co[3])
+{
+  if (data->orcodata) {
+    /* Transform orcos from normalized 0..1 to object space. */
+    madd_v3_v3v3v3(r_co, data->orco_loc, data->orcodata[v], data->orco_size);
+  }
+  else {
+    copy_v3_v3(r_co, data->mesh->mvert[v].co);
+  }
+}
+
+/* Face areas (or uniform weights) of a chunk, their sum and the biggest one. */
+static void distribute_weights_area_cb(void *__restrict userdata,
+                                       const int chunk,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DistributeWeightsData *data = userdata;
+  const int start = chunk * DISTRIBUTE_CHUNK_SIZE;
+  const int end = min_ii(start + DISTRIBUTE_CHUNK_SIZE, data->totelem);
+  double sum = 0.0;
+  float max = 0.0f;
+
+  for (int i = start; i < end; i++) {
+    float cur = data->uniform_weight;
+    if (data->use_area) {
+      const MFace *mf = &data->mface[i];
+      float co1[3], co2[3], co3[3], co4[3];
+      distribute_face_co(data, mf->v1, co1);
+      distribute_face_co(data, mf->v2, co2);
+      distribute_face_co(data, mf->v3, co3);
+      if (mf->v4) {
+        distribute_face_co(data, mf->v4, co4);
+        cur = area_quad_v3(co1, co2, co3, co4);
+      }
+      else {
+        cur = area_tri_v3(co1, co2, co3);
+      }
+    }
+    data->element_weight[i] = cur;
+    sum += cur;
+    max = max_ff(max, cur);
+  }
+
+  data->chunk_sum[chunk] = sum;
+  data->chunk_max[chunk] = max;
+}
+
+/* Apply the total area and the density vertex group, sum the weights of a chunk. */
+static void distribute_weights_vgroup_cb(void *__restrict userdata,
+                                         const int chunk,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DistributeWeightsData *data = userdata;
+  const int start = chunk * DISTRIBUTE_CHUNK_SIZE;
+  const int end = min_ii(start + DISTRIBUTE_CHUNK_SIZE, data->totelem);
+  const float *vweight = data->vweight;
+  double sum = 0.0;
+
+  for (int i = start; i < end; i++) {
+    float weight = (float)(data->element_weight[i] * data->inv_totweight);
+
+    if (vweight) {
+      if (data->from == PART_FROM_VERT) {
+        weight *= vweight[i];
+      }
+      else { /* PART_FROM_FACE / PART_FROM_VOLUME */
+        const MFace *mf = &data->mface[i];
+        float tweight = vweight[mf->v1] + vweight[mf->v2] + vweight[mf->v3];
+
+        if (mf->v4) {
+          tweight += vweight[mf->v4];
+          tweight /= 4.0f;
+        }
+        else {
+          tweight /= 3.0f;
+        }
+
+        weight *= tweight;
+      }
+    }
+
+    data->element_weight[i] = weight;
+    if (weight > 0.0f) {
+      sum += weight;
+    }
+  }
+
+  data->chunk_sum[chunk] = sum;
+}
+
+/* Cumulative weights within a chunk, starting from the sum of the previous chunks.
+ * Elements which weight is so small that it does not affect the sum are skipped. */
+static void distribute_weights_cumsum_cb(void *__restrict userdata,
+                                         const int chunk,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DistributeWeightsData *data = userdata;
+  const int start = chunk * DISTRIBUTE_CHUNK_SIZE;
+  const int end = min_ii(start + DISTRIBUTE_CHUNK_SIZE, data->totelem);
+  double sum = data->chunk_sum[chunk];
+  float sum_last = (float)sum;
+  int mapped = 0;
+
+  for (int i = start; i < end; i++) {
+    const float weight = data->element_weight[i];
+    if (weight > 0.0f) {
+      sum += weight * data->inv_totweight;
+    }
+    if ((float)sum > sum_last) {
+      mapped++;
+      sum_last = (float)sum;
+      data->element_cumsum[i] = sum_last;
+    }
+    else {
+      data->element_cumsum[i] = -1.0f;
+    }
+  }
+
+  data->chunk_mapped[chunk] = mapped;
+}
+
+static void distribute_weights_compact_cb(void *__restrict userdata,
+                                          const int chunk,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DistributeWeightsData *data = userdata;
+  const int start = chunk * DISTRIBUTE_CHUNK_SIZE;
+  const int end = min_ii(start + DISTRIBUTE_CHUNK_SIZE, data->totelem);
+  int i_mapped = data->chunk_mapped[chunk];
+
+  for (int i = start; i < end; i++) {
+    if (data->element_cumsum[i] >= 0.0f) {
+      data->element_sum[i_mapped] = data->element_cumsum[i];
+      data->element_map[i_mapped] = i;
+      i_mapped++;
+    }
+  }
+}
+
+/* Calculate the normalized cumulative weights of the emission elements.
+ * We remove all null-weighted elements from element_sum, and create a new mapping
+ * 'activ'_elem_index -> orig_elem_index.
+ * This simplifies greatly the filtering of zero-weighted items - and can be much more efficient
+ * especially in random case (reducing a lot the size of binary-searched array)... */
+static void distribute_weights_calc(ParticleDistributionWeights *weights,
+                                    DistributeWeightsData *data)
+{
+  const int chunks_len = distribute_chunks_len(data->totelem);
+  data->element_weight = MEM_mallocN(sizeof(float) * (size_t)data->totelem, __func__);
+  data->chunk_sum = MEM_mallocN(sizeof(double) * (size_t)chunks_len, __func__);
+  data->chunk_max = MEM_mallocN(sizeof(float) * (size_t)chunks_len, __func__);
+  data->chunk_mapped = MEM_mallocN(sizeof(int) * (size_t)(chunks_len + 1), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  /* Weights from face areas. */
+  BLI_task_parallel_range(0, chunks_len, data, distribute_weights_area_cb, &settings);
+  double totarea = 0.0;
+  float maxweight = 0.0f;
+  for (int chunk = 0; chunk < chunks_len; chunk++) {
+    totarea += data->chunk_sum[chunk];
+    maxweight = max_ff(maxweight, data->chunk_max[chunk]);
+  }
+  if (data->use_area) {
+    data->inv_totweight = 1.0 / totarea;
+    maxweight = (float)(maxweight * data->inv_totweight);
+  }
+  else {
+    data->inv_totweight = 1.0;
+  }
+  weights->maxweight = maxweight;
+
+  /* Weights from vgroup. */
+  BLI_task_parallel_range(0, chunks_len, data, distribute_weights_vgroup_cb, &settings);
+
+  /* Exclusive prefix sum of the chunks, then cumulative weights within chunks. */
+  double totweight = 0.0;
+  for (int chunk = 0; chunk < chunks_len; chunk++) {
+    const double chunk_sum = data->chunk_sum[chunk];
+    data->chunk_sum[chunk] = totweight;
+    totweight += chunk_sum;
+  }
+
+  weights->totmapped = 0;
+  if (totweight > 0.0) {
+    data->inv_totweight = 1.0 / totweight;
+    for (int chunk = 0; chunk < chunks_len; chunk++) {
+      data->chunk_sum[chunk] *= data->inv_totweight;
+    }
+
+    data->element_cumsum = MEM_mallocN(sizeof(float) * (size_t)data->totelem, __func__);
+    BLI_task_parallel_range(0, chunks_len, data, distribute_weights_cumsum_cb, &settings);
+
+    /* Chunks are summed separately, rounding can make the first cumulative weights of a chunk
+     * smaller than the last ones of the previous chunk, skip them as well. */
+    int totmapped = 0;
+    float chunk_last_sum = 0.0f;
+    for (int chunk = 0; chunk < chunks_len; chunk++) {
+      const int start = chunk * DISTRIBUTE_CHUNK_SIZE;
+      const int end = min_ii(start + DISTRIBUTE_CHUNK_SIZE, data->totelem);
+      for (int i = start; i < end; i++) {
+        if (data->element_cumsum[i] < 0.0f) {
+          continue;
+        }
+        if (data->element_cumsum[i] > chunk_last_sum) {
+          break;
+        }
+        data->element_cumsum[i] = -1.0f;
+        data->chunk_mapped[chunk]--;
+      }
+      for (int i = end - 1; i >= start; i--) {
+        if (data->element_cumsum[i] >= 0.0f) {
+          chunk_last_sum = data->element_cumsum[i];
+          break;
+        }
+      }
+      const int mapped = data->chunk_mapped[chunk];
+      data->chunk_mapped[chunk] = totmapped;
+      totmapped += mapped;
+    }
+
+    if (totmapped > 0) {
+      data->element_sum = MEM_mallocN(sizeof(float) * (size_t)totmapped, __func__);
+      data->element_map = MEM_mallocN(sizeof(int) * (size_t)totmapped, __func__);
+      BLI_task_parallel_range(0, chunks_len, data, distribute_weights_compact_cb, &settings);
+      weights->element_sum = data->element_sum;
+      weights->element_map = data->element_map;
+      weights->totmapped = totmapped;
+    }
+    MEM_freeN(data->element_cumsum);
+  }
+
+  MEM_freeN(data->element_weight);
+  MEM_freeN(data->chunk_sum);
+  MEM_freeN(data->chunk_max);
+  MEM_freeN(data->chunk_mapped);
+}
+
+/* Get the cumulative weights of the elements, from the cache when nothing they depend on
+ * changed. */
+static ParticleDistributionWeights *distribute_weights_ensure(ParticleSimulationData *sim,
+                                                              Mesh *mesh,
+                                                              const int from,
+                                                              const bool children,
+                                                              const int totpart)
+{
+  Object *ob = sim->ob;
+  ParticleSystem *psys = sim->psys;
+  ParticleSettings *part = psys->part;
+  const int totelem = (from == PART_FROM_VERT) ? mesh->totvert : mesh->totface;
+
+  DistributeWeightsData data = {
+      .mesh = mesh,
+      .mface = mesh->mface,
+      .from = from,
+      .totelem = totelem,
+      .use_area = (part->flag & PART_EDISTR || children) && from != PART_FROM_VERT,
+  };
+  data.uniform_weight = 1.0f / (float)(MIN2(totelem, totpart));
+
+  if (data.use_area) {
+    data.orcodata = CustomData_get_layer(&mesh->vdata, CD_ORCO);
+    if (data.orcodata) {
+      Mesh *me = ob->data;
+      BKE_mesh_texspace_get(me->texcomesh ? me->texcomesh : me, data.orco_loc, data.orco_size);
+    }
+  }
+
+  /* Calculate weights from vgroup */
+  float *vweight = psys_cache_vgroup(mesh, psys, PSYS_VG_DENSITY);
+  data.vweight = vweight;
+
+  /* Everything the weights depend on. */
+  struct {
+    int from, totelem, totvert, use_area, has_orco, has_vweight;
+    float uniform_weight, orco_loc[3], orco_size[3];
+  } params = {
+      from,
+      totelem,
+      mesh->totvert,
+      data.use_area,
+      data.orcodata != NULL,
+      vweight != NULL,
+      data.use_area ? 0.0f : data.uniform_weight,
+      {UNPACK3(data.orco_loc)},
+      {UNPACK3(data.orco_size)},
+  };
+  uint32_t key[2] = {0, 0};
+  distribute_hash_add(key, &params, sizeof(params));
+  if (data.use_area || (vweight && from != PART_FROM_VERT)) {
+    distribute_hash_add(key, mesh->mface, sizeof(*mesh->mface) * (size_t)mesh->totface);
+  }
+  if (data.orcodata) {
+    distribute_hash_add(key, data.orcodata, sizeof(*data.orcodata) * (size_t)mesh->totvert);
+  }
+  else if (data.use_area) {
+    distribute_hash_add(key, mesh->mvert, sizeof(*mesh->mvert) * (size_t)mesh->totvert);
+  }
+  if (vweight) {
+    distribute_hash_add(key, vweight, sizeof(*vweight) * (size_t)mesh->totvert);
+  }
+
+  ParticleDistributionCache *cache = distribute_cache_ensure(sim->psmd);
+  ParticleDistributionWeights *weights = &cache->weights[children ? 1 : 0];
+  if (!weights->is_valid || weights->key[0] != key[0] || weights->key[1] != key[1]) {
+    distribute_weights_clear(weights);
+    distribute_weights_calc(weights, &data);
+    weights->key[0] = key[0];
+    weights->key[1] = key[1];
+    weights->is_valid = true;
+  }
+
+  if (vweight) {
+    MEM_freeN(vweight);
+  }
+
+  return weights;
+}
+
+typedef struct DistributeSampleData {
+  RNG *rng;
+  const float *element_sum;
+  const int *element_map;
+  int totmapped, totpart;
+  int *particle_element;
+  float *particle_pos;
+} DistributeSampleData;
+
+/* Random sampling of the cumulative weights, every chunk skips the random numbers of the previous
+ * particles to give the same result as sampling in a single loop. */
+static void distribute_sample_random_cb(void *__restrict userdata,
+                                        const int chunk,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DistributeSampleData *data = userdata;
+  const int start = chunk * DISTRIBUTE_CHUNK_SIZE;
+  const int end = min_ii(start + DISTRIBUTE_CHUNK_SIZE, data->totpart);
+  const float *element_sum = data->element_sum;
+  const int totmapped = data->totmapped;
+
+  RNG *rng = BLI_rng_copy(data->rng);
+  BLI_rng_skip(rng, start);
+
+  for (int p = start; p < end; p++) {
+    /* In theory element_sum[totmapped - 1] should be 1.0,
+     * but due to float errors this is not necessarily always true, so scale pos accordingly. */
+    const float pos = BLI_rng_get_float(rng) * element_sum[totmapped - 1];
+    const int eidx = distribute_binary_search(element_sum, totmapped, pos);
+    data->particle_element[p] = data->element_map[eidx];
+    data->particle_pos[p] = pos;
+    BLI_assert(pos <= element_sum[eidx]);
+    BLI_assert(eidx ? (pos > element_sum[eidx - 1]) : (pos >= 0.0f));
+  }
+
+  BLI_rng_free(rng);
+}
+
+/** \} */
+
 /* Creates a distribution of coordinates on a Mesh */
 static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
                                                ParticleSimulationData *sim,
@@ -895,8 +1375,8 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
   int cfrom = 0;
   int totelem = 0, totpart, *particle_element = 0, children = 0, totseam = 0;
   int jitlevel = 1, distr;
-  float *element_weight = NULL, *jitter_offset = NULL, *vweight = NULL;
-  float cur, maxweight = 0.0, tweight, totweight, inv_totweight, co[3], nor[3], orco[3];
+  float *jitter_offset = NULL;
+  float co[3], nor[3], orco[3];
   RNG *rng = NULL;
 
   if (ELEM(NULL, ob, psys, psys->part)) {
@@ -1045,108 +1525,11 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
     return 0;
   }
 
-  element_weight = MEM_callocN(sizeof(float) * totelem, "particle_distribution_weights");
-  particle_element = MEM_callocN(sizeof(int) * totpart, "particle_distribution_indexes");
-  jitter_offset = MEM_callocN(sizeof(float) * totelem, "particle_distribution_jitoff");
-
-  /* Calculate weights from face areas */
-  if ((part->flag & PART_EDISTR || children) && from != PART_FROM_VERT) {
-    MVert *v1, *v2, *v3, *v4;
-    float totarea = 0.f, co1[3], co2[3], co3[3], co4[3];
-    float(*orcodata)[3];
-
-    orcodata = CustomData_get_layer(&mesh->vdata, CD_ORCO);
-
-    for (i = 0; i < totelem; i++) {
-      MFace *mf = &mesh->mface[i];
-
-      if (orcodata) {
-        /* Transform orcos from normalized 0..1 to object space. */
-        copy_v3_v3(co1, orcodata[mf->v1]);
-        copy_v3_v3(co2, orcodata[mf->v2]);
-        copy_v3_v3(co3, orcodata[mf->v3]);
-        BKE_mesh_orco_verts_transform(ob->data, &co1, 1, 1);
-        BKE_mesh_orco_verts_transform(ob->data, &co2, 1, 1);
-        BKE_mesh_orco_verts_transform(ob->data, &co3, 1, 1);
-        if (mf->v4) {
-          copy_v3_v3(co4, orcodata[mf->v4]);
-          BKE_mesh_orco_verts_transform(ob->data, &co4, 1, 1);
-        }
-      }
-      else {
-        v1 = &mesh->mvert[mf->v1];
-        v2 = &mesh->mvert[mf->v2];
-        v3 = &mesh->mvert[mf->v3];
-        copy_v3_v3(co1, v1->co);
-        copy_v3_v3(co2, v2->co);
-        copy_v3_v3(co3, v3->co);
-        if (mf->v4) {
-          v4 = &mesh->mvert[mf->v4];
-          copy_v3_v3(co4, v4->co);
-        }
-      }
-
-      cur = mf->v4 ? area_quad_v3(co1, co2, co3, co4) : area_tri_v3(co1, co2, co3);
-
-      if (cur > maxweight) {
-        maxweight = cur;
-      }
-
-      element_weight[i] = cur;
-      totarea += cur;
-    }
-
-    for (i = 0; i < totelem; i++) {
-      element_weight[i] /= totarea;
-    }
-
-    maxweight /= totarea;
-  }
-  else {
-    float min = 1.0f / (float)(MIN2(totelem, totpart));
-    for (i = 0; i < totelem; i++) {
-      element_weight[i] = min;
-    }
-    maxweight = min;
-  }
-
-  /* Calculate weights from vgroup */
-  vweight = psys_cache_vgroup(mesh, psys, PSYS_VG_DENSITY);
-
-  if (vweight) {
-    if (from == PART_FROM_VERT) {
-      for (i = 0; i < totelem; i++) {
-        element_weight[i] *= vweight[i];
-      }
-    }
-    else { /* PART_FROM_FACE / PART_FROM_VOLUME */
-      for (i = 0; i < totelem; i++) {
-        MFace *mf = &mesh->mface[i];
-        tweight = vweight[mf->v1] + vweight[mf->v2] + vweight[mf->v3];
-
-        if (mf->v4) {
-          tweight += vweight[mf->v4];
-          tweight /= 4.0f;
-        }
-        else {
-          tweight /= 3.0f;
-        }
-
-        element_weight[i] *= tweight;
-      }
-    }
-    MEM_freeN(vweight);
-  }
-
-  /* Calculate total weight of all elements */
-  int totmapped = 0;
-  totweight = 0.0f;
-  for (i = 0; i < totelem; i++) {
-    if (element_weight[i] > 0.0f) {
-      totmapped++;
-      totweight += element_weight[i];
-    }
-  }
+  ParticleDistributionWeights *weights = distribute_weights_ensure(
+      sim, mesh, from, children, totpart);
+  const float *element_sum = weights->element_sum;
+  const int *element_map = weights->element_map;
+  const int totmapped = weights->totmapped;
 
   if (totmapped == 0) {
     /* We are not allowed to distribute particles anywhere... */
@@ -1155,54 +1538,33 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
     }
     BLI_kdtree_3d_free(tree);
     BLI_rng_free(rng);
-    MEM_freeN(element_weight);
-    MEM_freeN(particle_element);
-    MEM_freeN(jitter_offset);
     return 0;
   }
 
-  inv_totweight = 1.0f / totweight;
-
-  /* Calculate cumulative weights.
-   * We remove all null-weighted elements from element_sum, and create a new mapping
-   * 'activ'_elem_index -> orig_elem_index.
-   * This simplifies greatly the filtering of zero-weighted items - and can be much more efficient
-   * especially in random case (reducing a lot the size of binary-searched array)...
-   */
-  float *element_sum = MEM_mallocN(sizeof(*element_sum) * totmapped, __func__);
-  int *element_map = MEM_mallocN(sizeof(*element_map) * totmapped, __func__);
-  int i_mapped = 0;
-
-  for (i = 0; i < totelem && element_weight[i] == 0.0f; i++) {
-    /* pass */
-  }
-  element_sum[i_mapped] = element_weight[i] * inv_totweight;
-  element_map[i_mapped] = i;
-  i_mapped++;
-  for (i++; i < totelem; i++) {
-    if (element_weight[i] > 0.0f) {
-      element_sum[i_mapped] = element_sum[i_mapped - 1] + element_weight[i] * inv_totweight;
-      /* Skip elements which weight is so small that it does not affect the sum. */
-      if (element_sum[i_mapped] > element_sum[i_mapped - 1]) {
-        element_map[i_mapped] = i;
-        i_mapped++;
-      }
-    }
-  }
-  totmapped = i_mapped;
+  particle_element = MEM_callocN(sizeof(int) * totpart, "particle_distribution_indexes");
+  jitter_offset = MEM_callocN(sizeof(float) * totelem, "particle_distribution_jitoff");
 
   /* Finally assign elements to particles */
   if (part->flag & PART_TRAND) {
+    DistributeSampleData sample_data = {
+        .rng = rng,
+        .element_sum = element_sum,
+        .element_map = element_map,
+        .totmapped = totmapped,
+        .totpart = totpart,
+        .particle_element = particle_element,
+    };
+    sample_data.particle_pos = MEM_mallocN(sizeof(float) * totpart, __func__);
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    BLI_task_parallel_range(
+        0, distribute_chunks_len(totpart), &sample_data, distribute_sample_random_cb, &settings);
+
     for (p = 0; p < totpart; p++) {
-      /* In theory element_sum[totmapped - 1] should be 1.0,
-       * but due to float errors this is not necessarily always true, so scale pos accordingly. */
-      const float pos = BLI_rng_get_float(rng) * element_sum[totmapped - 1];
-      const int eidx = distribute_binary_search(element_sum, totmapped, pos);
-      particle_element[p] = element_map[eidx];
-      BLI_assert(pos <= element_sum[eidx]);
-      BLI_assert(eidx ? (pos > element_sum[eidx - 1]) : (pos >= 0.0f));
-      jitter_offset[particle_element[p]] = pos;
+      jitter_offset[particle_element[p]] = sample_data.particle_pos[p];
     }
+    MEM_freeN(sample_data.particle_pos);
   }
   else {
     double step, pos;
@@ -1229,9 +1591,6 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
     }
   }
 
-  MEM_freeN(element_sum);
-  MEM_freeN(element_map);
-
   /* For hair, sort by origindex (allows optimization's in rendering), */
   /* however with virtual parents the children need to be in random order. */
   if (part->type == PART_HAIR && !(part->childtype == PART_CHILD_FACES && part->parents != 0.0f)) {
@@ -1292,8 +1651,7 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
   ctx->jit = jit;
   ctx->jitlevel = jitlevel;
   ctx->jitoff = jitter_offset;
-  ctx->weight = element_weight;
-  ctx->maxweight = maxweight;
+  ctx->maxweight = weights->maxweight;
   ctx->cfrom = cfrom;
   ctx->distr = distr;
   ctx->mesh = mesh;
@@ -32,6 +32,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_anim_types.h"
 #include "DNA_boid_types.h"
 #include "DNA_curve_types.h"
@@ -91,7 +93,7 @@
 #  include "manta_fluid_API.h"
 #endif  // WITH_FLUID
 
-static ThreadRWMutex psys_bvhtree_rwlock = BLI_RWLOCK_INITIALIZER;
+static ThreadRWMutex psys_sph_grid_rwlock = BLI_RWLOCK_INITIALIZER;
 
 /************************************************/
 /*          Reacting to system events           */
@@ -1318,47 +1320,6 @@ void psys_get_pointcache_start_end(Scene *scene, ParticleSystem *psys, int *sfra
 /************************************************/
 /*          Effectors                           */
 /************************************************/
-static void psys_update_particle_bvhtree(ParticleSystem *psys, float cfra)
-{
-  if (psys) {
-    PARTICLE_P;
-    int totpart = 0;
-    bool need_rebuild;
-
-    BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-    need_rebuild = !psys->bvhtree || psys->bvhtree_frame != cfra;
-    BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-
-    if (need_rebuild) {
-      LOOP_SHOWN_PARTICLES
-      {
-        totpart++;
-      }
-
-      BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_WRITE);
-
-      BLI_bvhtree_free(psys->bvhtree);
-      psys->bvhtree = BLI_bvhtree_new(totpart, 0.0, 4, 6);
-
-      LOOP_SHOWN_PARTICLES
-      {
-        if (pa->alive == PARS_ALIVE) {
-          if (pa->state.time == cfra) {
-            BLI_bvhtree_insert(psys->bvhtree, p, pa->prev_state.co, 1);
-          }
-          else {
-            BLI_bvhtree_insert(psys->bvhtree, p, pa->state.co, 1);
-          }
-        }
-      }
-      BLI_bvhtree_balance(psys->bvhtree);
-
-      psys->bvhtree_frame = cfra;
-
-      BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-    }
-  }
-}
 void psys_update_particle_tree(ParticleSystem *psys, float cfra)
 {
   if (psys) {
@@ -1547,6 +1508,326 @@ static void integrate_particle(
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name SPH Neighbor Grid
+ *
+ * Particles of fluid systems are binned in a uniform grid with cells the size of the
+ * interaction radius, so the neighbors of a particle are found in three cells per axis at most.
+ * Cells are hashed into buckets, the grid is rebuilt every step by a parallel counting sort of
+ * the particles over their buckets. Positions are copied in bucket order, neighbors are tested
+ * from contiguous memory instead of being looked up by particle index.
+ * \{ */
+
+/* Cell coordinates are packed in 21 bits per axis. */
+#define SPH_GRID_CELL_BITS 21
+#define SPH_GRID_CELLS_MAX (1 << SPH_GRID_CELL_BITS)
+/* Distances of a bucket are computed in blocks before calling back for neighbors. */
+#define SPH_GRID_BLOCK_SIZE 16
+
+typedef struct SPHGrid {
+  float min[3];
+  float cell_size_inv;
+  int res[3];
+  uint bucket_mask;
+  /* Particles of bucket `b` are in the range `bucket_offsets[b]` to `bucket_offsets[b + 1]`. */
+  int *bucket_offsets;
+  /* Cell key, particle index and position of every particle in bucket order. */
+  uint64_t *keys;
+  int *indices;
+  float (*co)[3];
+  int totpoint;
+} SPHGrid;
+
+BLI_INLINE uint64_t sph_grid_cell_key(const int cell[3])
+{
+  return (uint64_t)cell[0] | ((uint64_t)cell[1] << SPH_GRID_CELL_BITS) |
+         ((uint64_t)cell[2] << (2 * SPH_GRID_CELL_BITS));
+}
+
+BLI_INLINE uint sph_grid_bucket(const SPHGrid *grid, const uint64_t key)
+{
+  const uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+  return (uint)(hash ^ (hash >> 32)) & grid->bucket_mask;
+}
+
+/* Position used for neighbor queries, NULL for particles that don't interact. */
+BLI_INLINE const float *sph_grid_particle_co(const ParticleData *pa, const float cfra)
+{
+  if ((pa->flag & (PARS_UNEXIST | PARS_NO_DISP)) || pa->alive != PARS_ALIVE) {
+    return NULL;
+  }
+  return (pa->state.time == cfra) ? pa->prev_state.co : pa->state.co;
+}
+
+typedef struct SPHGridBuildData {
+  SPHGrid *grid;
+  const ParticleData *particles;
+  float cfra;
+  uint *particle_buckets;
+  uint64_t *particle_keys;
+  int *bucket_fill;
+} SPHGridBuildData;
+
+typedef struct SPHGridBoundsChunk {
+  float min[3], max[3];
+  int totpoint;
+} SPHGridBoundsChunk;
+
+static void sph_grid_bounds_cb(void *__restrict userdata,
+                               const int p,
+                               const TaskParallelTLS *__restrict tls)
+{
+  const SPHGridBuildData *data = userdata;
+  SPHGridBoundsChunk *chunk = tls->userdata_chunk;
+  const float *co = sph_grid_particle_co(&data->particles[p], data->cfra);
+  if (co) {
+    minmax_v3v3_v3(chunk->min, chunk->max, co);
+    chunk->totpoint++;
+  }
+}
+
+static void sph_grid_bounds_reduce(const void *__restrict UNUSED(userdata),
+                                   void *__restrict join_v,
+                                   void *__restrict chunk_v)
+{
+  SPHGridBoundsChunk *join = join_v;
+  const SPHGridBoundsChunk *chunk = chunk_v;
+  minmax_v3v3_v3(join->min, join->max, chunk->min);
+  minmax_v3v3_v3(join->min, join->max, chunk->max);
+  join->totpoint += chunk->totpoint;
+}
+
+static void sph_grid_count_cb(void *__restrict userdata,
+                              const int p,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SPHGridBuildData *data = userdata;
+  const SPHGrid *grid = data->grid;
+  const float *co = sph_grid_particle_co(&data->particles[p], data->cfra);
+  if (co == NULL) {
+    data->particle_buckets[p] = UINT_MAX;
+    return;
+  }
+
+  int cell[3];
+  for (int i = 0; i < 3; i++) {
+    cell[i] = min_ii((int)((co[i] - grid->min[i]) * grid->cell_size_inv), grid->res[i] - 1);
+  }
+  const uint64_t key = sph_grid_cell_key(cell);
+  const uint bucket = sph_grid_bucket(grid, key);
+  data->particle_keys[p] = key;
+  data->particle_buckets[p] = bucket;
+  atomic_add_and_fetch_int32(&grid->bucket_offsets[bucket + 1], 1);
+}
+
+static void sph_grid_scatter_cb(void *__restrict userdata,
+                                const int p,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SPHGridBuildData *data = userdata;
+  const SPHGrid *grid = data->grid;
+  const uint bucket = data->particle_buckets[p];
+  if (bucket == UINT_MAX) {
+    return;
+  }
+  const int dst = atomic_fetch_and_add_int32(&data->bucket_fill[bucket], 1);
+  grid->keys[dst] = data->particle_keys[p];
+  grid->indices[dst] = p;
+  copy_v3_v3(grid->co[dst], sph_grid_particle_co(&data->particles[p], data->cfra));
+}
+
+/* Scattering in parallel shuffles the particles of a bucket, sort them back by index so that
+ * neighbors are always visited in the same order and the simulation stays deterministic. */
+static void sph_grid_sort_bucket_cb(void *__restrict userdata,
+                                    const int b,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SPHGridBuildData *data = userdata;
+  const SPHGrid *grid = data->grid;
+  const int start = grid->bucket_offsets[b], end = grid->bucket_offsets[b + 1];
+  for (int i = start + 1; i < end; i++) {
+    const int index = grid->indices[i];
+    const uint64_t key = grid->keys[i];
+    float co[3];
+    copy_v3_v3(co, grid->co[i]);
+
+    int j = i;
+    for (; j > start && grid->indices[j - 1] > index; j--) {
+      grid->indices[j] = grid->indices[j - 1];
+      grid->keys[j] = grid->keys[j - 1];
+      copy_v3_v3(grid->co[j], grid->co[j - 1]);
+    }
+    grid->indices[j] = index;
+    grid->keys[j] = key;
+    copy_v3_v3(grid->co[j], co);
+  }
+}
+
+static SPHGrid *sph_grid_new(const ParticleSystem *psys, const float cfra, const float cell_size)
+{
+  SPHGrid *grid = MEM_callocN(sizeof(*grid), __func__);
+  SPHGridBuildData data = {
+      .grid = grid,
+      .particles = psys->particles,
+      .cfra = cfra,
+  };
+
+  SPHGridBoundsChunk bounds;
+  INIT_MINMAX(bounds.min, bounds.max);
+  bounds.totpoint = 0;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = &bounds;
+  settings.userdata_chunk_size = sizeof(bounds);
+  settings.func_reduce = sph_grid_bounds_reduce;
+  BLI_task_parallel_range(0, psys->totpart, &data, sph_grid_bounds_cb, &settings);
+
+  grid->totpoint = bounds.totpoint;
+  if (grid->totpoint == 0) {
+    zero_v3(bounds.min);
+    zero_v3(bounds.max);
+  }
+
+  /* Grow cells for widely scattered particles, to keep cell coordinates in range. */
+  float size[3];
+  sub_v3_v3v3(size, bounds.max, bounds.min);
+  const float size_max = max_fff(UNPACK3(size));
+  float cell_size_final = max_ff(cell_size, size_max / (float)(SPH_GRID_CELLS_MAX - 1));
+  if (cell_size_final == 0.0f) {
+    cell_size_final = 1.0f;
+  }
+  copy_v3_v3(grid->min, bounds.min);
+  grid->cell_size_inv = 1.0f / cell_size_final;
+  for (int i = 0; i < 3; i++) {
+    grid->res[i] = clamp_i((int)(size[i] * grid->cell_size_inv) + 1, 1, SPH_GRID_CELLS_MAX);
+  }
+
+  const uint buckets_len = power_of_2_max_u((uint)max_ii(grid->totpoint * 2, 1));
+  grid->bucket_mask = buckets_len - 1;
+  grid->bucket_offsets = MEM_callocN(sizeof(int) * (buckets_len + 1), __func__);
+  grid->keys = MEM_mallocN(sizeof(*grid->keys) * (size_t)max_ii(grid->totpoint, 1), __func__);
+  grid->indices = MEM_mallocN(sizeof(int) * (size_t)max_ii(grid->totpoint, 1), __func__);
+  grid->co = MEM_mallocN(sizeof(*grid->co) * (size_t)max_ii(grid->totpoint, 1), __func__);
+
+  data.particle_buckets = MEM_mallocN(sizeof(uint) * (size_t)psys->totpart, __func__);
+  data.particle_keys = MEM_mallocN(sizeof(uint64_t) * (size_t)psys->totpart, __func__);
+
+  /* Counting sort over the buckets: count in parallel, accumulate, then scatter in parallel. */
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, psys->totpart, &data, sph_grid_count_cb, &settings);
+
+  for (uint b = 0; b < buckets_len; b++) {
+    grid->bucket_offsets[b + 1] += grid->bucket_offsets[b];
+  }
+
+  data.bucket_fill = MEM_dupallocN(grid->bucket_offsets);
+  BLI_task_parallel_range(0, psys->totpart, &data, sph_grid_scatter_cb, &settings);
+  BLI_task_parallel_range(0, (int)buckets_len, &data, sph_grid_sort_bucket_cb, &settings);
+
+  MEM_freeN(data.bucket_fill);
+  MEM_freeN(data.particle_keys);
+  MEM_freeN(data.particle_buckets);
+
+  return grid;
+}
+
+void psys_sph_grid_free(SPHGrid *grid)
+{
+  if (grid) {
+    MEM_freeN(grid->bucket_offsets);
+    MEM_freeN(grid->keys);
+    MEM_freeN(grid->indices);
+    MEM_freeN(grid->co);
+    MEM_freeN(grid);
+  }
+}
+
+/**
+ * Call \a callback for every particle closer than \a radius to \a co. Like
+ * #BLI_bvhtree_range_query the callback gets the query position, not the one of the particle.
+ */
+static void sph_grid_range_query(const SPHGrid *grid,
+                                 const float co[3],
+                                 const float radius,
+                                 BVHTree_RangeQuery callback,
+                                 void *userdata)
+{
+  int cell_min[3], cell_max[3];
+  for (int i = 0; i < 3; i++) {
+    const float lo = (co[i] - radius - grid->min[i]) * grid->cell_size_inv;
+    const float hi = (co[i] + radius - grid->min[i]) * grid->cell_size_inv;
+    if (hi < 0.0f || lo >= (float)grid->res[i]) {
+      return;
+    }
+    cell_min[i] = (int)max_ff(lo, 0.0f);
+    cell_max[i] = (int)min_ff(hi, (float)(grid->res[i] - 1));
+  }
+
+  const float radius_sq = radius * radius;
+  float dist_sq[SPH_GRID_BLOCK_SIZE];
+  int cell[3];
+  for (cell[2] = cell_min[2]; cell[2] <= cell_max[2]; cell[2]++) {
+    for (cell[1] = cell_min[1]; cell[1] <= cell_max[1]; cell[1]++) {
+      for (cell[0] = cell_min[0]; cell[0] <= cell_max[0]; cell[0]++) {
+        const uint64_t key = sph_grid_cell_key(cell);
+        const uint bucket = sph_grid_bucket(grid, key);
+        const int end = grid->bucket_offsets[bucket + 1];
+
+        for (int start = grid->bucket_offsets[bucket]; start < end;
+             start += SPH_GRID_BLOCK_SIZE) {
+          const int block_len = min_ii(end - start, SPH_GRID_BLOCK_SIZE);
+          const uint64_t *keys = grid->keys + start;
+          const float(*block_co)[3] = grid->co + start;
+
+          /* Branch-less so the distances of a block are computed with SIMD,
+           * particles of other cells sharing the bucket are pushed out of range. */
+          for (int j = 0; j < block_len; j++) {
+            const float dx = block_co[j][0] - co[0];
+            const float dy = block_co[j][1] - co[1];
+            const float dz = block_co[j][2] - co[2];
+            dist_sq[j] = (keys[j] == key) ? dx * dx + dy * dy + dz * dz : FLT_MAX;
+          }
+          for (int j = 0; j < block_len; j++) {
+            if (dist_sq[j] < radius_sq) {
+              callback(userdata, grid->indices[start + j], co, dist_sq[j]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+static void psys_update_particle_sph_grid(ParticleSystem *psys,
+                                          float cfra,
+                                          float interaction_radius)
+{
+  if (psys) {
+    bool need_rebuild;
+
+    BLI_rw_mutex_lock(&psys_sph_grid_rwlock, THREAD_LOCK_READ);
+    need_rebuild = !psys->sph_grid || psys->sph_grid_frame != cfra;
+    BLI_rw_mutex_unlock(&psys_sph_grid_rwlock);
+
+    if (need_rebuild) {
+      SPHGrid *grid = sph_grid_new(psys, cfra, interaction_radius);
+
+      BLI_rw_mutex_lock(&psys_sph_grid_rwlock, THREAD_LOCK_WRITE);
+
+      psys_sph_grid_free(psys->sph_grid);
+      psys->sph_grid = grid;
+      psys->sph_grid_frame = cfra;
+
+      BLI_rw_mutex_unlock(&psys_sph_grid_rwlock);
+    }
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name SPH fluid physics
  *
@@ -1687,8 +1968,7 @@ typedef struct SPHRangeData {
   int use_size;
 } SPHRangeData;
 
-static void sph_evaluate_func(BVHTree *tree,
-                              ParticleSystem **psys,
+static void sph_evaluate_func(ParticleSystem **psys,
                               const float co[3],
                               SPHRangeData *pfr,
                               float interaction_radius,
@@ -1703,16 +1983,13 @@ static void sph_evaluate_func(BVHTree *tree,
     pfr->massfac = psys[i]->part->mass / pfr->mass;
     pfr->use_size = psys[i]->part->flag & PART_SIZEMASS;
 
-    if (tree) {
-      BLI_bvhtree_range_query(tree, co, interaction_radius, callback, pfr);
-      break;
-    }
-
-    BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
+    BLI_rw_mutex_lock(&psys_sph_grid_rwlock, THREAD_LOCK_READ);
 
-    BLI_bvhtree_range_query(psys[i]->bvhtree, co, interaction_radius, callback, pfr);
+    if (psys[i]->sph_grid) {
+      sph_grid_range_query(psys[i]->sph_grid, co, interaction_radius, callback, pfr);
+    }
 
-    BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+    BLI_rw_mutex_unlock(&psys_sph_grid_rwlock);
   }
 }
 static void sph_density_accum_cb(void *userdata, int index, const float co[3], float squared_dist)
@@ -1832,7 +2109,7 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
   pfr.pa = pa;
   pfr.mass = sphdata->mass;
 
-  sph_evaluate_func(NULL, psys, state->co, &pfr, interaction_radius, sph_density_accum_cb);
+  sph_evaluate_func(psys, state->co, &pfr, interaction_radius, sph_density_accum_cb);
 
   density = data[0];
   near_density = data[1];
@@ -2022,8 +2299,7 @@ static void sphclassical_force_cb(void *sphdata_v,
   pfr.h = h;
   pfr.pa = pa;
 
-  sph_evaluate_func(
-      NULL, psys, state->co, &pfr, interaction_radius, sphclassical_neighbor_accum_cb);
+  sph_evaluate_func(psys, state->co, &pfr, interaction_radius, sphclassical_neighbor_accum_cb);
   pressure = stiffness * (pow7f(pa->sphdensity / rest_density) - 1.0f);
 
   /* multiply by mass so that we return a force, not accel */
@@ -2106,8 +2382,7 @@ static void sphclassical_calc_dens(ParticleData *pa, float UNUSED(dfra), SPHData
   pfr.pa = pa;
   pfr.mass = sphdata->mass;
 
-  sph_evaluate_func(
-      NULL, psys, pa->state.co, &pfr, interaction_radius, sphclassical_density_accum_cb);
+  sph_evaluate_func(psys, pa->state.co, &pfr, interaction_radius, sphclassical_density_accum_cb);
   pa->sphdensity = min_ff(max_ff(data[0], fluid->rest_density * 0.9f), fluid->rest_density * 1.1f);
 }
 
@@ -2170,28 +2445,6 @@ void psys_sph_finalize(SPHData *sphdata)
   }
 }
 
-/* Sample the density field at a point in space. */
-void psys_sph_density(BVHTree *tree, SPHData *sphdata, float co[3], float vars[2])
-{
-  ParticleSystem **psys = sphdata->psys;
-  SPHFluidSettings *fluid = psys[0]->part->fluid;
-  /* 4.0 seems to be a pretty good value */
-  float interaction_radius = fluid->radius *
-                             (fluid->flag & SPH_FAC_RADIUS ? 4.0f * psys[0]->part->size : 1.0f);
-  SPHRangeData pfr;
-  float density[2];
-
-  density[0] = density[1] = 0.0f;
-  pfr.data = density;
-  pfr.h = interaction_radius * sphdata->hfac;
-  pfr.mass = sphdata->mass;
-
-  sph_evaluate_func(tree, psys, co, &pfr, interaction_radius, sphdata->density_cb);
-
-  vars[0] = pfr.data[0];
-  vars[1] = pfr.data[1];
-}
-
 static void sph_integrate(ParticleSimulationData *sim,
                           ParticleData *pa,
                           float dfra,
@@ -3870,12 +4123,17 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
     }
     case PART_PHYS_FLUID: {
       ParticleTarget *pt = psys->targets.first;
-      psys_update_particle_bvhtree(psys, cfra);
+      SPHFluidSettings *fluid = part->fluid;
+      /* Grid cells fit the usual interaction radius, bigger radii only visit more cells. */
+      const float interaction_radius = fluid->radius *
+                                       (fluid->flag & SPH_FAC_RADIUS ? 4.0f * part->size : 1.0f);
+      psys_update_particle_sph_grid(psys, cfra, interaction_radius);
 
       for (; pt;
-           pt = pt->next) { /* Updating others systems particle tree for fluid-fluid interaction */
+           pt = pt->next) { /* Updating others systems particle grid for fluid-fluid interaction */
         if (pt->ob) {
-          psys_update_particle_bvhtree(BLI_findlink(&pt->ob->particlesystem, pt->psys - 1), cfra);
+          psys_update_particle_sph_grid(
+              BLI_findlink(&pt->ob->particlesystem, pt->psys - 1), cfra, interaction_radius);
         }
       }
       break;
@@ -33,6 +33,7 @@
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_endian_switch.h"
@@ -49,6 +50,8 @@
 #include "BKE_scene.h"
 #include "BKE_sequencer.h"
 
+#include "seqcache_codec.h"
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -81,7 +84,8 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * Zlib compression with user definable level can be used to compress image data(per image)
+ * Image data can be compressed (per image) by one of the codecs in seqcache_codec.c, which
+ * compress chunks of image in parallel. Codec is chosen by compression level in preferences.
  * Images are written in order in which they are rendered.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
@@ -94,11 +98,14 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+#define DCACHE_CURRENT_VERSION 2
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
 
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char codec;        /* eSeqCacheCodec */
+  unsigned char shuffle_size; /* See SeqCacheCodecSettings. */
+  unsigned char level;        /* Compression level, only used when writing the entry. */
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -172,18 +179,30 @@ static char *seq_disk_cache_base_dir(void)
   return U.sequencer_disk_cache_dir;
 }
 
-static int seq_disk_cache_compression_level(void)
+static void seq_disk_cache_codec_settings(SeqCacheCodecSettings *r_settings)
 {
+  r_settings->codec = SEQ_CACHE_CODEC_ZLIB;
+  r_settings->level = 9;
+  /* Group bytes of float components, or channels of byte images. */
+  r_settings->shuffle_size = 4;
+
   switch (U.sequencer_disk_cache_compression) {
     case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
-      return 0;
+      r_settings->codec = SEQ_CACHE_CODEC_NONE;
+      r_settings->shuffle_size = 0;
+      break;
     case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
-      return 1;
+      /* Deflate is often slower to decode than re-rendering the strip, prefer fast codec. */
+      if (seq_cache_codec_is_available(SEQ_CACHE_CODEC_LZO)) {
+        r_settings->codec = SEQ_CACHE_CODEC_LZO;
+      }
+      else {
+        r_settings->level = 1;
+      }
+      break;
     case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
-      return 9;
+      break;
   }
-
-  return U.sequencer_disk_cache_compression;
 }
 
 static size_t seq_disk_cache_size_limit(void)
@@ -474,29 +493,72 @@ static void seq_disk_cache_invalidate(Scene *scene,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
-static size_t deflate_imbuf_to_file(ImBuf *ibuf,
-                                    FILE *file,
-                                    int level,
-                                    DiskCacheHeaderEntry *header_entry)
+static void seq_disk_cache_entry_codec_settings(const DiskCacheHeaderEntry *header_entry,
+                                                SeqCacheCodecSettings *r_settings)
 {
-  if (ibuf->rect) {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset, level);
+  r_settings->codec = header_entry->codec;
+  r_settings->level = header_entry->level;
+  r_settings->shuffle_size = header_entry->shuffle_size;
+}
+
+/* Returns number of bytes written to the file, 0 on failure. */
+static size_t compress_imbuf_to_file(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+{
+  SeqCacheCodecSettings settings;
+  seq_disk_cache_entry_codec_settings(header_entry, &settings);
+
+  const void *data = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+  void *compressed;
+  size_t compressed_size = seq_cache_codec_compress(
+      &settings, data, header_entry->size_raw, &compressed);
+
+  if (compressed_size == 0) {
+    return 0;
   }
 
-  return BLI_gzip_mem_to_file_at_pos(
-      ibuf->rect_float, header_entry->size_raw, file, header_entry->offset, level);
+  size_t bytes_written = 0;
+  if (BLI_fseek(file, header_entry->offset, SEEK_SET) == 0 &&
+      fwrite(compressed, compressed_size, 1, file) == 1) {
+    bytes_written = compressed_size;
+  }
+  MEM_freeN(compressed);
+
+  return bytes_written;
 }
 
-static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+/* Returns number of bytes of image data read, 0 on failure. */
+static size_t decompress_file_to_imbuf(ImBuf *ibuf,
+                                       FILE *file,
+                                       size_t file_size,
+                                       DiskCacheHeaderEntry *header_entry)
 {
-  if (ibuf->rect) {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset);
+  /* Header comes from disk, don't trust it to allocate memory. */
+  if (file_size == (size_t)-1 || header_entry->size_compressed == 0 ||
+      header_entry->offset > file_size ||
+      header_entry->size_compressed > file_size - header_entry->offset) {
+    return 0;
+  }
+
+  SeqCacheCodecSettings settings;
+  seq_disk_cache_entry_codec_settings(header_entry, &settings);
+
+  void *data = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+  void *compressed = MEM_mallocN(header_entry->size_compressed, __func__);
+  size_t bytes_read = 0;
+
+  if (compressed == NULL) {
+    return 0;
+  }
+
+  if (BLI_fseek(file, header_entry->offset, SEEK_SET) == 0 &&
+      fread(compressed, header_entry->size_compressed, 1, file) == 1 &&
+      seq_cache_codec_decompress(
+          &settings, compressed, header_entry->size_compressed, data, header_entry->size_raw)) {
+    bytes_read = header_entry->size_raw;
   }
+  MEM_freeN(compressed);
 
-  return BLI_ungzip_file_to_mem_at_pos(
-      ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
+  return bytes_read;
 }
 
 static void seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -555,6 +617,12 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
   header->entry[i].offset = offset;
   header->entry[i].frameno = key->nfra;
 
+  SeqCacheCodecSettings codec_settings;
+  seq_disk_cache_codec_settings(&codec_settings);
+  header->entry[i].codec = codec_settings.codec;
+  header->entry[i].shuffle_size = codec_settings.shuffle_size;
+  header->entry[i].level = codec_settings.level;
+
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
   if (ibuf->rect) {
@@ -602,8 +670,7 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
   memset(&header, 0, sizeof(header));
   seq_disk_cache_read_header(file, &header);
   int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  size_t bytes_written = compress_imbuf_to_file(ibuf, file, &header.entry[entry_index]);
 
   if (bytes_written != 0) {
     /* Last step is writing header, as image data can be overwritten,
@@ -662,7 +729,8 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
     return NULL;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
+  size_t bytes_read = decompress_file_to_imbuf(
+      ibuf, file, BLI_file_size(path), &header.entry[entry_index]);
 
   /* Sanity check. */
   if (bytes_read != expected_size) {
@@ -981,9 +1049,8 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 /* Find only "base" keys.
  * Sources(other types) for a frame must be freed all at once.
  */
-bool BKE_sequencer_cache_recycle_item(Scene *scene)
+static bool seq_cache_recycle_to(Scene *scene, size_t memory_total)
 {
-  size_t memory_total = seq_cache_get_mem_total();
   SeqCache *cache = seq_cache_get_from_scene(scene);
   if (!cache) {
     return false;
@@ -1006,6 +1073,35 @@ bool BKE_sequencer_cache_recycle_item(Scene *scene)
   return true;
 }
 
+bool BKE_sequencer_cache_recycle_item(Scene *scene)
+{
+  return seq_cache_recycle_to(scene, seq_cache_get_mem_total());
+}
+
+static size_t seq_cache_memory_pressure_usage(void *scene_v)
+{
+  SeqCache *cache = seq_cache_get_from_scene((Scene *)scene_v);
+
+  return cache ? cache->memory_used : 0;
+}
+
+/* Recycle frames when the system runs low on memory, independently of the cache limit. */
+static size_t seq_cache_memory_pressure_free(void *scene_v, size_t memory_to_free)
+{
+  Scene *scene = (Scene *)scene_v;
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  size_t memory_used;
+
+  if (!cache) {
+    return 0;
+  }
+
+  memory_used = cache->memory_used;
+  seq_cache_recycle_to(scene, (memory_used > memory_to_free) ? memory_used - memory_to_free : 0);
+
+  return (memory_used > cache->memory_used) ? memory_used - cache->memory_used : 0;
+}
+
 static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -1065,6 +1161,9 @@ static void seq_cache_create(Main *bmain, Scene *scene)
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
 
+    IMB_moviecache_memory_pressure_handler_add(
+        seq_cache_memory_pressure_usage, seq_cache_memory_pressure_free, scene);
+
     if (scene->ed->disk_cache_timestamp == 0) {
       scene->ed->disk_cache_timestamp = time(NULL);
     }
@@ -1104,6 +1203,8 @@ void BKE_sequencer_cache_destruct(Scene *scene)
     return;
   }
 
+  IMB_moviecache_memory_pressure_handler_remove(scene);
+
   BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
@@ -1401,6 +1502,8 @@ void BKE_sequencer_cache_put(const SeqRenderData *context,
 
   seq_cache_unlock(scene);
 
+  IMB_moviecache_memory_pressure_check();
+
   if (!key->is_temp_cache && !skip_disk_cache) {
     if (seq_disk_cache_is_enabled(context->bmain)) {
       if (cache->disk_cache == NULL) {
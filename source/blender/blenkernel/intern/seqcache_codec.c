@@ -0,0 +1,410 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <string.h>
+
+#include "zlib.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_endian_switch.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "seqcache_codec.h"
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
+#define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+
+/* Compressed data layout:
+ * - uint32_t number of chunks.
+ * - uint32_t compressed size of every chunk, a chunk whose compressed size equals its raw size
+ *   is stored uncompressed.
+ * - Data of all chunks. */
+#define CODEC_HEADER_SIZE(num_chunks) (sizeof(uint32_t) * ((num_chunks) + 1))
+
+/* -------------------------------------------------------------------- */
+/** \name Byte Shuffling
+ * \{ */
+
+/* Move byte `j` of every element to plane `j`, trailing bytes which don't form a whole element
+ * are copied as-is. */
+static void codec_shuffle(uchar *dst, const uchar *src, size_t size, int element_size)
+{
+  const size_t num_elements = size / element_size;
+
+  for (int j = 0; j < element_size; j++) {
+    uchar *plane = dst + j * num_elements;
+    const uchar *src_byte = src + j;
+    for (size_t i = 0; i < num_elements; i++, src_byte += element_size) {
+      plane[i] = *src_byte;
+    }
+  }
+  memcpy(dst + num_elements * element_size,
+         src + num_elements * element_size,
+         size - num_elements * element_size);
+}
+
+static void codec_unshuffle(uchar *dst, const uchar *src, size_t size, int element_size)
+{
+  const size_t num_elements = size / element_size;
+
+  for (int j = 0; j < element_size; j++) {
+    const uchar *plane = src + j * num_elements;
+    uchar *dst_byte = dst + j;
+    for (size_t i = 0; i < num_elements; i++, dst_byte += element_size) {
+      *dst_byte = plane[i];
+    }
+  }
+  memcpy(dst + num_elements * element_size,
+         src + num_elements * element_size,
+         size - num_elements * element_size);
+}
+
+static bool codec_use_shuffle(const SeqCacheCodecSettings *settings)
+{
+  return settings->codec != SEQ_CACHE_CODEC_NONE && settings->shuffle_size > 1;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Chunk Compression
+ * \{ */
+
+static size_t codec_compress_bound(eSeqCacheCodec codec, size_t size)
+{
+  switch (codec) {
+    case SEQ_CACHE_CODEC_ZLIB:
+      return compressBound(size);
+    case SEQ_CACHE_CODEC_LZO:
+      return LZO_OUT_LEN(size);
+    case SEQ_CACHE_CODEC_NONE:
+      break;
+  }
+  return size;
+}
+
+/* Returns compressed size, or 0 when data could not be compressed. */
+static size_t codec_compress_chunk(const SeqCacheCodecSettings *settings,
+                                   const uchar *src,
+                                   size_t src_size,
+                                   uchar *dst,
+                                   size_t dst_size)
+{
+  switch (settings->codec) {
+    case SEQ_CACHE_CODEC_ZLIB: {
+      uLongf dst_len = dst_size;
+      if (compress2(dst, &dst_len, src, src_size, settings->level) == Z_OK) {
+        return dst_len;
+      }
+      break;
+    }
+    case SEQ_CACHE_CODEC_LZO: {
+#ifdef WITH_LZO
+      lzo_uint dst_len = dst_size;
+      void *wrkmem = MEM_mallocN(LZO1X_1_MEM_COMPRESS, __func__);
+      int r = lzo1x_1_compress(src, (lzo_uint)src_size, dst, &dst_len, wrkmem);
+      MEM_freeN(wrkmem);
+      if (r == LZO_E_OK) {
+        return dst_len;
+      }
+#endif
+      break;
+    }
+    case SEQ_CACHE_CODEC_NONE:
+      break;
+  }
+  return 0;
+}
+
+static bool codec_decompress_chunk(const SeqCacheCodecSettings *settings,
+                                   const uchar *src,
+                                   size_t src_size,
+                                   uchar *dst,
+                                   size_t dst_size)
+{
+  switch (settings->codec) {
+    case SEQ_CACHE_CODEC_ZLIB: {
+      uLongf dst_len = dst_size;
+      return uncompress(dst, &dst_len, src, src_size) == Z_OK && dst_len == dst_size;
+    }
+    case SEQ_CACHE_CODEC_LZO: {
+#ifdef WITH_LZO
+      lzo_uint dst_len = dst_size;
+      int r = lzo1x_decompress_safe(src, (lzo_uint)src_size, dst, &dst_len, NULL);
+      return r == LZO_E_OK && dst_len == dst_size;
+#else
+      break;
+#endif
+    }
+    case SEQ_CACHE_CODEC_NONE:
+      break;
+  }
+  return false;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+typedef struct CodecChunk {
+  uchar *buffer;
+  size_t size;
+} CodecChunk;
+
+typedef struct CodecTaskData {
+  const SeqCacheCodecSettings *settings;
+  uchar *data;
+  size_t size;
+
+  /* Compression. */
+  CodecChunk *chunks;
+
+  /* Decompression. */
+  const uchar *compressed;
+  const uint32_t *chunk_sizes;
+  const size_t *chunk_offsets;
+  bool failed;
+} CodecTaskData;
+
+static size_t codec_chunk_size(size_t size, int chunk_index)
+{
+  return min_zz(SEQ_CACHE_CODEC_CHUNK_SIZE,
+                size - (size_t)chunk_index * SEQ_CACHE_CODEC_CHUNK_SIZE);
+}
+
+static void codec_compress_chunk_func(void *__restrict userdata,
+                                      const int chunk_index,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CodecTaskData *task_data = userdata;
+  const SeqCacheCodecSettings *settings = task_data->settings;
+  CodecChunk *chunk = &task_data->chunks[chunk_index];
+  const uchar *raw = task_data->data + (size_t)chunk_index * SEQ_CACHE_CODEC_CHUNK_SIZE;
+  const size_t raw_size = codec_chunk_size(task_data->size, chunk_index);
+
+  if (settings->codec != SEQ_CACHE_CODEC_NONE) {
+    const uchar *src = raw;
+    uchar *shuffled = NULL;
+    if (codec_use_shuffle(settings)) {
+      shuffled = MEM_mallocN(raw_size, __func__);
+      codec_shuffle(shuffled, raw, raw_size, settings->shuffle_size);
+      src = shuffled;
+    }
+
+    const size_t bound = codec_compress_bound(settings->codec, raw_size);
+    chunk->buffer = MEM_mallocN(bound, __func__);
+    chunk->size = codec_compress_chunk(settings, src, raw_size, chunk->buffer, bound);
+
+    MEM_SAFE_FREE(shuffled);
+
+    if (chunk->size != 0 && chunk->size < raw_size) {
+      return;
+    }
+    MEM_freeN(chunk->buffer);
+  }
+
+  /* Store uncompressed. The chunk buffer is left NULL and raw data is copied directly. */
+  chunk->buffer = NULL;
+  chunk->size = raw_size;
+}
+
+size_t seq_cache_codec_compress(const SeqCacheCodecSettings *settings,
+                                const void *data,
+                                size_t size,
+                                void **r_compressed)
+{
+  *r_compressed = NULL;
+
+  if (!seq_cache_codec_is_available(settings->codec)) {
+    return 0;
+  }
+
+  const int num_chunks = (int)((size + SEQ_CACHE_CODEC_CHUNK_SIZE - 1) /
+                               SEQ_CACHE_CODEC_CHUNK_SIZE);
+
+  CodecTaskData task_data = {
+      .settings = settings,
+      .data = (uchar *)data,
+      .size = size,
+      .chunks = MEM_calloc_arrayN(num_chunks, sizeof(CodecChunk), __func__),
+  };
+
+  TaskParallelSettings parallel_settings;
+  BLI_parallel_range_settings_defaults(&parallel_settings);
+  parallel_settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0, num_chunks, &task_data, codec_compress_chunk_func, &parallel_settings);
+
+  size_t compressed_size = CODEC_HEADER_SIZE(num_chunks);
+  for (int i = 0; i < num_chunks; i++) {
+    compressed_size += task_data.chunks[i].size;
+  }
+
+  uchar *compressed = MEM_mallocN(compressed_size, __func__);
+  uint32_t *header = (uint32_t *)compressed;
+  uchar *chunk_data = compressed + CODEC_HEADER_SIZE(num_chunks);
+
+  header[0] = (uint32_t)num_chunks;
+  for (int i = 0; i < num_chunks; i++) {
+    CodecChunk *chunk = &task_data.chunks[i];
+
+    header[i + 1] = (uint32_t)chunk->size;
+    if (chunk->buffer) {
+      memcpy(chunk_data, chunk->buffer, chunk->size);
+      MEM_freeN(chunk->buffer);
+    }
+    else {
+      memcpy(chunk_data, task_data.data + (size_t)i * SEQ_CACHE_CODEC_CHUNK_SIZE, chunk->size);
+    }
+    chunk_data += chunk->size;
+  }
+
+#ifdef __BIG_ENDIAN__
+  BLI_endian_switch_uint32_array(header, num_chunks + 1);
+#endif
+
+  MEM_freeN(task_data.chunks);
+
+  *r_compressed = compressed;
+  return compressed_size;
+}
+
+static void codec_decompress_chunk_func(void *__restrict userdata,
+                                        const int chunk_index,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CodecTaskData *task_data = userdata;
+  const SeqCacheCodecSettings *settings = task_data->settings;
+  uchar *raw = task_data->data + (size_t)chunk_index * SEQ_CACHE_CODEC_CHUNK_SIZE;
+  const size_t raw_size = codec_chunk_size(task_data->size, chunk_index);
+  const uchar *src = task_data->compressed + task_data->chunk_offsets[chunk_index];
+  const size_t src_size = task_data->chunk_sizes[chunk_index];
+
+  if (src_size == raw_size) {
+    memcpy(raw, src, raw_size);
+    return;
+  }
+
+  if (!codec_use_shuffle(settings)) {
+    if (!codec_decompress_chunk(settings, src, src_size, raw, raw_size)) {
+      task_data->failed = true;
+    }
+    return;
+  }
+
+  uchar *shuffled = MEM_mallocN(raw_size, __func__);
+  if (codec_decompress_chunk(settings, src, src_size, shuffled, raw_size)) {
+    codec_unshuffle(raw, shuffled, raw_size, settings->shuffle_size);
+  }
+  else {
+    task_data->failed = true;
+  }
+  MEM_freeN(shuffled);
+}
+
+bool seq_cache_codec_decompress(const SeqCacheCodecSettings *settings,
+                                const void *compressed,
+                                size_t compressed_size,
+                                void *data,
+                                size_t size)
+{
+  if (!seq_cache_codec_is_available(settings->codec) || compressed_size < sizeof(uint32_t)) {
+    return false;
+  }
+
+  uint32_t num_chunks = *(const uint32_t *)compressed;
+#ifdef __BIG_ENDIAN__
+  BLI_endian_switch_uint32(&num_chunks);
+#endif
+  if (num_chunks != (size + SEQ_CACHE_CODEC_CHUNK_SIZE - 1) / SEQ_CACHE_CODEC_CHUNK_SIZE ||
+      compressed_size < CODEC_HEADER_SIZE(num_chunks)) {
+    return false;
+  }
+
+  uint32_t *chunk_sizes = MEM_malloc_arrayN(num_chunks, sizeof(uint32_t), __func__);
+  size_t *chunk_offsets = MEM_malloc_arrayN(num_chunks, sizeof(size_t), __func__);
+  memcpy(chunk_sizes, (const uint32_t *)compressed + 1, sizeof(uint32_t) * num_chunks);
+#ifdef __BIG_ENDIAN__
+  BLI_endian_switch_uint32_array(chunk_sizes, num_chunks);
+#endif
+
+  /* Validate chunk sizes, so corrupted files can't cause reads out of bounds. */
+  size_t offset = CODEC_HEADER_SIZE(num_chunks);
+  for (uint32_t i = 0; i < num_chunks; i++) {
+    chunk_offsets[i] = offset;
+    offset += chunk_sizes[i];
+  }
+
+  bool ok = false;
+  if (offset == compressed_size) {
+    CodecTaskData task_data = {
+        .settings = settings,
+        .data = data,
+        .size = size,
+        .compressed = compressed,
+        .chunk_sizes = chunk_sizes,
+        .chunk_offsets = chunk_offsets,
+        .failed = false,
+    };
+
+    TaskParallelSettings parallel_settings;
+    BLI_parallel_range_settings_defaults(&parallel_settings);
+    parallel_settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(
+        0, (int)num_chunks, &task_data, codec_decompress_chunk_func, &parallel_settings);
+
+    ok = !task_data.failed;
+  }
+
+  MEM_freeN(chunk_sizes);
+  MEM_freeN(chunk_offsets);
+
+  return ok;
+}
+
+bool seq_cache_codec_is_available(eSeqCacheCodec codec)
+{
+  switch (codec) {
+    case SEQ_CACHE_CODEC_NONE:
+    case SEQ_CACHE_CODEC_ZLIB:
+      return true;
+    case SEQ_CACHE_CODEC_LZO:
+#ifdef WITH_LZO
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+/** \} */
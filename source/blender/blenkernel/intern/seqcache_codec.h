@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Codecs used to compress image data of the sequencer disk cache.
+ *
+ * Data is split into chunks of #SEQ_CACHE_CODEC_CHUNK_SIZE bytes which are compressed
+ * independently, so that writing and reading a cache entry can use all threads. Chunks which
+ * don't compress are stored as-is.
+ *
+ * Optionally bytes of every element are shuffled before compression, so that bytes of the same
+ * significance (or of the same channel) are stored next to each other. For float buffers this
+ * improves both ratio and speed of compression a lot.
+ */
+
+#pragma once
+
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEQ_CACHE_CODEC_CHUNK_SIZE (1 << 20)
+
+typedef enum eSeqCacheCodec {
+  /** Data is stored uncompressed. */
+  SEQ_CACHE_CODEC_NONE = 0,
+  /** Deflate, slow but gives the best compression ratio. */
+  SEQ_CACHE_CODEC_ZLIB = 1,
+  /** LZO1X, fast to compress and very fast to decompress. */
+  SEQ_CACHE_CODEC_LZO = 2,
+} eSeqCacheCodec;
+
+typedef struct SeqCacheCodecSettings {
+  eSeqCacheCodec codec;
+  /** Compression level, only used by #SEQ_CACHE_CODEC_ZLIB. */
+  int level;
+  /** Size of elements whose bytes are shuffled before compression, 0 to disable shuffling. */
+  int shuffle_size;
+} SeqCacheCodecSettings;
+
+bool seq_cache_codec_is_available(eSeqCacheCodec codec);
+
+/**
+ * Compress \a size bytes of \a data.
+ *
+ * \return Size of the compressed data stored in \a r_compressed, which is to be freed with
+ * #MEM_freeN, or 0 on failure.
+ */
+size_t seq_cache_codec_compress(const SeqCacheCodecSettings *settings,
+                                const void *data,
+                                size_t size,
+                                void **r_compressed);
+
+/**
+ * Decompress data created by #seq_cache_codec_compress using the same settings.
+ * \a size must match the size of the original data.
+ */
+bool seq_cache_codec_decompress(const SeqCacheCodecSettings *settings,
+                                const void *compressed,
+                                size_t compressed_size,
+                                void *data,
+                                size_t size);
+
+#ifdef __cplusplus
+}
+#endif
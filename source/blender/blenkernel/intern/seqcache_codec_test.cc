@@ -0,0 +1,207 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "seqcache_codec.h"
+
+#define DO_PERF_TESTS 0
+
+namespace blender::bke::tests {
+
+static void codec_roundtrip_test(const SeqCacheCodecSettings &settings,
+                                 const void *data,
+                                 size_t size)
+{
+  void *compressed;
+  const size_t compressed_size = seq_cache_codec_compress(&settings, data, size, &compressed);
+  ASSERT_NE(compressed_size, (size_t)0);
+
+  void *result = MEM_mallocN(size, __func__);
+  EXPECT_TRUE(seq_cache_codec_decompress(&settings, compressed, compressed_size, result, size));
+  EXPECT_EQ(memcmp(data, result, size), 0);
+
+  /* Truncated data must be rejected. */
+  EXPECT_FALSE(
+      seq_cache_codec_decompress(&settings, compressed, compressed_size - 1, result, size));
+
+  MEM_freeN(result);
+  MEM_freeN(compressed);
+}
+
+static const eSeqCacheCodec all_codecs[] = {
+    SEQ_CACHE_CODEC_NONE, SEQ_CACHE_CODEC_ZLIB, SEQ_CACHE_CODEC_LZO};
+
+TEST(seqcache_codec, Roundtrip)
+{
+  /* Odd size, to test partial chunks and trailing bytes of shuffled elements. */
+  const size_t size = 3 * SEQ_CACHE_CODEC_CHUNK_SIZE + 7;
+  uchar *data = (uchar *)MEM_mallocN(size, __func__);
+  RNG *rng = BLI_rng_new(0);
+  for (size_t i = 0; i < size; i++) {
+    /* Mix compressible and random data. */
+    data[i] = (i < size / 2) ? (uchar)(i / 1024) : (uchar)BLI_rng_get_uint(rng);
+  }
+  BLI_rng_free(rng);
+
+  for (eSeqCacheCodec codec : all_codecs) {
+    if (!seq_cache_codec_is_available(codec)) {
+      continue;
+    }
+    for (int shuffle_size : {0, 4, 16}) {
+      SeqCacheCodecSettings settings = {codec, 1, shuffle_size};
+      codec_roundtrip_test(settings, data, size);
+    }
+  }
+
+  MEM_freeN(data);
+}
+
+TEST(seqcache_codec, Unavailable)
+{
+  uchar data[16] = {0};
+  void *compressed;
+  for (eSeqCacheCodec codec : all_codecs) {
+    SeqCacheCodecSettings settings = {codec, 1, 0};
+    const size_t compressed_size = seq_cache_codec_compress(
+        &settings, data, sizeof(data), &compressed);
+    if (seq_cache_codec_is_available(codec)) {
+      EXPECT_NE(compressed_size, (size_t)0);
+      MEM_freeN(compressed);
+    }
+    else {
+      EXPECT_EQ(compressed_size, (size_t)0);
+      EXPECT_EQ(compressed, nullptr);
+    }
+  }
+}
+
+#if DO_PERF_TESTS
+
+static const int IMAGE_WIDTH = 1920;
+static const int IMAGE_HEIGHT = 1080;
+
+/* Smooth gradients with a bit of noise, roughly what rendered strips look like. */
+static float *image_float_create(int width, int height)
+{
+  float *rect = (float *)MEM_malloc_arrayN(width * height * 4, sizeof(float), __func__);
+  RNG *rng = BLI_rng_new(0);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float *pixel = rect + (y * width + x) * 4;
+      const float noise = (BLI_rng_get_float(rng) - 0.5f) * 0.01f;
+      pixel[0] = (float)x / width + noise;
+      pixel[1] = (float)y / height + noise;
+      pixel[2] = 0.5f + noise;
+      pixel[3] = 1.0f;
+    }
+  }
+  BLI_rng_free(rng);
+  return rect;
+}
+
+static uchar *image_byte_create(int width, int height)
+{
+  float *rect_float = image_float_create(width, height);
+  uchar *rect = (uchar *)MEM_malloc_arrayN(width * height * 4, sizeof(uchar), __func__);
+  for (int i = 0; i < width * height * 4; i++) {
+    rect[i] = (uchar)(CLAMPIS(rect_float[i], 0.0f, 1.0f) * 255.0f);
+  }
+  MEM_freeN(rect_float);
+  return rect;
+}
+
+static void codec_benchmark(const char *id,
+                            const SeqCacheCodecSettings &settings,
+                            const void *data,
+                            size_t size)
+{
+  if (!seq_cache_codec_is_available(settings.codec)) {
+    printf("%-32s not available\n", id);
+    return;
+  }
+
+  const double mb = (double)size / (1024.0 * 1024.0);
+  void *compressed;
+  void *result = MEM_mallocN(size, __func__);
+
+  double time_start = PIL_check_seconds_timer();
+  const size_t compressed_size = seq_cache_codec_compress(&settings, data, size, &compressed);
+  const double time_compress = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  EXPECT_TRUE(seq_cache_codec_decompress(&settings, compressed, compressed_size, result, size));
+  const double time_decompress = PIL_check_seconds_timer() - time_start;
+
+  EXPECT_EQ(memcmp(data, result, size), 0);
+
+  printf("%-32s ratio %5.2f, compress %8.1f MB/s, decompress %8.1f MB/s\n",
+         id,
+         (double)size / compressed_size,
+         mb / time_compress,
+         mb / time_decompress);
+
+  MEM_freeN(result);
+  MEM_freeN(compressed);
+}
+
+static void codec_benchmark_image(const char *image_id, const void *data, size_t size)
+{
+  struct {
+    const char *id;
+    SeqCacheCodecSettings settings;
+  } configurations[] = {
+      {"none", {SEQ_CACHE_CODEC_NONE, 0, 0}},
+      {"zlib 1", {SEQ_CACHE_CODEC_ZLIB, 1, 0}},
+      {"zlib 1, shuffle", {SEQ_CACHE_CODEC_ZLIB, 1, 4}},
+      {"zlib 9, shuffle", {SEQ_CACHE_CODEC_ZLIB, 9, 4}},
+      {"lzo", {SEQ_CACHE_CODEC_LZO, 0, 0}},
+      {"lzo, shuffle", {SEQ_CACHE_CODEC_LZO, 0, 4}},
+  };
+
+  printf("\n%s (%dx%d):\n", image_id, IMAGE_WIDTH, IMAGE_HEIGHT);
+  for (const auto &configuration : configurations) {
+    codec_benchmark(configuration.id, configuration.settings, data, size);
+  }
+}
+
+TEST(seqcache_codec, BenchmarkFloat)
+{
+  float *rect = image_float_create(IMAGE_WIDTH, IMAGE_HEIGHT);
+  codec_benchmark_image("Float image", rect, sizeof(float) * 4 * IMAGE_WIDTH * IMAGE_HEIGHT);
+  MEM_freeN(rect);
+}
+
+TEST(seqcache_codec, BenchmarkByte)
+{
+  uchar *rect = image_byte_create(IMAGE_WIDTH, IMAGE_HEIGHT);
+  codec_benchmark_image("Byte image", rect, sizeof(uchar) * 4 * IMAGE_WIDTH * IMAGE_HEIGHT);
+  MEM_freeN(rect);
+}
+
+#endif
+
+}  // namespace blender::bke::tests
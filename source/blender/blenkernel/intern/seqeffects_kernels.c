@@ -0,0 +1,1057 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <string.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "BLI_math_base.h"
+#include "BLI_math_color.h"
+#include "BLI_math_color_blend.h"
+#include "BLI_math_vector.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_sequence_types.h"
+
+#include "seqeffects_kernels.h"
+
+/* -------------------------------------------------------------------- */
+/** \name SSE2 Utilities
+ * \{ */
+
+#ifdef __SSE2__
+
+BLI_INLINE __m128 sse_select(const __m128 mask, const __m128 a, const __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+BLI_INLINE __m128 sse_splat_alpha(const __m128 v)
+{
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Mask of the RGB lanes of a pixel. */
+BLI_INLINE __m128 sse_rgb_mask(void)
+{
+  return _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+}
+
+/* Mask of the RGB bytes of 4 packed byte pixels. */
+BLI_INLINE __m128i sse_rgb_mask_byte(void)
+{
+  return _mm_set1_epi32(0x00ffffff);
+}
+
+BLI_INLINE __m128i sse_select_byte(const __m128i mask, const __m128i a, const __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Broadcast alpha of the 2 pixels stored as 16 bit integers. */
+BLI_INLINE __m128i sse_splat_alpha_epi16(const __m128i v)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)),
+                             _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Same as #straight_uchar_to_premul_float(). */
+BLI_INLINE __m128 sse_straight_uchar_to_premul_float(const uchar color[4])
+{
+  const __m128i zero = _mm_setzero_si128();
+  int packed;
+  memcpy(&packed, color, sizeof(packed));
+  const __m128i color_i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero),
+                                             zero);
+  const __m128 color_f = _mm_cvtepi32_ps(color_i);
+  const __m128 alpha = _mm_mul_ps(sse_splat_alpha(color_f), _mm_set1_ps(1.0f / 255.0f));
+  const __m128 fac = _mm_mul_ps(alpha, _mm_set1_ps(1.0f / 255.0f));
+  return sse_select(sse_rgb_mask(), _mm_mul_ps(color_f, fac), alpha);
+}
+
+/* Same as #premul_float_to_straight_uchar(). */
+BLI_INLINE void sse_premul_float_to_straight_uchar(uchar result[4], const __m128 color)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha = sse_splat_alpha(color);
+  const __m128 is_straight = _mm_or_ps(_mm_cmpeq_ps(alpha, zero), _mm_cmpeq_ps(alpha, one));
+  __m128 straight = _mm_mul_ps(color, _mm_div_ps(one, alpha));
+  straight = sse_select(_mm_andnot_ps(is_straight, sse_rgb_mask()), straight, color);
+
+  /* Same as #unit_float_to_uchar_clamp(). */
+  __m128i result_i = _mm_cvttps_epi32(
+      _mm_add_ps(_mm_mul_ps(straight, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+  result_i = _mm_andnot_si128(_mm_castps_si128(_mm_cmple_ps(straight, zero)), result_i);
+  result_i = sse_select_byte(
+      _mm_castps_si128(_mm_cmpgt_ps(straight, _mm_set1_ps(1.0f - 0.5f / 255.0f))),
+      _mm_set1_epi32(255),
+      result_i);
+  result_i = _mm_packus_epi16(_mm_packs_epi32(result_i, result_i), result_i);
+
+  const int packed = _mm_cvtsi128_si32(result_i);
+  memcpy(result, &packed, sizeof(packed));
+}
+
+#endif /* __SSE2__ */
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cross
+ * \{ */
+
+void seq_effect_cross_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  const int fac2 = (int)(256.0f * fac);
+  const int fac1 = 256 - fac2;
+  int i = 0;
+
+#ifdef __SSE2__
+  /* With both factors in 0..256 the weighted sum fits in 16 bits. */
+  if (fac2 >= 0 && fac2 <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac1_v = _mm_set1_epi16((short)fac1);
+    const __m128i fac2_v = _mm_set1_epi16((short)fac2);
+    for (; i + 4 <= num_pixels; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)(rect1 + i * 4));
+      const __m128i b = _mm_loadu_si128((const __m128i *)(rect2 + i * 4));
+      const __m128i lo = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), fac1_v),
+                        _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), fac2_v)),
+          8);
+      const __m128i hi = _mm_srli_epi16(
+          _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), fac1_v),
+                        _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), fac2_v)),
+          8);
+      _mm_storeu_si128((__m128i *)(out + i * 4), _mm_packus_epi16(lo, hi));
+    }
+  }
+#endif
+
+  for (; i < num_pixels; i++) {
+    const uchar *rt1 = rect1 + i * 4, *rt2 = rect2 + i * 4;
+    uchar *rt = out + i * 4;
+    rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
+    rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
+    rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
+    rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
+  }
+}
+
+void seq_effect_cross_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  const float fac2 = fac;
+  const float fac1 = 1.0f - fac2;
+  const int num_channels = num_pixels * 4;
+  int i = 0;
+
+#ifdef __SSE2__
+  const __m128 fac1_v = _mm_set1_ps(fac1);
+  const __m128 fac2_v = _mm_set1_ps(fac2);
+  for (; i + 4 <= num_channels; i += 4) {
+    const __m128 a = _mm_loadu_ps(rect1 + i);
+    const __m128 b = _mm_loadu_ps(rect2 + i);
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(fac1_v, a), _mm_mul_ps(fac2_v, b)));
+  }
+#endif
+
+  for (; i < num_channels; i++) {
+    out[i] = fac1 * rect1[i] + fac2 * rect2[i];
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Alpha Over / Alpha Under
+ * \{ */
+
+void seq_effect_alphaover_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  /* rt = rt1 over rt2  (alpha from rt1) */
+  if (fac <= 0.0f) {
+    memcpy(out, rect2, sizeof(float[4]) * num_pixels);
+    return;
+  }
+
+  for (int i = 0; i < num_pixels; i++) {
+    const float *rt1 = rect1 + i * 4, *rt2 = rect2 + i * 4;
+    float *rt = out + i * 4;
+#ifdef __SSE2__
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 fac_v = _mm_set1_ps(fac);
+    const __m128 mfac = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(fac_v, sse_splat_alpha(a)));
+    const __m128 result = _mm_add_ps(_mm_mul_ps(fac_v, a), _mm_mul_ps(mfac, b));
+    _mm_storeu_ps(rt, sse_select(_mm_cmple_ps(mfac, _mm_setzero_ps()), a, result));
+#else
+    const float mfac = 1.0f - (fac * rt1[3]);
+
+    if (mfac <= 0.0f) {
+      copy_v4_v4(rt, rt1);
+    }
+    else {
+      rt[0] = fac * rt1[0] + mfac * rt2[0];
+      rt[1] = fac * rt1[1] + mfac * rt2[1];
+      rt[2] = fac * rt1[2] + mfac * rt2[2];
+      rt[3] = fac * rt1[3] + mfac * rt2[3];
+    }
+#endif
+  }
+}
+
+void seq_effect_alphaover_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  /* rt = rt1 over rt2  (alpha from rt1) */
+  if (fac <= 0.0f) {
+    memcpy(out, rect2, sizeof(uchar[4]) * num_pixels);
+    return;
+  }
+
+  for (int i = 0; i < num_pixels; i++) {
+    const uchar *cp1 = rect1 + i * 4, *cp2 = rect2 + i * 4;
+    uchar *rt = out + i * 4;
+    const float mfac = 1.0f - fac * (cp1[3] * (1.0f / 255.0f));
+
+    if (mfac <= 0.0f) {
+      memcpy(rt, cp1, sizeof(uchar[4]));
+      continue;
+    }
+
+#ifdef __SSE2__
+    const __m128 a = sse_straight_uchar_to_premul_float(cp1);
+    const __m128 b = sse_straight_uchar_to_premul_float(cp2);
+    sse_premul_float_to_straight_uchar(
+        rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), a), _mm_mul_ps(_mm_set1_ps(mfac), b)));
+#else
+    float rt1[4], rt2[4], tempc[4];
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    tempc[0] = fac * rt1[0] + mfac * rt2[0];
+    tempc[1] = fac * rt1[1] + mfac * rt2[1];
+    tempc[2] = fac * rt1[2] + mfac * rt2[2];
+    tempc[3] = fac * rt1[3] + mfac * rt2[3];
+
+    premul_float_to_straight_uchar(rt, tempc);
+#endif
+  }
+}
+
+void seq_effect_alphaunder_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  /* rt = rt1 under rt2  (alpha from rt2) */
+  for (int i = 0; i < num_pixels; i++) {
+    const uchar *cp1 = rect1 + i * 4, *cp2 = rect2 + i * 4;
+    uchar *rt = out + i * 4;
+    const float alpha2 = cp2[3] * (1.0f / 255.0f);
+
+    /* this complex optimization is because the
+     * 'skybuf' can be crossed in
+     */
+    if (alpha2 <= 0.0f && fac >= 1.0f) {
+      memcpy(rt, cp1, sizeof(uchar[4]));
+      continue;
+    }
+    const float fac_pixel = fac * (1.0f - alpha2);
+    if (alpha2 >= 1.0f || fac_pixel <= 0.0f) {
+      memcpy(rt, cp2, sizeof(uchar[4]));
+      continue;
+    }
+
+#ifdef __SSE2__
+    const __m128 a = sse_straight_uchar_to_premul_float(cp1);
+    const __m128 b = sse_straight_uchar_to_premul_float(cp2);
+    sse_premul_float_to_straight_uchar(rt, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac_pixel), a), b));
+#else
+    float rt1[4], rt2[4], tempc[4];
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    tempc[0] = fac_pixel * rt1[0] + rt2[0];
+    tempc[1] = fac_pixel * rt1[1] + rt2[1];
+    tempc[2] = fac_pixel * rt1[2] + rt2[2];
+    tempc[3] = fac_pixel * rt1[3] + rt2[3];
+
+    premul_float_to_straight_uchar(rt, tempc);
+#endif
+  }
+}
+
+void seq_effect_alphaunder_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  /* rt = rt1 under rt2  (alpha from rt2) */
+  for (int i = 0; i < num_pixels; i++) {
+    const float *rt1 = rect1 + i * 4, *rt2 = rect2 + i * 4;
+    float *rt = out + i * 4;
+#ifdef __SSE2__
+    /* Evaluate all cases and select in reverse order of priority. */
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 b_alpha = sse_splat_alpha(b);
+    const __m128 fac_v = _mm_mul_ps(_mm_set1_ps(fac), _mm_sub_ps(_mm_set1_ps(1.0f), b_alpha));
+    __m128 result = _mm_add_ps(_mm_mul_ps(fac_v, a), b);
+    result = sse_select(_mm_cmpeq_ps(fac_v, _mm_setzero_ps()), b, result);
+    result = sse_select(_mm_cmpge_ps(b_alpha, _mm_set1_ps(1.0f)), b, result);
+    if (fac >= 1.0f) {
+      result = sse_select(_mm_cmple_ps(b_alpha, _mm_setzero_ps()), a, result);
+    }
+    _mm_storeu_ps(rt, result);
+#else
+    /* this complex optimization is because the
+     * 'skybuf' can be crossed in
+     */
+    if (rt2[3] <= 0.0f && fac >= 1.0f) {
+      copy_v4_v4(rt, rt1);
+    }
+    else if (rt2[3] >= 1.0f) {
+      copy_v4_v4(rt, rt2);
+    }
+    else {
+      const float fac_pixel = fac * (1.0f - rt2[3]);
+
+      if (fac_pixel == 0.0f) {
+        copy_v4_v4(rt, rt2);
+      }
+      else {
+        rt[0] = fac_pixel * rt1[0] + rt2[0];
+        rt[1] = fac_pixel * rt1[1] + rt2[1];
+        rt[2] = fac_pixel * rt1[2] + rt2[2];
+        rt[3] = fac_pixel * rt1[3] + rt2[3];
+      }
+    }
+#endif
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Gamma Cross
+ *
+ * Colors are crossed in a space with gamma 2.0, using piecewise linear approximations of the
+ * gamma curves stored in lookup tables.
+ * \{ */
+
+/* copied code from initrender.c */
+#define RE_GAMMA_TABLE_SIZE 400
+
+static float gamma_range_table[RE_GAMMA_TABLE_SIZE + 1];
+static float gamfactor_table[RE_GAMMA_TABLE_SIZE];
+static float inv_gamma_range_table[RE_GAMMA_TABLE_SIZE + 1];
+static float inv_gamfactor_table[RE_GAMMA_TABLE_SIZE];
+static float color_domain_table[RE_GAMMA_TABLE_SIZE + 1];
+static float color_step;
+static float inv_color_step;
+static float valid_gamma;
+static float valid_inv_gamma;
+static bool gamma_tabs_init = false;
+
+static void makeGammaTables(float gamma)
+{
+  /* we need two tables: one forward, one backward */
+  int i;
+
+  valid_gamma = gamma;
+  valid_inv_gamma = 1.0f / gamma;
+  color_step = 1.0f / RE_GAMMA_TABLE_SIZE;
+  inv_color_step = (float)RE_GAMMA_TABLE_SIZE;
+
+  /* We could squeeze out the two range tables to gain some memory */
+  for (i = 0; i < RE_GAMMA_TABLE_SIZE; i++) {
+    color_domain_table[i] = i * color_step;
+    gamma_range_table[i] = pow(color_domain_table[i], valid_gamma);
+    inv_gamma_range_table[i] = pow(color_domain_table[i], valid_inv_gamma);
+  }
+
+  /* The end of the table should match 1.0 carefully. In order to avoid
+   * rounding errors, we just set this explicitly. The last segment may
+   * have a different length than the other segments, but our
+   * interpolation is insensitive to that
+   */
+  color_domain_table[RE_GAMMA_TABLE_SIZE] = 1.0;
+  gamma_range_table[RE_GAMMA_TABLE_SIZE] = 1.0;
+  inv_gamma_range_table[RE_GAMMA_TABLE_SIZE] = 1.0;
+
+  /* To speed up calculations, we make these calc factor tables. They are
+   * multiplication factors used in scaling the interpolation
+   */
+  for (i = 0; i < RE_GAMMA_TABLE_SIZE; i++) {
+    gamfactor_table[i] = inv_color_step * (gamma_range_table[i + 1] - gamma_range_table[i]);
+    inv_gamfactor_table[i] = inv_color_step *
+                             (inv_gamma_range_table[i + 1] - inv_gamma_range_table[i]);
+  }
+}
+
+void seq_effect_gammacross_init(void)
+{
+  if (gamma_tabs_init == false) {
+    makeGammaTables(2.0f);
+    gamma_tabs_init = true;
+  }
+}
+
+BLI_INLINE float gamma_table_lookup(const float c,
+                                    const float gamma,
+                                    const float *range_table,
+                                    const float *factor_table)
+{
+  const int i = floorf(c * inv_color_step);
+  /* Clip to range [0, 1]: outside, just do the complete calculation.
+   * Negative colors are explicitly handled.
+   */
+  if (UNLIKELY(i < 0)) {
+    return -powf(-c, gamma);
+  }
+  if (i >= RE_GAMMA_TABLE_SIZE) {
+    return powf(c, gamma);
+  }
+  return range_table[i] + ((c - color_domain_table[i]) * factor_table[i]);
+}
+
+BLI_INLINE float gammaCorrect(float c)
+{
+  return gamma_table_lookup(c, valid_gamma, gamma_range_table, gamfactor_table);
+}
+
+BLI_INLINE float invGammaCorrect(float c)
+{
+  return gamma_table_lookup(c, valid_inv_gamma, inv_gamma_range_table, inv_gamfactor_table);
+}
+
+#ifdef __SSE2__
+
+/* Same as #gamma_table_lookup() for 4 values. SSE2 has no gather, table entries are loaded per
+ * lane, but index computation and interpolation are vectorized. */
+BLI_INLINE __m128 sse_gamma_table_lookup(const __m128 c,
+                                         const float gamma,
+                                         const float *range_table,
+                                         const float *factor_table)
+{
+  const __m128 x = _mm_mul_ps(c, _mm_set1_ps(inv_color_step));
+  /* `floorf(x)` is outside of the table when x is, truncation equals floor inside of it. */
+  const __m128 outside = _mm_or_ps(_mm_cmplt_ps(x, _mm_setzero_ps()),
+                                   _mm_cmpge_ps(x, _mm_set1_ps((float)RE_GAMMA_TABLE_SIZE)));
+  if (UNLIKELY(_mm_movemask_ps(outside) != 0)) {
+    float values[4];
+    _mm_storeu_ps(values, c);
+    for (int j = 0; j < 4; j++) {
+      values[j] = gamma_table_lookup(values[j], gamma, range_table, factor_table);
+    }
+    return _mm_loadu_ps(values);
+  }
+
+  int index[4];
+  _mm_storeu_si128((__m128i *)index, _mm_cvttps_epi32(x));
+  const __m128 domain = _mm_setr_ps(color_domain_table[index[0]],
+                                    color_domain_table[index[1]],
+                                    color_domain_table[index[2]],
+                                    color_domain_table[index[3]]);
+  const __m128 range = _mm_setr_ps(
+      range_table[index[0]], range_table[index[1]], range_table[index[2]], range_table[index[3]]);
+  const __m128 factor = _mm_setr_ps(factor_table[index[0]],
+                                    factor_table[index[1]],
+                                    factor_table[index[2]],
+                                    factor_table[index[3]]);
+  return _mm_add_ps(range, _mm_mul_ps(_mm_sub_ps(c, domain), factor));
+}
+
+BLI_INLINE __m128 sse_gammacross(const __m128 a,
+                                 const __m128 b,
+                                 const __m128 fac1_v,
+                                 const __m128 fac2_v)
+{
+  const __m128 a_linear = sse_gamma_table_lookup(
+      a, valid_inv_gamma, inv_gamma_range_table, inv_gamfactor_table);
+  const __m128 b_linear = sse_gamma_table_lookup(
+      b, valid_inv_gamma, inv_gamma_range_table, inv_gamfactor_table);
+  return sse_gamma_table_lookup(
+      _mm_add_ps(_mm_mul_ps(fac1_v, a_linear), _mm_mul_ps(fac2_v, b_linear)),
+      valid_gamma,
+      gamma_range_table,
+      gamfactor_table);
+}
+
+#endif /* __SSE2__ */
+
+void seq_effect_gammacross_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  const float fac2 = fac;
+  const float fac1 = 1.0f - fac2;
+
+  BLI_assert(gamma_tabs_init);
+
+#ifdef __SSE2__
+  const __m128 fac1_v = _mm_set1_ps(fac1);
+  const __m128 fac2_v = _mm_set1_ps(fac2);
+#endif
+
+  for (int i = 0; i < num_pixels; i++) {
+    const uchar *cp1 = rect1 + i * 4, *cp2 = rect2 + i * 4;
+    uchar *rt = out + i * 4;
+#ifdef __SSE2__
+    sse_premul_float_to_straight_uchar(rt,
+                                       sse_gammacross(sse_straight_uchar_to_premul_float(cp1),
+                                                      sse_straight_uchar_to_premul_float(cp2),
+                                                      fac1_v,
+                                                      fac2_v));
+#else
+    float rt1[4], rt2[4], tempc[4];
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    tempc[0] = gammaCorrect(fac1 * invGammaCorrect(rt1[0]) + fac2 * invGammaCorrect(rt2[0]));
+    tempc[1] = gammaCorrect(fac1 * invGammaCorrect(rt1[1]) + fac2 * invGammaCorrect(rt2[1]));
+    tempc[2] = gammaCorrect(fac1 * invGammaCorrect(rt1[2]) + fac2 * invGammaCorrect(rt2[2]));
+    tempc[3] = gammaCorrect(fac1 * invGammaCorrect(rt1[3]) + fac2 * invGammaCorrect(rt2[3]));
+
+    premul_float_to_straight_uchar(rt, tempc);
+#endif
+  }
+}
+
+void seq_effect_gammacross_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  const float fac2 = fac;
+  const float fac1 = 1.0f - fac2;
+  const int num_channels = num_pixels * 4;
+  int i = 0;
+
+  BLI_assert(gamma_tabs_init);
+
+#ifdef __SSE2__
+  const __m128 fac1_v = _mm_set1_ps(fac1);
+  const __m128 fac2_v = _mm_set1_ps(fac2);
+  for (; i + 4 <= num_channels; i += 4) {
+    _mm_storeu_ps(
+        out + i,
+        sse_gammacross(_mm_loadu_ps(rect1 + i), _mm_loadu_ps(rect2 + i), fac1_v, fac2_v));
+  }
+#endif
+
+  for (; i < num_channels; i++) {
+    out[i] = gammaCorrect(fac1 * invGammaCorrect(rect1[i]) + fac2 * invGammaCorrect(rect2[i]));
+  }
+}
+
+#undef RE_GAMMA_TABLE_SIZE
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Add / Subtract / Multiply
+ * \{ */
+
+#ifdef __SSE2__
+/* Shared by add and subtract: `(m * rt2) >> 16` with `m = fac * rt2[3]`, for 4 byte pixels. */
+BLI_INLINE __m128i sse_add_sub_term_byte(const __m128i b, const __m128i fac_v)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i b_lo = _mm_unpacklo_epi8(b, zero);
+  const __m128i b_hi = _mm_unpackhi_epi8(b, zero);
+  const __m128i m_lo = _mm_mullo_epi16(sse_splat_alpha_epi16(b_lo), fac_v);
+  const __m128i m_hi = _mm_mullo_epi16(sse_splat_alpha_epi16(b_hi), fac_v);
+  return _mm_packus_epi16(_mm_mulhi_epu16(m_lo, b_lo), _mm_mulhi_epu16(m_hi, b_hi));
+}
+#endif
+
+void seq_effect_add_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  const int fac_i = (int)(256.0f * fac);
+  int i = 0;
+
+#ifdef __SSE2__
+  /* `fac * alpha` has to fit in unsigned 16 bits. */
+  if (fac_i >= 0 && fac_i <= 256) {
+    const __m128i fac_v = _mm_set1_epi16((short)fac_i);
+    const __m128i rgb_mask = sse_rgb_mask_byte();
+    for (; i + 4 <= num_pixels; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)(rect1 + i * 4));
+      const __m128i b = _mm_loadu_si128((const __m128i *)(rect2 + i * 4));
+      const __m128i result = _mm_adds_epu8(a, sse_add_sub_term_byte(b, fac_v));
+      _mm_storeu_si128((__m128i *)(out + i * 4), sse_select_byte(rgb_mask, result, a));
+    }
+  }
+#endif
+
+  for (; i < num_pixels; i++) {
+    const uchar *cp1 = rect1 + i * 4, *cp2 = rect2 + i * 4;
+    uchar *rt = out + i * 4;
+    const int m = fac_i * (int)cp2[3];
+    rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
+    rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
+    rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
+    rt[3] = cp1[3];
+  }
+}
+
+void seq_effect_add_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  const float fac_inv = 1.0f - fac;
+
+  for (int i = 0; i < num_pixels; i++) {
+    const float *rt1 = rect1 + i * 4, *rt2 = rect2 + i * 4;
+    float *rt = out + i * 4;
+#ifdef __SSE2__
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(
+        _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(sse_splat_alpha(a), _mm_set1_ps(fac_inv))),
+        sse_splat_alpha(b));
+    const __m128 result = _mm_add_ps(a, _mm_mul_ps(m, b));
+    _mm_storeu_ps(rt, sse_select(sse_rgb_mask(), result, a));
+#else
+    const float m = (1.0f - (rt1[3] * fac_inv)) * rt2[3];
+    rt[0] = rt1[0] + m * rt2[0];
+    rt[1] = rt1[1] + m * rt2[1];
+    rt[2] = rt1[2] + m * rt2[2];
+    rt[3] = rt1[3];
+#endif
+  }
+}
+
+void seq_effect_sub_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  const int fac_i = (int)(256.0f * fac);
+  int i = 0;
+
+#ifdef __SSE2__
+  if (fac_i >= 0 && fac_i <= 256) {
+    const __m128i fac_v = _mm_set1_epi16((short)fac_i);
+    const __m128i rgb_mask = sse_rgb_mask_byte();
+    for (; i + 4 <= num_pixels; i += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)(rect1 + i * 4));
+      const __m128i b = _mm_loadu_si128((const __m128i *)(rect2 + i * 4));
+      const __m128i result = _mm_subs_epu8(a, sse_add_sub_term_byte(b, fac_v));
+      _mm_storeu_si128((__m128i *)(out + i * 4), sse_select_byte(rgb_mask, result, a));
+    }
+  }
+#endif
+
+  for (; i < num_pixels; i++) {
+    const uchar *cp1 = rect1 + i * 4, *cp2 = rect2 + i * 4;
+    uchar *rt = out + i * 4;
+    const int m = fac_i * (int)cp2[3];
+    rt[0] = max_ii(cp1[0] - ((m * cp2[0]) >> 16), 0);
+    rt[1] = max_ii(cp1[1] - ((m * cp2[1]) >> 16), 0);
+    rt[2] = max_ii(cp1[2] - ((m * cp2[2]) >> 16), 0);
+    rt[3] = cp1[3];
+  }
+}
+
+void seq_effect_sub_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  const float fac_inv = 1.0f - fac;
+
+  for (int i = 0; i < num_pixels; i++) {
+    const float *rt1 = rect1 + i * 4, *rt2 = rect2 + i * 4;
+    float *rt = out + i * 4;
+#ifdef __SSE2__
+    const __m128 a = _mm_loadu_ps(rt1);
+    const __m128 b = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(
+        _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(sse_splat_alpha(a), _mm_set1_ps(fac_inv))),
+        sse_splat_alpha(b));
+    const __m128 result = _mm_max_ps(_mm_sub_ps(a, _mm_mul_ps(m, b)), _mm_setzero_ps());
+    _mm_storeu_ps(rt, sse_select(sse_rgb_mask(), result, a));
+#else
+    const float m = (1.0f - (rt1[3] * fac_inv)) * rt2[3];
+    rt[0] = max_ff(rt1[0] - m * rt2[0], 0.0f);
+    rt[1] = max_ff(rt1[1] - m * rt2[1], 0.0f);
+    rt[2] = max_ff(rt1[2] - m * rt2[2], 0.0f);
+    rt[3] = rt1[3];
+#endif
+  }
+}
+
+void seq_effect_mul_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac)
+{
+  const int fac_i = (int)(256.0f * fac);
+
+  /* formula:
+   * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
+   *
+   * Products don't fit in 16 bits, leave vectorization of the plain loop to the compiler.
+   */
+  for (int i = 0; i < num_pixels * 4; i++) {
+    out[i] = rect1[i] + ((fac_i * rect1[i] * (rect2[i] - 255)) >> 16);
+  }
+}
+
+void seq_effect_mul_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac)
+{
+  const int num_channels = num_pixels * 4;
+  int i = 0;
+
+  /* formula:
+   * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
+   */
+#ifdef __SSE2__
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (; i + 4 <= num_channels; i += 4) {
+    const __m128 a = _mm_loadu_ps(rect1 + i);
+    const __m128 b = _mm_loadu_ps(rect2 + i);
+    _mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(fac_v, a), _mm_sub_ps(b, one))));
+  }
+#endif
+
+  for (; i < num_channels; i++) {
+    out[i] = rect1[i] + fac * rect1[i] * (rect2[i] - 1.0f);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Blend Modes
+ *
+ * The blend functions take their factor from alpha of the second input, alpha of the first
+ * input is multiplied by the strip factor, output keeps alpha of the first input.
+ * \{ */
+
+typedef void (*SeqBlendFuncByte)(uchar *dst, const uchar *src1, const uchar *src2);
+typedef void (*SeqBlendFuncFloat)(float *dst, const float *src1, const float *src2);
+
+/* Inlined with a constant blend function, so every blend mode gets its own loop. */
+BLI_INLINE void blend_row_byte(const uchar *rect1,
+                               const uchar *rect2,
+                               uchar *out,
+                               int num_pixels,
+                               float fac,
+                               SeqBlendFuncByte blend_function)
+{
+  for (int i = 0; i < num_pixels; i++) {
+    const uchar *rt1 = rect1 + i * 4;
+    uchar *rt = out + i * 4;
+    uchar src1[4] = {rt1[0], rt1[1], rt1[2], rt1[3]};
+    src1[3] = (unsigned int)rt1[3] * fac;
+    blend_function(rt, src1, rect2 + i * 4);
+    rt[3] = rt1[3];
+  }
+}
+
+BLI_INLINE void blend_row_float(const float *rect1,
+                                const float *rect2,
+                                float *out,
+                                int num_pixels,
+                                float fac,
+                                SeqBlendFuncFloat blend_function)
+{
+  for (int i = 0; i < num_pixels; i++) {
+    const float *rt1 = rect1 + i * 4;
+    float *rt = out + i * 4;
+    const float src1[4] = {rt1[0], rt1[1], rt1[2], rt1[3] * fac};
+    blend_function(rt, src1, rect2 + i * 4);
+    rt[3] = rt1[3];
+  }
+}
+
+#ifdef __SSE2__
+
+/* Same as the `blend_color_*_float()` functions, for a pixel in a register. */
+BLI_INLINE __m128 blend_pixel_sse(const int blend_mode, const __m128 src1, const __m128 src2)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac = sse_splat_alpha(src2);
+  const __m128 mfac = _mm_sub_ps(one, fac);
+  __m128 temp;
+
+  switch (blend_mode) {
+    case SEQ_TYPE_ADD:
+      return _mm_add_ps(src1, _mm_mul_ps(src2, sse_splat_alpha(src1)));
+    case SEQ_TYPE_SUB:
+      return _mm_max_ps(_mm_sub_ps(src1, _mm_mul_ps(src2, sse_splat_alpha(src1))), zero);
+    case SEQ_TYPE_MUL:
+      return _mm_add_ps(_mm_mul_ps(mfac, src1),
+                        _mm_mul_ps(_mm_mul_ps(src1, src2), sse_splat_alpha(src1)));
+    case SEQ_TYPE_LIGHTEN:
+    case SEQ_TYPE_DARKEN: {
+      const __m128 map_alpha = _mm_div_ps(sse_splat_alpha(src1), fac);
+      const __m128 src2_mapped = _mm_mul_ps(src2, map_alpha);
+      temp = (blend_mode == SEQ_TYPE_LIGHTEN) ? _mm_max_ps(src1, src2_mapped) :
+                                                 _mm_min_ps(src1, src2_mapped);
+      return _mm_add_ps(_mm_mul_ps(mfac, src1), _mm_mul_ps(fac, temp));
+    }
+    case SEQ_TYPE_SCREEN:
+      temp = _mm_max_ps(
+          _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, src1), _mm_sub_ps(one, src2))), zero);
+      break;
+    case SEQ_TYPE_LINEAR_BURN:
+      temp = _mm_max_ps(_mm_sub_ps(_mm_add_ps(src1, src2), one), zero);
+      break;
+    case SEQ_TYPE_DIFFERENCE:
+      temp = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(src1, src2));
+      break;
+    case SEQ_TYPE_EXCLUSION: {
+      const __m128 half = _mm_set1_ps(0.5f);
+      const __m128 src1_twice = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_sub_ps(src1, half));
+      temp = _mm_sub_ps(half, _mm_mul_ps(src1_twice, _mm_sub_ps(src2, half)));
+      break;
+    }
+    default:
+      BLI_assert(0);
+      return src1;
+  }
+
+  return _mm_add_ps(_mm_mul_ps(temp, fac), _mm_mul_ps(src1, mfac));
+}
+
+BLI_INLINE void blend_row_float_sse(const float *rect1,
+                                    const float *rect2,
+                                    float *out,
+                                    int num_pixels,
+                                    float fac,
+                                    const int blend_mode)
+{
+  const __m128 src1_fac = _mm_set_ps(fac, 1.0f, 1.0f, 1.0f);
+  const __m128 rgb_mask = sse_rgb_mask();
+  for (int i = 0; i < num_pixels; i++) {
+    const __m128 rt1 = _mm_loadu_ps(rect1 + i * 4);
+    const __m128 src1 = _mm_mul_ps(rt1, src1_fac);
+    const __m128 src2 = _mm_loadu_ps(rect2 + i * 4);
+    /* Pixels with zero alpha in the second input are a no-op. */
+    const __m128 no_op = _mm_cmpeq_ps(sse_splat_alpha(src2), _mm_setzero_ps());
+    const __m128 result = sse_select(no_op, src1, blend_pixel_sse(blend_mode, src1, src2));
+    _mm_storeu_ps(out + i * 4, sse_select(rgb_mask, result, rt1));
+  }
+}
+
+#endif /* __SSE2__ */
+
+void seq_effect_blend_row_byte(const uchar *rect1,
+                               const uchar *rect2,
+                               uchar *out,
+                               int num_pixels,
+                               float fac,
+                               int blend_mode)
+{
+#define BLEND_ROW(blend_function) \
+  blend_row_byte(rect1, rect2, out, num_pixels, fac, blend_function)
+
+  switch (blend_mode) {
+    case SEQ_TYPE_ADD:
+      BLEND_ROW(blend_color_add_byte);
+      break;
+    case SEQ_TYPE_SUB:
+      BLEND_ROW(blend_color_sub_byte);
+      break;
+    case SEQ_TYPE_MUL:
+      BLEND_ROW(blend_color_mul_byte);
+      break;
+    case SEQ_TYPE_DARKEN:
+      BLEND_ROW(blend_color_darken_byte);
+      break;
+    case SEQ_TYPE_COLOR_BURN:
+      BLEND_ROW(blend_color_burn_byte);
+      break;
+    case SEQ_TYPE_LINEAR_BURN:
+      BLEND_ROW(blend_color_linearburn_byte);
+      break;
+    case SEQ_TYPE_SCREEN:
+      BLEND_ROW(blend_color_screen_byte);
+      break;
+    case SEQ_TYPE_LIGHTEN:
+      BLEND_ROW(blend_color_lighten_byte);
+      break;
+    case SEQ_TYPE_DODGE:
+      BLEND_ROW(blend_color_dodge_byte);
+      break;
+    case SEQ_TYPE_OVERLAY:
+      BLEND_ROW(blend_color_overlay_byte);
+      break;
+    case SEQ_TYPE_SOFT_LIGHT:
+      BLEND_ROW(blend_color_softlight_byte);
+      break;
+    case SEQ_TYPE_HARD_LIGHT:
+      BLEND_ROW(blend_color_hardlight_byte);
+      break;
+    case SEQ_TYPE_PIN_LIGHT:
+      BLEND_ROW(blend_color_pinlight_byte);
+      break;
+    case SEQ_TYPE_LIN_LIGHT:
+      BLEND_ROW(blend_color_linearlight_byte);
+      break;
+    case SEQ_TYPE_VIVID_LIGHT:
+      BLEND_ROW(blend_color_vividlight_byte);
+      break;
+    case SEQ_TYPE_BLEND_COLOR:
+      BLEND_ROW(blend_color_color_byte);
+      break;
+    case SEQ_TYPE_HUE:
+      BLEND_ROW(blend_color_hue_byte);
+      break;
+    case SEQ_TYPE_SATURATION:
+      BLEND_ROW(blend_color_saturation_byte);
+      break;
+    case SEQ_TYPE_VALUE:
+      BLEND_ROW(blend_color_luminosity_byte);
+      break;
+    case SEQ_TYPE_DIFFERENCE:
+      BLEND_ROW(blend_color_difference_byte);
+      break;
+    case SEQ_TYPE_EXCLUSION:
+      BLEND_ROW(blend_color_exclusion_byte);
+      break;
+    default:
+      break;
+  }
+
+#undef BLEND_ROW
+}
+
+void seq_effect_blend_row_float(const float *rect1,
+                                const float *rect2,
+                                float *out,
+                                int num_pixels,
+                                float fac,
+                                int blend_mode)
+{
+#ifdef __SSE2__
+#  define BLEND_ROW_SSE(blend_mode) \
+    blend_row_float_sse(rect1, rect2, out, num_pixels, fac, blend_mode)
+#endif
+#define BLEND_ROW(blend_function) \
+  blend_row_float(rect1, rect2, out, num_pixels, fac, blend_function)
+
+  switch (blend_mode) {
+#ifdef __SSE2__
+    case SEQ_TYPE_ADD:
+      BLEND_ROW_SSE(SEQ_TYPE_ADD);
+      break;
+    case SEQ_TYPE_SUB:
+      BLEND_ROW_SSE(SEQ_TYPE_SUB);
+      break;
+    case SEQ_TYPE_MUL:
+      BLEND_ROW_SSE(SEQ_TYPE_MUL);
+      break;
+    case SEQ_TYPE_DARKEN:
+      BLEND_ROW_SSE(SEQ_TYPE_DARKEN);
+      break;
+    case SEQ_TYPE_LINEAR_BURN:
+      BLEND_ROW_SSE(SEQ_TYPE_LINEAR_BURN);
+      break;
+    case SEQ_TYPE_SCREEN:
+      BLEND_ROW_SSE(SEQ_TYPE_SCREEN);
+      break;
+    case SEQ_TYPE_LIGHTEN:
+      BLEND_ROW_SSE(SEQ_TYPE_LIGHTEN);
+      break;
+    case SEQ_TYPE_DIFFERENCE:
+      BLEND_ROW_SSE(SEQ_TYPE_DIFFERENCE);
+      break;
+    case SEQ_TYPE_EXCLUSION:
+      BLEND_ROW_SSE(SEQ_TYPE_EXCLUSION);
+      break;
+#else
+    case SEQ_TYPE_ADD:
+      BLEND_ROW(blend_color_add_float);
+      break;
+    case SEQ_TYPE_SUB:
+      BLEND_ROW(blend_color_sub_float);
+      break;
+    case SEQ_TYPE_MUL:
+      BLEND_ROW(blend_color_mul_float);
+      break;
+    case SEQ_TYPE_DARKEN:
+      BLEND_ROW(blend_color_darken_float);
+      break;
+    case SEQ_TYPE_LINEAR_BURN:
+      BLEND_ROW(blend_color_linearburn_float);
+      break;
+    case SEQ_TYPE_SCREEN:
+      BLEND_ROW(blend_color_screen_float);
+      break;
+    case SEQ_TYPE_LIGHTEN:
+      BLEND_ROW(blend_color_lighten_float);
+      break;
+    case SEQ_TYPE_DIFFERENCE:
+      BLEND_ROW(blend_color_difference_float);
+      break;
+    case SEQ_TYPE_EXCLUSION:
+      BLEND_ROW(blend_color_exclusion_float);
+      break;
+#endif
+    /* Modes which depend on per channel conditions or color space conversions. */
+    case SEQ_TYPE_COLOR_BURN:
+      BLEND_ROW(blend_color_burn_float);
+      break;
+    case SEQ_TYPE_DODGE:
+      BLEND_ROW(blend_color_dodge_float);
+      break;
+    case SEQ_TYPE_OVERLAY:
+      BLEND_ROW(blend_color_overlay_float);
+      break;
+    case SEQ_TYPE_SOFT_LIGHT:
+      BLEND_ROW(blend_color_softlight_float);
+      break;
+    case SEQ_TYPE_HARD_LIGHT:
+      BLEND_ROW(blend_color_hardlight_float);
+      break;
+    case SEQ_TYPE_PIN_LIGHT:
+      BLEND_ROW(blend_color_pinlight_float);
+      break;
+    case SEQ_TYPE_LIN_LIGHT:
+      BLEND_ROW(blend_color_linearlight_float);
+      break;
+    case SEQ_TYPE_VIVID_LIGHT:
+      BLEND_ROW(blend_color_vividlight_float);
+      break;
+    case SEQ_TYPE_BLEND_COLOR:
+      BLEND_ROW(blend_color_color_float);
+      break;
+    case SEQ_TYPE_HUE:
+      BLEND_ROW(blend_color_hue_float);
+      break;
+    case SEQ_TYPE_SATURATION:
+      BLEND_ROW(blend_color_saturation_float);
+      break;
+    case SEQ_TYPE_VALUE:
+      BLEND_ROW(blend_color_luminosity_float);
+      break;
+    default:
+      break;
+  }
+
+#undef BLEND_ROW
+#ifdef __SSE2__
+#  undef BLEND_ROW_SSE
+#endif
+}
+
+/** \} */
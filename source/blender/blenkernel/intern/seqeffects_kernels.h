@@ -0,0 +1,92 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Per-row pixel kernels of sequencer blend and effect strips.
+ *
+ * Every kernel processes \a num_pixels RGBA pixels of a single row with a constant factor, the
+ * effects call them for every row of their slice. Kernels use SSE2 where it is available, the
+ * results match the scalar code they replace (exactly for byte buffers, within float rounding for
+ * float buffers).
+ */
+
+#pragma once
+
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cross. */
+void seq_effect_cross_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_cross_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+
+/* Alpha Over and Alpha Under. */
+void seq_effect_alphaover_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_alphaover_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+void seq_effect_alphaunder_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_alphaunder_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+
+/* Gamma Cross, #seq_effect_gammacross_init must be called before the kernels are used. */
+void seq_effect_gammacross_init(void);
+void seq_effect_gammacross_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_gammacross_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+
+/* Add, Subtract and Multiply effect strips. */
+void seq_effect_add_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_add_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+void seq_effect_sub_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_sub_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+void seq_effect_mul_row_byte(
+    const uchar *rect1, const uchar *rect2, uchar *out, int num_pixels, float fac);
+void seq_effect_mul_row_float(
+    const float *rect1, const float *rect2, float *out, int num_pixels, float fac);
+
+/**
+ * Blend mode of strips and of the Color Mix effect, \a blend_mode is one of the
+ * `SEQ_TYPE_*` blend types. Alpha of \a rect1 is multiplied by \a fac before blending.
+ */
+void seq_effect_blend_row_byte(const uchar *rect1,
+                               const uchar *rect2,
+                               uchar *out,
+                               int num_pixels,
+                               float fac,
+                               int blend_mode);
+void seq_effect_blend_row_float(const float *rect1,
+                                const float *rect2,
+                                float *out,
+                                int num_pixels,
+                                float fac,
+                                int blend_mode);
+
+#ifdef __cplusplus
+}
+#endif
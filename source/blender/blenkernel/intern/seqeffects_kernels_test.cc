@@ -0,0 +1,657 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_color.h"
+#include "BLI_math_color_blend.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_sequence_types.h"
+
+#include "PIL_time.h"
+
+#include "seqeffects_kernels.h"
+
+#define DO_PERF_TESTS 0
+
+namespace blender::bke::tests {
+
+/* Odd width to test the scalar tail of vectorized loops. */
+static const int TEST_WIDTH = 1001;
+static const float TEST_FACTORS[] = {0.0f, 0.3f, 1.0f};
+
+/* -------------------------------------------------------------------- */
+/* Reference implementations, per pixel code the kernels replace. */
+
+using RowFuncByte = void (*)(const uchar *, const uchar *, uchar *, int, float);
+using RowFuncFloat = void (*)(const float *, const float *, float *, int, float);
+
+static void reference_cross_byte(
+    const uchar *rt1, const uchar *rt2, uchar *rt, int num_pixels, float fac)
+{
+  const int fac2 = (int)(256.0f * fac);
+  const int fac1 = 256 - fac2;
+  for (int i = 0; i < num_pixels * 4; i++) {
+    rt[i] = (fac1 * rt1[i] + fac2 * rt2[i]) >> 8;
+  }
+}
+
+static void reference_cross_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  for (int i = 0; i < num_pixels * 4; i++) {
+    rt[i] = (1.0f - fac) * rt1[i] + fac * rt2[i];
+  }
+}
+
+static void reference_alphaover_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  for (int i = 0; i < num_pixels; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float mfac = 1.0f - (fac * rt1[3]);
+    for (int c = 0; c < 4; c++) {
+      if (fac <= 0.0f) {
+        rt[c] = rt2[c];
+      }
+      else if (mfac <= 0.0f) {
+        rt[c] = rt1[c];
+      }
+      else {
+        rt[c] = fac * rt1[c] + mfac * rt2[c];
+      }
+    }
+  }
+}
+
+static void reference_alphaover_byte(
+    const uchar *cp1, const uchar *cp2, uchar *rt, int num_pixels, float fac)
+{
+  float rt1[4], rt2[4], tempc[4];
+  for (int i = 0; i < num_pixels; i++, cp1 += 4, cp2 += 4, rt += 4) {
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    const float mfac = 1.0f - fac * rt1[3];
+
+    if (fac <= 0.0f) {
+      *((unsigned int *)rt) = *((unsigned int *)cp2);
+    }
+    else if (mfac <= 0.0f) {
+      *((unsigned int *)rt) = *((unsigned int *)cp1);
+    }
+    else {
+      tempc[0] = fac * rt1[0] + mfac * rt2[0];
+      tempc[1] = fac * rt1[1] + mfac * rt2[1];
+      tempc[2] = fac * rt1[2] + mfac * rt2[2];
+      tempc[3] = fac * rt1[3] + mfac * rt2[3];
+
+      premul_float_to_straight_uchar(rt, tempc);
+    }
+  }
+}
+
+static void reference_alphaunder_byte(
+    const uchar *cp1, const uchar *cp2, uchar *rt, int num_pixels, float fac)
+{
+  float rt1[4], rt2[4], tempc[4];
+  for (int i = 0; i < num_pixels; i++, cp1 += 4, cp2 += 4, rt += 4) {
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+
+    if (rt2[3] <= 0.0f && fac >= 1.0f) {
+      *((unsigned int *)rt) = *((unsigned int *)cp1);
+    }
+    else if (rt2[3] >= 1.0f) {
+      *((unsigned int *)rt) = *((unsigned int *)cp2);
+    }
+    else {
+      const float fac_pixel = fac * (1.0f - rt2[3]);
+
+      if (fac_pixel <= 0) {
+        *((unsigned int *)rt) = *((unsigned int *)cp2);
+      }
+      else {
+        tempc[0] = fac_pixel * rt1[0] + rt2[0];
+        tempc[1] = fac_pixel * rt1[1] + rt2[1];
+        tempc[2] = fac_pixel * rt1[2] + rt2[2];
+        tempc[3] = fac_pixel * rt1[3] + rt2[3];
+
+        premul_float_to_straight_uchar(rt, tempc);
+      }
+    }
+  }
+}
+
+static void reference_alphaunder_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  for (int i = 0; i < num_pixels; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float fac_pixel = fac * (1.0f - rt2[3]);
+    for (int c = 0; c < 4; c++) {
+      if (rt2[3] <= 0.0f && fac >= 1.0f) {
+        rt[c] = rt1[c];
+      }
+      else if (rt2[3] >= 1.0f || fac_pixel == 0.0f) {
+        rt[c] = rt2[c];
+      }
+      else {
+        rt[c] = fac_pixel * rt1[c] + rt2[c];
+      }
+    }
+  }
+}
+
+/* Gamma tables with gamma 2.0, as built by the gamma cross effect. */
+struct ReferenceGammaTables {
+  static const int size = 400;
+  float domain[size + 1];
+  float range[size + 1], factor[size];
+  float inv_range[size + 1], inv_factor[size];
+
+  ReferenceGammaTables()
+  {
+    for (int i = 0; i < size; i++) {
+      domain[i] = i * (1.0f / size);
+      range[i] = (float)pow((double)domain[i], 2.0);
+      inv_range[i] = (float)pow((double)domain[i], 0.5);
+    }
+    domain[size] = range[size] = inv_range[size] = 1.0f;
+    for (int i = 0; i < size; i++) {
+      factor[i] = (float)size * (range[i + 1] - range[i]);
+      inv_factor[i] = (float)size * (inv_range[i + 1] - inv_range[i]);
+    }
+  }
+
+  float lookup(float c, float gamma, const float *range_table, const float *factor_table) const
+  {
+    const int i = floorf(c * (float)size);
+    if (i < 0) {
+      return -powf(-c, gamma);
+    }
+    if (i >= size) {
+      return powf(c, gamma);
+    }
+    return range_table[i] + ((c - domain[i]) * factor_table[i]);
+  }
+
+  float cross(float fac, float c1, float c2) const
+  {
+    return lookup((1.0f - fac) * lookup(c1, 0.5f, inv_range, inv_factor) +
+                      fac * lookup(c2, 0.5f, inv_range, inv_factor),
+                  2.0f,
+                  range,
+                  factor);
+  }
+};
+
+static const ReferenceGammaTables &reference_gamma_tables()
+{
+  static const ReferenceGammaTables tables;
+  return tables;
+}
+
+static void reference_gammacross_byte(
+    const uchar *cp1, const uchar *cp2, uchar *rt, int num_pixels, float fac)
+{
+  const ReferenceGammaTables &tables = reference_gamma_tables();
+  float rt1[4], rt2[4], tempc[4];
+  for (int i = 0; i < num_pixels; i++, cp1 += 4, cp2 += 4, rt += 4) {
+    straight_uchar_to_premul_float(rt1, cp1);
+    straight_uchar_to_premul_float(rt2, cp2);
+    for (int c = 0; c < 4; c++) {
+      tempc[c] = tables.cross(fac, rt1[c], rt2[c]);
+    }
+    premul_float_to_straight_uchar(rt, tempc);
+  }
+}
+
+static void reference_gammacross_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  const ReferenceGammaTables &tables = reference_gamma_tables();
+  for (int i = 0; i < num_pixels * 4; i++) {
+    rt[i] = tables.cross(fac, rt1[i], rt2[i]);
+  }
+}
+
+static void reference_add_byte(
+    const uchar *cp1, const uchar *cp2, uchar *rt, int num_pixels, float fac)
+{
+  const int fac_i = (int)(256.0f * fac);
+  for (int i = 0; i < num_pixels; i++, cp1 += 4, cp2 += 4, rt += 4) {
+    const int m = fac_i * (int)cp2[3];
+    for (int c = 0; c < 3; c++) {
+      rt[c] = min_ii(cp1[c] + ((m * cp2[c]) >> 16), 255);
+    }
+    rt[3] = cp1[3];
+  }
+}
+
+static void reference_add_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  for (int i = 0; i < num_pixels; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float m = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
+    for (int c = 0; c < 3; c++) {
+      rt[c] = rt1[c] + m * rt2[c];
+    }
+    rt[3] = rt1[3];
+  }
+}
+
+static void reference_sub_byte(
+    const uchar *cp1, const uchar *cp2, uchar *rt, int num_pixels, float fac)
+{
+  const int fac_i = (int)(256.0f * fac);
+  for (int i = 0; i < num_pixels; i++, cp1 += 4, cp2 += 4, rt += 4) {
+    const int m = fac_i * (int)cp2[3];
+    for (int c = 0; c < 3; c++) {
+      rt[c] = max_ii(cp1[c] - ((m * cp2[c]) >> 16), 0);
+    }
+    rt[3] = cp1[3];
+  }
+}
+
+static void reference_sub_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  for (int i = 0; i < num_pixels; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float m = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
+    for (int c = 0; c < 3; c++) {
+      rt[c] = max_ff(rt1[c] - m * rt2[c], 0.0f);
+    }
+    rt[3] = rt1[3];
+  }
+}
+
+static void reference_mul_byte(
+    const uchar *rt1, const uchar *rt2, uchar *rt, int num_pixels, float fac)
+{
+  const int fac_i = (int)(256.0f * fac);
+  for (int i = 0; i < num_pixels * 4; i++) {
+    rt[i] = rt1[i] + ((fac_i * rt1[i] * (rt2[i] - 255)) >> 16);
+  }
+}
+
+static void reference_mul_float(
+    const float *rt1, const float *rt2, float *rt, int num_pixels, float fac)
+{
+  for (int i = 0; i < num_pixels * 4; i++) {
+    rt[i] = rt1[i] + fac * rt1[i] * (rt2[i] - 1.0f);
+  }
+}
+
+struct BlendMode {
+  int mode;
+  const char *name;
+  void (*func_byte)(uchar dst[4], const uchar src1[4], const uchar src2[4]);
+  void (*func_float)(float dst[4], const float src1[4], const float src2[4]);
+};
+
+static const BlendMode blend_modes[] = {
+    {SEQ_TYPE_ADD, "add", blend_color_add_byte, blend_color_add_float},
+    {SEQ_TYPE_SUB, "sub", blend_color_sub_byte, blend_color_sub_float},
+    {SEQ_TYPE_MUL, "mul", blend_color_mul_byte, blend_color_mul_float},
+    {SEQ_TYPE_DARKEN, "darken", blend_color_darken_byte, blend_color_darken_float},
+    {SEQ_TYPE_COLOR_BURN, "color burn", blend_color_burn_byte, blend_color_burn_float},
+    {SEQ_TYPE_LINEAR_BURN,
+     "linear burn",
+     blend_color_linearburn_byte,
+     blend_color_linearburn_float},
+    {SEQ_TYPE_SCREEN, "screen", blend_color_screen_byte, blend_color_screen_float},
+    {SEQ_TYPE_LIGHTEN, "lighten", blend_color_lighten_byte, blend_color_lighten_float},
+    {SEQ_TYPE_DODGE, "dodge", blend_color_dodge_byte, blend_color_dodge_float},
+    {SEQ_TYPE_OVERLAY, "overlay", blend_color_overlay_byte, blend_color_overlay_float},
+    {SEQ_TYPE_SOFT_LIGHT, "soft light", blend_color_softlight_byte, blend_color_softlight_float},
+    {SEQ_TYPE_HARD_LIGHT, "hard light", blend_color_hardlight_byte, blend_color_hardlight_float},
+    {SEQ_TYPE_PIN_LIGHT, "pin light", blend_color_pinlight_byte, blend_color_pinlight_float},
+    {SEQ_TYPE_LIN_LIGHT,
+     "linear light",
+     blend_color_linearlight_byte,
+     blend_color_linearlight_float},
+    {SEQ_TYPE_VIVID_LIGHT,
+     "vivid light",
+     blend_color_vividlight_byte,
+     blend_color_vividlight_float},
+    {SEQ_TYPE_BLEND_COLOR, "color", blend_color_color_byte, blend_color_color_float},
+    {SEQ_TYPE_HUE, "hue", blend_color_hue_byte, blend_color_hue_float},
+    {SEQ_TYPE_SATURATION, "saturation", blend_color_saturation_byte, blend_color_saturation_float},
+    {SEQ_TYPE_VALUE, "value", blend_color_luminosity_byte, blend_color_luminosity_float},
+    {SEQ_TYPE_DIFFERENCE, "difference", blend_color_difference_byte, blend_color_difference_float},
+    {SEQ_TYPE_EXCLUSION, "exclusion", blend_color_exclusion_byte, blend_color_exclusion_float},
+};
+
+static void reference_blend_byte(const BlendMode &blend_mode,
+                                 const uchar *rt1,
+                                 const uchar *rt2,
+                                 uchar *rt,
+                                 int num_pixels,
+                                 float fac)
+{
+  for (int i = 0; i < num_pixels; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    uchar src1[4] = {rt1[0], rt1[1], rt1[2], rt1[3]};
+    src1[3] = (unsigned int)rt1[3] * fac;
+    blend_mode.func_byte(rt, src1, rt2);
+    rt[3] = rt1[3];
+  }
+}
+
+static void reference_blend_float(const BlendMode &blend_mode,
+                                  const float *rt1,
+                                  const float *rt2,
+                                  float *rt,
+                                  int num_pixels,
+                                  float fac)
+{
+  for (int i = 0; i < num_pixels; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float src1[4] = {rt1[0], rt1[1], rt1[2], rt1[3] * fac};
+    blend_mode.func_float(rt, src1, rt2);
+    rt[3] = rt1[3];
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Test data. */
+
+/* Premultiplied pixels, including fully transparent and fully opaque ones. */
+static float *pixels_float_create(int num_pixels, int seed)
+{
+  float *rect = (float *)MEM_malloc_arrayN(num_pixels * 4, sizeof(float), __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < num_pixels; i++) {
+    float *pixel = rect + i * 4;
+    const int alpha_case = BLI_rng_get_int(rng) % 8;
+    pixel[3] = (alpha_case == 0) ? 0.0f : (alpha_case == 1) ? 1.0f : BLI_rng_get_float(rng);
+    for (int c = 0; c < 3; c++) {
+      pixel[c] = BLI_rng_get_float(rng) * pixel[3];
+    }
+  }
+  BLI_rng_free(rng);
+  return rect;
+}
+
+static uchar *pixels_byte_create(int num_pixels, int seed)
+{
+  uchar *rect = (uchar *)MEM_malloc_arrayN(num_pixels * 4, sizeof(uchar), __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < num_pixels * 4; i++) {
+    rect[i] = (uchar)(BLI_rng_get_uint(rng) & 0xff);
+  }
+  /* Fully transparent and fully opaque pixels. */
+  for (int i = 0; i < num_pixels; i += 7) {
+    rect[i * 4 + 3] = (i % 2) ? 0 : 255;
+  }
+  BLI_rng_free(rng);
+  return rect;
+}
+
+struct TestBuffers {
+  int num_pixels;
+  uchar *byte1, *byte2, *byte_out, *byte_expected;
+  float *float1, *float2, *float_out, *float_expected;
+
+  TestBuffers(int num_pixels) : num_pixels(num_pixels)
+  {
+    byte1 = pixels_byte_create(num_pixels, 1);
+    byte2 = pixels_byte_create(num_pixels, 2);
+    byte_out = (uchar *)MEM_calloc_arrayN(num_pixels * 4, sizeof(uchar), __func__);
+    byte_expected = (uchar *)MEM_calloc_arrayN(num_pixels * 4, sizeof(uchar), __func__);
+    float1 = pixels_float_create(num_pixels, 3);
+    float2 = pixels_float_create(num_pixels, 4);
+    float_out = (float *)MEM_calloc_arrayN(num_pixels * 4, sizeof(float), __func__);
+    float_expected = (float *)MEM_calloc_arrayN(num_pixels * 4, sizeof(float), __func__);
+  }
+
+  ~TestBuffers()
+  {
+    MEM_freeN(byte1);
+    MEM_freeN(byte2);
+    MEM_freeN(byte_out);
+    MEM_freeN(byte_expected);
+    MEM_freeN(float1);
+    MEM_freeN(float2);
+    MEM_freeN(float_out);
+    MEM_freeN(float_expected);
+  }
+
+  void expect_byte_equal(const char *id, float fac) const
+  {
+    for (int i = 0; i < num_pixels * 4; i++) {
+      if (byte_out[i] != byte_expected[i]) {
+        ADD_FAILURE() << id << ", factor " << fac << ": mismatch at pixel " << i / 4
+                      << ", channel " << i % 4 << ": " << (int)byte_out[i]
+                      << " != " << (int)byte_expected[i];
+        return;
+      }
+    }
+  }
+
+  void expect_float_near(const char *id, float fac) const
+  {
+    for (int i = 0; i < num_pixels * 4; i++) {
+      const float expected = float_expected[i];
+      const float tolerance = 1e-6f * max_ff(1.0f, fabsf(expected));
+      if (!(fabsf(float_out[i] - expected) <= tolerance) &&
+          !(std::isnan(float_out[i]) && std::isnan(expected))) {
+        ADD_FAILURE() << id << ", factor " << fac << ": mismatch at pixel " << i / 4
+                      << ", channel " << i % 4 << ": " << float_out[i] << " != " << expected;
+        return;
+      }
+    }
+  }
+};
+
+static void test_kernel_byte(const char *id, RowFuncByte kernel, RowFuncByte reference)
+{
+  TestBuffers buffers(TEST_WIDTH);
+  for (float fac : TEST_FACTORS) {
+    kernel(buffers.byte1, buffers.byte2, buffers.byte_out, TEST_WIDTH, fac);
+    reference(buffers.byte1, buffers.byte2, buffers.byte_expected, TEST_WIDTH, fac);
+    buffers.expect_byte_equal(id, fac);
+  }
+}
+
+static void test_kernel_float(const char *id, RowFuncFloat kernel, RowFuncFloat reference)
+{
+  TestBuffers buffers(TEST_WIDTH);
+  for (float fac : TEST_FACTORS) {
+    kernel(buffers.float1, buffers.float2, buffers.float_out, TEST_WIDTH, fac);
+    reference(buffers.float1, buffers.float2, buffers.float_expected, TEST_WIDTH, fac);
+    buffers.expect_float_near(id, fac);
+  }
+}
+
+TEST(seqeffects_kernels, Effects)
+{
+  seq_effect_gammacross_init();
+
+  test_kernel_byte("cross", seq_effect_cross_row_byte, reference_cross_byte);
+  test_kernel_float("cross", seq_effect_cross_row_float, reference_cross_float);
+  test_kernel_byte("gamma cross", seq_effect_gammacross_row_byte, reference_gammacross_byte);
+  test_kernel_float("gamma cross", seq_effect_gammacross_row_float, reference_gammacross_float);
+  test_kernel_byte("alpha over", seq_effect_alphaover_row_byte, reference_alphaover_byte);
+  test_kernel_float("alpha over", seq_effect_alphaover_row_float, reference_alphaover_float);
+  test_kernel_byte("alpha under", seq_effect_alphaunder_row_byte, reference_alphaunder_byte);
+  test_kernel_float("alpha under", seq_effect_alphaunder_row_float, reference_alphaunder_float);
+  test_kernel_byte("add", seq_effect_add_row_byte, reference_add_byte);
+  test_kernel_float("add", seq_effect_add_row_float, reference_add_float);
+  test_kernel_byte("sub", seq_effect_sub_row_byte, reference_sub_byte);
+  test_kernel_float("sub", seq_effect_sub_row_float, reference_sub_float);
+  test_kernel_byte("mul", seq_effect_mul_row_byte, reference_mul_byte);
+  test_kernel_float("mul", seq_effect_mul_row_float, reference_mul_float);
+}
+
+TEST(seqeffects_kernels, BlendModes)
+{
+  TestBuffers buffers(TEST_WIDTH);
+  for (const BlendMode &blend_mode : blend_modes) {
+    for (float fac : TEST_FACTORS) {
+      seq_effect_blend_row_byte(
+          buffers.byte1, buffers.byte2, buffers.byte_out, TEST_WIDTH, fac, blend_mode.mode);
+      reference_blend_byte(
+          blend_mode, buffers.byte1, buffers.byte2, buffers.byte_expected, TEST_WIDTH, fac);
+      buffers.expect_byte_equal(blend_mode.name, fac);
+
+      seq_effect_blend_row_float(
+          buffers.float1, buffers.float2, buffers.float_out, TEST_WIDTH, fac, blend_mode.mode);
+      reference_blend_float(
+          blend_mode, buffers.float1, buffers.float2, buffers.float_expected, TEST_WIDTH, fac);
+      buffers.expect_float_near(blend_mode.name, fac);
+    }
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Benchmarks, single threaded over a 4K frame. */
+
+#if DO_PERF_TESTS
+
+/* 4K frame for benchmarks. */
+static const int BENCHMARK_WIDTH = 3840;
+static const int BENCHMARK_HEIGHT = 2160;
+
+template<typename Func> static double benchmark_time(const Func &func)
+{
+  const double time_start = PIL_check_seconds_timer();
+  for (int y = 0; y < BENCHMARK_HEIGHT; y++) {
+    func((size_t)y * BENCHMARK_WIDTH * 4);
+  }
+  return PIL_check_seconds_timer() - time_start;
+}
+
+static void benchmark_print(const char *id, double time_reference, double time_kernel)
+{
+  printf("%-24s reference %7.2f ms, kernel %7.2f ms, speedup %5.2fx\n",
+         id,
+         time_reference * 1000.0,
+         time_kernel * 1000.0,
+         time_reference / time_kernel);
+}
+
+static void benchmark_kernel_byte(const char *id,
+                                  TestBuffers &buffers,
+                                  RowFuncByte kernel,
+                                  RowFuncByte reference)
+{
+  const double time_reference = benchmark_time([&](size_t offset) {
+    reference(buffers.byte1 + offset,
+              buffers.byte2 + offset,
+              buffers.byte_expected + offset,
+              BENCHMARK_WIDTH,
+              0.5f);
+  });
+  const double time_kernel = benchmark_time([&](size_t offset) {
+    kernel(buffers.byte1 + offset,
+           buffers.byte2 + offset,
+           buffers.byte_out + offset,
+           BENCHMARK_WIDTH,
+           0.5f);
+  });
+  benchmark_print(id, time_reference, time_kernel);
+}
+
+static void benchmark_kernel_float(const char *id,
+                                   TestBuffers &buffers,
+                                   RowFuncFloat kernel,
+                                   RowFuncFloat reference)
+{
+  const double time_reference = benchmark_time([&](size_t offset) {
+    reference(buffers.float1 + offset,
+              buffers.float2 + offset,
+              buffers.float_expected + offset,
+              BENCHMARK_WIDTH,
+              0.5f);
+  });
+  const double time_kernel = benchmark_time([&](size_t offset) {
+    kernel(buffers.float1 + offset,
+           buffers.float2 + offset,
+           buffers.float_out + offset,
+           BENCHMARK_WIDTH,
+           0.5f);
+  });
+  benchmark_print(id, time_reference, time_kernel);
+}
+
+TEST(seqeffects_kernels, Benchmark)
+{
+  const int num_pixels = BENCHMARK_WIDTH * BENCHMARK_HEIGHT;
+  TestBuffers buffers(num_pixels);
+  /* Touch output buffers, so page faults are not included in timings of the first run. */
+  memset(buffers.byte_out, 0, sizeof(uchar[4]) * num_pixels);
+  memset(buffers.byte_expected, 0, sizeof(uchar[4]) * num_pixels);
+  memset(buffers.float_out, 0, sizeof(float[4]) * num_pixels);
+  memset(buffers.float_expected, 0, sizeof(float[4]) * num_pixels);
+
+  seq_effect_gammacross_init();
+
+  printf("\nByte %dx%d:\n", BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+  benchmark_kernel_byte("cross", buffers, seq_effect_cross_row_byte, reference_cross_byte);
+  benchmark_kernel_byte(
+      "gamma cross", buffers, seq_effect_gammacross_row_byte, reference_gammacross_byte);
+  benchmark_kernel_byte(
+      "alpha over", buffers, seq_effect_alphaover_row_byte, reference_alphaover_byte);
+  benchmark_kernel_byte(
+      "alpha under", buffers, seq_effect_alphaunder_row_byte, reference_alphaunder_byte);
+  benchmark_kernel_byte("add", buffers, seq_effect_add_row_byte, reference_add_byte);
+  benchmark_kernel_byte("sub", buffers, seq_effect_sub_row_byte, reference_sub_byte);
+  benchmark_kernel_byte("mul", buffers, seq_effect_mul_row_byte, reference_mul_byte);
+
+  printf("\nFloat %dx%d:\n", BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+  benchmark_kernel_float("cross", buffers, seq_effect_cross_row_float, reference_cross_float);
+  benchmark_kernel_float(
+      "gamma cross", buffers, seq_effect_gammacross_row_float, reference_gammacross_float);
+  benchmark_kernel_float(
+      "alpha over", buffers, seq_effect_alphaover_row_float, reference_alphaover_float);
+  benchmark_kernel_float(
+      "alpha under", buffers, seq_effect_alphaunder_row_float, reference_alphaunder_float);
+  benchmark_kernel_float("add", buffers, seq_effect_add_row_float, reference_add_float);
+  benchmark_kernel_float("sub", buffers, seq_effect_sub_row_float, reference_sub_float);
+  benchmark_kernel_float("mul", buffers, seq_effect_mul_row_float, reference_mul_float);
+
+  printf("\nFloat blend modes %dx%d:\n", BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+  for (const BlendMode &blend_mode : blend_modes) {
+    const double time_reference = benchmark_time([&](size_t offset) {
+      reference_blend_float(blend_mode,
+                            buffers.float1 + offset,
+                            buffers.float2 + offset,
+                            buffers.float_expected + offset,
+                            BENCHMARK_WIDTH,
+                            0.5f);
+    });
+    const double time_kernel = benchmark_time([&](size_t offset) {
+      seq_effect_blend_row_float(buffers.float1 + offset,
+                                 buffers.float2 + offset,
+                                 buffers.float_out + offset,
+                                 BENCHMARK_WIDTH,
+                                 0.5f,
+                                 blend_mode.mode);
+    });
+    benchmark_print(blend_mode.name, time_reference, time_kernel);
+  }
+}
+
+#endif
+
+}  // namespace blender::bke::tests
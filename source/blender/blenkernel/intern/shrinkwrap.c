@@ -92,8 +92,18 @@ typedef struct ShrinkwrapCalcData {
   float keepDist;  // Distance to keep above target surface (units are in local space)
 } ShrinkwrapCalcData;
 
+/* Vertices to move in target space, queried as one batch. */
+typedef struct ShrinkwrapNearestBatch {
+  int *vert_index;
+  float (*co)[3];
+  float *weight;
+  BVHTreeNearest *nearest;
+  int len;
+} ShrinkwrapNearestBatch;
+
 typedef struct ShrinkwrapCalcCBData {
   ShrinkwrapCalcData *calc;
+  ShrinkwrapNearestBatch *batch;
 
   ShrinkwrapTreeData *tree;
   ShrinkwrapTreeData *aux_tree;
@@ -346,6 +356,49 @@ void BKE_shrinkwrap_compute_boundary_data(struct Mesh *mesh)
   mesh->runtime.shrinkwrap_data = shrinkwrap_build_boundary_data(mesh);
 }
 
+/* Collect the vertices with non-zero weight and their coordinates in target space. */
+static void shrinkwrap_nearest_batch_init(const ShrinkwrapCalcData *calc,
+                                          ShrinkwrapNearestBatch *batch)
+{
+  const size_t verts_len = (size_t)calc->numVerts;
+
+  batch->vert_index = MEM_malloc_arrayN(verts_len, sizeof(*batch->vert_index), __func__);
+  batch->co = MEM_malloc_arrayN(verts_len, sizeof(*batch->co), __func__);
+  batch->weight = MEM_malloc_arrayN(verts_len, sizeof(*batch->weight), __func__);
+  batch->nearest = MEM_calloc_arrayN(verts_len, sizeof(*batch->nearest), __func__);
+  batch->len = 0;
+
+  for (int i = 0; i < calc->numVerts; i++) {
+    float weight = BKE_defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
+
+    if (calc->invert_vgroup) {
+      weight = 1.0f - weight;
+    }
+
+    if (weight == 0.0f) {
+      continue;
+    }
+
+    const int j = batch->len++;
+    batch->vert_index[j] = i;
+    batch->weight[j] = weight;
+    batch->nearest[j].index = -1;
+    batch->nearest[j].dist_sq = FLT_MAX;
+
+    /* Convert the vertex to tree coordinates */
+    copy_v3_v3(batch->co[j], calc->vert ? calc->vert[i].co : calc->vertexCos[i]);
+    BLI_space_transform_apply(&calc->local2target, batch->co[j]);
+  }
+}
+
+static void shrinkwrap_nearest_batch_free(ShrinkwrapNearestBatch *batch)
+{
+  MEM_freeN(batch->vert_index);
+  MEM_freeN(batch->co);
+  MEM_freeN(batch->weight);
+  MEM_freeN(batch->nearest);
+}
+
 /*
  * Shrinkwrap to the nearest vertex
  *
@@ -353,49 +406,18 @@ void BKE_shrinkwrap_compute_boundary_data(struct Mesh *mesh)
  * for each vertex performs a nearest vertex search on the tree
  */
 static void shrinkwrap_calc_nearest_vertex_cb_ex(void *__restrict userdata,
-                                                 const int i,
-                                                 const TaskParallelTLS *__restrict tls)
+                                                 const int j,
+                                                 const TaskParallelTLS *__restrict UNUSED(tls))
 {
   ShrinkwrapCalcCBData *data = userdata;
 
   ShrinkwrapCalcData *calc = data->calc;
-  BVHTreeFromMesh *treeData = &data->tree->treeData;
-  BVHTreeNearest *nearest = tls->userdata_chunk;
+  const ShrinkwrapNearestBatch *batch = data->batch;
+  const BVHTreeNearest *nearest = &batch->nearest[j];
 
-  float *co = calc->vertexCos[i];
+  float *co = calc->vertexCos[batch->vert_index[j]];
   float tmp_co[3];
-  float weight = BKE_defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
-
-  if (calc->invert_vgroup) {
-    weight = 1.0f - weight;
-  }
-
-  if (weight == 0.0f) {
-    return;
-  }
-
-  /* Convert the vertex to tree coordinates */
-  if (calc->vert) {
-    copy_v3_v3(tmp_co, calc->vert[i].co);
-  }
-  else {
-    copy_v3_v3(tmp_co, co);
-  }
-  BLI_space_transform_apply(&calc->local2target, tmp_co);
-
-  /* Use local proximity heuristics (to reduce the nearest search)
-   *
-   * If we already had an hit before.. we assume this vertex is going to have a close hit to that
-   * other vertex so we can initiate the "nearest.dist" with the expected value to that last hit.
-   * This will lead in pruning of the search tree. */
-  if (nearest->index != -1) {
-    nearest->dist_sq = len_squared_v3v3(tmp_co, nearest->co);
-  }
-  else {
-    nearest->dist_sq = FLT_MAX;
-  }
-
-  BLI_bvhtree_find_nearest(treeData->tree, tmp_co, nearest, treeData->nearest_callback, treeData);
+  float weight = batch->weight[j];
 
   /* Found the nearest vertex */
   if (nearest->index != -1) {
@@ -416,23 +438,32 @@ static void shrinkwrap_calc_nearest_vertex_cb_ex(void *__restrict userdata,
 
 static void shrinkwrap_calc_nearest_vertex(ShrinkwrapCalcData *calc)
 {
-  BVHTreeNearest nearest = NULL_BVHTreeNearest;
+  BVHTreeFromMesh *treeData = &calc->tree->treeData;
+  ShrinkwrapNearestBatch batch;
+
+  shrinkwrap_nearest_batch_init(calc, &batch);
 
-  /* Setup nearest */
-  nearest.index = -1;
-  nearest.dist_sq = FLT_MAX;
+  /* Nearby vertices are queried together,
+   * each search starts from the result of its neighbor. */
+  BLI_bvhtree_find_nearest_batch(treeData->tree,
+                                 (const float(*)[3])batch.co,
+                                 batch.len,
+                                 batch.nearest,
+                                 treeData->nearest_callback,
+                                 treeData,
+                                 0);
 
   ShrinkwrapCalcCBData data = {
       .calc = calc,
+      .batch = &batch,
       .tree = calc->tree,
   };
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
-  settings.use_threading = (calc->numVerts > BKE_MESH_OMP_LIMIT);
-  settings.userdata_chunk = &nearest;
-  settings.userdata_chunk_size = sizeof(nearest);
-  BLI_task_parallel_range(
-      0, calc->numVerts, &data, shrinkwrap_calc_nearest_vertex_cb_ex, &settings);
+  settings.use_threading = (batch.len > BKE_MESH_OMP_LIMIT);
+  BLI_task_parallel_range(0, batch.len, &data, shrinkwrap_calc_nearest_vertex_cb_ex, &settings);
+
+  shrinkwrap_nearest_batch_free(&batch);
 }
 
 /*
@@ -1122,62 +1153,60 @@ void BKE_shrinkwrap_find_nearest_surface(struct ShrinkwrapTreeData *tree,
   }
 }
 
+/* Same as #BKE_shrinkwrap_find_nearest_surface for all vertices of the batch. */
+static void shrinkwrap_find_nearest_surface_batch(ShrinkwrapTreeData *tree,
+                                                  ShrinkwrapNearestBatch *batch,
+                                                  int type)
+{
+  BVHTreeFromMesh *treeData = &tree->treeData;
+
+  if (type == MOD_SHRINKWRAP_TARGET_PROJECT) {
+    /* The triangle found for the previous vertex is projected onto like any other one,
+     * so only a valid projection bounds the search of the next vertex. */
+    BLI_bvhtree_find_nearest_batch(tree->bvh,
+                                   (const float(*)[3])batch->co,
+                                   batch->len,
+                                   batch->nearest,
+                                   mesh_looptri_target_project,
+                                   tree,
+                                   BVH_NEAREST_OPTIMAL_ORDER);
+
+    for (int j = 0; j < batch->len; j++) {
+      if (batch->nearest[j].index < 0) {
+        /* fallback to simple nearest */
+        BLI_bvhtree_find_nearest(
+            tree->bvh, batch->co[j], &batch->nearest[j], treeData->nearest_callback, treeData);
+      }
+    }
+  }
+  else {
+    BLI_bvhtree_find_nearest_batch(tree->bvh,
+                                   (const float(*)[3])batch->co,
+                                   batch->len,
+                                   batch->nearest,
+                                   treeData->nearest_callback,
+                                   treeData,
+                                   0);
+  }
+}
+
 /*
  * Shrinkwrap moving vertexs to the nearest surface point on the target
  *
  * it builds a BVHTree from the target mesh and then performs a
  * NN matches for each vertex
  */
-static void shrinkwrap_calc_nearest_surface_point_cb_ex(void *__restrict userdata,
-                                                        const int i,
-                                                        const TaskParallelTLS *__restrict tls)
+static void shrinkwrap_calc_nearest_surface_point_cb_ex(
+    void *__restrict userdata, const int j, const TaskParallelTLS *__restrict UNUSED(tls))
 {
   ShrinkwrapCalcCBData *data = userdata;
 
   ShrinkwrapCalcData *calc = data->calc;
-  BVHTreeNearest *nearest = tls->userdata_chunk;
+  const ShrinkwrapNearestBatch *batch = data->batch;
+  const BVHTreeNearest *nearest = &batch->nearest[j];
 
-  float *co = calc->vertexCos[i];
+  float *co = calc->vertexCos[batch->vert_index[j]];
   float tmp_co[3];
-  float weight = BKE_defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
-
-  if (calc->invert_vgroup) {
-    weight = 1.0f - weight;
-  }
-
-  if (weight == 0.0f) {
-    return;
-  }
-
-  /* Convert the vertex to tree coordinates */
-  if (calc->vert) {
-    copy_v3_v3(tmp_co, calc->vert[i].co);
-  }
-  else {
-    copy_v3_v3(tmp_co, co);
-  }
-  BLI_space_transform_apply(&calc->local2target, tmp_co);
-
-  /* Use local proximity heuristics (to reduce the nearest search)
-   *
-   * If we already had an hit before.. we assume this vertex is going to have a close hit to that
-   * other vertex so we can initiate the "nearest.dist" with the expected value to that last hit.
-   * This will lead in pruning of the search tree. */
-  if (nearest->index != -1) {
-    if (calc->smd->shrinkType == MOD_SHRINKWRAP_TARGET_PROJECT) {
-      /* Heuristic doesn't work because of additional restrictions. */
-      nearest->index = -1;
-      nearest->dist_sq = FLT_MAX;
-    }
-    else {
-      nearest->dist_sq = len_squared_v3v3(tmp_co, nearest->co);
-    }
-  }
-  else {
-    nearest->dist_sq = FLT_MAX;
-  }
-
-  BKE_shrinkwrap_find_nearest_surface(data->tree, nearest, tmp_co, calc->smd->shrinkType);
 
   /* Found the nearest vertex */
   if (nearest->index != -1) {
@@ -1188,12 +1217,12 @@ static void shrinkwrap_calc_nearest_surface_point_cb_ex(void *__restrict userdat
                                          nearest->co,
                                          nearest->no,
                                          calc->keepDist,
-                                         tmp_co,
+                                         batch->co[j],
                                          tmp_co);
 
     /* Convert the coordinates back to mesh coordinates */
     BLI_space_transform_invert(&calc->local2target, tmp_co);
-    interp_v3_v3v3(co, co, tmp_co, weight); /* linear interpolation */
+    interp_v3_v3v3(co, co, tmp_co, batch->weight[j]); /* linear interpolation */
   }
 }
 
@@ -1385,24 +1414,25 @@ void BKE_shrinkwrap_snap_point_to_surface(const struct ShrinkwrapTreeData *tree,
 
 static void shrinkwrap_calc_nearest_surface_point(ShrinkwrapCalcData *calc)
 {
-  BVHTreeNearest nearest = NULL_BVHTreeNearest;
+  ShrinkwrapNearestBatch batch;
+
+  shrinkwrap_nearest_batch_init(calc, &batch);
 
-  /* Setup nearest */
-  nearest.index = -1;
-  nearest.dist_sq = FLT_MAX;
+  /* Find the nearest surface point */
+  shrinkwrap_find_nearest_surface_batch(calc->tree, &batch, calc->smd->shrinkType);
 
-  /* Find the nearest vertex */
   ShrinkwrapCalcCBData data = {
       .calc = calc,
+      .batch = &batch,
       .tree = calc->tree,
   };
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
-  settings.use_threading = (calc->numVerts > BKE_MESH_OMP_LIMIT);
-  settings.userdata_chunk = &nearest;
-  settings.userdata_chunk_size = sizeof(nearest);
+  settings.use_threading = (batch.len > BKE_MESH_OMP_LIMIT);
   BLI_task_parallel_range(
-      0, calc->numVerts, &data, shrinkwrap_calc_nearest_surface_point_cb_ex, &settings);
+      0, batch.len, &data, shrinkwrap_calc_nearest_surface_point_cb_ex, &settings);
+
+  shrinkwrap_nearest_batch_free(&batch);
 }
 
 /* Main shrinkwrap function */
@@ -395,6 +395,10 @@ static void studiolight_multilayer_addpass(void *base,
   MultilayerConvertContext *ctx = base;
   /* NOTE: This function must free pass pixels data if it is not used, this
    * is how IMB_exr_multilayer_convert() is working. */
+  /* Passes which are not read have no pixels. */
+  if (rect == NULL) {
+    return;
+  }
   /* If we've found a first combined pass, skip all the rest ones. */
   if (STREQ(pass_name, STUDIOLIGHT_PASSNAME_DIFFUSE)) {
     ctx->diffuse_pass = rect;
@@ -409,6 +413,17 @@ static void studiolight_multilayer_addpass(void *base,
   }
 }
 
+static bool studiolight_multilayer_testpass(void *UNUSED(base),
+                                            const char *UNUSED(layer_name),
+                                            const char *pass_name,
+                                            const char *UNUSED(chan_id),
+                                            const char *UNUSED(view_name))
+{
+  /* Only the diffuse and specular passes are used, don't read the others. */
+  return STREQ(pass_name, STUDIOLIGHT_PASSNAME_DIFFUSE) ||
+         STREQ(pass_name, STUDIOLIGHT_PASSNAME_SPECULAR);
+}
+
 static void studiolight_load_equirect_image(StudioLight *sl)
 {
   if (sl->flag & STUDIOLIGHT_EXTERNAL_FILE) {
@@ -428,7 +443,8 @@ static void studiolight_load_equirect_image(StudioLight *sl)
                                    &ctx,
                                    &studiolight_multilayer_addview,
                                    &studiolight_multilayer_addlayer,
-                                   &studiolight_multilayer_addpass);
+                                   &studiolight_multilayer_addpass,
+                                   &studiolight_multilayer_testpass);
 
         /* `ctx.diffuse_pass` and `ctx.specular_pass` can be freed inside
          * `studiolight_multilayer_convert_pass` when conversion happens.
@@ -65,9 +65,23 @@ static void set_coarse_positions(Subdiv *subdiv,
                                  const Mesh *mesh,
                                  const float (*coarse_vertex_cos)[3])
 {
+  OpenSubdiv_TopologyRefiner *topology_refiner = subdiv->topology_refiner;
+  OpenSubdiv_Evaluator *evaluator = subdiv->evaluator;
   const MVert *mvert = mesh->mvert;
   const MLoop *mloop = mesh->mloop;
   const MPoly *mpoly = mesh->mpoly;
+  /* Common case of a mesh without loose vertices: OpenSubdiv's vertices match mesh ones, so all
+   * coordinates are passed at once, without looking into the topology. */
+  if (topology_refiner->getNumVertices(topology_refiner) == mesh->totvert) {
+    if (coarse_vertex_cos != NULL) {
+      evaluator->setCoarsePositions(evaluator, coarse_vertex_cos[0], 0, mesh->totvert);
+    }
+    else {
+      evaluator->setCoarsePositionsFromBuffer(
+          evaluator, mvert, offsetof(MVert, co), sizeof(MVert), 0, mesh->totvert);
+    }
+    return;
+  }
   /* Mark vertices which needs new coordinates. */
   /* TODO(sergey): This is annoying to calculate this on every update,
    * maybe it's better to cache this mapping. Or make it possible to have
@@ -93,7 +107,7 @@ static void set_coarse_positions(Subdiv *subdiv,
       const MVert *vertex = &mvert[vertex_index];
       vertex_co = vertex->co;
     }
-    subdiv->evaluator->setCoarsePositions(subdiv->evaluator, vertex_co, manifold_vertex_index, 1);
+    evaluator->setCoarsePositions(evaluator, vertex_co, manifold_vertex_index, 1);
     manifold_vertex_index++;
   }
   MEM_freeN(vertex_used_map);
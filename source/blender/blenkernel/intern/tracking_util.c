@@ -47,6 +47,8 @@
 #include "IMB_imbuf_types.h"
 #include "IMB_moviecache.h"
 
+#include "PIL_time.h"
+
 #include "tracking_private.h"
 
 #include "libmv-capi.h"
@@ -659,11 +661,12 @@ static void accesscache_put(TrackingImageAccessor *accessor,
                             int downscale,
                             const libmv_Region *region,
                             int64_t transform_key,
-                            ImBuf *ibuf)
+                            ImBuf *ibuf,
+                            float cost)
 {
   AccessCacheKey key;
   accesscache_construct_key(&key, clip_index, frame, input_mode, downscale, region, transform_key);
-  IMB_moviecache_put(accessor->cache, &key, ibuf);
+  IMB_moviecache_put_ex(accessor->cache, &key, ibuf, cost);
 }
 
 static ImBuf *accesscache_get(TrackingImageAccessor *accessor,
@@ -780,6 +783,7 @@ static ImBuf *accessor_get_ibuf(TrackingImageAccessor *accessor,
     return ibuf;
   }
   CACHE_PRINTF("Calculate new buffer for frame %d\n", frame);
+  const double start_time = PIL_check_seconds_timer();
   /* And now we do postprocessing of the original frame. */
   orig_ibuf = accessor_get_preprocessed_ibuf(accessor, clip_index, frame);
   if (orig_ibuf == NULL) {
@@ -886,9 +890,17 @@ static ImBuf *accessor_get_ibuf(TrackingImageAccessor *accessor,
   IMB_freeImBuf(orig_ibuf);
   BLI_spin_lock(&accessor->cache_lock);
   /* Put final buffer to cache. */
-  accesscache_put(
-      accessor, clip_index, frame, input_mode, downscale, region, transform_key, final_ibuf);
+  accesscache_put(accessor,
+                  clip_index,
+                  frame,
+                  input_mode,
+                  downscale,
+                  region,
+                  transform_key,
+                  final_ibuf,
+                  PIL_check_seconds_timer() - start_time);
   BLI_spin_unlock(&accessor->cache_lock);
+  IMB_moviecache_memory_pressure_check();
   return final_ibuf;
 }
 
@@ -49,6 +49,11 @@ int incircle_fast(const double2 &a, const double2 &b, const double2 &c, const do
 int orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
 int orient3d_fast(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
 
+/* #orient3d_filter takes a, b, c, d to be the nearest doubles to some exact points,
+ * and returns the sign #orient3d would give for those exact points, if that is certain
+ * from the double values. Otherwise it returns 0, and the caller needs an exact test. */
+int orient3d_filter(const double3 &a, const double3 &b, const double3 &c, const double3 &d);
+
 int insphere(
     const double3 &a, const double3 &b, const double3 &c, const double3 &d, const double3 &e);
 int insphere_fast(
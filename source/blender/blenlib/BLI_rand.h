@@ -65,7 +65,7 @@ void BLI_rng_shuffle_array(struct RNG *rng,
                            unsigned int elem_size_i,
                            unsigned int elem_tot) ATTR_NONNULL(1, 2);
 
-/** Note that skipping is as slow as generating n numbers! */
+/** Skipping takes logarithmic time, independent sequences can start at any offset. */
 void BLI_rng_skip(struct RNG *rng, int n) ATTR_NONNULL(1);
 
 /* fill an array with random numbers */
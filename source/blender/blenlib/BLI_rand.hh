@@ -30,6 +30,10 @@ namespace blender {
 
 class RandomNumberGenerator {
  private:
+  static constexpr uint64_t multiplier = 0x5DEECE66Dll;
+  static constexpr uint64_t addend = 0xB;
+  static constexpr uint64_t mask = 0x0000FFFFFFFFFFFFll;
+
   uint64_t x_;
 
  public:
@@ -121,22 +125,29 @@ class RandomNumberGenerator {
   void get_bytes(MutableSpan<char> r_bytes);
 
   /**
-   * Simulate getting \a n random values.
+   * Simulate getting \a n random values. Takes logarithmic time: the n-th power of the affine
+   * step is built by squaring, so streams can start at any offset of a sequence, e.g. one stream
+   * per thread that gives the same values as a single thread.
    */
   void skip(int64_t n)
   {
-    while (n--) {
-      this->step();
+    uint64_t step_mul = multiplier, step_add = addend;
+    uint64_t skip_mul = 1, skip_add = 0;
+    for (; n > 0; n >>= 1) {
+      if (n & 1) {
+        skip_mul *= step_mul;
+        skip_add = skip_add * step_mul + step_add;
+      }
+      step_add *= step_mul + 1;
+      step_mul *= step_mul;
     }
+    /* Arithmetic modulo 2^64 is exact modulo 2^48 too. */
+    x_ = (skip_mul * x_ + skip_add) & mask;
   }
 
  private:
   void step()
   {
-    constexpr uint64_t multiplier = 0x5DEECE66Dll;
-    constexpr uint64_t addend = 0xB;
-    constexpr uint64_t mask = 0x0000FFFFFFFFFFFFll;
-
     x_ = (multiplier * x_ + addend) & mask;
   }
 };
@@ -49,6 +49,9 @@ void BLI_hostname_get(char *buffer, size_t bufsize);
 size_t BLI_system_memory_max_in_megabytes(void);
 int BLI_system_memory_max_in_megabytes_int(void);
 
+/* Get installed physical memory in bytes, 0 when it can't be determined. */
+size_t BLI_system_memory_physical(void);
+
 /* getpid */
 #ifdef WIN32
 #  define BLI_SYSTEM_PID_H <process.h>
@@ -72,6 +72,9 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Number of node pairs the overlap of a tree with itself is split into, for threading. */
+#define KDOPBVH_SELF_OVERLAP_TASKS 256
+
 /* -------------------------------------------------------------------- */
 /** \name Struct Definitions
  * \{ */
@@ -1078,6 +1081,15 @@ float BLI_bvhtree_get_epsilon(const BVHTree *tree)
   return tree->epsilon;
 }
 
+/**
+ * Memory allocated for the tree, in bytes.
+ */
+size_t BLI_bvhtree_get_memory_size(const BVHTree *tree)
+{
+  return sizeof(*tree) + MEM_allocN_len(tree->nodes) + MEM_allocN_len(tree->nodebv) +
+         MEM_allocN_len(tree->nodechild) + MEM_allocN_len(tree->nodearray);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1247,6 +1259,188 @@ static bool tree_overlap_traverse_num(BVHOverlapData_Thread *data_thread,
   return false;
 }
 
+/**
+ * Overlap of the children of a node with each other, for overlap of a tree with itself.
+ * Every pair of different leaves is visited once.
+ */
+static void tree_overlap_traverse_self(BVHOverlapData_Thread *data_thread, const BVHNode *node)
+{
+  BVHOverlapData_Shared *data = data_thread->shared;
+  int j, k;
+
+  for (j = 0; j < node->totnode; j++) {
+    tree_overlap_traverse_self(data_thread, node->children[j]);
+
+    for (k = j + 1; k < node->totnode; k++) {
+      if (data->callback) {
+        tree_overlap_traverse_cb(data_thread, node->children[j], node->children[k]);
+      }
+      else {
+        tree_overlap_traverse(data_thread, node->children[j], node->children[k]);
+      }
+    }
+  }
+}
+
+/* A pair of nodes to traverse for self overlap, the same node twice for its own overlap. */
+typedef struct BVHOverlapSelfTask {
+  const BVHNode *node1, *node2;
+} BVHOverlapSelfTask;
+
+typedef struct BVHOverlapSelfData {
+  BVHOverlapData_Shared *shared;
+  const BVHOverlapSelfTask *tasks;
+  struct BLI_Stack **overlap; /* store BVHTreeOverlap, for each task */
+} BVHOverlapSelfData;
+
+/**
+ * Split the overlap of the root node with itself into overlapping pairs of nodes, level by level
+ * until there are enough of them to balance the work between threads.
+ */
+static BVHOverlapSelfTask *tree_overlap_self_tasks(const BVHOverlapData_Shared *data,
+                                                   const BVHNode *root,
+                                                   int *r_tasks_len)
+{
+  const int tree_type = data->tree1->tree_type;
+  /* A node splits into its children and the pairs of them. */
+  const int split_max = tree_type + (tree_type * (tree_type - 1)) / 2;
+  BVHOverlapSelfTask *tasks = MEM_mallocN(sizeof(*tasks), __func__);
+  int tasks_len = 1;
+  bool split = true;
+  int i, j, k;
+
+  tasks[0].node1 = tasks[0].node2 = root;
+
+  while (split && tasks_len < KDOPBVH_SELF_OVERLAP_TASKS) {
+    BVHOverlapSelfTask *tasks_next = MEM_mallocN(
+        sizeof(*tasks) * (size_t)(tasks_len * split_max), __func__);
+    int tasks_next_len = 0;
+    split = false;
+
+    for (i = 0; i < tasks_len; i++) {
+      const BVHNode *node1 = tasks[i].node1, *node2 = tasks[i].node2;
+
+      if (node1 == node2) {
+        /* A leaf doesn't overlap with itself, so it's dropped. */
+        for (j = 0; j < node1->totnode; j++) {
+          tasks_next[tasks_next_len].node1 = node1->children[j];
+          tasks_next[tasks_next_len].node2 = node1->children[j];
+          tasks_next_len++;
+
+          for (k = j + 1; k < node1->totnode; k++) {
+            if (tree_overlap_test(
+                    node1->children[j], node1->children[k], data->start_axis, data->stop_axis)) {
+              tasks_next[tasks_next_len].node1 = node1->children[j];
+              tasks_next[tasks_next_len].node2 = node1->children[k];
+              tasks_next_len++;
+            }
+          }
+        }
+        split = true;
+      }
+      else if (node1->totnode) {
+        for (j = 0; j < node1->totnode; j++) {
+          if (tree_overlap_test(node1->children[j], node2, data->start_axis, data->stop_axis)) {
+            tasks_next[tasks_next_len].node1 = node1->children[j];
+            tasks_next[tasks_next_len].node2 = node2;
+            tasks_next_len++;
+          }
+        }
+        split = true;
+      }
+      else if (node2->totnode) {
+        for (j = 0; j < node2->totnode; j++) {
+          if (tree_overlap_test(node1, node2->children[j], data->start_axis, data->stop_axis)) {
+            tasks_next[tasks_next_len].node1 = node1;
+            tasks_next[tasks_next_len].node2 = node2->children[j];
+            tasks_next_len++;
+          }
+        }
+        split = true;
+      }
+      else {
+        tasks_next[tasks_next_len++] = tasks[i];
+      }
+    }
+
+    MEM_freeN(tasks);
+    tasks = tasks_next;
+    tasks_len = tasks_next_len;
+  }
+
+  *r_tasks_len = tasks_len;
+  return tasks;
+}
+
+static void bvhtree_overlap_self_task_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHOverlapSelfData *data = (BVHOverlapSelfData *)userdata;
+  const BVHOverlapSelfTask *task = &data->tasks[i];
+  BVHOverlapData_Thread data_thread = {
+      .shared = data->shared,
+      .overlap = data->overlap[i],
+      .max_interactions = 0,
+      .thread = 0,
+  };
+
+  if (task->node1 == task->node2) {
+    tree_overlap_traverse_self(&data_thread, task->node1);
+  }
+  else if (data->shared->callback) {
+    tree_overlap_traverse_cb(&data_thread, task->node1, task->node2);
+  }
+  else {
+    tree_overlap_traverse(&data_thread, task->node1, task->node2);
+  }
+}
+
+static BVHTreeOverlap *bvhtree_overlap_self(BVHOverlapData_Shared *data_shared,
+                                            const bool use_threading,
+                                            uint *r_overlap_tot)
+{
+  const BVHTree *tree = data_shared->tree1;
+  int tasks_len, i;
+  BVHOverlapSelfTask *tasks = tree_overlap_self_tasks(
+      data_shared, tree->nodes[tree->totleaf], &tasks_len);
+
+  BVHOverlapSelfData data = {
+      .shared = data_shared,
+      .tasks = tasks,
+      .overlap = MEM_mallocN(sizeof(struct BLI_Stack *) * (size_t)max_ii(tasks_len, 1), __func__),
+  };
+  for (i = 0; i < tasks_len; i++) {
+    data.overlap[i] = BLI_stack_new(sizeof(BVHTreeOverlap), __func__);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = use_threading;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, tasks_len, &data, bvhtree_overlap_self_task_cb, &settings);
+
+  size_t total = 0;
+  for (i = 0; i < tasks_len; i++) {
+    total += BLI_stack_count(data.overlap[i]);
+  }
+
+  BVHTreeOverlap *overlap = MEM_mallocN(sizeof(BVHTreeOverlap) * max_zz(total, 1), __func__);
+  BVHTreeOverlap *to = overlap;
+  for (i = 0; i < tasks_len; i++) {
+    const size_t count = BLI_stack_count(data.overlap[i]);
+    BLI_stack_pop_n(data.overlap[i], to, (uint)count);
+    BLI_stack_free(data.overlap[i]);
+    to += count;
+  }
+
+  MEM_freeN(data.overlap);
+  MEM_freeN(tasks);
+
+  *r_overlap_tot = (uint)total;
+  return overlap;
+}
+
 /**
  * Use to check the total number of threads #BLI_bvhtree_overlap will use.
  *
@@ -1334,6 +1528,12 @@ BVHTreeOverlap *BLI_bvhtree_overlap_ex(
   data_shared.callback = callback;
   data_shared.userdata = userdata;
 
+  if (flag & BVH_OVERLAP_SELF) {
+    /* Only implemented for returning all pairs. */
+    BLI_assert(tree1 == tree2 && overlap_pairs && !max_interactions);
+    return bvhtree_overlap_self(&data_shared, use_threading, r_overlap_tot);
+  }
+
   for (j = 0; j < thread_num; j++) {
     /* init BVHOverlapData_Thread */
     data[j].shared = &data_shared;
@@ -2060,6 +2260,162 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_find_nearest_batch
+ *
+ * Queries are sorted along a Morton curve and processed in blocks, each query of a block starts
+ * with the result of the previous one as its best guess. Nearby queries mostly have nearby
+ * results, so the guess prunes most of the tree.
+ * \{ */
+
+#define BVH_BATCH_BLOCK_SIZE 256
+
+typedef struct BVHBatchItem {
+  uint code;
+  int index;
+} BVHBatchItem;
+
+typedef struct BVHBatchData {
+  BVHTree *tree;
+  const BVHBatchItem *items;
+  int items_len;
+
+  const float (*co)[3];
+
+  BVHTreeNearest *nearest;
+  BVHTree_NearestPointCallback nearest_callback;
+  void *userdata;
+  int flag;
+} BVHBatchData;
+
+/* Spread the lower 10 bits so there are two zero bits between each of them. */
+BLI_INLINE uint bvh_morton_expand_bits(uint v)
+{
+  v = (v * 0x00010001u) & 0xFF0000FFu;
+  v = (v * 0x00000101u) & 0x0F00F00Fu;
+  v = (v * 0x00000011u) & 0xC30C30C3u;
+  v = (v * 0x00000005u) & 0x49249249u;
+  return v;
+}
+
+static int bvh_batch_item_cmp(const void *a_v, const void *b_v)
+{
+  const BVHBatchItem *a = a_v, *b = b_v;
+  if (a->code != b->code) {
+    return (a->code < b->code) ? -1 : 1;
+  }
+  return (a->index < b->index) ? -1 : (a->index > b->index);
+}
+
+/* Order of the queries along a Morton curve through the bounds of \a co. */
+static BVHBatchItem *bvh_batch_items_create(const float (*co)[3], const int co_len)
+{
+  BVHBatchItem *items = MEM_mallocN(sizeof(*items) * (size_t)co_len, __func__);
+  float min[3], max[3], scale[3];
+
+  INIT_MINMAX(min, max);
+  for (int i = 0; i < co_len; i++) {
+    minmax_v3v3_v3(min, max, co[i]);
+  }
+  for (int k = 0; k < 3; k++) {
+    const float extent = max[k] - min[k];
+    scale[k] = (extent > 0.0f) ? 1023.0f / extent : 0.0f;
+  }
+
+  for (int i = 0; i < co_len; i++) {
+    uint cell[3];
+    for (int k = 0; k < 3; k++) {
+      const float f = (co[i][k] - min[k]) * scale[k];
+      /* NaN and infinite coordinates end up in the first cell. */
+      cell[k] = (f > 0.0f) ? (uint)min_ff(f, 1023.0f) : 0u;
+    }
+    items[i].code = (bvh_morton_expand_bits(cell[0]) << 2) |
+                    (bvh_morton_expand_bits(cell[1]) << 1) | bvh_morton_expand_bits(cell[2]);
+    items[i].index = i;
+  }
+
+  qsort(items, (size_t)co_len, sizeof(*items), bvh_batch_item_cmp);
+  return items;
+}
+
+static void bvhtree_find_nearest_batch_cb(void *__restrict userdata,
+                                          const int block,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHBatchData *data = userdata;
+  const int start = block * BVH_BATCH_BLOCK_SIZE;
+  const int end = min_ii(start + BVH_BATCH_BLOCK_SIZE, data->items_len);
+  const BVHTreeNearest *prev = NULL;
+
+  for (int i = start; i < end; i++) {
+    const int index = data->items[i].index;
+    const float *co = data->co[index];
+    BVHTreeNearest *nearest = &data->nearest[index];
+
+    if (prev && prev->index != -1) {
+      if (data->nearest_callback) {
+        data->nearest_callback(data->userdata, prev->index, co, nearest);
+      }
+      else {
+        /* The previous nearest point lies on the bounds of its leaf,
+         * so it gives an upper bound for the distance to that leaf. */
+        const float dist_sq = len_squared_v3v3(co, prev->co);
+        if (dist_sq < nearest->dist_sq) {
+          nearest->index = prev->index;
+          nearest->dist_sq = dist_sq;
+          copy_v3_v3(nearest->co, prev->co);
+        }
+      }
+    }
+
+    BLI_bvhtree_find_nearest_ex(
+        data->tree, co, nearest, data->nearest_callback, data->userdata, data->flag);
+    prev = nearest;
+  }
+}
+
+/**
+ * Find the nearest element for many points at once.
+ *
+ * \param r_nearest: One item per point, initialized like the \a nearest argument of
+ * #BLI_bvhtree_find_nearest_ex (index -1 and the maximum squared distance to search).
+ * \note The callback is called from multiple threads.
+ */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    const int co_len,
+                                    BVHTreeNearest *r_nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    const int flag)
+{
+  if (co_len == 0) {
+    return;
+  }
+
+  BVHBatchData data = {
+      .tree = tree,
+      .items = bvh_batch_items_create(co, co_len),
+      .items_len = co_len,
+      .co = co,
+      .nearest = r_nearest,
+      .nearest_callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  const int blocks_len = (co_len + BVH_BATCH_BLOCK_SIZE - 1) / BVH_BATCH_BLOCK_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_len > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  BLI_task_parallel_range(0, blocks_len, &data, bvhtree_find_nearest_batch_cb, &settings);
+
+  MEM_freeN((void *)data.items);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
@@ -23,6 +23,7 @@
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
 #include "BLI_strict_flags.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #define _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2) MACRO_ARG1##MACRO_ARG2
@@ -64,6 +65,12 @@ struct KDTree {
  */
 #define KD_NODE_ROOT_IS_INIT ((uint)-2)
 
+/**
+ * Nearest searches push the far child of a node as the node with this flag, the split plane
+ * of the node is tested again against the (smaller) distance found so far when it's popped.
+ */
+#define KD_STACK_FAR_CHILD (1u << 31)
+
 /* -------------------------------------------------------------------- */
 /** \name Local Math API
  * \{ */
@@ -100,6 +107,8 @@ KDTree *BLI_kdtree_nd_(new)(uint nodes_len_capacity)
 {
   KDTree *tree;
 
+  BLI_assert(nodes_len_capacity < KD_STACK_FAR_CHILD);
+
   tree = MEM_mallocN(sizeof(KDTree), "KDTree");
   tree->nodes = MEM_mallocN(sizeof(KDTreeNode) * nodes_len_capacity, "KDTreeNode");
   tree->nodes_len = 0;
@@ -145,19 +154,15 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/**
+ * Quick-select style partitioning around the median on \a axis,
+ * returns the index of the median in \a nodes.
+ */
+static uint kdtree_median_partition(KDTreeNode *nodes, uint nodes_len, uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
   /* quicksort style sorting around median */
   left = 0;
   right = nodes_len - 1;
@@ -190,6 +195,23 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
+  return median;
+}
+
+static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+{
+  KDTreeNode *node;
+  uint median;
+
+  if (nodes_len <= 0) {
+    return KD_NODE_UNSET;
+  }
+  else if (nodes_len == 1) {
+    return 0 + ofs;
+  }
+
+  median = kdtree_median_partition(nodes, nodes_len, axis);
+
   /* set node and sort subnodes */
   node = &nodes[median];
   node->d = axis;
@@ -201,6 +223,91 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   return median + ofs;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded Balancing
+ *
+ * The top levels of the tree are partitioned on the calling thread, until sub-trees are small
+ * enough to be balanced by a single thread each. Every sub-tree owns a contiguous range of the
+ * nodes, so sub-trees are balanced independently and the result is the same as balancing on a
+ * single thread.
+ * \{ */
+
+/* Sub-trees up to this size are balanced by a single thread. */
+#define KD_BALANCE_THREAD_THRESHOLD 8192
+
+typedef struct KDBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+  /* Where to store the root of the sub-tree. */
+  uint *r_root;
+} KDBalanceTask;
+
+static void kdtree_balance_split(KDTreeNode *nodes,
+                                 uint nodes_len,
+                                 uint axis,
+                                 const uint ofs,
+                                 uint *r_root,
+                                 KDBalanceTask *tasks,
+                                 uint *tasks_len)
+{
+  if (nodes_len <= KD_BALANCE_THREAD_THRESHOLD) {
+    KDBalanceTask *task = &tasks[(*tasks_len)++];
+    task->nodes = nodes;
+    task->nodes_len = nodes_len;
+    task->axis = axis;
+    task->ofs = ofs;
+    task->r_root = r_root;
+    return;
+  }
+
+  const uint median = kdtree_median_partition(nodes, nodes_len, axis);
+
+  KDTreeNode *node = &nodes[median];
+  node->d = axis;
+  axis = (axis + 1) % KD_DIMS;
+  kdtree_balance_split(nodes, median, axis, ofs, &node->left, tasks, tasks_len);
+  kdtree_balance_split(nodes + median + 1,
+                       (nodes_len - (median + 1)),
+                       axis,
+                       (median + 1) + ofs,
+                       &node->right,
+                       tasks,
+                       tasks_len);
+
+  *r_root = median + ofs;
+}
+
+static void kdtree_balance_task_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDBalanceTask *task = &((const KDBalanceTask *)userdata)[i];
+  *task->r_root = kdtree_balance(task->nodes, task->nodes_len, task->axis, task->ofs);
+}
+
+static uint kdtree_balance_threaded(KDTreeNode *nodes, uint nodes_len)
+{
+  /* Split sub-trees hold more than a quarter of the threshold. */
+  const uint tasks_len_max = nodes_len / (KD_BALANCE_THREAD_THRESHOLD / 4) + 2;
+  KDBalanceTask *tasks = MEM_mallocN(sizeof(*tasks) * tasks_len_max, __func__);
+  uint tasks_len = 0;
+  uint root;
+
+  kdtree_balance_split(nodes, nodes_len, 0, 0, &root, tasks, &tasks_len);
+  BLI_assert(tasks_len <= tasks_len_max);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, (int)tasks_len, tasks, kdtree_balance_task_cb, &settings);
+
+  MEM_freeN(tasks);
+  return root;
+}
+
+/** \} */
+
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
   if (tree->root != KD_NODE_ROOT_IS_INIT) {
@@ -210,7 +317,12 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  if (tree->nodes_len > KD_BALANCE_THREAD_THRESHOLD) {
+    tree->root = kdtree_balance_threaded(tree->nodes, tree->nodes_len);
+  }
+  else {
+    tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  }
 
 #ifdef DEBUG
   tree->is_balanced = true;
@@ -258,25 +370,21 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
   min_node = root;
   min_dist = len_squared_vnvn(root->co, co);
 
-  if (co[root->d] < root->co[root->d]) {
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-  }
-  else {
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-  }
+  stack[cur++] = tree->root;
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    uint node_index = stack[cur];
+
+    if (node_index & KD_STACK_FAR_CHILD) {
+      const KDTreeNode *parent = &nodes[node_index & ~KD_STACK_FAR_CHILD];
+      cur_dist = parent->co[parent->d] - co[parent->d];
+      if (cur_dist * cur_dist >= min_dist) {
+        continue;
+      }
+      node_index = (cur_dist < 0.0f) ? parent->left : parent->right;
+    }
+
+    const KDTreeNode *node = &nodes[node_index];
 
     cur_dist = node->co[node->d] - co[node->d];
 
@@ -290,7 +398,7 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
           min_node = node;
         }
         if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
+          stack[cur++] = node_index | KD_STACK_FAR_CHILD;
         }
       }
       if (node->right != KD_NODE_UNSET) {
@@ -307,7 +415,7 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
           min_node = node;
         }
         if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
+          stack[cur++] = node_index | KD_STACK_FAR_CHILD;
         }
       }
       if (node->left != KD_NODE_UNSET) {
@@ -488,7 +596,6 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
     const void *user_data)
 {
   const KDTreeNode *nodes = tree->nodes;
-  const KDTreeNode *root;
   uint *stack, stack_default[KD_STACK_INIT];
   float cur_dist;
   uint stack_len_capacity, cur = 0;
@@ -510,31 +617,22 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
   stack = stack_default;
   stack_len_capacity = ARRAY_SIZE(stack_default);
 
-  root = &nodes[tree->root];
-
-  cur_dist = len_sq_fn(co, root->co, user_data);
-  nearest_ordered_insert(
-      r_nearest, &nearest_len, nearest_len_capacity, root->index, cur_dist, root->co);
+  stack[cur++] = tree->root;
 
-  if (co[root->d] < root->co[root->d]) {
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-  }
-  else {
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
+  while (cur--) {
+    uint node_index = stack[cur];
+
+    if (node_index & KD_STACK_FAR_CHILD) {
+      const KDTreeNode *parent = &nodes[node_index & ~KD_STACK_FAR_CHILD];
+      cur_dist = parent->co[parent->d] - co[parent->d];
+      if (nearest_len == nearest_len_capacity &&
+          cur_dist * cur_dist >= r_nearest[nearest_len - 1].dist) {
+        continue;
+      }
+      node_index = (cur_dist < 0.0f) ? parent->left : parent->right;
     }
-  }
 
-  while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const KDTreeNode *node = &nodes[node_index];
 
     cur_dist = node->co[node->d] - co[node->d];
 
@@ -550,7 +648,7 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
         }
 
         if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
+          stack[cur++] = node_index | KD_STACK_FAR_CHILD;
         }
       }
       if (node->right != KD_NODE_UNSET) {
@@ -568,7 +666,7 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
         }
 
         if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
+          stack[cur++] = node_index | KD_STACK_FAR_CHILD;
         }
       }
       if (node->left != KD_NODE_UNSET) {
@@ -806,6 +904,233 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_kdtree_3d_find_nearest_n_batch / BLI_kdtree_3d_range_search_batch
+ *
+ * Queries are sorted along a Morton curve and processed in blocks on multiple threads.
+ * Consecutive queries of a block visit mostly the same nodes, which stay in the cache.
+ * \{ */
+
+#define KD_BATCH_BLOCK_SIZE 256
+/* Bits per axis of the Morton codes, so codes fit in 32 bits. */
+#define KD_BATCH_MORTON_BITS (KD_DIMS == 1 ? 16u : (32u / KD_DIMS))
+
+typedef struct KDBatchItem {
+  uint code;
+  int index;
+} KDBatchItem;
+
+typedef struct KDBatchData {
+  const KDTree *tree;
+  const KDBatchItem *items;
+  int items_len;
+  const float (*co)[KD_DIMS];
+
+  /* find_nearest_n */
+  KDTreeNearest *nearest;
+  uint nearest_len_capacity;
+  int *nearest_len;
+
+  /* range_search */
+  float range;
+  KDTreeNearest **range_nearest;
+} KDBatchData;
+
+static int kdtree_batch_item_cmp(const void *a_v, const void *b_v)
+{
+  const KDBatchItem *a = a_v, *b = b_v;
+  if (a->code != b->code) {
+    return (a->code < b->code) ? -1 : 1;
+  }
+  return (a->index < b->index) ? -1 : (a->index > b->index);
+}
+
+/* Order of the queries along a Morton curve through the bounds of \a co. */
+static KDBatchItem *kdtree_batch_items_create(const float (*co)[KD_DIMS], const int co_len)
+{
+  KDBatchItem *items = MEM_mallocN(sizeof(*items) * (size_t)co_len, __func__);
+  const float cell_max = (float)((1u << KD_BATCH_MORTON_BITS) - 1);
+  float min[KD_DIMS], max[KD_DIMS], scale[KD_DIMS];
+
+  for (uint j = 0; j < KD_DIMS; j++) {
+    min[j] = FLT_MAX;
+    max[j] = -FLT_MAX;
+  }
+  for (int i = 0; i < co_len; i++) {
+    for (uint j = 0; j < KD_DIMS; j++) {
+      min[j] = min_ff(min[j], co[i][j]);
+      max[j] = max_ff(max[j], co[i][j]);
+    }
+  }
+  for (uint j = 0; j < KD_DIMS; j++) {
+    const float extent = max[j] - min[j];
+    scale[j] = (extent > 0.0f) ? cell_max / extent : 0.0f;
+  }
+
+  for (int i = 0; i < co_len; i++) {
+    uint cell[KD_DIMS];
+    for (uint j = 0; j < KD_DIMS; j++) {
+      const float f = (co[i][j] - min[j]) * scale[j];
+      /* NaN and infinite coordinates end up in the first cell. */
+      cell[j] = (f > 0.0f) ? (uint)min_ff(f, cell_max) : 0u;
+    }
+    uint code = 0;
+    for (uint b = KD_BATCH_MORTON_BITS; b--;) {
+      for (uint j = 0; j < KD_DIMS; j++) {
+        code = (code << 1) | ((cell[j] >> b) & 1u);
+      }
+    }
+    items[i].code = code;
+    items[i].index = i;
+  }
+
+  qsort(items, (size_t)co_len, sizeof(*items), kdtree_batch_item_cmp);
+  return items;
+}
+
+static void kdtree_batch_run(KDBatchData *data, TaskParallelRangeFunc func)
+{
+  const int blocks_len = (data->items_len + KD_BATCH_BLOCK_SIZE - 1) / KD_BATCH_BLOCK_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, blocks_len, data, func, &settings);
+}
+
+static void kdtree_find_nearest_n_batch_cb(void *__restrict userdata,
+                                           const int block,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDBatchData *data = userdata;
+  const int start = block * KD_BATCH_BLOCK_SIZE;
+  const int end = min_ii(start + KD_BATCH_BLOCK_SIZE, data->items_len);
+
+  for (int i = start; i < end; i++) {
+    const int index = data->items[i].index;
+    const int found = BLI_kdtree_nd_(find_nearest_n)(
+        data->tree,
+        data->co[index],
+        &data->nearest[(size_t)index * data->nearest_len_capacity],
+        data->nearest_len_capacity);
+    if (data->nearest_len) {
+      data->nearest_len[index] = found;
+    }
+  }
+}
+
+/**
+ * Find the \a nearest_len_capacity nearest points of many points at once.
+ *
+ * \param r_nearest: Results of the point `i` start at `r_nearest[i * nearest_len_capacity]`,
+ * sized at least `co_len * nearest_len_capacity`.
+ * \param r_nearest_len: Optional, the number of points found for each point.
+ */
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                         const float (*co)[KD_DIMS],
+                                         const int co_len,
+                                         KDTreeNearest *r_nearest,
+                                         const uint nearest_len_capacity,
+                                         int *r_nearest_len)
+{
+  if (co_len == 0) {
+    return;
+  }
+
+  KDBatchData data = {
+      .tree = tree,
+      .items = kdtree_batch_items_create(co, co_len),
+      .items_len = co_len,
+      .co = co,
+      .nearest = r_nearest,
+      .nearest_len_capacity = nearest_len_capacity,
+      .nearest_len = r_nearest_len,
+  };
+
+  kdtree_batch_run(&data, kdtree_find_nearest_n_batch_cb);
+
+  MEM_freeN((void *)data.items);
+}
+
+static void kdtree_range_search_batch_cb(void *__restrict userdata,
+                                         const int block,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDBatchData *data = userdata;
+  const int start = block * KD_BATCH_BLOCK_SIZE;
+  const int end = min_ii(start + KD_BATCH_BLOCK_SIZE, data->items_len);
+
+  for (int i = start; i < end; i++) {
+    const int index = data->items[i].index;
+    data->nearest_len[index] = BLI_kdtree_nd_(range_search)(
+        data->tree, data->co[index], &data->range_nearest[index], data->range);
+  }
+}
+
+/**
+ * Range search for many points at once.
+ *
+ * \param r_nearest: Allocated array of all points found (caller is responsible for freeing),
+ * the points found for each point are sorted by distance like #BLI_kdtree_3d_range_search.
+ * \param r_nearest_offsets: Sized `co_len + 1`, the points found for the point `i` are
+ * in the range `r_nearest_offsets[i]` to `r_nearest_offsets[i + 1]`.
+ * \return The number of points found for all points.
+ */
+int BLI_kdtree_nd_(range_search_batch)(const KDTree *tree,
+                                       const float (*co)[KD_DIMS],
+                                       const int co_len,
+                                       const float range,
+                                       KDTreeNearest **r_nearest,
+                                       int *r_nearest_offsets)
+{
+  r_nearest_offsets[0] = 0;
+  *r_nearest = NULL;
+  if (co_len == 0) {
+    return 0;
+  }
+
+  /* Results of each point are collected separately, then packed. */
+  KDTreeNearest **range_nearest = MEM_callocN(sizeof(*range_nearest) * (size_t)co_len,
+                                              __func__);
+  KDBatchData data = {
+      .tree = tree,
+      .items = kdtree_batch_items_create(co, co_len),
+      .items_len = co_len,
+      .co = co,
+      .nearest_len = r_nearest_offsets + 1,
+      .range = range,
+      .range_nearest = range_nearest,
+  };
+
+  kdtree_batch_run(&data, kdtree_range_search_batch_cb);
+  MEM_freeN((void *)data.items);
+
+  for (int i = 0; i < co_len; i++) {
+    r_nearest_offsets[i + 1] += r_nearest_offsets[i];
+  }
+  const int nearest_len = r_nearest_offsets[co_len];
+
+  if (nearest_len) {
+    KDTreeNearest *nearest = MEM_mallocN(sizeof(*nearest) * (size_t)nearest_len, __func__);
+    for (int i = 0; i < co_len; i++) {
+      if (range_nearest[i]) {
+        memcpy(&nearest[r_nearest_offsets[i]],
+               range_nearest[i],
+               sizeof(*nearest) * (size_t)(r_nearest_offsets[i + 1] - r_nearest_offsets[i]));
+        MEM_freeN(range_nearest[i]);
+      }
+    }
+    *r_nearest = nearest;
+  }
+  MEM_freeN(range_nearest);
+
+  return nearest_len;
+}
+
+#undef KD_BATCH_BLOCK_SIZE
+#undef KD_BATCH_MORTON_BITS
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
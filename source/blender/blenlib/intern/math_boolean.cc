@@ -32,13 +32,125 @@
 
 namespace blender {
 
+/**
+ * Floating point filters for the exact predicates.
+ * These use the technique of Burnikel, Funke and Seel: the predicate is evaluated
+ * in double arithmetic, along with its "supremum" (the same expression evaluated on the
+ * absolute values of the inputs, with every - replaced by +) and its "index", which
+ * follows these rules:
+ *    index(x op y) = 1 + max(index(x), index(y)) for op + or -
+ *    index(x * y)  = 1 + index(x) + index(y)
+ *    index(x) = 1 for an input that is the double nearest to an exact value.
+ * The calculated value E then differs from the exact value by at most
+ * `supremum(E) * index(E) * DBL_EPSILON`, so its sign is certain if |E| is larger than that.
+ * The filters return 0 when the sign is not certain, and the caller must then
+ * evaluate the predicate exactly.
+ */
+int orient3d_filter(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  constexpr int index_orient3d = 11;
+  double adx = a[0] - d[0];
+  double bdx = b[0] - d[0];
+  double cdx = c[0] - d[0];
+  double ady = a[1] - d[1];
+  double bdy = b[1] - d[1];
+  double cdy = c[1] - d[1];
+  double adz = a[2] - d[2];
+  double bdz = b[2] - d[2];
+  double cdz = c[2] - d[2];
+  double det = adz * (bdx * cdy - cdx * bdy) + bdz * (cdx * ady - adx * cdy) +
+               cdz * (adx * bdy - bdx * ady);
+  if (det == 0.0) {
+    return 0;
+  }
+  double sadx = fabs(a[0]) + fabs(d[0]);
+  double sbdx = fabs(b[0]) + fabs(d[0]);
+  double scdx = fabs(c[0]) + fabs(d[0]);
+  double sady = fabs(a[1]) + fabs(d[1]);
+  double sbdy = fabs(b[1]) + fabs(d[1]);
+  double scdy = fabs(c[1]) + fabs(d[1]);
+  double sadz = fabs(a[2]) + fabs(d[2]);
+  double sbdz = fabs(b[2]) + fabs(d[2]);
+  double scdz = fabs(c[2]) + fabs(d[2]);
+  double supremum = sadz * (sbdx * scdy + scdx * sbdy) + sbdz * (scdx * sady + sadx * scdy) +
+                    scdz * (sadx * sbdy + sbdx * sady);
+  double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0.0 ? 1 : -1;
+  }
+  return 0;
+}
+
 #ifdef WITH_GMP
+static int filter_orient2d(const double2 &a, const double2 &b, const double2 &c)
+{
+  constexpr int index_orient2d = 6;
+  double det = (a[0] - c[0]) * (b[1] - c[1]) - (a[1] - c[1]) * (b[0] - c[0]);
+  if (det == 0.0) {
+    return 0;
+  }
+  double supremum = (fabs(a[0]) + fabs(c[0])) * (fabs(b[1]) + fabs(c[1])) +
+                    (fabs(a[1]) + fabs(c[1])) * (fabs(b[0]) + fabs(c[0]));
+  double err_bound = supremum * index_orient2d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0.0 ? 1 : -1;
+  }
+  return 0;
+}
+
+static int filter_incircle(const double2 &a, const double2 &b, const double2 &c, const double2 &d)
+{
+  constexpr int index_incircle = 15;
+  double adx = a[0] - d[0];
+  double bdx = b[0] - d[0];
+  double cdx = c[0] - d[0];
+  double ady = a[1] - d[1];
+  double bdy = b[1] - d[1];
+  double cdy = c[1] - d[1];
+  double alift = adx * adx + ady * ady;
+  double blift = bdx * bdx + bdy * bdy;
+  double clift = cdx * cdx + cdy * cdy;
+  double det = alift * (bdx * cdy - cdx * bdy) + blift * (cdx * ady - adx * cdy) +
+               clift * (adx * bdy - bdx * ady);
+  if (det == 0.0) {
+    return 0;
+  }
+  double sadx = fabs(a[0]) + fabs(d[0]);
+  double sbdx = fabs(b[0]) + fabs(d[0]);
+  double scdx = fabs(c[0]) + fabs(d[0]);
+  double sady = fabs(a[1]) + fabs(d[1]);
+  double sbdy = fabs(b[1]) + fabs(d[1]);
+  double scdy = fabs(c[1]) + fabs(d[1]);
+  double supremum = (sadx * sadx + sady * sady) * (sbdx * scdy + scdx * sbdy) +
+                    (sbdx * sbdx + sbdy * sbdy) * (scdx * sady + sadx * scdy) +
+                    (scdx * scdx + scdy * scdy) * (sadx * sbdy + sbdx * sady);
+  double err_bound = supremum * index_incircle * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0.0 ? 1 : -1;
+  }
+  return 0;
+}
+
+static double2 mpq2_approx(const mpq2 &v)
+{
+  return double2(v[0].get_d(), v[1].get_d());
+}
+
+static double3 mpq3_approx(const mpq3 &v)
+{
+  return double3(v[0].get_d(), v[1].get_d(), v[2].get_d());
+}
+
 /**
  * Return +1 if a, b, c are in CCW order around a circle in the plane.
  * Return -1 if they are in CW order, and 0 if they are in line.
  */
 int orient2d(const mpq2 &a, const mpq2 &b, const mpq2 &c)
 {
+  int filter = filter_orient2d(mpq2_approx(a), mpq2_approx(b), mpq2_approx(c));
+  if (filter != 0) {
+    return filter;
+  }
   mpq_class detleft = (a[0] - c[0]) * (b[1] - c[1]);
   mpq_class detright = (a[1] - c[1]) * (b[0] - c[0]);
   mpq_class det = detleft - detright;
@@ -52,6 +164,10 @@ int orient2d(const mpq2 &a, const mpq2 &b, const mpq2 &c)
  */
 int incircle(const mpq2 &a, const mpq2 &b, const mpq2 &c, const mpq2 &d)
 {
+  int filter = filter_incircle(mpq2_approx(a), mpq2_approx(b), mpq2_approx(c), mpq2_approx(d));
+  if (filter != 0) {
+    return filter;
+  }
   mpq_class adx = a[0] - d[0];
   mpq_class bdx = b[0] - d[0];
   mpq_class cdx = c[0] - d[0];
@@ -84,6 +200,10 @@ int incircle(const mpq2 &a, const mpq2 &b, const mpq2 &c, const mpq2 &d)
  */
 int orient3d(const mpq3 &a, const mpq3 &b, const mpq3 &c, const mpq3 &d)
 {
+  int filter = orient3d_filter(mpq3_approx(a), mpq3_approx(b), mpq3_approx(c), mpq3_approx(d));
+  if (filter != 0) {
+    return filter;
+  }
   mpq_class adx = a[0] - d[0];
   mpq_class bdx = b[0] - d[0];
   mpq_class cdx = c[0] - d[0];
@@ -0,0 +1,479 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Points are binned in a uniform grid with cells at least twice the merge distance, so the
+ * neighbors of a point are found in two cells per axis at most. Cells are hashed into buckets,
+ * points of a bucket are stored contiguously (with their coordinates) to keep the search cache
+ * friendly.
+ *
+ * Pairs closer than the merge distance are searched in parallel, each point only looks for
+ * points with a bigger index so every pair is found once.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_disjoint_set.hh"
+#include "BLI_float3.hh"
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_merge_by_distance.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+namespace blender {
+
+using MergePair = std::pair<int, int>;
+
+/* -------------------------------------------------------------------- */
+/** \name Points Grid
+ * \{ */
+
+class PointsGrid {
+ private:
+  float3 min_;
+  float cell_size_inv_;
+  uint bucket_mask_;
+  /* Points of bucket `b` are in the range `bucket_offsets_[b]` to `bucket_offsets_[b + 1]`. */
+  Array<int> bucket_offsets_;
+  Array<int> points_;
+  Array<float3> cos_;
+
+ public:
+  PointsGrid(const float (*co)[3], const int co_len, const BLI_bitmap *mask, const float dist);
+
+  int64_t size() const
+  {
+    return points_.size();
+  }
+
+  /** Points in bucket order, iterating in this order keeps the search cache friendly. */
+  int point(const int64_t i) const
+  {
+    return points_[i];
+  }
+  const float3 &co(const int64_t i) const
+  {
+    return cos_[i];
+  }
+
+  void cell_of(const float3 &co, int r_cell[3]) const
+  {
+    for (int i = 0; i < 3; i++) {
+      r_cell[i] = (int)floorf((co[i] - min_[i]) * cell_size_inv_);
+    }
+  }
+
+  /* Meshes are often regular, the high bits of the product are mixed in to avoid collisions of
+   * cells at regular intervals. */
+  uint bucket_of(const int cell[3]) const
+  {
+    uint64_t hash = ((uint64_t)(uint)cell[0] * 0x9E3779B97F4A7C15ull) ^
+                    ((uint64_t)(uint)cell[1] * 0xC2B2AE3D27D4EB4Full) ^
+                    ((uint64_t)(uint)cell[2] * 0x165667B19E3779F9ull);
+    return (uint)(hash ^ (hash >> 32)) & bucket_mask_;
+  }
+
+  /**
+   * Call `fn(point, co)` for every point stored in the buckets of the cells overlapping the
+   * box of \a dist around \a co. Each bucket is visited once, points of other cells sharing
+   * the bucket are included, callers have to test the distance. Stops when `fn` returns false.
+   */
+  template<typename Fn> void foreach_candidate(const float3 &co, const float dist, Fn fn) const
+  {
+    int cell_min[3], cell_max[3];
+    this->cell_of(co - float3(dist), cell_min);
+    this->cell_of(co + float3(dist), cell_max);
+
+    /* Usually two cells per axis at most, rounding can make it three. */
+    uint buckets[27];
+    int buckets_len = 0;
+    int cell[3];
+    for (cell[0] = cell_min[0]; cell[0] <= cell_max[0]; cell[0]++) {
+      for (cell[1] = cell_min[1]; cell[1] <= cell_max[1]; cell[1]++) {
+        for (cell[2] = cell_min[2]; cell[2] <= cell_max[2]; cell[2]++) {
+          const uint bucket = this->bucket_of(cell);
+          bool is_new = true;
+          for (int i = 0; i < buckets_len; i++) {
+            if (buckets[i] == bucket) {
+              is_new = false;
+              break;
+            }
+          }
+          if (!is_new) {
+            continue;
+          }
+          buckets[buckets_len++] = bucket;
+          for (int i = bucket_offsets_[bucket]; i < bucket_offsets_[bucket + 1]; i++) {
+            if (!fn(points_[i], cos_[i])) {
+              return;
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+struct BoundsData {
+  const float (*co)[3];
+  const BLI_bitmap *mask;
+};
+
+struct BoundsChunk {
+  float3 min, max;
+};
+
+static void points_bounds_range_func(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict tls)
+{
+  const BoundsData *data = static_cast<const BoundsData *>(userdata);
+  if (data->mask && !BLI_BITMAP_TEST(data->mask, i)) {
+    return;
+  }
+  BoundsChunk *chunk = static_cast<BoundsChunk *>(tls->userdata_chunk);
+  minmax_v3v3_v3(chunk->min, chunk->max, data->co[i]);
+}
+
+static void points_bounds_reduce_func(const void *__restrict UNUSED(userdata),
+                                      void *__restrict chunk_join,
+                                      void *__restrict chunk)
+{
+  BoundsChunk *join = static_cast<BoundsChunk *>(chunk_join);
+  const BoundsChunk *other = static_cast<const BoundsChunk *>(chunk);
+  minmax_v3v3_v3(join->min, join->max, other->min);
+  minmax_v3v3_v3(join->min, join->max, other->max);
+}
+
+struct BucketsData {
+  const PointsGrid *grid;
+  const float (*co)[3];
+  const BLI_bitmap *mask;
+  uint *point_buckets;
+};
+
+static void points_buckets_range_func(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BucketsData *data = static_cast<const BucketsData *>(userdata);
+  if (data->mask && !BLI_BITMAP_TEST(data->mask, i)) {
+    data->point_buckets[i] = UINT_MAX;
+    return;
+  }
+  int cell[3];
+  data->grid->cell_of(data->co[i], cell);
+  data->point_buckets[i] = data->grid->bucket_of(cell);
+}
+
+PointsGrid::PointsGrid(const float (*co)[3],
+                       const int co_len,
+                       const BLI_bitmap *mask,
+                       const float dist)
+{
+  BoundsData bounds_data = {co, mask};
+  BoundsChunk bounds;
+  INIT_MINMAX(bounds.min, bounds.max);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4096;
+  settings.userdata_chunk = &bounds;
+  settings.userdata_chunk_size = sizeof(bounds);
+  settings.func_reduce = points_bounds_reduce_func;
+  BLI_task_parallel_range(0, co_len, &bounds_data, points_bounds_range_func, &settings);
+
+  int points_len = 0;
+  if (mask) {
+    for (int i = 0; i < co_len; i++) {
+      if (BLI_BITMAP_TEST(mask, i)) {
+        points_len++;
+      }
+    }
+  }
+  else {
+    points_len = co_len;
+  }
+
+  if (points_len == 0) {
+    zero_v3(bounds.min);
+    zero_v3(bounds.max);
+  }
+
+  /* Cells are at least twice the distance, so neighbors are in two cells per axis at most.
+   * Bigger cells are still correct: points much further apart than the distance (the common
+   * case when welding) probe fewer empty cells with cells about the size of the spacing of
+   * points, estimated as if they were spread over the surface of the bounds. This also keeps
+   * cell coordinates in range for tiny distances. */
+  const float3 size = bounds.max - bounds.min;
+  const float area = 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+  const float spacing = sqrtf(area / (float)max_ii(points_len, 1));
+  float cell_size = max_fff(2.0f * dist, spacing, max_fff(UNPACK3(size)) * 1e-6f);
+  if (cell_size == 0.0f) {
+    cell_size = 1.0f;
+  }
+  min_ = bounds.min;
+  cell_size_inv_ = 1.0f / cell_size;
+
+  const uint buckets_len = power_of_2_max_u((uint)max_ii(points_len * 2, 1));
+  bucket_mask_ = buckets_len - 1;
+
+  Array<uint> point_buckets(co_len);
+  BucketsData buckets_data = {this, co, mask, point_buckets.data()};
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4096;
+  BLI_task_parallel_range(0, co_len, &buckets_data, points_buckets_range_func, &settings);
+
+  /* Counting sort, keeps points of a bucket in index order. */
+  bucket_offsets_ = Array<int>(buckets_len + 1, 0);
+  for (int i = 0; i < co_len; i++) {
+    if (point_buckets[i] != UINT_MAX) {
+      bucket_offsets_[point_buckets[i] + 1]++;
+    }
+  }
+  for (uint b = 0; b < buckets_len; b++) {
+    bucket_offsets_[b + 1] += bucket_offsets_[b];
+  }
+
+  points_ = Array<int>(points_len);
+  cos_ = Array<float3>(points_len);
+  Array<int> bucket_fill(bucket_offsets_.as_span().drop_back(1));
+  for (int i = 0; i < co_len; i++) {
+    if (point_buckets[i] != UINT_MAX) {
+      const int dst = bucket_fill[point_buckets[i]]++;
+      points_[dst] = i;
+      cos_[dst] = co[i];
+    }
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Pairs Search
+ * \{ */
+
+struct PairsData {
+  const PointsGrid *grid;
+  float dist;
+  float dist_sq;
+  int max_interactions;
+
+  SpinLock lock;
+  Vector<MergePair> *r_pairs;
+};
+
+struct PairsChunk {
+  /* Allocated on first use, chunks are copied with `memcpy`. */
+  Vector<MergePair> *pairs;
+};
+
+static void merge_pairs_range_func(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict tls)
+{
+  const PairsData *data = static_cast<const PairsData *>(userdata);
+  PairsChunk *chunk = static_cast<PairsChunk *>(tls->userdata_chunk);
+  const int a = data->grid->point(i);
+  const float3 co_a = data->grid->co(i);
+  int interactions = 0;
+
+  data->grid->foreach_candidate(co_a, data->dist, [&](const int b, const float3 &co_b) {
+    if (b <= a || len_squared_v3v3(co_a, co_b) > data->dist_sq) {
+      return true;
+    }
+    if (chunk->pairs == nullptr) {
+      chunk->pairs = new Vector<MergePair>();
+    }
+    chunk->pairs->append({a, b});
+    interactions++;
+    return (data->max_interactions == 0) || (interactions < data->max_interactions);
+  });
+}
+
+static void merge_pairs_free_func(const void *__restrict userdata, void *__restrict chunk_v)
+{
+  PairsData *data = const_cast<PairsData *>(static_cast<const PairsData *>(userdata));
+  PairsChunk *chunk = static_cast<PairsChunk *>(chunk_v);
+  if (chunk->pairs == nullptr) {
+    return;
+  }
+  BLI_spin_lock(&data->lock);
+  data->r_pairs->extend(chunk->pairs->as_span());
+  BLI_spin_unlock(&data->lock);
+  delete chunk->pairs;
+  chunk->pairs = nullptr;
+}
+
+/**
+ * Find all pairs `(a, b)` with `a < b` closer than \a dist, in no particular order.
+ */
+static Vector<MergePair> merge_pairs_find(const float (*co)[3],
+                                          const int co_len,
+                                          const BLI_bitmap *mask,
+                                          const float dist,
+                                          const int max_interactions)
+{
+  const PointsGrid grid(co, co_len, mask, dist);
+  Vector<MergePair> pairs;
+
+  PairsData data;
+  data.grid = &grid;
+  data.dist = dist;
+  data.dist_sq = square_f(dist);
+  data.max_interactions = max_interactions;
+  data.r_pairs = &pairs;
+  BLI_spin_init(&data.lock);
+
+  PairsChunk chunk = {nullptr};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = &chunk;
+  settings.userdata_chunk_size = sizeof(chunk);
+  settings.func_free = merge_pairs_free_func;
+  BLI_task_parallel_range(0, (int)grid.size(), &data, merge_pairs_range_func, &settings);
+
+  BLI_spin_end(&data.lock);
+  return pairs;
+}
+
+/** \} */
+
+}  // namespace blender
+
+using namespace blender;
+
+/**
+ * Group points closer than \a dist, transitively: points end up in the same group when a chain
+ * of close points links them.
+ *
+ * \param mask: When not null, only points enabled in the mask are considered.
+ * \param max_interactions: The maximum number of points with a bigger index each point is
+ * linked with, zero for no limit.
+ * \param r_dest_map: Receives the smallest index of the group for grouped points,
+ * -1 for points without any close point.
+ * \return The number of points to remove, the grouped points which are not the group target.
+ */
+int BLI_merge_by_distance_calc_groups(const float (*co)[3],
+                                      const int co_len,
+                                      const BLI_bitmap *mask,
+                                      const float dist,
+                                      const int max_interactions,
+                                      int *r_dest_map)
+{
+  const Vector<MergePair> pairs = merge_pairs_find(co, co_len, mask, dist, max_interactions);
+
+  for (int i = 0; i < co_len; i++) {
+    r_dest_map[i] = -1;
+  }
+  if (pairs.is_empty()) {
+    return 0;
+  }
+
+  /* Joining is cheap compared to the search, and #DisjointSet isn't thread-safe. */
+  DisjointSet disjoint_set(co_len);
+  for (const MergePair &pair : pairs) {
+    disjoint_set.join(pair.first, pair.second);
+    /* Only mark grouped points, group targets are set below. */
+    r_dest_map[pair.first] = pair.first;
+    r_dest_map[pair.second] = pair.second;
+  }
+
+  /* Points are visited in index order, the first point of a group is the smallest. */
+  Array<int> root_dest(co_len, -1);
+  int kill_len = 0;
+  for (int i = 0; i < co_len; i++) {
+    if (r_dest_map[i] == -1) {
+      continue;
+    }
+    const int root = (int)disjoint_set.find_root(i);
+    if (root_dest[root] == -1) {
+      root_dest[root] = i;
+    }
+    else {
+      kill_len++;
+    }
+    r_dest_map[i] = root_dest[root];
+  }
+  return kill_len;
+}
+
+/**
+ * Find duplicate points in \a dist, with the same contract as
+ * #BLI_kdtree_3d_calc_duplicates_fast using index order.
+ *
+ * \param duplicates: An array of int's the length of \a co_len.
+ * Values initialized to -1 are candidates to be merged.
+ * Setting the index to it's own position in the array prevents it from being touched,
+ * although it can still be used as a target.
+ * \returns The number of merges found.
+ *
+ * \note Merging is always a single step (target indices wont be marked for merging).
+ */
+int BLI_merge_by_distance_calc_duplicates(const float (*co)[3],
+                                          const int co_len,
+                                          const float dist,
+                                          int *duplicates)
+{
+  const Vector<MergePair> pairs = merge_pairs_find(co, co_len, nullptr, dist, 0);
+  if (pairs.is_empty()) {
+    return 0;
+  }
+
+  /* Symmetric adjacency, neighbors of point `i` are in `adjacency[offsets[i]..offsets[i + 1]]`.
+   * The order of neighbors doesn't matter, merging below only depends on the index order. */
+  Array<int> offsets(co_len + 1, 0);
+  for (const MergePair &pair : pairs) {
+    offsets[pair.first + 1]++;
+    offsets[pair.second + 1]++;
+  }
+  for (int i = 0; i < co_len; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  Array<int> adjacency(offsets.last());
+  Array<int> fill(offsets.as_span().drop_back(1));
+  for (const MergePair &pair : pairs) {
+    adjacency[fill[pair.first]++] = pair.second;
+    adjacency[fill[pair.second]++] = pair.first;
+  }
+
+  int found = 0;
+  for (int i = 0; i < co_len; i++) {
+    if (!ELEM(duplicates[i], -1, i)) {
+      continue;
+    }
+    const int found_prev = found;
+    for (int j = offsets[i]; j < offsets[i + 1]; j++) {
+      const int other = adjacency[j];
+      if (duplicates[other] == -1) {
+        duplicates[other] = i;
+        found++;
+      }
+    }
+    if (found != found_prev) {
+      /* Prevent chains of doubles. */
+      duplicates[i] = i;
+    }
+  }
+  return found;
+}
@@ -37,6 +37,7 @@
 #  include "BLI_set.hh"
 #  include "BLI_span.hh"
 #  include "BLI_stack.hh"
+#  include "BLI_task.h"
 #  include "BLI_vector.hh"
 #  include "BLI_vector_set.hh"
 
@@ -840,9 +841,6 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
   if (dbg_level > 0) {
     std::cout << "classify  e = " << e << "\n";
   }
-  mpq3 a0 = tri0[0]->co_exact;
-  mpq3 a1 = tri0[1]->co_exact;
-  mpq3 a2 = tri0[2]->co_exact;
   bool rev;
   bool rev0;
   const Vert *flapv0 = find_flap_vert(tri0, e, &rev0);
@@ -854,9 +852,12 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
     std::cout << " rev = " << rev << " flapv = " << flapv << "\n";
   }
   BLI_assert(flapv != nullptr && flapv0 != nullptr);
-  const mpq3 flap = flapv->co_exact;
-  /* orient will be positive if flap is below oriented plane of a0,a1,a2. */
-  int orient = orient3d(a0, a1, a2, flap);
+  /* orient will be positive if flap is below oriented plane of tri0.
+   * Try the floating point filter on the approximate coordinates first. */
+  int orient = orient3d_filter(tri0[0]->co, tri0[1]->co, tri0[2]->co, flapv->co);
+  if (orient == 0) {
+    orient = orient3d(tri0[0]->co_exact, tri0[1]->co_exact, tri0[2]->co_exact, flapv->co_exact);
+  }
   int ans;
   if (orient > 0) {
     ans = rev0 ? 4 : 3;
@@ -2558,45 +2559,74 @@ static Array<Face *> triangulate_poly(Face *f, IMeshArena *arena)
   return ans;
 }
 
+/**
+ * Data needed for parallelization of #triangulate_polymesh.
+ */
+struct TriangulateData {
+  MutableSpan<Array<Face *>> r_face_tris;
+  IMesh &imesh;
+  IMeshArena *arena;
+};
+
+static void triangulate_polymesh_range_func(void *__restrict userdata,
+                                            const int iter,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TriangulateData *data = static_cast<TriangulateData *>(userdata);
+  Face *f = data->imesh.face(iter);
+  /* Tessellate face f, following plan similar to #BM_face_calc_tesselation. */
+  int flen = f->size();
+  if (flen == 3) {
+    data->r_face_tris[iter] = Array<Face *>({f});
+  }
+  else if (flen == 4) {
+    const Vert *v0 = (*f)[0];
+    const Vert *v1 = (*f)[1];
+    const Vert *v2 = (*f)[2];
+    const Vert *v3 = (*f)[3];
+    int eo_01 = f->edge_orig[0];
+    int eo_12 = f->edge_orig[1];
+    int eo_23 = f->edge_orig[2];
+    int eo_30 = f->edge_orig[3];
+    IMeshArena *arena = data->arena;
+    Face *f0 = arena->add_face({v0, v1, v2}, f->orig, {eo_01, eo_12, -1}, {false, false, false});
+    Face *f1 = arena->add_face({v0, v2, v3}, f->orig, {-1, eo_23, eo_30}, {false, false, false});
+    data->r_face_tris[iter] = Array<Face *>({f0, f1});
+  }
+  else {
+    data->r_face_tris[iter] = triangulate_poly(f, data->arena);
+  }
+}
+
 /**
  * Return an #IMesh that is a triangulation of a mesh with general
  * polygonal faces, #IMesh.
  * Added diagonals will be distinguishable by having edge original
  * indices of #NO_INDEX.
+ * The faces are triangulated in parallel, but the output triangles
+ * are in the order of the faces they came from.
  */
 static IMesh triangulate_polymesh(IMesh &imesh, IMeshArena *arena)
 {
-  Vector<Face *> face_tris;
-  constexpr int estimated_tris_per_face = 3;
-  face_tris.reserve(estimated_tris_per_face * imesh.face_size());
-  for (Face *f : imesh.faces()) {
-    /* Tessellate face f, following plan similar to #BM_face_calc_tesselation. */
-    int flen = f->size();
-    if (flen == 3) {
-      face_tris.append(f);
-    }
-    else if (flen == 4) {
-      const Vert *v0 = (*f)[0];
-      const Vert *v1 = (*f)[1];
-      const Vert *v2 = (*f)[2];
-      const Vert *v3 = (*f)[3];
-      int eo_01 = f->edge_orig[0];
-      int eo_12 = f->edge_orig[1];
-      int eo_23 = f->edge_orig[2];
-      int eo_30 = f->edge_orig[3];
-      Face *f0 = arena->add_face({v0, v1, v2}, f->orig, {eo_01, eo_12, -1}, {false, false, false});
-      Face *f1 = arena->add_face({v0, v2, v3}, f->orig, {-1, eo_23, eo_30}, {false, false, false});
-      face_tris.append(f0);
-      face_tris.append(f1);
-    }
-    else {
-      Array<Face *> tris = triangulate_poly(f, arena);
-      for (Face *tri : tris) {
-        face_tris.append(tri);
-      }
-    }
-  }
-  return IMesh(face_tris);
+  Array<Array<Face *>> face_tris(imesh.face_size());
+  TriangulateData data = {face_tris, imesh, arena};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1000;
+  BLI_task_parallel_range(
+      0, imesh.face_size(), &data, triangulate_polymesh_range_func, &settings);
+  int tot_tri = 0;
+  for (const Array<Face *> &tris : face_tris) {
+    tot_tri += tris.size();
+  }
+  Array<Face *> tris(tot_tri);
+  int tri_index = 0;
+  for (const Array<Face *> &f_tris : face_tris) {
+    for (Face *tri : f_tris) {
+      tris[tri_index++] = tri;
+    }
+  }
+  return IMesh(tris);
 }
 
 /**
@@ -194,3 +194,24 @@ int BLI_system_memory_max_in_megabytes_int(void)
   /* NOTE: The result will fit into integer. */
   return (int)min_zz(limit_megabytes, (size_t)INT_MAX);
 }
+
+size_t BLI_system_memory_physical(void)
+{
+#if defined(WIN32)
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status)) {
+    return 0;
+  }
+  return (size_t)status.ullTotalPhys;
+#elif defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+  const long pages = sysconf(_SC_PHYS_PAGES);
+  const long page_size = sysconf(_SC_PAGESIZE);
+  if (pages <= 0 || page_size <= 0) {
+    return 0;
+  }
+  return (size_t)pages * (size_t)page_size;
+#else
+  return 0;
+#endif
+}
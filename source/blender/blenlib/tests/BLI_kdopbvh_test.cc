@@ -132,3 +132,106 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+static bool self_overlap_even_cb(void *UNUSED(userdata),
+                                 int index_a,
+                                 int index_b,
+                                 int UNUSED(thread))
+{
+  return ((index_a + index_b) % 2) == 0;
+}
+
+static int overlap_cmp(const void *a_v, const void *b_v)
+{
+  const BVHTreeOverlap *a = (const BVHTreeOverlap *)a_v, *b = (const BVHTreeOverlap *)b_v;
+  if (a->indexA != b->indexA) {
+    return (a->indexA < b->indexA) ? -1 : 1;
+  }
+  if (a->indexB != b->indexB) {
+    return (a->indexB < b->indexB) ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Sort the pairs with the lower index first in each pair. */
+static void overlap_sort(BVHTreeOverlap *overlap, uint overlap_len)
+{
+  for (uint i = 0; i < overlap_len; i++) {
+    if (overlap[i].indexA > overlap[i].indexB) {
+      SWAP(int, overlap[i].indexA, overlap[i].indexB);
+    }
+  }
+  qsort(overlap, overlap_len, sizeof(*overlap), overlap_cmp);
+}
+
+/**
+ * Self overlap must find the same pairs as regular overlap of the tree with itself,
+ * each of them only once.
+ */
+static void self_overlap_test(int segments_len, int random_seed, bool use_callback)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(segments_len, 0.0, 4, 26);
+
+  for (int i = 0; i < segments_len; i++) {
+    float co[2][3];
+    rng_v3_round(co[0], 3, rng, 1000, 1.0f);
+    rng_v3_round(co[1], 3, rng, 1000, 0.03f);
+    add_v3_v3(co[1], co[0]);
+    BLI_bvhtree_insert(tree, i, co[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+
+  BVHTree_OverlapCallback callback = use_callback ? self_overlap_even_cb : NULL;
+  uint overlap_len, self_overlap_len;
+  BVHTreeOverlap *overlap = BLI_bvhtree_overlap(tree, tree, &overlap_len, callback, NULL);
+  BVHTreeOverlap *self_overlap = BLI_bvhtree_overlap_ex(
+      tree,
+      tree,
+      &self_overlap_len,
+      callback,
+      NULL,
+      0,
+      BVH_OVERLAP_USE_THREADING | BVH_OVERLAP_RETURN_PAIRS | BVH_OVERLAP_SELF);
+
+  ASSERT_GT(overlap_len, 0);
+  ASSERT_EQ(overlap_len, self_overlap_len * 2);
+
+  /* Every pair is in the regular overlap in both orders. */
+  overlap_sort(overlap, overlap_len);
+  overlap_sort(self_overlap, self_overlap_len);
+  for (uint i = 0; i < self_overlap_len; i++) {
+    EXPECT_NE(self_overlap[i].indexA, self_overlap[i].indexB);
+    EXPECT_EQ(self_overlap[i].indexA, overlap[i * 2].indexA);
+    EXPECT_EQ(self_overlap[i].indexB, overlap[i * 2].indexB);
+    EXPECT_EQ(overlap_cmp(&overlap[i * 2], &overlap[i * 2 + 1]), 0);
+  }
+
+  MEM_freeN(overlap);
+  MEM_freeN(self_overlap);
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+}
+
+TEST(kdopbvh, SelfOverlap_1)
+{
+  BVHTree *tree = BLI_bvhtree_new(1, 0.0, 4, 26);
+  const float co[3] = {0.0f, 0.0f, 0.0f};
+  BLI_bvhtree_insert(tree, 0, co, 1);
+  BLI_bvhtree_balance(tree);
+
+  uint overlap_len = 1;
+  BVHTreeOverlap *overlap = BLI_bvhtree_overlap_ex(
+      tree, tree, &overlap_len, NULL, NULL, 0, BVH_OVERLAP_RETURN_PAIRS | BVH_OVERLAP_SELF);
+  EXPECT_EQ(overlap_len, 0);
+  MEM_SAFE_FREE(overlap);
+  BLI_bvhtree_free(tree);
+}
+TEST(kdopbvh, SelfOverlap_5000)
+{
+  self_overlap_test(5000, 1234, false);
+}
+TEST(kdopbvh, SelfOverlapCallback_5000)
+{
+  self_overlap_test(5000, 4321, true);
+}
@@ -0,0 +1,126 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+
+/* More points than balanced by a single thread. */
+#define POINTS_LEN 50000
+#define QUERIES_LEN 2000
+
+static float (*random_points_create(const int points_len, const uint seed))[3]
+{
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(*co) * points_len, __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < points_len; i++) {
+    co[i][0] = BLI_rng_get_float(rng);
+    co[i][1] = BLI_rng_get_float(rng);
+    /* Flat along Z, like points on a surface. */
+    co[i][2] = BLI_rng_get_float(rng) * 0.05f;
+  }
+  BLI_rng_free(rng);
+  return co;
+}
+
+static KDTree_3d *random_tree_create(const float (*co)[3], const int points_len)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+TEST(kdtree, FindNearestBruteForce)
+{
+  float(*co)[3] = random_points_create(POINTS_LEN, 1234);
+  float(*queries)[3] = random_points_create(QUERIES_LEN, 4321);
+  KDTree_3d *tree = random_tree_create(co, POINTS_LEN);
+
+  for (int q = 0; q < QUERIES_LEN; q++) {
+    float min_dist_sq = FLT_MAX;
+    for (int i = 0; i < POINTS_LEN; i++) {
+      min_dist_sq = min_ff(min_dist_sq, len_squared_v3v3(queries[q], co[i]));
+    }
+    KDTreeNearest_3d nearest;
+    const int index = BLI_kdtree_3d_find_nearest(tree, queries[q], &nearest);
+    ASSERT_NE(index, -1);
+    EXPECT_FLOAT_EQ(len_squared_v3v3(queries[q], co[index]), min_dist_sq);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(queries);
+  MEM_freeN(co);
+}
+
+TEST(kdtree, FindNearestNBatch)
+{
+  const uint nearest_len_capacity = 8;
+  float(*co)[3] = random_points_create(POINTS_LEN, 1234);
+  float(*queries)[3] = random_points_create(QUERIES_LEN, 4321);
+  KDTree_3d *tree = random_tree_create(co, POINTS_LEN);
+
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(*nearest) * QUERIES_LEN * nearest_len_capacity, __func__);
+  int *nearest_len = (int *)MEM_mallocN(sizeof(int) * QUERIES_LEN, __func__);
+  BLI_kdtree_3d_find_nearest_n_batch(
+      tree, queries, QUERIES_LEN, nearest, nearest_len_capacity, nearest_len);
+
+  for (int q = 0; q < QUERIES_LEN; q++) {
+    KDTreeNearest_3d nearest_single[nearest_len_capacity];
+    const int found = BLI_kdtree_3d_find_nearest_n(
+        tree, queries[q], nearest_single, nearest_len_capacity);
+    ASSERT_EQ(nearest_len[q], found);
+    for (int n = 0; n < found; n++) {
+      EXPECT_EQ(nearest[q * nearest_len_capacity + n].index, nearest_single[n].index);
+      EXPECT_EQ(nearest[q * nearest_len_capacity + n].dist, nearest_single[n].dist);
+    }
+  }
+
+  MEM_freeN(nearest_len);
+  MEM_freeN(nearest);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(queries);
+  MEM_freeN(co);
+}
+
+TEST(kdtree, RangeSearchBatch)
+{
+  const float range = 0.01f;
+  float(*co)[3] = random_points_create(POINTS_LEN, 1234);
+  float(*queries)[3] = random_points_create(QUERIES_LEN, 4321);
+  KDTree_3d *tree = random_tree_create(co, POINTS_LEN);
+
+  KDTreeNearest_3d *nearest;
+  int *offsets = (int *)MEM_mallocN(sizeof(int) * (QUERIES_LEN + 1), __func__);
+  const int nearest_len = BLI_kdtree_3d_range_search_batch(
+      tree, queries, QUERIES_LEN, range, &nearest, offsets);
+  EXPECT_EQ(offsets[QUERIES_LEN], nearest_len);
+  EXPECT_GT(nearest_len, 0);
+
+  for (int q = 0; q < QUERIES_LEN; q++) {
+    KDTreeNearest_3d *nearest_single = NULL;
+    const int found = BLI_kdtree_3d_range_search(tree, queries[q], &nearest_single, range);
+    ASSERT_EQ(offsets[q + 1] - offsets[q], found);
+    for (int n = 0; n < found; n++) {
+      EXPECT_EQ(nearest[offsets[q] + n].index, nearest_single[n].index);
+      EXPECT_LE(nearest[offsets[q] + n].dist, range);
+    }
+    if (nearest_single) {
+      MEM_freeN(nearest_single);
+    }
+  }
+
+  if (nearest) {
+    MEM_freeN(nearest);
+  }
+  MEM_freeN(offsets);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(queries);
+  MEM_freeN(co);
+}
@@ -0,0 +1,135 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_disjoint_set.hh"
+#include "BLI_float3.hh"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_merge_by_distance.h"
+#include "BLI_rand.h"
+
+namespace blender::tests {
+
+/* Clusters of jittered points on a grid, with some isolated points in between. */
+static Array<float3> merge_test_points(const int clusters_len, const float jitter)
+{
+  RNG *rng = BLI_rng_new(0);
+  Array<float3> points(clusters_len * 4);
+  for (int i = 0; i < clusters_len; i++) {
+    const float3 center((float)(i % 16), (float)((i / 16) % 16), (float)(i / 256));
+    for (int j = 0; j < 4; j++) {
+      float3 offset;
+      BLI_rng_get_float_unit_v3(rng, offset);
+      /* Every fourth point is far from its cluster. */
+      const float scale = (j == 3) ? 0.5f : jitter * BLI_rng_get_float(rng);
+      points[i * 4 + j] = center + offset * scale;
+    }
+  }
+  BLI_rng_free(rng);
+  return points;
+}
+
+TEST(merge_by_distance, GroupsMatchBruteForce)
+{
+  const float dist = 0.1f;
+  Array<float3> points = merge_test_points(1000, 0.06f);
+  const int points_len = (int)points.size();
+  const float(*co)[3] = (const float(*)[3])points.data();
+
+  Array<int> dest_map(points_len);
+  const int kill_len = BLI_merge_by_distance_calc_groups(
+      co, points_len, nullptr, dist, 0, dest_map.data());
+
+  DisjointSet disjoint_set(points_len);
+  Array<bool> grouped(points_len, false);
+  for (int a = 0; a < points_len; a++) {
+    for (int b = a + 1; b < points_len; b++) {
+      if (len_v3v3(co[a], co[b]) <= dist) {
+        disjoint_set.join(a, b);
+        grouped[a] = grouped[b] = true;
+      }
+    }
+  }
+
+  int expected_kill_len = 0;
+  for (int i = 0; i < points_len; i++) {
+    if (!grouped[i]) {
+      EXPECT_EQ(dest_map[i], -1);
+      continue;
+    }
+    const int dest = dest_map[i];
+    ASSERT_NE(dest, -1);
+    EXPECT_LE(dest, i);
+    EXPECT_EQ(dest_map[dest], dest);
+    EXPECT_TRUE(disjoint_set.in_same_set(i, dest));
+    expected_kill_len += (dest != i);
+  }
+  EXPECT_EQ(kill_len, expected_kill_len);
+  EXPECT_GT(kill_len, 0);
+}
+
+TEST(merge_by_distance, GroupsMask)
+{
+  const float co[4][3] = {{0, 0, 0}, {0.01f, 0, 0}, {0.02f, 0, 0}, {5, 5, 5}};
+  BLI_bitmap *mask = BLI_BITMAP_NEW(4, __func__);
+  BLI_BITMAP_ENABLE(mask, 1);
+  BLI_BITMAP_ENABLE(mask, 2);
+  BLI_BITMAP_ENABLE(mask, 3);
+
+  int dest_map[4];
+  EXPECT_EQ(BLI_merge_by_distance_calc_groups(co, 4, mask, 0.05f, 0, dest_map), 1);
+  EXPECT_EQ(dest_map[0], -1);
+  EXPECT_EQ(dest_map[1], 1);
+  EXPECT_EQ(dest_map[2], 1);
+  EXPECT_EQ(dest_map[3], -1);
+  MEM_freeN(mask);
+}
+
+TEST(merge_by_distance, GroupsZeroDistance)
+{
+  const float co[4][3] = {{1, 2, 3}, {1, 2, 3}, {1, 2, 3.0001f}, {1, 2, 3}};
+  int dest_map[4];
+  EXPECT_EQ(BLI_merge_by_distance_calc_groups(co, 4, nullptr, 0.0f, 0, dest_map), 2);
+  EXPECT_EQ(dest_map[0], 0);
+  EXPECT_EQ(dest_map[1], 0);
+  EXPECT_EQ(dest_map[2], -1);
+  EXPECT_EQ(dest_map[3], 0);
+}
+
+TEST(merge_by_distance, DuplicatesMatchKDTree)
+{
+  const float dist = 0.1f;
+  Array<float3> points = merge_test_points(1000, 0.15f);
+  const int points_len = (int)points.size();
+  const float(*co)[3] = (const float(*)[3])points.data();
+
+  KDTree_3d *tree = BLI_kdtree_3d_new((uint)points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  /* Some points are kept, they can only be used as targets. */
+  Array<int> duplicates(points_len), duplicates_kdtree(points_len);
+  for (int i = 0; i < points_len; i++) {
+    duplicates[i] = duplicates_kdtree[i] = (i % 7 == 0) ? i : -1;
+  }
+
+  const int found_kdtree = BLI_kdtree_3d_calc_duplicates_fast(
+      tree, dist, true, duplicates_kdtree.data());
+  const int found = BLI_merge_by_distance_calc_duplicates(
+      co, points_len, dist, duplicates.data());
+  BLI_kdtree_3d_free(tree);
+
+  EXPECT_GT(found, 0);
+  EXPECT_EQ(found, found_kdtree);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(duplicates[i], duplicates_kdtree[i]);
+  }
+}
+
+}  // namespace blender::tests
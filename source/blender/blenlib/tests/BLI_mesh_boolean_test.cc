@@ -8,13 +8,18 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #include "BLI_array.hh"
 #include "BLI_map.hh"
 #include "BLI_math_mpq.hh"
 #include "BLI_mesh_boolean.hh"
 #include "BLI_mpq3.hh"
+#include "BLI_task.h"
 #include "BLI_vector.hh"
 
+#define DO_PERF_TESTS 0
+
 #ifdef WITH_GMP
 namespace blender::meshintersect::tests {
 
@@ -906,5 +911,163 @@ TEST(boolean_polymesh, CubePlane)
   }
 }
 
+#  if DO_PERF_TESTS
+
+/**
+ * Append the faces of a UV sphere with nrings rings and 2 * nrings segments to faces,
+ * using quads for all but the triangle fans around the poles.
+ */
+static void add_sphere_polys(Vector<Face *> &faces,
+                             int nrings,
+                             const double3 &center,
+                             double radius,
+                             IMeshArena *arena)
+{
+  const int nsegs = 2 * nrings;
+  Array<const Vert *> vert((nrings - 1) * nsegs);
+  auto vert_index_fn = [nrings](int seg, int ring) { return seg * (nrings - 1) + (ring - 1); };
+  for (int s = 0; s < nsegs; ++s) {
+    double phi = s * 2.0 * M_PI / nsegs;
+    for (int r = 1; r < nrings; ++r) {
+      double theta = r * M_PI / nrings;
+      double3 co(radius * sin(theta) * cos(phi),
+                 radius * sin(theta) * sin(phi),
+                 radius * cos(theta));
+      vert[vert_index_fn(s, r)] = arena->add_or_find_vert(co + center, NO_INDEX);
+    }
+  }
+  const Vert *vtop = arena->add_or_find_vert(center + double3(0.0, 0.0, radius), NO_INDEX);
+  const Vert *vbot = arena->add_or_find_vert(center - double3(0.0, 0.0, radius), NO_INDEX);
+  Array<int> eid3(3, NO_INDEX);
+  Array<int> eid4(4, NO_INDEX);
+  for (int s = 0; s < nsegs; ++s) {
+    int snext = (s + 1) % nsegs;
+    faces.append(arena->add_face(
+        {vtop, vert[vert_index_fn(s, 1)], vert[vert_index_fn(snext, 1)]}, faces.size(), eid3));
+    for (int r = 1; r < nrings - 1; ++r) {
+      faces.append(arena->add_face({vert[vert_index_fn(s, r)],
+                                    vert[vert_index_fn(s, r + 1)],
+                                    vert[vert_index_fn(snext, r + 1)],
+                                    vert[vert_index_fn(snext, r)]},
+                                   faces.size(),
+                                   eid4));
+    }
+    faces.append(arena->add_face(
+        {vert[vert_index_fn(s, nrings - 1)], vbot, vert[vert_index_fn(snext, nrings - 1)]},
+        faces.size(),
+        eid3));
+  }
+}
+
+/**
+ * Append the faces of a closed cylinder with nsegs sides, of the given radius and half height,
+ * to faces. The caps are n-gons, so that the polygon triangulation is exercised too.
+ * The axis of the cylinder is z, or x if along_x is true.
+ */
+static void add_cylinder_polys(Vector<Face *> &faces,
+                               int nsegs,
+                               double radius,
+                               double half_height,
+                               bool along_x,
+                               IMeshArena *arena)
+{
+  Array<const Vert *> bot(nsegs);
+  Array<const Vert *> top(nsegs);
+  for (int s = 0; s < nsegs; ++s) {
+    double phi = s * 2.0 * M_PI / nsegs;
+    double3 cob(radius * cos(phi), radius * sin(phi), -half_height);
+    double3 cot(radius * cos(phi), radius * sin(phi), half_height);
+    if (along_x) {
+      /* Cyclic permutation of the axes, to keep the orientation. */
+      cob = double3(cob[2], cob[0], cob[1]);
+      cot = double3(cot[2], cot[0], cot[1]);
+    }
+    bot[s] = arena->add_or_find_vert(cob, NO_INDEX);
+    top[s] = arena->add_or_find_vert(cot, NO_INDEX);
+  }
+  Array<int> eid4(4, NO_INDEX);
+  for (int s = 0; s < nsegs; ++s) {
+    int snext = (s + 1) % nsegs;
+    faces.append(
+        arena->add_face({bot[s], bot[snext], top[snext], top[s]}, faces.size(), eid4));
+  }
+  Array<const Vert *> bot_rev(nsegs);
+  for (int s = 0; s < nsegs; ++s) {
+    bot_rev[s] = bot[nsegs - 1 - s];
+  }
+  Array<int> eid_cap(nsegs, NO_INDEX);
+  faces.append(arena->add_face(top, faces.size(), eid_cap));
+  faces.append(arena->add_face(bot_rev, faces.size(), eid_cap));
+}
+
+static void spheresphere_boolean_test(int nrings, double y_offset, BoolOpType op)
+{
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  double time_start = PIL_check_seconds_timer();
+  IMeshArena arena;
+  Vector<Face *> faces;
+  add_sphere_polys(faces, nrings, double3(0.0, 0.0, 0.0), 1.0, &arena);
+  int nf = faces.size();
+  add_sphere_polys(faces, nrings, double3(0.0, y_offset, 0.0), 1.0, &arena);
+  IMesh mesh(faces);
+  double time_create = PIL_check_seconds_timer();
+  IMesh out = boolean_mesh(
+      mesh, op, 2, [nf](int t) { return t < nf ? 0 : 1; }, false, nullptr, &arena);
+  double time_boolean = PIL_check_seconds_timer();
+  out.populate_vert();
+  std::cout << "Input faces: " << mesh.face_size() << ", output faces: " << out.face_size()
+            << "\n";
+  std::cout << "Create time: " << time_create - time_start << "\n";
+  std::cout << "Boolean time: " << time_boolean - time_create << "\n";
+  EXPECT_GT(out.face_size(), 0);
+  if (DO_OBJ) {
+    write_obj_mesh(out, "spheresphere_boolean");
+  }
+  BLI_task_scheduler_exit();
+}
+
+static void cylinders_boolean_test(int nsegs, BoolOpType op)
+{
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  double time_start = PIL_check_seconds_timer();
+  IMeshArena arena;
+  Vector<Face *> faces;
+  add_cylinder_polys(faces, nsegs, 0.5, 1.0, false, &arena);
+  int nf = faces.size();
+  add_cylinder_polys(faces, nsegs, 0.5, 1.0, true, &arena);
+  IMesh mesh(faces);
+  double time_create = PIL_check_seconds_timer();
+  IMesh out = boolean_mesh(
+      mesh, op, 2, [nf](int t) { return t < nf ? 0 : 1; }, false, nullptr, &arena);
+  double time_boolean = PIL_check_seconds_timer();
+  out.populate_vert();
+  std::cout << "Input faces: " << mesh.face_size() << ", output faces: " << out.face_size()
+            << "\n";
+  std::cout << "Create time: " << time_create - time_start << "\n";
+  std::cout << "Boolean time: " << time_boolean - time_create << "\n";
+  EXPECT_GT(out.face_size(), 0);
+  if (DO_OBJ) {
+    write_obj_mesh(out, "cylinders_boolean");
+  }
+  BLI_task_scheduler_exit();
+}
+
+TEST(boolean_polymesh_perf, SphereSphereUnion)
+{
+  spheresphere_boolean_test(128, 0.5, BoolOpType::Union);
+}
+
+TEST(boolean_polymesh_perf, SphereSphereDifference)
+{
+  spheresphere_boolean_test(128, 0.5, BoolOpType::Difference);
+}
+
+TEST(boolean_polymesh_perf, CylindersUnion)
+{
+  cylinders_boolean_test(4096, BoolOpType::Union);
+}
+
+#  endif
+
 }  // namespace blender::meshintersect::tests
 #endif
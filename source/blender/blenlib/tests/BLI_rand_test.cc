@@ -0,0 +1,40 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_rand.h"
+#include "BLI_rand.hh"
+
+namespace blender::tests {
+
+TEST(rand, SkipMatchesSteps)
+{
+  for (const int64_t n : {0, 1, 2, 3, 7, 64, 1000, 123457}) {
+    RandomNumberGenerator rng_step(1234);
+    RandomNumberGenerator rng_skip(1234);
+    for (int64_t i = 0; i < n; i++) {
+      rng_step.get_uint32();
+    }
+    rng_skip.skip(n);
+    for (int i = 0; i < 8; i++) {
+      EXPECT_EQ(rng_step.get_uint32(), rng_skip.get_uint32());
+    }
+  }
+}
+
+TEST(rand, SkipLarge)
+{
+  /* Skipping in one go or in parts gives the same sequence. */
+  RNG *rng_a = BLI_rng_new_srandom(42);
+  RNG *rng_b = BLI_rng_copy(rng_a);
+  BLI_rng_skip(rng_a, 2000000000);
+  for (int i = 0; i < 20; i++) {
+    BLI_rng_skip(rng_b, 100000000);
+  }
+  EXPECT_EQ(BLI_rng_get_int(rng_a), BLI_rng_get_int(rng_b));
+  EXPECT_EQ(BLI_rng_get_float(rng_a), BLI_rng_get_float(rng_b));
+  BLI_rng_free(rng_a);
+  BLI_rng_free(rng_b);
+}
+
+}  // namespace blender::tests
@@ -0,0 +1,288 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdopbvh.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#define NUM_RUN_AVERAGED 5
+
+/* Same tree type and k-dop as mesh triangle trees in bvhutils. */
+#define TREE_TYPE 4
+#define TREE_AXIS 6
+
+/* A bumpy grid with uneven triangle sizes, denser towards one corner. */
+static float (*grid_triangles_create(const int res, int *r_tris_len))[3][3]
+{
+  float(*tris)[3][3] = (float(*)[3][3])MEM_mallocN(sizeof(*tris) * res * res * 2, __func__);
+  RNG *rng = BLI_rng_new(1234);
+  int tris_len = 0;
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      float co[4][3];
+      for (int i = 0; i < 4; i++) {
+        const float fx = (float)(x + (i & 1)) / res, fy = (float)(y + (i >> 1)) / res;
+        co[i][0] = fx * fx;
+        co[i][1] = fy * fy;
+        co[i][2] = 0.05f * sinf(fx * 40.0f) * cosf(fy * 25.0f) + 0.001f * BLI_rng_get_float(rng);
+      }
+      copy_v3_v3(tris[tris_len][0], co[0]);
+      copy_v3_v3(tris[tris_len][1], co[1]);
+      copy_v3_v3(tris[tris_len][2], co[3]);
+      tris_len++;
+      copy_v3_v3(tris[tris_len][0], co[0]);
+      copy_v3_v3(tris[tris_len][1], co[3]);
+      copy_v3_v3(tris[tris_len][2], co[2]);
+      tris_len++;
+    }
+  }
+
+  BLI_rng_free(rng);
+  *r_tris_len = tris_len;
+  return tris;
+}
+
+/* Small triangles packed in a few dense clusters, plus some long thin ones crossing the
+ * bounds, so leaf bounds overlap a lot. */
+static float (*cluster_triangles_create(const int tris_len, int *r_tris_len))[3][3]
+{
+  float(*tris)[3][3] = (float(*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+  RNG *rng = BLI_rng_new(1234);
+  float centers[8][3];
+
+  for (int c = 0; c < 8; c++) {
+    BLI_rng_get_float_unit_v3(rng, centers[c]);
+  }
+  for (int i = 0; i < tris_len; i++) {
+    if (i % 64 == 0) {
+      for (int v = 0; v < 3; v++) {
+        for (int k = 0; k < 3; k++) {
+          tris[i][v][k] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+        }
+      }
+      continue;
+    }
+    const float *center = centers[BLI_rng_get_int(rng) % 8];
+    float co[3];
+    for (int k = 0; k < 3; k++) {
+      co[k] = center[k] + 0.1f * (BLI_rng_get_float(rng) - 0.5f);
+    }
+    for (int v = 0; v < 3; v++) {
+      for (int k = 0; k < 3; k++) {
+        tris[i][v][k] = co[k] + 0.002f * (BLI_rng_get_float(rng) - 0.5f);
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+  *r_tris_len = tris_len;
+  return tris;
+}
+
+static BVHTree *grid_tree_create(const float (*tris)[3][3], const int tris_len)
+{
+  BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0f, TREE_TYPE, TREE_AXIS);
+  for (int i = 0; i < tris_len; i++) {
+    BLI_bvhtree_insert(tree, i, &tris[i][0][0], 3);
+  }
+  BLI_bvhtree_balance(tree);
+  return tree;
+}
+static void grid_raycast_cb(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+  const float(*tri)[3] = ((const float(*)[3][3])userdata)[index];
+  float dist;
+
+  if (isect_ray_tri_v3(ray->origin, ray->direction, tri[0], tri[1], tri[2], &dist, NULL) &&
+      dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static void grid_nearest_cb(void *userdata, int index, const float co[3], BVHTreeNearest *nearest)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  float nearest_tmp[3];
+
+  closest_on_tri_to_point_v3(nearest_tmp, co, tris[index][0], tris[index][1], tris[index][2]);
+  const float dist_sq = len_squared_v3v3(co, nearest_tmp);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, nearest_tmp);
+  }
+}
+
+static void kdopbvh_query_test(const char *id,
+                               const bool use_clusters,
+                               const int size,
+                               const int queries_len)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  int tris_len;
+  float(*tris)[3][3] = use_clusters ? cluster_triangles_create(size, &tris_len) :
+                                      grid_triangles_create(size, &tris_len);
+
+  RNG *rng = BLI_rng_new(4321);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * queries_len, __func__);
+  for (int i = 0; i < queries_len; i++) {
+    points[i][0] = BLI_rng_get_float(rng);
+    points[i][1] = BLI_rng_get_float(rng);
+    points[i][2] = BLI_rng_get_float(rng) * 0.2f - 0.1f;
+  }
+  BLI_rng_free(rng);
+
+  double build_time = 0.0;
+  BVHTree *tree = NULL;
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    if (tree) {
+      BLI_bvhtree_free(tree);
+    }
+    const double start = PIL_check_seconds_timer();
+    tree = grid_tree_create(tris, tris_len);
+    build_time += PIL_check_seconds_timer() - start;
+  }
+
+  const float dir[3] = {0.0f, 0.0f, -1.0f};
+  double start = PIL_check_seconds_timer();
+  for (int i = 0; i < queries_len; i++) {
+    const float origin[3] = {points[i][0], points[i][1], 1.0f};
+    BVHTreeRayHit hit;
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, origin, dir, 0.0f, &hit, grid_raycast_cb, tris);
+  }
+  const double raycast_time = PIL_check_seconds_timer() - start;
+
+  start = PIL_check_seconds_timer();
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeNearest nearest;
+    nearest.index = -1;
+    nearest.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, points[i], &nearest, grid_nearest_cb, tris);
+    EXPECT_NE(nearest.index, -1);
+  }
+  const double nearest_time = PIL_check_seconds_timer() - start;
+
+  printf("\tBuild %fs (average over %d runs), %d ray casts %fs, %d nearest %fs\n",
+         build_time / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED,
+         queries_len,
+         raycast_time,
+         queries_len,
+         nearest_time);
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(tris);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+typedef struct SingleQueryData {
+  BVHTree *tree;
+  const float (*tris)[3][3];
+  const float (*co)[3];
+  BVHTreeNearest *nearest;
+} SingleQueryData;
+
+static void single_nearest_cb(void *__restrict userdata,
+                              const int i,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SingleQueryData *data = (SingleQueryData *)userdata;
+  BLI_bvhtree_find_nearest(
+      data->tree, data->co[i], &data->nearest[i], grid_nearest_cb, (void *)data->tris);
+}
+
+/* Points close to the surface in random order, like vertices of a shrink-wrapped mesh. */
+static void kdopbvh_batch_test(const char *id, const int res, const int queries_len)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  int tris_len;
+  float(*tris)[3][3] = grid_triangles_create(res, &tris_len);
+  BVHTree *tree = grid_tree_create(tris, tris_len);
+
+  RNG *rng = BLI_rng_new(4321);
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(*co) * queries_len, __func__);
+  for (int i = 0; i < queries_len; i++) {
+    co[i][0] = BLI_rng_get_float(rng);
+    co[i][1] = BLI_rng_get_float(rng);
+    co[i][2] = BLI_rng_get_float(rng) * 0.2f + 0.1f;
+  }
+  BLI_rng_free(rng);
+
+  BVHTreeNearest *nearest[2];
+  for (int b = 0; b < 2; b++) {
+    nearest[b] = (BVHTreeNearest *)MEM_mallocN(sizeof(BVHTreeNearest) * queries_len, __func__);
+    for (int i = 0; i < queries_len; i++) {
+      nearest[b][i].index = -1;
+      nearest[b][i].dist_sq = FLT_MAX;
+    }
+  }
+
+  SingleQueryData data = {tree, tris, co, nearest[0]};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  double start = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, queries_len, &data, single_nearest_cb, &settings);
+  const double single_nearest_time = PIL_check_seconds_timer() - start;
+
+  start = PIL_check_seconds_timer();
+  BLI_bvhtree_find_nearest_batch(
+      tree, co, queries_len, nearest[1], grid_nearest_cb, (void *)tris, 0);
+  const double batch_nearest_time = PIL_check_seconds_timer() - start;
+
+  printf("\tNearest: single %fs, batch %fs\n", single_nearest_time, batch_nearest_time);
+
+  for (int i = 0; i < queries_len; i++) {
+    EXPECT_FLOAT_EQ(nearest[0][i].dist_sq, nearest[1][i].dist_sq);
+  }
+
+  for (int b = 0; b < 2; b++) {
+    MEM_freeN(nearest[b]);
+  }
+  MEM_freeN(co);
+  BLI_bvhtree_free(tree);
+  MEM_freeN(tris);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, Grid_32k_Queries_100k)
+{
+  kdopbvh_query_test("BVH queries - Grid - 32k triangles - 100k queries", false, 128, 100000);
+}
+
+TEST(kdopbvh, Grid_2M_Queries_50k)
+{
+  kdopbvh_query_test("BVH queries - Grid - 2M triangles - 50k queries", false, 1024, 50000);
+}
+
+TEST(kdopbvh, Clusters_100k_Queries_100k)
+{
+  kdopbvh_query_test(
+      "BVH queries - Clusters - 100k triangles - 100k queries", true, 100000, 100000);
+}
+
+TEST(kdopbvh, Batch_Grid_32k_Queries_100k)
+{
+  kdopbvh_batch_test("BVH batch queries - Grid - 32k triangles - 100k queries", 128, 100000);
+}
+
+TEST(kdopbvh, Batch_Grid_2M_Queries_200k)
+{
+  kdopbvh_batch_test("BVH batch queries - Grid - 2M triangles - 200k queries", 1024, 200000);
+}
@@ -0,0 +1,171 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#define NUM_RUN_AVERAGED 5
+
+/* Points on a bumpy surface, denser towards one corner, in random order like the vertices of
+ * a mesh after editing. */
+static float (*surface_points_create(const int points_len, const uint seed))[3]
+{
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(*co) * points_len, __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < points_len; i++) {
+    const float fx = BLI_rng_get_float(rng), fy = BLI_rng_get_float(rng);
+    co[i][0] = fx * fx;
+    co[i][1] = fy * fy;
+    co[i][2] = 0.05f * sinf(fx * 40.0f) * cosf(fy * 25.0f);
+  }
+  BLI_rng_free(rng);
+  return co;
+}
+
+static KDTree_3d *surface_tree_create(const float (*co)[3], const int points_len)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+typedef struct SingleQueryData {
+  const KDTree_3d *tree;
+  const float (*co)[3];
+  KDTreeNearest_3d *nearest;
+  uint nearest_len_capacity;
+  float range;
+  int *found;
+} SingleQueryData;
+
+static void single_find_nearest_n_cb(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SingleQueryData *data = (SingleQueryData *)userdata;
+  data->found[i] = BLI_kdtree_3d_find_nearest_n(data->tree,
+                                                data->co[i],
+                                                &data->nearest[i * data->nearest_len_capacity],
+                                                data->nearest_len_capacity);
+}
+
+static void single_range_search_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SingleQueryData *data = (SingleQueryData *)userdata;
+  KDTreeNearest_3d *nearest = NULL;
+  data->found[i] = BLI_kdtree_3d_range_search(data->tree, data->co[i], &nearest, data->range);
+  if (nearest) {
+    MEM_freeN(nearest);
+  }
+}
+
+static void kdtree_query_test(const char *id,
+                              const int points_len,
+                              const int queries_len,
+                              const uint nearest_len_capacity,
+                              const float range)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  float(*co)[3] = surface_points_create(points_len, 1234);
+  float(*queries)[3] = surface_points_create(queries_len, 4321);
+
+  double build_time = 0.0;
+  KDTree_3d *tree = NULL;
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    if (tree) {
+      BLI_kdtree_3d_free(tree);
+    }
+    const double start = PIL_check_seconds_timer();
+    tree = surface_tree_create(co, points_len);
+    build_time += PIL_check_seconds_timer() - start;
+  }
+
+  KDTreeNearest_3d *nearest[2];
+  int *found[2];
+  for (int b = 0; b < 2; b++) {
+    nearest[b] = (KDTreeNearest_3d *)MEM_mallocN(
+        sizeof(KDTreeNearest_3d) * queries_len * nearest_len_capacity, __func__);
+    found[b] = (int *)MEM_mallocN(sizeof(int) * queries_len, __func__);
+  }
+
+  SingleQueryData data = {tree, queries, nearest[0], nearest_len_capacity, range, found[0]};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  double start = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, queries_len, &data, single_find_nearest_n_cb, &settings);
+  const double single_nearest_time = PIL_check_seconds_timer() - start;
+
+  start = PIL_check_seconds_timer();
+  BLI_kdtree_3d_find_nearest_n_batch(
+      tree, queries, queries_len, nearest[1], nearest_len_capacity, found[1]);
+  const double batch_nearest_time = PIL_check_seconds_timer() - start;
+
+  for (int i = 0; i < queries_len; i++) {
+    EXPECT_EQ(found[0][i], found[1][i]);
+    EXPECT_FLOAT_EQ(nearest[0][i * nearest_len_capacity].dist,
+                    nearest[1][i * nearest_len_capacity].dist);
+  }
+
+  start = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, queries_len, &data, single_range_search_cb, &settings);
+  const double single_range_time = PIL_check_seconds_timer() - start;
+
+  KDTreeNearest_3d *range_nearest;
+  int *range_offsets = (int *)MEM_mallocN(sizeof(int) * (queries_len + 1), __func__);
+  start = PIL_check_seconds_timer();
+  BLI_kdtree_3d_range_search_batch(
+      tree, queries, queries_len, range, &range_nearest, range_offsets);
+  const double batch_range_time = PIL_check_seconds_timer() - start;
+
+  for (int i = 0; i < queries_len; i++) {
+    EXPECT_EQ(found[0][i], range_offsets[i + 1] - range_offsets[i]);
+  }
+
+  printf("\tBuild: %fs (average over %d runs)\n",
+         build_time / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+  printf("\t%u nearest: single %fs, batch %fs\n",
+         nearest_len_capacity,
+         single_nearest_time,
+         batch_nearest_time);
+  printf("\tRange: single %fs, batch %fs\n", single_range_time, batch_range_time);
+
+  if (range_nearest) {
+    MEM_freeN(range_nearest);
+  }
+  MEM_freeN(range_offsets);
+  for (int b = 0; b < 2; b++) {
+    MEM_freeN(nearest[b]);
+    MEM_freeN(found[b]);
+  }
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(queries);
+  MEM_freeN(co);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdtree, Points_100k_Queries_100k)
+{
+  kdtree_query_test("KD-tree queries - 100k points - 100k queries", 100000, 100000, 3, 0.005f);
+}
+
+TEST(kdtree, Points_2M_Queries_1M)
+{
+  kdtree_query_test("KD-tree queries - 2M points - 1M queries", 2000000, 1000000, 10, 0.001f);
+}
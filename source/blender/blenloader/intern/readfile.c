@@ -4096,7 +4096,7 @@ static void direct_link_particlesystems(BlendDataReader *reader, ListBase *parti
     }
 
     psys->tree = NULL;
-    psys->bvhtree = NULL;
+    psys->sph_grid = NULL;
 
     psys->orig_psys = NULL;
     psys->batch_cache = NULL;
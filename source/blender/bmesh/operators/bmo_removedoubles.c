@@ -23,9 +23,9 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_alloca.h"
-#include "BLI_kdtree.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_merge_by_distance.h"
 #include "BLI_stack.h"
 #include "BLI_utildefines_stack.h"
 
@@ -652,9 +652,9 @@ static void bmesh_find_doubles_common(BMesh *bm,
 
   int *duplicates = MEM_mallocN(sizeof(int) * verts_len, __func__);
   {
-    KDTree_3d *tree = BLI_kdtree_3d_new(verts_len);
+    float(*vert_cos)[3] = MEM_malloc_arrayN(verts_len, sizeof(*vert_cos), __func__);
     for (int i = 0; i < verts_len; i++) {
-      BLI_kdtree_3d_insert(tree, i, verts[i]->co);
+      copy_v3_v3(vert_cos[i], verts[i]->co);
       if (has_keep_vert && BMO_vert_flag_test(bm, verts[i], VERT_KEEP)) {
         duplicates[i] = i;
       }
@@ -663,9 +663,10 @@ static void bmesh_find_doubles_common(BMesh *bm,
       }
     }
 
-    BLI_kdtree_3d_balance(tree);
-    found_duplicates = BLI_kdtree_3d_calc_duplicates_fast(tree, dist, false, duplicates) != 0;
-    BLI_kdtree_3d_free(tree);
+    const int duplicates_found = BLI_merge_by_distance_calc_duplicates(
+        vert_cos, verts_len, dist, duplicates);
+    found_duplicates = duplicates_found != 0;
+    MEM_freeN(vert_cos);
   }
 
   if (found_duplicates) {
@@ -34,6 +34,7 @@
 #include "BLI_hash.h"
 #include "BLI_utildefines.h"
 
+#include "BKE_bvhutils.h"
 #include "BKE_global.h"
 #include "BKE_idtype.h"
 #include "BKE_scene.h"
@@ -310,6 +311,8 @@ void DEG_graph_free(Depsgraph *graph)
   deg::Depsgraph *deg_depsgraph = reinterpret_cast<deg::Depsgraph *>(graph);
   deg::unregister_graph(deg_depsgraph);
   delete deg_depsgraph;
+  /* Shared trees released by the evaluated meshes are not needed anymore. */
+  bvhcache_shared_free_unused();
 }
 
 bool DEG_is_evaluating(const struct Depsgraph *depsgraph)
@@ -36,6 +36,7 @@
 #include "DNA_scene_types.h"
 #include "DNA_simulation_types.h"
 
+#include "BKE_bvhutils.h"
 #include "BKE_main.h"
 #include "BKE_scene.h"
 
@@ -267,6 +268,8 @@ void DEG_graph_relations_update(Depsgraph *graph)
     return;
   }
   DEG_graph_build_from_view_layer(graph);
+  /* Trees of meshes which are not evaluated anymore won't be used again soon. */
+  bvhcache_shared_free_unused();
 }
 
 /* Tag all relations for update. */
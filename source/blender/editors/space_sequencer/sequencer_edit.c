@@ -27,12 +27,17 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
 #include "BLI_math.h"
+#include "BLI_threads.h"
 #include "BLI_timecode.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #include "BLT_translation.h"
 
 #include "DNA_scene_types.h"
@@ -144,16 +149,100 @@ static void proxy_freejob(void *pjv)
   MEM_freeN(pj);
 }
 
+/* Movie strips which are rebuilt concurrently, shared by the threads of proxy_movies_rebuild. */
+typedef struct ProxyMovieQueue {
+  struct SeqIndexBuildContext **contexts;
+  float *progress;
+  int num_contexts;
+  int next_context;
+  int num_running_threads;
+  short *stop;
+  short *do_update;
+} ProxyMovieQueue;
+
+static void *proxy_movie_thread(void *queue_v)
+{
+  ProxyMovieQueue *queue = queue_v;
+
+  while (!*queue->stop) {
+    const int index = atomic_fetch_and_add_int32(&queue->next_context, 1);
+    if (index >= queue->num_contexts) {
+      break;
+    }
+    BKE_sequencer_proxy_rebuild(
+        queue->contexts[index], queue->stop, queue->do_update, &queue->progress[index]);
+  }
+
+  atomic_sub_and_fetch_int32(&queue->num_running_threads, 1);
+  return NULL;
+}
+
+/* Rebuild the movie strips of the job, several at once. Every movie already decodes and encodes
+ * on multiple threads, so only a few of them run at the same time. */
+static void proxy_movies_rebuild(ProxyJob *pj, short *stop, short *do_update, float *progress)
+{
+  ProxyMovieQueue queue = {NULL};
+  ListBase threads;
+  int num_threads;
+
+  queue.contexts = MEM_malloc_arrayN(
+      BLI_listbase_count(&pj->queue), sizeof(*queue.contexts), __func__);
+  LISTBASE_FOREACH (LinkData *, link, &pj->queue) {
+    if (BKE_sequencer_proxy_rebuild_is_threadsafe(link->data)) {
+      queue.contexts[queue.num_contexts++] = link->data;
+    }
+  }
+
+  if (queue.num_contexts == 0) {
+    MEM_freeN(queue.contexts);
+    return;
+  }
+
+  queue.progress = MEM_calloc_arrayN(queue.num_contexts, sizeof(*queue.progress), __func__);
+  queue.stop = stop;
+  queue.do_update = do_update;
+
+  num_threads = min_ii(queue.num_contexts, clamp_i(BLI_system_thread_count() / 4, 1, 8));
+  queue.num_running_threads = num_threads;
+
+  BLI_threadpool_init(&threads, proxy_movie_thread, num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    BLI_threadpool_insert(&threads, &queue);
+  }
+
+  /* Report the average progress of all movies while they are being rebuilt. */
+  while (atomic_add_and_fetch_int32(&queue.num_running_threads, 0) > 0) {
+    float progress_sum = 0.0f;
+
+    PIL_sleep_ms(50);
+
+    for (int i = 0; i < queue.num_contexts; i++) {
+      progress_sum += queue.progress[i];
+    }
+    *progress = progress_sum / queue.num_contexts;
+    *do_update = true;
+  }
+
+  BLI_threadpool_end(&threads);
+
+  MEM_freeN(queue.progress);
+  MEM_freeN(queue.contexts);
+}
+
 /* Only this runs inside thread. */
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
   ProxyJob *pj = pjv;
   LinkData *link;
 
+  proxy_movies_rebuild(pj, stop, do_update, progress);
+
   for (link = pj->queue.first; link; link = link->next) {
     struct SeqIndexBuildContext *context = link->data;
 
-    BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+    if (!BKE_sequencer_proxy_rebuild_is_threadsafe(context)) {
+      BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+    }
 
     if (*stop) {
       pj->stop = 1;
@@ -448,7 +448,19 @@ struct ImBuf *IMB_onehalf(struct ImBuf *ibuf1);
  *
  * \attention Defined in scaling.c
  */
+typedef enum eIMBScaleFilter {
+  /** Average of covered pixels when scaling down, nearest pixel when scaling up. */
+  IMB_SCALE_FILTER_BOX = 0,
+  IMB_SCALE_FILTER_BILINEAR = 1,
+  IMB_SCALE_FILTER_MITCHELL = 2,
+  IMB_SCALE_FILTER_LANCZOS = 3,
+} eIMBScaleFilter;
+
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf,
+                           unsigned int newx,
+                           unsigned int newy,
+                           eIMBScaleFilter filter);
 
 /**
  *
@@ -43,6 +43,10 @@ typedef void *(*MovieCacheGetPriorityDataFP)(void *userkey);
 typedef int (*MovieCacheGetItemPriorityFP)(void *last_userkey, void *priority_data);
 typedef void (*MovieCachePriorityDeleterFP)(void *priority_data);
 
+/* Memory pressure handlers of caches which are not managed by the movie cache limiter. */
+typedef size_t (*MovieCacheMemoryUsageFP)(void *userdata);
+typedef size_t (*MovieCacheMemoryFreeFP)(void *userdata, size_t memory_to_free);
+
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
@@ -58,7 +62,15 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
                                           MovieCachePriorityDeleterFP prioritydeleterfp);
 
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+void IMB_moviecache_put_ex(struct MovieCache *cache,
+                           void *userkey,
+                           struct ImBuf *ibuf,
+                           float cost);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+bool IMB_moviecache_put_if_possible_ex(struct MovieCache *cache,
+                                       void *userkey,
+                                       struct ImBuf *ibuf,
+                                       float cost);
 struct ImBuf *IMB_moviecache_get(struct MovieCache *cache, void *userkey);
 void IMB_moviecache_remove(struct MovieCache *cache, void *userkey);
 bool IMB_moviecache_has_frame(struct MovieCache *cache, void *userkey);
@@ -73,6 +85,13 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
 void IMB_moviecache_get_cache_segments(
     struct MovieCache *cache, int proxy, int render_flags, int *r_totseg, int **r_points);
 
+void IMB_moviecache_memory_pressure_handler_add(MovieCacheMemoryUsageFP usagefp,
+                                                MovieCacheMemoryFreeFP freefp,
+                                                void *userdata);
+void IMB_moviecache_memory_pressure_handler_remove(void *userdata);
+size_t IMB_moviecache_memory_pressure_free(size_t memory_to_free);
+void IMB_moviecache_memory_pressure_check(void);
+
 struct MovieCacheIter;
 struct MovieCacheIter *IMB_moviecacheIter_new(struct MovieCache *cache);
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter);
@@ -135,7 +135,12 @@ struct anim {
   struct ImBuf *last_frame;
   int64_t last_pts;
   int64_t next_pts;
+  /* Time stamp of the frame decoded before the one in pFrame, -1 right after seeking. */
+  int64_t prev_pts;
   AVPacket next_packet;
+
+  /* Decoded frames around the play head and read-ahead thread, see anim_movie.c. */
+  struct FFmpegFrameCache *frame_cache;
 #endif
 
   char index_dir[768];
@@ -151,3 +156,9 @@ struct anim {
 
   struct IDProperty *metadata;
 };
+
+/* Stop decoding frames ahead in the background, the read-ahead thread uses the indices and
+ * decoder of the anim. */
+void imb_anim_readahead_end(struct anim *anim);
+/* Memory used by the decoded frames cached for all movies. */
+size_t imb_anim_frame_cache_memory_in_use(void);
@@ -53,10 +53,14 @@
 #  include <io.h>
 #endif
 
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "MEM_CacheLimiterC-Api.h"
 #include "MEM_guardedalloc.h"
 
 #ifdef WITH_AVI
@@ -74,6 +78,8 @@
 #include "IMB_metadata.h"
 
 #ifdef WITH_FFMPEG
+#  include "atomic_ops.h"
+
 #  include "BKE_global.h" /* ENDIAN_ORDER */
 
 #  include <libavcodec/avcodec.h>
@@ -505,6 +511,194 @@ BLI_INLINE bool need_aligned_ffmpeg_buffer(struct anim *anim)
   return (anim->x & 31) != 0;
 }
 
+/* Decoded frames around the play head are kept for every movie, so scrubbing and playing
+ * backwards don't decode the same group of pictures over and over again. The frames are kept as
+ * decoded by FFmpeg and only converted to RGBA when used.
+ *
+ * All movies, including proxies, share one memory budget. Once it is used up a movie replaces
+ * its own frames furthest away from its play head, only the first few frames of every movie are
+ * always kept. */
+
+/* Memory used for the decoded frames of all movies together, at most a quarter of the memory
+ * cache limit. */
+#  define FFMPEG_FRAME_CACHE_MEMORY ((size_t)256 * 1024 * 1024)
+/* Limits on the number of frames of a movie. */
+#  define FFMPEG_FRAME_CACHE_MIN_FRAMES 4
+#  define FFMPEG_FRAME_CACHE_MAX_FRAMES 120
+
+/* Number of frames the read-ahead thread decodes ahead of the play head. */
+#  define FFMPEG_READAHEAD_FRAMES 8
+
+typedef struct FFmpegCachedFrame {
+  AVFrame *frame;
+  int64_t pts;
+  /* Time stamp of the frame decoded before this one, -1 when unknown. Seeking to any time stamp
+   * in (prev_pts, pts] ends up at this frame. */
+  int64_t prev_pts;
+} FFmpegCachedFrame;
+
+typedef struct FFmpegFrameCache {
+  /* Protects the cache as well as the decoder state of the anim. */
+  ThreadMutex mutex;
+  ThreadCondition cond;
+  /* Threads waiting for the mutex, the read-ahead thread steps aside for them. */
+  int num_waiting;
+
+  FFmpegCachedFrame *frames;
+  int num_frames, max_frames;
+  /* Memory used by a decoded frame. */
+  size_t frame_size;
+  /* Frame duration in stream time base. */
+  double frame_duration;
+  /* Time stamp of the last requested frame, frames furthest away from it are freed first. */
+  int64_t playhead_pts;
+
+  /* Position and direction of the last requested frames, frames are decoded ahead in the
+   * background while the play head keeps moving in the same direction. */
+  int last_position;
+  int readahead_direction;
+  /* Timecode index and duration of the requested frames. They are resolved by the requesting
+   * thread, opening an index lazily writes to the anim, which is not protected by the mutex.
+   * The index stays valid while reading ahead, #IMB_free_indices ends the read-ahead first. */
+  struct anim_index *readahead_tc_index;
+  int readahead_duration;
+  ListBase readahead_threads;
+  bool readahead_running;
+  bool readahead_stop;
+} FFmpegFrameCache;
+
+/* Memory used by the frame caches of all movies. */
+static size_t ffmpeg_frame_cache_memory_in_use = 0;
+
+static size_t ffmpeg_frame_cache_memory_budget(void)
+{
+  return min_zz(FFMPEG_FRAME_CACHE_MEMORY, MEM_CacheLimiter_get_maximum() / 4);
+}
+
+static void ffmpeg_frame_cache_init(struct anim *anim)
+{
+  FFmpegFrameCache *cache = MEM_callocN(sizeof(FFmpegFrameCache), "ffmpeg frame cache");
+  AVStream *v_st = anim->pFormatCtx->streams[anim->videoStream];
+  const double frame_rate = av_q2d(av_guess_frame_rate(anim->pFormatCtx, v_st, NULL));
+  const size_t frame_size = max_zz(
+      avpicture_get_size(anim->pCodecCtx->pix_fmt, anim->x, anim->y), 1);
+
+  BLI_mutex_init(&cache->mutex);
+  BLI_condition_init(&cache->cond);
+
+  cache->frame_size = frame_size;
+  cache->max_frames = (int)min_zz(ffmpeg_frame_cache_memory_budget() / frame_size,
+                                  FFMPEG_FRAME_CACHE_MAX_FRAMES);
+  cache->max_frames = max_ii(cache->max_frames, FFMPEG_FRAME_CACHE_MIN_FRAMES);
+  cache->frames = MEM_malloc_arrayN(cache->max_frames, sizeof(FFmpegCachedFrame), __func__);
+  cache->frame_duration = (frame_rate > 0.0) ? 1.0 / (frame_rate * av_q2d(v_st->time_base)) :
+                                               0.0;
+  cache->last_position = -1;
+
+  anim->frame_cache = cache;
+}
+
+static void ffmpeg_frame_cache_free(struct anim *anim)
+{
+  FFmpegFrameCache *cache = anim->frame_cache;
+
+  if (cache == NULL) {
+    return;
+  }
+
+  imb_anim_readahead_end(anim);
+
+  for (int i = 0; i < cache->num_frames; i++) {
+    av_frame_free(&cache->frames[i].frame);
+  }
+  atomic_sub_and_fetch_z(&ffmpeg_frame_cache_memory_in_use, cache->frame_size * cache->num_frames);
+  MEM_freeN(cache->frames);
+
+  BLI_condition_end(&cache->cond);
+  BLI_mutex_end(&cache->mutex);
+  MEM_freeN(cache);
+
+  anim->frame_cache = NULL;
+}
+
+static void ffmpeg_frame_cache_lock(FFmpegFrameCache *cache)
+{
+  atomic_add_and_fetch_int32(&cache->num_waiting, 1);
+  BLI_mutex_lock(&cache->mutex);
+  atomic_sub_and_fetch_int32(&cache->num_waiting, 1);
+}
+
+static void ffmpeg_frame_cache_unlock(FFmpegFrameCache *cache)
+{
+  /* Wake up the read-ahead thread. */
+  BLI_condition_notify_all(&cache->cond);
+  BLI_mutex_unlock(&cache->mutex);
+}
+
+/* Cached frame a seek to pts_to_search would decode. */
+static FFmpegCachedFrame *ffmpeg_frame_cache_find(FFmpegFrameCache *cache, int64_t pts_to_search)
+{
+  for (int i = 0; i < cache->num_frames; i++) {
+    FFmpegCachedFrame *cached_frame = &cache->frames[i];
+    if (cached_frame->pts == pts_to_search ||
+        (cached_frame->prev_pts != -1 && cached_frame->prev_pts < pts_to_search &&
+         pts_to_search < cached_frame->pts)) {
+      return cached_frame;
+    }
+  }
+  return NULL;
+}
+
+static void ffmpeg_frame_cache_add(FFmpegFrameCache *cache,
+                                   AVFrame *frame,
+                                   int64_t pts,
+                                   int64_t prev_pts)
+{
+  FFmpegCachedFrame *cached_frame = NULL;
+
+  for (int i = 0; i < cache->num_frames; i++) {
+    if (cache->frames[i].pts == pts) {
+      return;
+    }
+  }
+
+  if (cache->num_frames < cache->max_frames &&
+      (cache->num_frames < FFMPEG_FRAME_CACHE_MIN_FRAMES ||
+       atomic_add_and_fetch_z(&ffmpeg_frame_cache_memory_in_use, 0) + cache->frame_size <=
+           ffmpeg_frame_cache_memory_budget())) {
+    cached_frame = &cache->frames[cache->num_frames++];
+    atomic_add_and_fetch_z(&ffmpeg_frame_cache_memory_in_use, cache->frame_size);
+  }
+  else {
+    /* Replace the frame furthest away from the play head, unless the new one is even further. */
+    int64_t max_distance = (pts > cache->playhead_pts) ? pts - cache->playhead_pts :
+                                                         cache->playhead_pts - pts;
+    for (int i = 0; i < cache->num_frames; i++) {
+      const int64_t frame_pts = cache->frames[i].pts;
+      const int64_t distance = (frame_pts > cache->playhead_pts) ?
+                                   frame_pts - cache->playhead_pts :
+                                   cache->playhead_pts - frame_pts;
+      if (distance > max_distance) {
+        max_distance = distance;
+        cached_frame = &cache->frames[i];
+      }
+    }
+    if (cached_frame == NULL) {
+      return;
+    }
+    av_frame_free(&cached_frame->frame);
+  }
+
+  cached_frame->frame = av_frame_clone(frame);
+  cached_frame->pts = pts;
+  cached_frame->prev_pts = prev_pts;
+
+  if (cached_frame->frame == NULL) {
+    *cached_frame = cache->frames[--cache->num_frames];
+    atomic_sub_and_fetch_z(&ffmpeg_frame_cache_memory_in_use, cache->frame_size);
+  }
+}
+
 static int startffmpeg(struct anim *anim)
 {
   int i, video_stream_index;
@@ -639,6 +833,7 @@ static int startffmpeg(struct anim *anim)
   anim->last_frame = 0;
   anim->last_pts = -1;
   anim->next_pts = -1;
+  anim->prev_pts = -1;
   anim->next_packet.stream_index = -1;
 
   anim->pFrame = av_frame_alloc();
@@ -743,25 +938,52 @@ static int startffmpeg(struct anim *anim)
   }
 #  endif
 
+  ffmpeg_frame_cache_init(anim);
+
   return 0;
 }
 
-/* postprocess the image in anim->pFrame and do color conversion
+static ImBuf *ffmpeg_frame_ibuf_alloc(struct anim *anim)
+{
+  ImBuf *ibuf;
+
+  /* Certain versions of FFmpeg have a bug in libswscale which ends up in crash
+   * when destination buffer is not properly aligned. For example, this happens
+   * in FFmpeg 4.3.1. It got fixed later on, but for compatibility reasons is
+   * still best to avoid crash.
+   *
+   * This is achieved by using own allocation call rather than relying on
+   * IMB_allocImBuf() to do so since the IMB_allocImBuf() is not guaranteed
+   * to perform aligned allocation.
+   *
+   * In theory this could give better performance, since SIMD operations on
+   * aligned data are usually faster.
+   *
+   * Note that even though sometimes vertical flip is required it does not
+   * affect on alignment of data passed to sws_scale because if the X dimension
+   * is not 32 byte aligned special intermediate buffer is allocated.
+   *
+   * The issue was reported to FFmpeg under ticket #8747 in the FFmpeg tracker
+   * and is fixed in the newer versions than 4.3.1. */
+  ibuf = IMB_allocImBuf(anim->x, anim->y, 32, 0);
+  ibuf->rect = MEM_mallocN_aligned((size_t)4 * anim->x * anim->y, 32, "ffmpeg ibuf");
+  ibuf->mall |= IB_rect;
+
+  ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+
+  return ibuf;
+}
+
+/* postprocess the decoded image in input and do color conversion
  * and deinterlacing stuff.
  *
- * Output is anim->last_frame
+ * Output is ibuf
  */
 
-static void ffmpeg_postprocess(struct anim *anim)
+static void ffmpeg_postprocess(struct anim *anim, AVFrame *input, ImBuf *ibuf)
 {
-  AVFrame *input = anim->pFrame;
-  ImBuf *ibuf = anim->last_frame;
   int filter_y = 0;
 
-  if (!anim->pFrameComplete) {
-    return;
-  }
-
   /* This means the data wasn't read properly,
    * this check stops crashing */
   if (input->data[0] == 0 && input->data[1] == 0 && input->data[2] == 0 && input->data[3] == 0) {
@@ -781,7 +1003,7 @@ static void ffmpeg_postprocess(struct anim *anim)
 
   if (anim->ib_flags & IB_animdeinterlace) {
     if (avpicture_deinterlace((AVPicture *)anim->pFrameDeinterlaced,
-                              (const AVPicture *)anim->pFrame,
+                              (const AVPicture *)input,
                               anim->pCodecCtx->pix_fmt,
                               anim->pCodecCtx->width,
                               anim->pCodecCtx->height) < 0) {
@@ -907,6 +1129,7 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
           anim->pCodecCtx, anim->pFrame, &anim->pFrameComplete, &anim->next_packet);
 
       if (anim->pFrameComplete) {
+        anim->prev_pts = anim->next_pts;
         anim->next_pts = av_get_pts_from_frame(anim->pFormatCtx, anim->pFrame);
 
         av_log(anim->pFormatCtx,
@@ -942,6 +1165,7 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
         anim->pCodecCtx, anim->pFrame, &anim->pFrameComplete, &anim->next_packet);
 
     if (anim->pFrameComplete) {
+      anim->prev_pts = anim->next_pts;
       anim->next_pts = av_get_pts_from_frame(anim->pFormatCtx, anim->pFrame);
 
       av_log(anim->pFormatCtx,
@@ -968,6 +1192,21 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
   return (rval >= 0);
 }
 
+/* Keep the decoded frames close before pts_to_search while scanning towards it. */
+static void ffmpeg_frame_cache_add_scanned(struct anim *anim, int64_t pts_to_search)
+{
+  FFmpegFrameCache *cache = anim->frame_cache;
+
+  if (!anim->pFrameComplete || anim->next_pts == -1) {
+    return;
+  }
+  if (pts_to_search - anim->next_pts > cache->max_frames * cache->frame_duration) {
+    return;
+  }
+
+  ffmpeg_frame_cache_add(cache, anim->pFrame, anim->next_pts, anim->prev_pts);
+}
+
 static void ffmpeg_decode_video_frame_scan(struct anim *anim, int64_t pts_to_search)
 {
   /* there seem to exist *very* silly GOP lengths out in the wild... */
@@ -985,6 +1224,7 @@ static void ffmpeg_decode_video_frame_scan(struct anim *anim, int64_t pts_to_sea
            "  WHILE: pts=%lld in search of %lld\n",
            (long long int)anim->next_pts,
            (long long int)pts_to_search);
+    ffmpeg_frame_cache_add_scanned(anim, pts_to_search);
     if (!ffmpeg_decode_video_frame(anim)) {
       break;
     }
@@ -1048,27 +1288,58 @@ static int ffmpeg_seek_by_byte(AVFormatContext *pFormatCtx)
   return false;
 }
 
-static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Type tc)
+static int64_t ffmpeg_get_pts_to_search(struct anim *anim,
+                                        struct anim_index *tc_index,
+                                        int position)
+{
+  int64_t pts_to_search;
+
+  if (tc_index) {
+    int new_frame_index = IMB_indexer_get_frame_index(tc_index, position);
+    pts_to_search = IMB_indexer_get_pts(tc_index, new_frame_index);
+  }
+  else {
+    AVStream *v_st = anim->pFormatCtx->streams[anim->videoStream];
+    double frame_rate = av_q2d(av_guess_frame_rate(anim->pFormatCtx, v_st, NULL));
+    double pts_time_base = av_q2d(v_st->time_base);
+    long long st_time = anim->pFormatCtx->start_time;
+
+    pts_to_search = (long long)floor(((double)position) / pts_time_base / frame_rate + 0.5);
+
+    if (st_time != AV_NOPTS_VALUE) {
+      pts_to_search += st_time / pts_time_base / AV_TIME_BASE;
+    }
+  }
+
+  return pts_to_search;
+}
+
+/* Whether the frame at pts_to_search is available without decoding. */
+static bool ffmpeg_frame_is_decoded(struct anim *anim, int64_t pts_to_search)
+{
+  return (anim->last_frame && anim->last_pts <= pts_to_search &&
+          anim->next_pts > pts_to_search) ||
+         ffmpeg_frame_cache_find(anim->frame_cache, pts_to_search);
+}
+
+/* Fetch a frame, the frame cache mutex must be locked. When reading ahead frames are only
+ * decoded into the cache and NULL is returned. */
+static ImBuf *ffmpeg_fetchibuf_locked(struct anim *anim,
+                                      int position,
+                                      struct anim_index *tc_index,
+                                      bool readahead)
 {
   int64_t pts_to_search = 0;
   double frame_rate;
   double pts_time_base;
   long long st_time;
-  struct anim_index *tc_index = 0;
   AVStream *v_st;
+  FFmpegCachedFrame *cached_frame;
   int new_frame_index = 0; /* To quiet gcc barking... */
   int old_frame_index = 0; /* To quiet gcc barking... */
 
-  if (anim == NULL) {
-    return 0;
-  }
-
   av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: pos=%d\n", position);
 
-  if (tc != IMB_TC_NONE) {
-    tc_index = IMB_anim_open_index(anim, tc);
-  }
-
   v_st = anim->pFormatCtx->streams[anim->videoStream];
 
   frame_rate = av_q2d(av_guess_frame_rate(anim->pFormatCtx, v_st, NULL));
@@ -1079,15 +1350,8 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   if (tc_index) {
     new_frame_index = IMB_indexer_get_frame_index(tc_index, position);
     old_frame_index = IMB_indexer_get_frame_index(tc_index, anim->curposition);
-    pts_to_search = IMB_indexer_get_pts(tc_index, new_frame_index);
-  }
-  else {
-    pts_to_search = (long long)floor(((double)position) / pts_time_base / frame_rate + 0.5);
-
-    if (st_time != AV_NOPTS_VALUE) {
-      pts_to_search += st_time / pts_time_base / AV_TIME_BASE;
-    }
   }
+  pts_to_search = ffmpeg_get_pts_to_search(anim, tc_index, position);
 
   av_log(anim->pFormatCtx,
          AV_LOG_DEBUG,
@@ -1098,6 +1362,15 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
          frame_rate,
          st_time);
 
+  if (readahead) {
+    if (ffmpeg_frame_is_decoded(anim, pts_to_search)) {
+      return NULL;
+    }
+  }
+  else {
+    anim->frame_cache->playhead_pts = pts_to_search;
+  }
+
   if (anim->last_frame && anim->last_pts <= pts_to_search && anim->next_pts > pts_to_search) {
     av_log(anim->pFormatCtx,
            AV_LOG_DEBUG,
@@ -1109,6 +1382,20 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     return anim->last_frame;
   }
 
+  /* The decoder state is left alone for cached frames, curposition keeps referring to the last
+   * decoded frame. */
+  cached_frame = ffmpeg_frame_cache_find(anim->frame_cache, pts_to_search);
+  if (cached_frame) {
+    ImBuf *ibuf = ffmpeg_frame_ibuf_alloc(anim);
+
+    av_log(anim->pFormatCtx,
+           AV_LOG_DEBUG,
+           "FETCH: cached frame: %lld\n",
+           (long long int)cached_frame->pts);
+    ffmpeg_postprocess(anim, cached_frame->frame, ibuf);
+    return ibuf;
+  }
+
   if (position > anim->curposition + 1 && anim->preseek && !tc_index &&
       position - (anim->curposition + 1) < anim->preseek) {
     av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: within preseek interval (no index)\n");
@@ -1205,32 +1492,20 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   }
 
   IMB_freeImBuf(anim->last_frame);
+  anim->last_frame = NULL;
 
-  /* Certain versions of FFmpeg have a bug in libswscale which ends up in crash
-   * when destination buffer is not properly aligned. For example, this happens
-   * in FFmpeg 4.3.1. It got fixed later on, but for compatibility reasons is
-   * still best to avoid crash.
-   *
-   * This is achieved by using own allocation call rather than relying on
-   * IMB_allocImBuf() to do so since the IMB_allocImBuf() is not guaranteed
-   * to perform aligned allocation.
-   *
-   * In theory this could give better performance, since SIMD operations on
-   * aligned data are usually faster.
-   *
-   * Note that even though sometimes vertical flip is required it does not
-   * affect on alignment of data passed to sws_scale because if the X dimension
-   * is not 32 byte aligned special intermediate buffer is allocated.
-   *
-   * The issue was reported to FFmpeg under ticket #8747 in the FFmpeg tracker
-   * and is fixed in the newer versions than 4.3.1. */
-  anim->last_frame = IMB_allocImBuf(anim->x, anim->y, 32, 0);
-  anim->last_frame->rect = MEM_mallocN_aligned((size_t)4 * anim->x * anim->y, 32, "ffmpeg ibuf");
-  anim->last_frame->mall |= IB_rect;
+  if (anim->pFrameComplete) {
+    ffmpeg_frame_cache_add(anim->frame_cache, anim->pFrame, anim->next_pts, anim->prev_pts);
+  }
 
-  anim->last_frame->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+  /* Frames read ahead are only converted once they are requested. */
+  if (!readahead) {
+    anim->last_frame = ffmpeg_frame_ibuf_alloc(anim);
 
-  ffmpeg_postprocess(anim);
+    if (anim->pFrameComplete) {
+      ffmpeg_postprocess(anim, anim->pFrame, anim->last_frame);
+    }
+  }
 
   anim->last_pts = anim->next_pts;
 
@@ -1238,11 +1513,131 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
 
   anim->curposition = position;
 
+  if (readahead) {
+    return NULL;
+  }
+
   IMB_refImBuf(anim->last_frame);
 
   return anim->last_frame;
 }
 
+/* Next frame in the play direction which is not decoded yet, -1 when all frames up to
+ * FFMPEG_READAHEAD_FRAMES ahead are available. */
+static int ffmpeg_readahead_next_position(struct anim *anim)
+{
+  FFmpegFrameCache *cache = anim->frame_cache;
+
+  for (int i = 1; i <= FFMPEG_READAHEAD_FRAMES; i++) {
+    const int position = cache->last_position + cache->readahead_direction * i;
+
+    if (position < 0 || position >= cache->readahead_duration) {
+      break;
+    }
+    if (!ffmpeg_frame_is_decoded(
+            anim, ffmpeg_get_pts_to_search(anim, cache->readahead_tc_index, position))) {
+      return position;
+    }
+  }
+
+  return -1;
+}
+
+static void *ffmpeg_readahead_thread(void *anim_v)
+{
+  struct anim *anim = anim_v;
+  FFmpegFrameCache *cache = anim->frame_cache;
+  int failed_position = -1;
+
+  BLI_mutex_lock(&cache->mutex);
+
+  while (!cache->readahead_stop) {
+    int position;
+
+    /* Let requests from other threads go first. */
+    if (atomic_add_and_fetch_int32(&cache->num_waiting, 0) > 0) {
+      BLI_condition_wait(&cache->cond, &cache->mutex);
+      continue;
+    }
+
+    position = ffmpeg_readahead_next_position(anim);
+
+    /* Stop at the end of the movie or at frames which can't be decoded or cached. */
+    if (position == -1 || position == failed_position) {
+      break;
+    }
+
+    ffmpeg_fetchibuf_locked(anim, position, cache->readahead_tc_index, true);
+    failed_position = position;
+  }
+
+  cache->readahead_running = false;
+  BLI_mutex_unlock(&cache->mutex);
+
+  return NULL;
+}
+
+/* Start reading ahead when the play head moves in one direction, the frame cache mutex must be
+ * locked. */
+static void ffmpeg_readahead_update(struct anim *anim,
+                                    int position,
+                                    struct anim_index *tc_index,
+                                    int duration)
+{
+  FFmpegFrameCache *cache = anim->frame_cache;
+  const int offset = position - cache->last_position;
+
+  if (offset == 0) {
+    return;
+  }
+
+  cache->readahead_direction = (offset > 0) ? 1 : -1;
+  cache->readahead_tc_index = tc_index;
+  cache->readahead_duration = duration;
+
+  /* Random access, don't read ahead. */
+  if (cache->last_position == -1 || abs(offset) > FFMPEG_READAHEAD_FRAMES) {
+    cache->last_position = position;
+    return;
+  }
+  cache->last_position = position;
+
+  if (cache->readahead_running) {
+    return;
+  }
+
+  /* The previous read-ahead thread already finished, joining it doesn't block. */
+  BLI_threadpool_end(&cache->readahead_threads);
+
+  BLI_threadpool_init(&cache->readahead_threads, ffmpeg_readahead_thread, 1);
+  BLI_threadpool_insert(&cache->readahead_threads, anim);
+  cache->readahead_running = true;
+}
+
+static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Type tc)
+{
+  FFmpegFrameCache *cache;
+  struct anim_index *tc_index;
+  ImBuf *ibuf;
+
+  if (anim == NULL) {
+    return 0;
+  }
+
+  cache = anim->frame_cache;
+
+  ffmpeg_frame_cache_lock(cache);
+  /* The index is opened here and not by the read-ahead thread, see #FFmpegFrameCache. */
+  tc_index = (tc != IMB_TC_NONE) ? IMB_anim_open_index(anim, tc) : NULL;
+  ibuf = ffmpeg_fetchibuf_locked(anim, position, tc_index, false);
+  if (!cache->readahead_stop) {
+    ffmpeg_readahead_update(anim, position, tc_index, IMB_anim_get_duration(anim, tc));
+  }
+  ffmpeg_frame_cache_unlock(cache);
+
+  return ibuf;
+}
+
 static void free_anim_ffmpeg(struct anim *anim)
 {
   if (anim == NULL) {
@@ -1250,6 +1645,8 @@ static void free_anim_ffmpeg(struct anim *anim)
   }
 
   if (anim->pCodecCtx) {
+    ffmpeg_frame_cache_free(anim);
+
     avcodec_close(anim->pCodecCtx);
     avformat_close_input(&anim->pFormatCtx);
 
@@ -1282,6 +1679,40 @@ static void free_anim_ffmpeg(struct anim *anim)
 
 #endif
 
+void imb_anim_readahead_end(struct anim *anim)
+{
+#ifdef WITH_FFMPEG
+  FFmpegFrameCache *cache = anim->frame_cache;
+
+  if (cache == NULL) {
+    return;
+  }
+
+  ffmpeg_frame_cache_lock(cache);
+  cache->readahead_stop = true;
+  ffmpeg_frame_cache_unlock(cache);
+
+  BLI_threadpool_end(&cache->readahead_threads);
+
+  ffmpeg_frame_cache_lock(cache);
+  cache->readahead_stop = false;
+  cache->readahead_running = false;
+  cache->last_position = -1;
+  ffmpeg_frame_cache_unlock(cache);
+#else
+  UNUSED_VARS(anim);
+#endif
+}
+
+size_t imb_anim_frame_cache_memory_in_use(void)
+{
+#ifdef WITH_FFMPEG
+  return atomic_add_and_fetch_z(&ffmpeg_frame_cache_memory_in_use, 0);
+#else
+  return 0;
+#endif
+}
+
 /* Try next picture to read */
 /* No picture, try to open next animation */
 /* Succeed, remove first image from animation */
@@ -1429,10 +1860,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
 #endif
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
+      /* curposition is set internally, it refers to the decoder state. */
       ibuf = ffmpeg_fetchibuf(anim, position, tc);
-      if (ibuf) {
-        anim->curposition = position;
-      }
       filter_y = 0; /* done internally */
       break;
 #endif
@@ -1442,7 +1871,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     if (filter_y) {
       IMB_filtery(ibuf);
     }
-    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
   }
   return ibuf;
 }
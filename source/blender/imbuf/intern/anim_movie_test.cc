@@ -0,0 +1,244 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MEM_CacheLimiterC-Api.h"
+
+#include "BLI_fileops.h"
+#include "BLI_utildefines.h"
+
+extern "C" {
+#include "IMB_anim.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace blender::imbuf::tests {
+
+#define MOVIE_WIDTH 64
+#define MOVIE_HEIGHT 48
+#define MOVIE_FRAMES 30
+#define MOVIE_FPS 25
+/* Key frame interval, so seeking backwards has to decode from an earlier key frame. */
+#define MOVIE_GOP 10
+
+/* Size of a decoded YUV 4:2:0 frame, as used by the frame cache. */
+#define MOVIE_FRAME_SIZE (MOVIE_WIDTH * MOVIE_HEIGHT * 3 / 2)
+
+/* Write a movie where every frame has different pixels. */
+static bool write_test_movie(const char *filepath)
+{
+  AVFormatContext *format_ctx = nullptr;
+  AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  bool ok = false;
+
+  if (codec == nullptr ||
+      avformat_alloc_output_context2(&format_ctx, nullptr, nullptr, filepath) < 0) {
+    return false;
+  }
+
+  AVStream *stream = avformat_new_stream(format_ctx, nullptr);
+  AVCodecContext *codec_ctx = avcodec_alloc_context3(codec);
+  AVFrame *frame = av_frame_alloc();
+  AVPacket *packet = av_packet_alloc();
+
+  codec_ctx->width = MOVIE_WIDTH;
+  codec_ctx->height = MOVIE_HEIGHT;
+  codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+  codec_ctx->time_base = AVRational{1, MOVIE_FPS};
+  codec_ctx->framerate = AVRational{MOVIE_FPS, 1};
+  codec_ctx->gop_size = MOVIE_GOP;
+  codec_ctx->max_b_frames = 0;
+  if (format_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+    codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+
+  frame->format = codec_ctx->pix_fmt;
+  frame->width = MOVIE_WIDTH;
+  frame->height = MOVIE_HEIGHT;
+
+  if (avcodec_open2(codec_ctx, codec, nullptr) < 0 ||
+      avcodec_parameters_from_context(stream->codecpar, codec_ctx) < 0 ||
+      av_frame_get_buffer(frame, 32) < 0) {
+    goto finally;
+  }
+  stream->time_base = codec_ctx->time_base;
+
+  if (avio_open(&format_ctx->pb, filepath, AVIO_FLAG_WRITE) < 0) {
+    goto finally;
+  }
+  if (avformat_write_header(format_ctx, nullptr) < 0) {
+    goto finally;
+  }
+
+  /* One more iteration without a frame flushes the encoder. */
+  for (int i = 0; i <= MOVIE_FRAMES; i++) {
+    if (i < MOVIE_FRAMES) {
+      av_frame_make_writable(frame);
+      for (int y = 0; y < MOVIE_HEIGHT; y++) {
+        for (int x = 0; x < MOVIE_WIDTH; x++) {
+          frame->data[0][y * frame->linesize[0] + x] = (uint8_t)(x * 2 + y + i * 7);
+        }
+      }
+      for (int y = 0; y < MOVIE_HEIGHT / 2; y++) {
+        memset(frame->data[1] + y * frame->linesize[1], 128 + i, MOVIE_WIDTH / 2);
+        memset(frame->data[2] + y * frame->linesize[2], 128 - i, MOVIE_WIDTH / 2);
+      }
+      frame->pts = i;
+    }
+
+    if (avcodec_send_frame(codec_ctx, (i < MOVIE_FRAMES) ? frame : nullptr) < 0) {
+      goto finally;
+    }
+    while (avcodec_receive_packet(codec_ctx, packet) == 0) {
+      av_packet_rescale_ts(packet, codec_ctx->time_base, stream->time_base);
+      packet->stream_index = stream->index;
+      if (av_interleaved_write_frame(format_ctx, packet) < 0) {
+        goto finally;
+      }
+    }
+  }
+
+  ok = (av_write_trailer(format_ctx) == 0);
+
+finally:
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&codec_ctx);
+  if (format_ctx->pb) {
+    avio_closep(&format_ctx->pb);
+  }
+  avformat_free_context(format_ctx);
+  return ok;
+}
+
+class imbuf_anim_movie : public testing::Test {
+ protected:
+  std::string filepath_;
+  size_t cache_limit_;
+
+  static void SetUpTestCase()
+  {
+    IMB_init();
+    IMB_ffmpeg_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+  }
+
+  void SetUp() override
+  {
+    filepath_ = testing::TempDir() + "imbuf_anim_movie_test.mp4";
+    ASSERT_TRUE(write_test_movie(filepath_.c_str()));
+    cache_limit_ = MEM_CacheLimiter_get_maximum();
+  }
+
+  void TearDown() override
+  {
+    MEM_CacheLimiter_set_maximum(cache_limit_);
+    BLI_delete(filepath_.c_str(), false, false);
+  }
+
+  struct anim *open_anim()
+  {
+    char colorspace[IM_MAX_SPACE] = "";
+    return IMB_open_anim(filepath_.c_str(), IB_rect, 0, colorspace);
+  }
+};
+
+using Frame = std::vector<unsigned char>;
+
+static Frame anim_frame(struct anim *anim, int position)
+{
+  ImBuf *ibuf = IMB_anim_absolute(anim, position, IMB_TC_NONE, IMB_PROXY_NONE);
+  Frame frame;
+
+  if (ibuf && ibuf->rect) {
+    const unsigned char *rect = (const unsigned char *)ibuf->rect;
+    frame.assign(rect, rect + (size_t)ibuf->x * ibuf->y * 4);
+  }
+  IMB_freeImBuf(ibuf);
+  return frame;
+}
+
+/* Jumping around within the cached frames returns the same pixels as decoding in order. */
+TEST_F(imbuf_anim_movie, SeekBackAndForth)
+{
+  std::vector<Frame> expected;
+
+  MEM_CacheLimiter_set_maximum((size_t)1024 * 1024 * 1024);
+
+  struct anim *anim = open_anim();
+  ASSERT_NE(anim, nullptr);
+  for (int i = 0; i < MOVIE_FRAMES; i++) {
+    expected.push_back(anim_frame(anim, i));
+    ASSERT_FALSE(expected.back().empty()) << "frame " << i;
+  }
+  IMB_free_anim(anim);
+  EXPECT_EQ(imb_anim_frame_cache_memory_in_use(), (size_t)0);
+
+  anim = open_anim();
+  ASSERT_NE(anim, nullptr);
+  /* Play backwards over a key frame, then scrub both ways. */
+  const int positions[] = {25, 24, 23, 22, 21, 20, 19, 18, 12, 27, 5, 6, 29, 0, 15, 14, 16, 9};
+  for (const int position : positions) {
+    EXPECT_TRUE(anim_frame(anim, position) == expected[position]) << "frame " << position;
+  }
+  EXPECT_GT(imb_anim_frame_cache_memory_in_use(), (size_t)0);
+
+  IMB_free_anim(anim);
+  EXPECT_EQ(imb_anim_frame_cache_memory_in_use(), (size_t)0);
+}
+
+/* Movies share one budget, frames of the first movie limit what the second movie keeps. */
+TEST_F(imbuf_anim_movie, SharedMemoryBudget)
+{
+  /* The frame caches use a quarter of the cache limit, 8 frames here. */
+  MEM_CacheLimiter_set_maximum((size_t)MOVIE_FRAME_SIZE * 8 * 4);
+
+  struct anim *anim_a = open_anim();
+  struct anim *anim_b = open_anim();
+  ASSERT_NE(anim_a, nullptr);
+  ASSERT_NE(anim_b, nullptr);
+
+  for (int i = MOVIE_FRAMES - 1; i >= 0; i--) {
+    EXPECT_FALSE(anim_frame(anim_a, i).empty());
+  }
+  EXPECT_LE(imb_anim_frame_cache_memory_in_use(), (size_t)MOVIE_FRAME_SIZE * 8);
+
+  /* The second movie only keeps the few frames every movie is allowed. */
+  for (int i = MOVIE_FRAMES - 1; i >= 0; i--) {
+    EXPECT_FALSE(anim_frame(anim_b, i).empty());
+  }
+  EXPECT_LE(imb_anim_frame_cache_memory_in_use(), (size_t)MOVIE_FRAME_SIZE * (8 + 4));
+
+  IMB_free_anim(anim_a);
+  IMB_free_anim(anim_b);
+  EXPECT_EQ(imb_anim_frame_cache_memory_in_use(), (size_t)0);
+}
+
+}  // namespace blender::imbuf::tests
@@ -56,6 +56,8 @@
 #include "BKE_main.h"
 #include "BKE_sequencer.h"
 
+#include "PIL_time.h"
+
 #include "RNA_define.h"
 
 #include <ocio_capi.h>
@@ -101,6 +103,11 @@ typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
   bool is_data_result;
+
+  /* Buffers are transformed without OCIO, see #colormanage_use_srgb_fast_path. */
+  bool use_srgb_fast_path;
+  float exposure_gain;
+  float gamma_exponent;
 } ColormanageProcessor;
 
 static struct global_glsl_state {
@@ -412,6 +419,7 @@ static void colormanage_cache_put(ImBuf *ibuf,
                                   const ColormanageCacheViewSettings *view_settings,
                                   const ColormanageCacheDisplaySettings *display_settings,
                                   unsigned char *display_buffer,
+                                  float cost,
                                   void **cache_handle)
 {
   ColormanageCacheKey key;
@@ -449,7 +457,7 @@ static void colormanage_cache_put(ImBuf *ibuf,
 
   *cache_handle = cache_ibuf;
 
-  IMB_moviecache_put(moviecache, &key, cache_ibuf);
+  IMB_moviecache_put_ex(moviecache, &key, cache_ibuf, cost);
 }
 
 static void colormanage_cache_handle_release(void *cache_handle)
@@ -2681,6 +2689,7 @@ unsigned char *IMB_display_buffer_acquire(ImBuf *ibuf,
   ColormanageCacheDisplaySettings cache_display_settings;
   ColorManagedViewSettings default_view_settings;
   const ColorManagedViewSettings *applied_view_settings;
+  double start_time;
 
   *cache_handle = NULL;
 
@@ -2756,14 +2765,21 @@ unsigned char *IMB_display_buffer_acquire(ImBuf *ibuf,
   buffer_size = DISPLAY_BUFFER_CHANNELS * ((size_t)ibuf->x) * ibuf->y * sizeof(char);
   display_buffer = MEM_callocN(buffer_size, "imbuf display buffer");
 
+  start_time = PIL_check_seconds_timer();
   colormanage_display_buffer_process(
       ibuf, display_buffer, applied_view_settings, display_settings);
 
-  colormanage_cache_put(
-      ibuf, &cache_view_settings, &cache_display_settings, display_buffer, cache_handle);
+  colormanage_cache_put(ibuf,
+                        &cache_view_settings,
+                        &cache_display_settings,
+                        display_buffer,
+                        PIL_check_seconds_timer() - start_time,
+                        cache_handle);
 
   BLI_thread_unlock(LOCK_COLORMANAGE);
 
+  IMB_moviecache_memory_pressure_check();
+
   return display_buffer;
 }
 
@@ -3752,6 +3768,128 @@ void IMB_partial_display_buffer_update_delayed(ImBuf *ibuf, int xmin, int ymin,
 
 /*********************** Pixel processor functions *************************/
 
+/* The most common display transform goes from scene linear to an sRGB display through a view
+ * without looks or curves. It boils down to the sRGB transfer function with an optional exposure
+ * gain before and a gamma exponent after it, which is much cheaper to evaluate directly than
+ * through OCIO.
+ *
+ * The display space decoding to scene linear by exactly the sRGB transfer function (which is what
+ * the built-in check tests) also means both spaces share primaries and white point. */
+static bool colormanage_use_srgb_fast_path(const ColorManagedViewSettings *view_settings,
+                                           ColorSpace *display_space)
+{
+  if (view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) {
+    return false;
+  }
+
+  ColorManagedLook *look_descr = colormanage_look_get_named(view_settings->look);
+  if (look_descr != NULL && look_descr->is_noop == false &&
+      colormanage_compatible_look(look_descr, view_settings->view_transform)) {
+    return false;
+  }
+
+  if (display_space == NULL || display_space->is_data) {
+    return false;
+  }
+
+  return IMB_colormanagement_space_is_srgb(display_space);
+}
+
+/* Matches the OCIO display transform: exposure is applied in scene linear space, gamma to all
+ * channels in display space, predivide restores the original alpha afterwards. */
+BLI_INLINE void colormanage_srgb_fast_path_pixel(const ColormanageProcessor *cm_processor,
+                                                 float *pixel,
+                                                 int channels,
+                                                 bool predivide)
+{
+  const float gain = cm_processor->exposure_gain;
+  const float exponent = cm_processor->gamma_exponent;
+  float alpha = 1.0f, inv_alpha = 1.0f;
+
+  if (predivide && channels == 4 && pixel[3] != 1.0f && pixel[3] != 0.0f) {
+    alpha = pixel[3];
+    inv_alpha = 1.0f / alpha;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    pixel[i] = linearrgb_to_srgb(pixel[i] * inv_alpha * gain);
+  }
+
+  if (exponent != 1.0f) {
+    for (int i = 0; i < channels; i++) {
+      pixel[i] = powf(max_ff(pixel[i], 0.0f), exponent);
+    }
+  }
+
+  mul_v3_fl(pixel, alpha);
+}
+
+#ifdef __SSE2__
+/* Transform RGBA pixels four at a time, channels are transposed into separate registers so every
+ * transfer function evaluation handles four pixels. Gamma is not supported here.
+ * Returns the number of processed pixels, the remainder is left for the scalar code. */
+static size_t colormanage_srgb_fast_path_rgba_sse(const ColormanageProcessor *cm_processor,
+                                                  float *buffer,
+                                                  size_t num_pixels,
+                                                  bool predivide)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 gain = _mm_set1_ps(cm_processor->exposure_gain);
+  size_t i;
+
+  for (i = 0; i + 4 <= num_pixels; i += 4) {
+    float *pixel = buffer + i * 4;
+    __m128 r = _mm_loadu_ps(pixel);
+    __m128 g = _mm_loadu_ps(pixel + 4);
+    __m128 b = _mm_loadu_ps(pixel + 8);
+    __m128 a = _mm_loadu_ps(pixel + 12);
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    __m128 scale = gain;
+    __m128 alpha = one;
+    if (predivide) {
+      const __m128 mask = _mm_and_ps(_mm_cmpneq_ps(a, one), _mm_cmpneq_ps(a, zero));
+      alpha = _bli_math_blend_sse(mask, a, one);
+      scale = _mm_div_ps(gain, alpha);
+    }
+
+    r = _mm_mul_ps(linearrgb_to_srgb_v4_simd(_mm_mul_ps(r, scale)), alpha);
+    g = _mm_mul_ps(linearrgb_to_srgb_v4_simd(_mm_mul_ps(g, scale)), alpha);
+    b = _mm_mul_ps(linearrgb_to_srgb_v4_simd(_mm_mul_ps(b, scale)), alpha);
+
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    _mm_storeu_ps(pixel, r);
+    _mm_storeu_ps(pixel + 4, g);
+    _mm_storeu_ps(pixel + 8, b);
+    _mm_storeu_ps(pixel + 12, a);
+  }
+
+  return i;
+}
+#endif
+
+static void colormanage_srgb_fast_path_apply(const ColormanageProcessor *cm_processor,
+                                             float *buffer,
+                                             int width,
+                                             int height,
+                                             int channels,
+                                             bool predivide)
+{
+  const size_t num_pixels = ((size_t)width) * height;
+  size_t i = 0;
+
+#ifdef __SSE2__
+  if (channels == 4 && cm_processor->gamma_exponent == 1.0f) {
+    i = colormanage_srgb_fast_path_rgba_sse(cm_processor, buffer, num_pixels, predivide);
+  }
+#endif
+
+  for (; i < num_pixels; i++) {
+    colormanage_srgb_fast_path_pixel(cm_processor, buffer + i * channels, channels, predivide);
+  }
+}
+
 ColormanageProcessor *IMB_colormanagement_display_processor_new(
     const ColorManagedViewSettings *view_settings,
     const ColorManagedDisplaySettings *display_settings)
@@ -3789,6 +3927,13 @@ ColormanageProcessor *IMB_colormanagement_display_processor_new(
     BKE_curvemapping_premultiply(cm_processor->curve_mapping, false);
   }
 
+  /* The OCIO processor is still created, it's used for single pixels. */
+  if (colormanage_use_srgb_fast_path(applied_view_settings, display_space)) {
+    cm_processor->use_srgb_fast_path = true;
+    cm_processor->exposure_gain = powf(2.0f, applied_view_settings->exposure);
+    cm_processor->gamma_exponent = 1.0f / MAX2(FLT_EPSILON, applied_view_settings->gamma);
+  }
+
   return cm_processor;
 }
 
@@ -3870,6 +4015,13 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
                                          int channels,
                                          bool predivide)
 {
+  if (cm_processor->use_srgb_fast_path) {
+    if (channels >= 3) {
+      colormanage_srgb_fast_path_apply(cm_processor, buffer, width, height, channels, predivide);
+    }
+    return;
+  }
+
   /* apply curve mapping */
   if (cm_processor->curve_mapping) {
     int x, y;
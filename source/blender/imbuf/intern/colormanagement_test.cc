@@ -0,0 +1,273 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "BLI_math_color.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_color_types.h"
+
+#include "IMB_colormanagement.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+namespace blender::imbuf::tests {
+
+/* -------------------------------------------------------------------- */
+/** \name Settings
+ *
+ * Scene linear to the default sRGB display through the standard view, which is what the direct
+ * sRGB display path handles without OCIO. Single pixels are still transformed by the OCIO
+ * processor, so they are used as the reference.
+ * \{ */
+
+static void display_settings_init(ColorManagedDisplaySettings *display_settings)
+{
+  memset(display_settings, 0, sizeof(*display_settings));
+  STRNCPY(display_settings->display_device, IMB_colormanagement_display_get_default_name());
+}
+
+static void view_settings_init(ColorManagedViewSettings *view_settings,
+                               const ColorManagedDisplaySettings *display_settings,
+                               float exposure,
+                               float gamma)
+{
+  memset(view_settings, 0, sizeof(*view_settings));
+  if (IMB_colormanagement_view_get_named_index("Standard")) {
+    STRNCPY(view_settings->view_transform, "Standard");
+  }
+  else {
+    STRNCPY(view_settings->view_transform,
+            IMB_colormanagement_view_get_default_name(display_settings->display_device));
+  }
+  STRNCPY(view_settings->look, "None");
+  view_settings->exposure = exposure;
+  view_settings->gamma = gamma;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Test Buffers
+ * \{ */
+
+/* Scene linear colors up to a few stops over white, with a mix of opaque, transparent and
+ * partially transparent pixels. */
+static std::vector<float> create_linear_buffer(int width, int height, int channels)
+{
+  std::vector<float> buffer((size_t)width * height * channels);
+  RNG *rng = BLI_rng_new(width * 31 + height);
+
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    float *pixel = &buffer[i * channels];
+    for (int c = 0; c < 3; c++) {
+      pixel[c] = 4.0f * BLI_rng_get_float(rng) * BLI_rng_get_float(rng);
+    }
+    if (channels == 4) {
+      const int kind = i % 4;
+      pixel[3] = (kind == 0) ? 1.0f : (kind == 1) ? 0.0f : BLI_rng_get_float(rng);
+    }
+  }
+
+  BLI_rng_free(rng);
+  return buffer;
+}
+
+static ImBuf *create_test_ibuf(int width, int height, bool is_float)
+{
+  ImBuf *ibuf = IMB_allocImBuf(width, height, 32, is_float ? IB_rectfloat : IB_rect);
+  const std::vector<float> buffer = create_linear_buffer(width, height, 4);
+
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    const float *pixel = &buffer[i * 4];
+    if (is_float) {
+      /* Float buffers are premultiplied. */
+      mul_v3_v3fl(&ibuf->rect_float[i * 4], pixel, pixel[3]);
+      ibuf->rect_float[i * 4 + 3] = pixel[3];
+    }
+    else {
+      /* Byte buffers are straight alpha in the sRGB color space. */
+      float srgb[4];
+      linearrgb_to_srgb_v3_v3(srgb, pixel);
+      srgb[3] = pixel[3];
+      rgba_float_to_uchar((unsigned char *)&ibuf->rect[i], srgb);
+    }
+  }
+
+  return ibuf;
+}
+
+static void expect_bytes_near(const unsigned char *result,
+                              const unsigned char *expected,
+                              int num_pixels,
+                              int channels)
+{
+  for (int i = 0; i < num_pixels * channels; i++) {
+    EXPECT_LE(abs((int)result[i] - (int)expected[i]), 1)
+        << "at pixel " << i / channels << " channel " << i % channels;
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Tests
+ * \{ */
+
+class imbuf_colormanagement : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+  }
+};
+
+/* Compare #IMB_colormanagement_processor_apply on a whole buffer against the OCIO processor
+ * applied one pixel at a time, quantized to bytes. */
+static void test_processor_matches_ocio(
+    float exposure, float gamma, int width, int height, int channels, bool predivide)
+{
+  ColorManagedDisplaySettings display_settings;
+  ColorManagedViewSettings view_settings;
+  display_settings_init(&display_settings);
+  view_settings_init(&view_settings, &display_settings, exposure, gamma);
+
+  ColormanageProcessor *cm_processor = IMB_colormanagement_display_processor_new(
+      &view_settings, &display_settings);
+
+  std::vector<float> result = create_linear_buffer(width, height, channels);
+  std::vector<float> expected = result;
+  const int num_pixels = width * height;
+
+  IMB_colormanagement_processor_apply(
+      cm_processor, result.data(), width, height, channels, predivide);
+
+  for (int i = 0; i < num_pixels; i++) {
+    float *pixel = &expected[(size_t)i * channels];
+    if (channels == 3) {
+      IMB_colormanagement_processor_apply_v3(cm_processor, pixel);
+    }
+    else if (predivide) {
+      IMB_colormanagement_processor_apply_v4_predivide(cm_processor, pixel);
+    }
+    else {
+      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
+    }
+  }
+
+  std::vector<unsigned char> result_bytes(result.size()), expected_bytes(expected.size());
+  for (size_t i = 0; i < result.size(); i++) {
+    result_bytes[i] = unit_float_to_uchar_clamp(result[i]);
+    expected_bytes[i] = unit_float_to_uchar_clamp(expected[i]);
+  }
+  expect_bytes_near(result_bytes.data(), expected_bytes.data(), num_pixels, channels);
+
+  IMB_colormanagement_processor_free(cm_processor);
+}
+
+/* Compare the display buffer of a whole image against the OCIO processor applied one pixel at a
+ * time, going through the same conversions the display buffer does for byte and float images. */
+static void test_display_buffer_matches_ocio(float exposure, float gamma, bool is_float)
+{
+  const int width = 37, height = 11, num_pixels = width * height;
+  ColorManagedDisplaySettings display_settings;
+  ColorManagedViewSettings view_settings;
+  display_settings_init(&display_settings);
+  view_settings_init(&view_settings, &display_settings, exposure, gamma);
+
+  ImBuf *ibuf = create_test_ibuf(width, height, is_float);
+
+  void *cache_handle;
+  const unsigned char *result = IMB_display_buffer_acquire(
+      ibuf, &view_settings, &display_settings, &cache_handle);
+  ASSERT_NE(result, nullptr);
+
+  ColormanageProcessor *cm_processor = IMB_colormanagement_display_processor_new(
+      &view_settings, &display_settings);
+
+  std::vector<unsigned char> expected((size_t)num_pixels * 4);
+  for (int i = 0; i < num_pixels; i++) {
+    float pixel[4];
+    if (is_float) {
+      copy_v4_v4(pixel, &ibuf->rect_float[i * 4]);
+      IMB_colormanagement_processor_apply_v4_predivide(cm_processor, pixel);
+      premul_to_straight_v4(pixel);
+    }
+    else {
+      rgba_uchar_to_float(pixel, (unsigned char *)&ibuf->rect[i]);
+      IMB_colormanagement_colorspace_to_scene_linear_v3(pixel, ibuf->rect_colorspace);
+      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
+    }
+    rgba_float_to_uchar(&expected[(size_t)i * 4], pixel);
+  }
+  expect_bytes_near(result, expected.data(), num_pixels, 4);
+
+  IMB_colormanagement_processor_free(cm_processor);
+  IMB_display_buffer_release(cache_handle);
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(imbuf_colormanagement, SRGBProcessorRGBA)
+{
+  /* Widths which are not a multiple of four leave a remainder for the scalar code. */
+  test_processor_matches_ocio(0.0f, 1.0f, 37, 5, 4, false);
+  test_processor_matches_ocio(0.0f, 1.0f, 37, 5, 4, true);
+  test_processor_matches_ocio(1.5f, 1.0f, 37, 5, 4, true);
+  test_processor_matches_ocio(-2.0f, 1.0f, 37, 5, 4, false);
+}
+
+TEST_F(imbuf_colormanagement, SRGBProcessorGamma)
+{
+  test_processor_matches_ocio(0.0f, 2.2f, 37, 5, 4, false);
+  test_processor_matches_ocio(0.5f, 0.6f, 37, 5, 4, true);
+}
+
+TEST_F(imbuf_colormanagement, SRGBProcessorRGB)
+{
+  test_processor_matches_ocio(0.0f, 1.0f, 37, 5, 3, false);
+  test_processor_matches_ocio(1.0f, 1.8f, 37, 5, 3, false);
+}
+
+TEST_F(imbuf_colormanagement, SRGBDisplayBufferByte)
+{
+  test_display_buffer_matches_ocio(1.0f, 1.0f, false);
+  test_display_buffer_matches_ocio(-1.0f, 1.5f, false);
+}
+
+TEST_F(imbuf_colormanagement, SRGBDisplayBufferFloat)
+{
+  test_display_buffer_matches_ocio(0.0f, 1.0f, true);
+  test_display_buffer_matches_ocio(2.0f, 1.0f, true);
+  test_display_buffer_matches_ocio(0.0f, 0.8f, true);
+}
+
+/** \} */
+
+}  // namespace blender::imbuf::tests
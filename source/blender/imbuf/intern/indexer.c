@@ -27,8 +27,10 @@
 #include "BLI_endian_switch.h"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 #ifdef _WIN32
 #  include "BLI_winstuff.h"
@@ -444,6 +446,10 @@ typedef struct IndexBuildContext {
 
 #ifdef WITH_FFMPEG
 
+/* Maximum number of decoded frames queued for a proxy size, limits memory usage when encoding
+ * is slower than decoding. */
+#  define PROXY_QUEUE_SIZE 8
+
 struct proxy_output_ctx {
   AVFormatContext *of;
   AVStream *st;
@@ -455,6 +461,14 @@ struct proxy_output_ctx {
   int proxy_size;
   int orig_height;
   struct anim *anim;
+
+  /* Decoded frames waiting to be scaled and encoded on the proxy thread, so decoding and the
+   * encoding of every proxy size run concurrently. */
+  ThreadMutex queue_mutex;
+  ThreadCondition queue_cond;
+  AVFrame *queue[PROXY_QUEUE_SIZE];
+  int queue_start, queue_len;
+  bool queue_finished;
 };
 
 // work around stupid swscaler 16 bytes alignment bug...
@@ -493,6 +507,8 @@ static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
   rv->c->codec_id = AV_CODEC_ID_MJPEG;
   rv->c->width = width;
   rv->c->height = height;
+  rv->c->thread_count = 0;
+  rv->c->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
   rv->of->oformat->video_codec = rv->c->codec_id;
   rv->codec = avcodec_find_encoder(rv->c->codec_id);
@@ -570,6 +586,9 @@ static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
     return 0;
   }
 
+  BLI_mutex_init(&rv->queue_mutex);
+  BLI_condition_init(&rv->queue_cond);
+
   return rv;
 }
 
@@ -632,6 +651,73 @@ static int add_to_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, AVFrame *fra
   return 0;
 }
 
+/* Queue a reference to a decoded frame for the proxy thread, waits while the queue is full. */
+static void proxy_output_queue_push(struct proxy_output_ctx *ctx, AVFrame *frame)
+{
+  AVFrame *queued_frame = av_frame_clone(frame);
+
+  if (!queued_frame) {
+    return;
+  }
+
+  BLI_mutex_lock(&ctx->queue_mutex);
+  while (ctx->queue_len == PROXY_QUEUE_SIZE) {
+    BLI_condition_wait(&ctx->queue_cond, &ctx->queue_mutex);
+  }
+  ctx->queue[(ctx->queue_start + ctx->queue_len) % PROXY_QUEUE_SIZE] = queued_frame;
+  ctx->queue_len++;
+  BLI_condition_notify_all(&ctx->queue_cond);
+  BLI_mutex_unlock(&ctx->queue_mutex);
+}
+
+/* Returns NULL once the queue is finished and all frames were processed. */
+static AVFrame *proxy_output_queue_pop(struct proxy_output_ctx *ctx)
+{
+  AVFrame *frame = NULL;
+
+  BLI_mutex_lock(&ctx->queue_mutex);
+  while (ctx->queue_len == 0 && !ctx->queue_finished) {
+    BLI_condition_wait(&ctx->queue_cond, &ctx->queue_mutex);
+  }
+  if (ctx->queue_len != 0) {
+    frame = ctx->queue[ctx->queue_start];
+    ctx->queue_start = (ctx->queue_start + 1) % PROXY_QUEUE_SIZE;
+    ctx->queue_len--;
+    BLI_condition_notify_all(&ctx->queue_cond);
+  }
+  BLI_mutex_unlock(&ctx->queue_mutex);
+
+  return frame;
+}
+
+/* Stop the proxy thread after the queued frames, or right away when \a discard is set. */
+static void proxy_output_queue_finish(struct proxy_output_ctx *ctx, bool discard)
+{
+  BLI_mutex_lock(&ctx->queue_mutex);
+  if (discard) {
+    for (; ctx->queue_len > 0; ctx->queue_len--) {
+      av_frame_free(&ctx->queue[ctx->queue_start]);
+      ctx->queue_start = (ctx->queue_start + 1) % PROXY_QUEUE_SIZE;
+    }
+  }
+  ctx->queue_finished = true;
+  BLI_condition_notify_all(&ctx->queue_cond);
+  BLI_mutex_unlock(&ctx->queue_mutex);
+}
+
+static void *proxy_output_thread(void *ctx_v)
+{
+  struct proxy_output_ctx *ctx = ctx_v;
+  AVFrame *frame;
+
+  while ((frame = proxy_output_queue_pop(ctx))) {
+    add_to_proxy_output_ffmpeg(ctx, frame);
+    av_frame_free(&frame);
+  }
+
+  return NULL;
+}
+
 static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, int rollback)
 {
   char fname[FILE_MAX];
@@ -677,9 +763,22 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, int rollback)
     BLI_rename(fname_tmp, fname);
   }
 
+  BLI_condition_end(&ctx->queue_cond);
+  BLI_mutex_end(&ctx->queue_mutex);
+
   MEM_freeN(ctx);
 }
 
+/* Key frames kept to look up seek positions, frame threaded decoding returns frames several
+ * packets after they were read. */
+#  define INDEX_KEY_FRAME_HISTORY 32
+
+typedef struct IndexKeyFrame {
+  unsigned long long pos;
+  unsigned long long dts;
+  unsigned long long pts;
+} IndexKeyFrame;
+
 typedef struct FFmpegIndexBuilderContext {
   int anim_type;
 
@@ -695,14 +794,16 @@ typedef struct FFmpegIndexBuilderContext {
   struct proxy_output_ctx *proxy_ctx[IMB_PROXY_MAX_SLOT];
   anim_index_builder *indexer[IMB_TC_MAX_SLOT];
 
+  /* Threads scaling and encoding the proxies, one for every proxy size. */
+  ListBase proxy_threads;
+
   IMB_Timecode_Type tcs_in_use;
   IMB_Proxy_Size proxy_sizes_in_use;
 
-  unsigned long long seek_pos;
-  unsigned long long last_seek_pos;
-  unsigned long long seek_pos_dts;
-  unsigned long long seek_pos_pts;
-  unsigned long long last_seek_pos_dts;
+  /* Ring buffer of the most recently read key frames. */
+  IndexKeyFrame key_frames[INDEX_KEY_FRAME_HISTORY];
+  int key_frames_start, key_frames_len;
+
   unsigned long long start_pts;
   double frame_rate;
   double pts_time_base;
@@ -773,6 +874,8 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
   }
 
   context->iCodecCtx->workaround_bugs = 1;
+  context->iCodecCtx->thread_count = 0;
+  context->iCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
   if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
     avformat_close_input(&context->iFormatCtx);
@@ -833,17 +936,63 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, int
   MEM_freeN(context);
 }
 
+static void index_rebuild_ffmpeg_add_key_frame(FFmpegIndexBuilderContext *context,
+                                               const AVPacket *packet)
+{
+  IndexKeyFrame *key_frame;
+
+  if (context->key_frames_len == INDEX_KEY_FRAME_HISTORY) {
+    context->key_frames_start = (context->key_frames_start + 1) % INDEX_KEY_FRAME_HISTORY;
+    context->key_frames_len--;
+  }
+
+  key_frame = &context->key_frames[(context->key_frames_start + context->key_frames_len) %
+                                   INDEX_KEY_FRAME_HISTORY];
+  key_frame->pos = packet->pos;
+  key_frame->dts = packet->dts;
+  /* Only used to find the key frame of decoded frames, fall back to the decoding time stamp. */
+  key_frame->pts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+  context->key_frames_len++;
+}
+
+/* decoding starts *always* on I-Frames,
+ * so: P-Frames won't work, even if all the
+ * information is in place, when we seek
+ * to the I-Frame presented *after* the P-Frame,
+ * but located before the P-Frame within
+ * the stream.
+ *
+ * Use the most recent key frame that is presented at or before the frame, decoding is delayed
+ * by several packets with frame threading. */
+static IndexKeyFrame index_rebuild_ffmpeg_find_key_frame(const FFmpegIndexBuilderContext *context,
+                                                         unsigned long long pts)
+{
+  const IndexKeyFrame start_key_frame = {0};
+
+  for (int i = context->key_frames_len - 1; i >= 0; i--) {
+    const IndexKeyFrame *key_frame =
+        &context->key_frames[(context->key_frames_start + i) % INDEX_KEY_FRAME_HISTORY];
+    if (key_frame->pts <= pts) {
+      return *key_frame;
+    }
+  }
+
+  /* Frames presented before the first key frame, seek from the start of the file. */
+  return start_key_frame;
+}
+
 static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *context,
                                                     AVPacket *curr_packet,
                                                     AVFrame *in_frame)
 {
   int i;
-  unsigned long long s_pos = context->seek_pos;
-  unsigned long long s_dts = context->seek_pos_dts;
   unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
+  const IndexKeyFrame key_frame = index_rebuild_ffmpeg_find_key_frame(context, pts);
 
   for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+    if (context->proxy_ctx[i]) {
+      proxy_output_queue_push(context->proxy_ctx[i], in_frame);
+    }
   }
 
   if (!context->start_pts_set) {
@@ -854,18 +1003,6 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   context->frameno = floor(
       (pts - context->start_pts) * context->pts_time_base * context->frame_rate + 0.5);
 
-  /* decoding starts *always* on I-Frames,
-   * so: P-Frames won't work, even if all the
-   * information is in place, when we seek
-   * to the I-Frame presented *after* the P-Frame,
-   * but located before the P-Frame within
-   * the stream */
-
-  if (pts < context->seek_pos_pts) {
-    s_pos = context->last_seek_pos;
-    s_dts = context->last_seek_pos_dts;
-  }
-
   for (i = 0; i < context->num_indexers; i++) {
     if (context->tcs_in_use & tc_types[i]) {
       int tc_frameno = context->frameno;
@@ -878,8 +1015,8 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
                                    curr_packet->data,
                                    curr_packet->size,
                                    tc_frameno,
-                                   s_pos,
-                                   s_dts,
+                                   key_frame.pos,
+                                   key_frame.dts,
                                    pts);
     }
   }
@@ -887,6 +1024,40 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   context->frameno_gapless++;
 }
 
+/* Decoding happens on the calling thread (and the decoder's own frame threads), scaling and
+ * encoding of every proxy size on a thread of its own. */
+static void index_rebuild_ffmpeg_proxy_threads_start(FFmpegIndexBuilderContext *context)
+{
+  int num_threads = 0;
+
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    num_threads += (context->proxy_ctx[i] != NULL);
+  }
+
+  BLI_listbase_clear(&context->proxy_threads);
+  if (num_threads == 0) {
+    return;
+  }
+
+  BLI_threadpool_init(&context->proxy_threads, proxy_output_thread, num_threads);
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      BLI_threadpool_insert(&context->proxy_threads, context->proxy_ctx[i]);
+    }
+  }
+}
+
+static void index_rebuild_ffmpeg_proxy_threads_end(FFmpegIndexBuilderContext *context, bool stop)
+{
+  for (int i = 0; i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      proxy_output_queue_finish(context->proxy_ctx[i], stop);
+    }
+  }
+
+  BLI_threadpool_end(&context->proxy_threads);
+}
+
 static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
                                 const short *stop,
                                 short *do_update,
@@ -905,6 +1076,8 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
   context->frame_rate = av_q2d(av_guess_frame_rate(context->iFormatCtx, context->iStream, NULL));
   context->pts_time_base = av_q2d(context->iStream->time_base);
 
+  index_rebuild_ffmpeg_proxy_threads_start(context);
+
   while (av_read_frame(context->iFormatCtx, &next_packet) >= 0) {
     int frame_finished = 0;
     float next_progress =
@@ -922,11 +1095,7 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 
     if (next_packet.stream_index == context->videoStream) {
       if (next_packet.flags & AV_PKT_FLAG_KEY) {
-        context->last_seek_pos = context->seek_pos;
-        context->last_seek_pos_dts = context->seek_pos_dts;
-        context->seek_pos = next_packet.pos;
-        context->seek_pos_dts = next_packet.dts;
-        context->seek_pos_pts = next_packet.pts;
+        index_rebuild_ffmpeg_add_key_frame(context, &next_packet);
       }
 
       avcodec_decode_video2(context->iCodecCtx, in_frame, &frame_finished, &next_packet);
@@ -960,6 +1129,9 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
     } while (frame_finished);
   }
 
+  /* Wait for the proxy threads to encode the queued frames. */
+  index_rebuild_ffmpeg_proxy_threads_end(context, *stop);
+
   av_free(in_frame);
 
   return 1;
@@ -1261,6 +1433,8 @@ void IMB_free_indices(struct anim *anim)
 {
   int i;
 
+  imb_anim_readahead_end(anim);
+
   for (i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
     if (anim->proxy_anim[i]) {
       IMB_close_anim(anim->proxy_anim[i]);
@@ -30,8 +30,11 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
+#include "BLI_system.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -53,6 +56,32 @@
 static MEM_CacheLimiterC *limitor = NULL;
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
 
+/* Counter of put and get calls, used to find least recently used items, and average cost per
+ * byte of the items with a known cost. Both are protected by limitor_lock. */
+static unsigned int limitor_use_counter = 0;
+static double limitor_average_cost = 0.0;
+
+/* Items which are more expensive to produce per byte than average are kept up to this many times
+ * longer, cheaper ones are freed up to this many times sooner. */
+#define MOVIECACHE_COST_WEIGHT_MAX 16.0
+/* Weight of a new item in the running average of cost per byte. */
+#define MOVIECACHE_COST_AVERAGE_FACTOR 0.05
+
+/* Fraction of the physical memory in use at which caches are shrunk, and the fraction they are
+ * shrunk to. */
+#define MOVIECACHE_MEMORY_PRESSURE_HIGH 0.85
+#define MOVIECACHE_MEMORY_PRESSURE_LOW 0.75
+
+typedef struct MovieCacheMemoryPressureHandler {
+  struct MovieCacheMemoryPressureHandler *next, *prev;
+  MovieCacheMemoryUsageFP usagefp;
+  MovieCacheMemoryFreeFP freefp;
+  void *userdata;
+} MovieCacheMemoryPressureHandler;
+
+static ListBase pressure_handlers = {NULL, NULL};
+static pthread_mutex_t pressure_lock = BLI_MUTEX_INITIALIZER;
+
 typedef struct MovieCache {
   char name[64];
 
@@ -87,6 +116,10 @@ typedef struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  /* Time in seconds it took to produce the buffer, 0 when unknown. */
+  float cost;
+  /* Value of limitor_use_counter when the item was put or got last. */
+  unsigned int last_use;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -207,29 +240,65 @@ static size_t get_item_size(void *p)
   return size;
 }
 
-static int get_item_priority(void *item_v, int default_priority)
+/* Items which are cheap to produce for their size are freed first: the (negative) priority is
+ * scaled by how much more expensive than average the item is per byte. */
+static int get_item_cost_weighted_priority(MovieCacheItem *item, int priority)
+{
+  double cost_per_byte, weight;
+
+  if (priority >= 0 || item->cost <= 0.0f || limitor_average_cost <= 0.0) {
+    return priority;
+  }
+
+  cost_per_byte = (double)item->cost / get_item_size(item);
+  weight = limitor_average_cost / cost_per_byte;
+  CLAMP(weight, 1.0 / MOVIECACHE_COST_WEIGHT_MAX, MOVIECACHE_COST_WEIGHT_MAX);
+
+  return (int)max_dd(priority * weight, -INT_MAX);
+}
+
+static int get_item_priority(void *item_v, int UNUSED(default_priority))
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
   MovieCache *cache = item->cache_owner;
   int priority;
 
-  if (!cache->getitempriorityfp) {
-    PRINT("%s: cache '%s' item %p use default priority %d\n",
-          __func__,
-          cache->name,
-          item,
-          default_priority);
-
-    return default_priority;
+  if (cache->getitempriorityfp) {
+    priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+  }
+  else {
+    /* The limiter doesn't reorder its queue on access when priorities are used, so recency is
+     * tracked here. */
+    const unsigned int age = limitor_use_counter - item->last_use;
+    priority = -(int)min_zz(age, INT_MAX);
   }
 
-  priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+  priority = get_item_cost_weighted_priority(item, priority);
 
   PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
 
   return priority;
 }
 
+static void update_average_cost(MovieCacheItem *item)
+{
+  double cost_per_byte;
+
+  if (item->cost <= 0.0f) {
+    return;
+  }
+
+  cost_per_byte = (double)item->cost / get_item_size(item);
+
+  if (limitor_average_cost == 0.0) {
+    limitor_average_cost = cost_per_byte;
+  }
+  else {
+    limitor_average_cost += (cost_per_byte - limitor_average_cost) *
+                            MOVIECACHE_COST_AVERAGE_FACTOR;
+  }
+}
+
 static bool get_item_destroyable(void *item_v)
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
@@ -303,7 +372,8 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+static void do_moviecache_put(
+    MovieCache *cache, void *userkey, ImBuf *ibuf, float cost, bool need_lock)
 {
   MovieCacheKey *key;
   MovieCacheItem *item;
@@ -327,6 +397,7 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   item->cache_owner = cache;
   item->c_handle = NULL;
   item->priority_data = NULL;
+  item->cost = cost;
 
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
@@ -342,6 +413,9 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     BLI_mutex_lock(&limitor_lock);
   }
 
+  item->last_use = ++limitor_use_counter;
+  update_average_cost(item);
+
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
 
   MEM_CacheLimiter_ref(item->c_handle);
@@ -363,10 +437,21 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-  do_moviecache_put(cache, userkey, ibuf, true);
+  IMB_moviecache_put_ex(cache, userkey, ibuf, 0.0f);
+}
+
+/* Put a buffer which took cost seconds to produce, expensive buffers are kept longer. */
+void IMB_moviecache_put_ex(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
+{
+  do_moviecache_put(cache, userkey, ibuf, cost, true);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
+{
+  return IMB_moviecache_put_if_possible_ex(cache, userkey, ibuf, 0.0f);
+}
+
+bool IMB_moviecache_put_if_possible_ex(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
 {
   size_t mem_in_use, mem_limit, elem_size;
   bool result = false;
@@ -378,7 +463,7 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
   mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
   if (mem_in_use + elem_size <= mem_limit) {
-    do_moviecache_put(cache, userkey, ibuf, false);
+    do_moviecache_put(cache, userkey, ibuf, cost, false);
     result = true;
   }
 
@@ -408,6 +493,7 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
     if (item->ibuf) {
       BLI_mutex_lock(&limitor_lock);
       MEM_CacheLimiter_touch(item->c_handle);
+      item->last_use = ++limitor_use_counter;
       BLI_mutex_unlock(&limitor_lock);
 
       IMB_refImBuf(item->ibuf);
@@ -476,6 +562,107 @@ void IMB_moviecache_cleanup(MovieCache *cache,
   }
 }
 
+/* Memory pressure.
+ *
+ * Caches which keep their own budget, such as the sequencer cache, register handlers here so all
+ * image caches of the process are shrunk together when it runs low on memory. */
+
+void IMB_moviecache_memory_pressure_handler_add(MovieCacheMemoryUsageFP usagefp,
+                                                MovieCacheMemoryFreeFP freefp,
+                                                void *userdata)
+{
+  MovieCacheMemoryPressureHandler *handler = MEM_callocN(sizeof(*handler), __func__);
+
+  handler->usagefp = usagefp;
+  handler->freefp = freefp;
+  handler->userdata = userdata;
+
+  BLI_mutex_lock(&pressure_lock);
+  BLI_addtail(&pressure_handlers, handler);
+  BLI_mutex_unlock(&pressure_lock);
+}
+
+void IMB_moviecache_memory_pressure_handler_remove(void *userdata)
+{
+  BLI_mutex_lock(&pressure_lock);
+  LISTBASE_FOREACH_MUTABLE (MovieCacheMemoryPressureHandler *, handler, &pressure_handlers) {
+    if (handler->userdata == userdata) {
+      BLI_freelinkN(&pressure_handlers, handler);
+    }
+  }
+  BLI_mutex_unlock(&pressure_lock);
+}
+
+/* Free memory from the movie caches and all registered caches, each of them is shrunk by the
+ * same fraction of its size. Returns amount of memory freed, nothing is done when another thread
+ * is already freeing memory. */
+size_t IMB_moviecache_memory_pressure_free(size_t memory_to_free)
+{
+  size_t memory_used = 0, memory_freed = 0;
+  double fraction;
+
+  if (!BLI_mutex_trylock(&pressure_lock)) {
+    return 0;
+  }
+
+  if (limitor) {
+    BLI_mutex_lock(&limitor_lock);
+    memory_used += MEM_CacheLimiter_get_memory_in_use(limitor);
+    BLI_mutex_unlock(&limitor_lock);
+  }
+  LISTBASE_FOREACH (MovieCacheMemoryPressureHandler *, handler, &pressure_handlers) {
+    memory_used += handler->usagefp(handler->userdata);
+  }
+
+  if (memory_used == 0) {
+    BLI_mutex_unlock(&pressure_lock);
+    return 0;
+  }
+
+  fraction = min_dd((double)memory_to_free / memory_used, 1.0);
+
+  PRINT("%s: free %zu of %zu bytes used by caches\n", __func__, memory_to_free, memory_used);
+
+  if (limitor) {
+    BLI_mutex_lock(&limitor_lock);
+    memory_freed += MEM_CacheLimiter_free_memory(
+        limitor, (size_t)(MEM_CacheLimiter_get_memory_in_use(limitor) * fraction));
+    BLI_mutex_unlock(&limitor_lock);
+  }
+  LISTBASE_FOREACH (MovieCacheMemoryPressureHandler *, handler, &pressure_handlers) {
+    const size_t handler_memory_used = handler->usagefp(handler->userdata);
+    memory_freed += handler->freefp(handler->userdata, (size_t)(handler_memory_used * fraction));
+  }
+
+  BLI_mutex_unlock(&pressure_lock);
+
+  return memory_freed;
+}
+
+/* Shrink caches when the process gets close to using all physical memory. Not done by the put
+ * functions since their callers often hold locks, call it once those are released. */
+void IMB_moviecache_memory_pressure_check(void)
+{
+  static size_t memory_physical = 0;
+  size_t memory_in_use, memory_low;
+
+  if (memory_physical == 0) {
+    memory_physical = BLI_system_memory_physical();
+    if (memory_physical == 0) {
+      return;
+    }
+  }
+
+  memory_in_use = MEM_get_memory_in_use();
+
+  if (memory_in_use < (size_t)(memory_physical * MOVIECACHE_MEMORY_PRESSURE_HIGH)) {
+    return;
+  }
+
+  memory_low = (size_t)(memory_physical * MOVIECACHE_MEMORY_PRESSURE_LOW);
+  IMB_moviecache_memory_pressure_free(memory_in_use - memory_low);
+}
+
 /* get segments of cached frames. useful for debugging cache policies */
 void IMB_moviecache_get_cache_segments(
     MovieCache *cache, int proxy, int render_flags, int *r_totseg, int **r_points)
@@ -55,6 +55,7 @@
 #include <ImfOutputPart.h>
 #include <ImfPartHelper.h>
 #include <ImfPartType.h>
+#include <ImfThreading.h>
 #include <ImfTiledOutputPart.h>
 
 #include "DNA_scene_types.h" /* For OpenEXR compression constants */
@@ -78,6 +79,7 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 }
 #include "BLI_blenlib.h"
 #include "BLI_math_color.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -98,6 +100,7 @@ using namespace Imath;
 extern "C" {
 /* prototype */
 static struct ExrPass *imb_exr_get_pass(ListBase *lb, char *passname);
+static void imb_exr_update_thread_count(void);
 static bool exr_has_multiview(MultiPartInputFile &file);
 static bool exr_has_multipart_file(MultiPartInputFile &file);
 static bool exr_has_alpha(MultiPartInputFile &file);
@@ -115,13 +118,26 @@ static void imb_exr_type_by_channels(ChannelList &channels,
 class IMemStream : public Imf::IStream {
  public:
   IMemStream(unsigned char *exrbuf, size_t exrsize)
-      : IStream("<memory>"), _exrpos(0), _exrsize(exrsize)
+      : IStream("<memory>"), _exrpos(0), _exrsize(exrsize), _exrbuf_owned(false)
   {
     _exrbuf = exrbuf;
   }
 
   virtual ~IMemStream()
   {
+    if (_exrbuf_owned) {
+      MEM_freeN(_exrbuf);
+    }
+  }
+
+  /* Read from an own copy of the memory from now on, for streams outliving the caller's
+   * buffer. */
+  void copy_buffer()
+  {
+    unsigned char *exrbuf = (unsigned char *)MEM_mallocN(_exrsize, "IMemStream");
+    memcpy(exrbuf, _exrbuf, _exrsize);
+    _exrbuf = exrbuf;
+    _exrbuf_owned = true;
   }
 
   virtual bool read(char c[], int n)
@@ -153,6 +169,7 @@ class IMemStream : public Imf::IStream {
   Int64 _exrpos;
   Int64 _exrsize;
   unsigned char *_exrbuf;
+  bool _exrbuf_owned;
 };
 
 /* File Input Stream */
@@ -588,6 +605,8 @@ static bool imb_save_openexr_float(ImBuf *ibuf, const char *name, const int flag
 
 int imb_save_openexr(struct ImBuf *ibuf, const char *name, int flags)
 {
+  imb_exr_update_thread_count();
+
   if (flags & IB_mem) {
     imb_addencodedbufferImBuf(ibuf);
     ibuf->encodedsize = 0;
@@ -678,6 +697,22 @@ typedef struct ExrLayer {
 
 /* ********************** */
 
+/* Keep the OpenEXR thread pool in sync with the threads Blender may use, the count can be
+ * overridden after startup. */
+static void imb_exr_update_thread_count(void)
+{
+  static ThreadMutex thread_count_lock = BLI_MUTEX_INITIALIZER;
+  const int num_threads = BLI_system_thread_count();
+
+  if (globalThreadCount() != num_threads) {
+    BLI_mutex_lock(&thread_count_lock);
+    if (globalThreadCount() != num_threads) {
+      setGlobalThreadCount(num_threads);
+    }
+    BLI_mutex_unlock(&thread_count_lock);
+  }
+}
+
 void *IMB_exr_get_handle(void)
 {
   ExrHandle *data = (ExrHandle *)MEM_callocN(sizeof(ExrHandle), "exr handle");
@@ -1089,12 +1124,34 @@ void IMB_exr_clear_channels(void *handle)
   BLI_freelistN(&data->channels);
 }
 
+typedef struct ExrHalfConvertData {
+  const float *rect;
+  half *rect_half;
+  int xstride;
+  int width;
+} ExrHalfConvertData;
+
+static void exr_half_convert_row(void *__restrict userdata,
+                                 const int y,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ExrHalfConvertData *convert = (const ExrHalfConvertData *)userdata;
+  const float *rect = convert->rect + (size_t)y * convert->width * convert->xstride;
+  half *cur = convert->rect_half + (size_t)y * convert->width;
+
+  for (int x = 0; x < convert->width; x++, cur++, rect += convert->xstride) {
+    *cur = *rect;
+  }
+}
+
 void IMB_exr_write_channels(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
   FrameBuffer frameBuffer;
   ExrChannel *echan;
 
+  imb_exr_update_thread_count();
+
   if (data->channels.first) {
     const size_t num_pixels = ((size_t)data->width) * data->height;
     half *rect_half = NULL, *current_rect_half = NULL;
@@ -1109,11 +1166,17 @@ void IMB_exr_write_channels(void *handle)
     for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
       /* Writing starts from last scanline, stride negative. */
       if (echan->use_half_float) {
-        float *rect = echan->rect;
-        half *cur = current_rect_half;
-        for (size_t i = 0; i < num_pixels; i++, cur++) {
-          *cur = rect[i * echan->xstride];
-        }
+        ExrHalfConvertData convert;
+        convert.rect = echan->rect;
+        convert.rect_half = current_rect_half;
+        convert.xstride = echan->xstride;
+        convert.width = data->width;
+
+        TaskParallelSettings settings;
+        BLI_parallel_range_settings_defaults(&settings);
+        settings.use_threading = (num_pixels > 64 * 64);
+        BLI_task_parallel_range(0, data->height, &convert, exr_half_convert_row, &settings);
+
         half *rect_to_write = current_rect_half + (data->height - 1L) * data->width;
         frameBuffer.insert(
             echan->name,
@@ -1205,6 +1268,8 @@ void IMB_exr_read_channels(void *handle)
   ExrHandle *data = (ExrHandle *)handle;
   int numparts = data->ifile->parts();
 
+  imb_exr_update_thread_count();
+
   /* Check if EXR was saved with previous versions of blender which flipped images. */
   const StringAttribute *ta = data->ifile->header(0).findTypedAttribute<StringAttribute>(
       "BlenderMultiChannel");
@@ -1229,6 +1294,7 @@ void IMB_exr_read_channels(void *handle)
     /* Insert all matching channel into framebuffer. */
     FrameBuffer frameBuffer;
     ExrChannel *echan;
+    bool has_slices = false;
 
     for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
       if (echan->m->part_number != i) {
@@ -1260,12 +1326,18 @@ void IMB_exr_read_channels(void *handle)
 
         frameBuffer.insert(echan->m->internal_name,
                            Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+        has_slices = true;
       }
       else {
-        printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
+        exr_printf("channel with no rect set %s, skipped\n", echan->m->internal_name.c_str());
       }
     }
 
+    /* Nothing requested from this part, don't decompress it. */
+    if (!has_slices) {
+      continue;
+    }
+
     /* Read pixels. */
     try {
       in.setFrameBuffer(frameBuffer);
@@ -1289,7 +1361,12 @@ void IMB_exr_multilayer_convert(void *handle,
                                                 float *rect,
                                                 int totchan,
                                                 const char *chan_id,
-                                                const char *view))
+                                                const char *view),
+                                bool (*testpass)(void *base,
+                                                 const char *layname,
+                                                 const char *passname,
+                                                 const char *chan_id,
+                                                 const char *view))
 {
   ExrHandle *data = (ExrHandle *)handle;
   ExrLayer *lay;
@@ -1312,10 +1389,32 @@ void IMB_exr_multilayer_convert(void *handle,
     return;
   }
 
+  /* Only allocate and decode the passes the caller asks for. */
+  bool read_pending = false;
+  for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
+    for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+      if (pass->rect || pass->totchan == 0) {
+        continue;
+      }
+      if (testpass && !testpass(base, lay->name, pass->internal_name, pass->chan_id, pass->view)) {
+        continue;
+      }
+      imb_exr_pass_alloc(data, pass);
+      read_pending = true;
+    }
+  }
+
+  if (read_pending && data->ifile) {
+    IMB_exr_read_channels(data);
+  }
+
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     void *laybase = addlayer(base, lay->name);
     if (laybase) {
       for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+        if (pass->totchan == 0) {
+          continue;
+        }
         addpass(base,
                 laybase,
                 pass->internal_name,
@@ -1520,7 +1619,62 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
   return pass;
 }
 
-/* creates channels, makes a hierarchy and assigns memory to channels */
+/* with some heuristics, find where each channel goes in the buffer of its pass */
+static void imb_exr_pass_channel_offsets(const ExrPass *pass, int offset[EXR_PASS_MAXCHAN])
+{
+  int a;
+
+  /* we can have RGB(A), XYZ(W), UVA */
+  if (pass->totchan == 3 || pass->totchan == 4) {
+    char lookup[256];
+
+    memset(lookup, 0, sizeof(lookup));
+
+    if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
+        pass->chan[2]->chan_id == 'B') {
+      lookup[(unsigned int)'R'] = 0;
+      lookup[(unsigned int)'G'] = 1;
+      lookup[(unsigned int)'B'] = 2;
+      lookup[(unsigned int)'A'] = 3;
+    }
+    else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
+             pass->chan[2]->chan_id == 'Y') {
+      lookup[(unsigned int)'X'] = 0;
+      lookup[(unsigned int)'Y'] = 1;
+      lookup[(unsigned int)'Z'] = 2;
+      lookup[(unsigned int)'W'] = 3;
+    }
+    else {
+      lookup[(unsigned int)'U'] = 0;
+      lookup[(unsigned int)'V'] = 1;
+      lookup[(unsigned int)'A'] = 2;
+    }
+    for (a = 0; a < pass->totchan; a++) {
+      offset[a] = lookup[(unsigned int)pass->chan[a]->chan_id];
+    }
+  }
+  else { /* single channel or unknown */
+    for (a = 0; a < pass->totchan; a++) {
+      offset[a] = a;
+    }
+  }
+}
+
+/* allocates the buffer of a pass and points its channels into it */
+static void imb_exr_pass_alloc(ExrHandle *data, ExrPass *pass)
+{
+  int offset[EXR_PASS_MAXCHAN];
+
+  pass->rect = (float *)MEM_callocN(
+      sizeof(float) * (size_t)data->width * data->height * pass->totchan, "pass rect");
+
+  imb_exr_pass_channel_offsets(pass, offset);
+  for (int a = 0; a < pass->totchan; a++) {
+    pass->chan[a]->rect = pass->rect + offset[a];
+  }
+}
+
+/* creates channels and makes a hierarchy, pixels are read on conversion */
 static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
                                          MultiPartInputFile &file,
                                          int width,
@@ -1591,63 +1745,18 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
     return NULL;
   }
 
-  /* with some heuristics, try to merge the channels in buffers */
+  /* Channels are merged into one buffer per pass. Only strides are set up here, buffers are
+   * allocated when the pass is read, see #IMB_exr_multilayer_convert. */
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
-      if (pass->totchan) {
-        pass->rect = (float *)MEM_callocN(width * height * pass->totchan * sizeof(float),
-                                          "pass rect");
-        if (pass->totchan == 1) {
-          echan = pass->chan[0];
-          echan->rect = pass->rect;
-          echan->xstride = 1;
-          echan->ystride = width;
-          pass->chan_id[0] = echan->chan_id;
-        }
-        else {
-          char lookup[256];
-
-          memset(lookup, 0, sizeof(lookup));
-
-          /* we can have RGB(A), XYZ(W), UVA */
-          if (pass->totchan == 3 || pass->totchan == 4) {
-            if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
-                pass->chan[2]->chan_id == 'B') {
-              lookup[(unsigned int)'R'] = 0;
-              lookup[(unsigned int)'G'] = 1;
-              lookup[(unsigned int)'B'] = 2;
-              lookup[(unsigned int)'A'] = 3;
-            }
-            else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
-                     pass->chan[2]->chan_id == 'Y') {
-              lookup[(unsigned int)'X'] = 0;
-              lookup[(unsigned int)'Y'] = 1;
-              lookup[(unsigned int)'Z'] = 2;
-              lookup[(unsigned int)'W'] = 3;
-            }
-            else {
-              lookup[(unsigned int)'U'] = 0;
-              lookup[(unsigned int)'V'] = 1;
-              lookup[(unsigned int)'A'] = 2;
-            }
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-            }
-          }
-          else { /* unknown */
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + a;
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[a] = echan->chan_id;
-            }
-          }
-        }
+      int offset[EXR_PASS_MAXCHAN];
+
+      imb_exr_pass_channel_offsets(pass, offset);
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[offset[a]] = echan->chan_id;
       }
     }
   }
@@ -1903,6 +2012,8 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
     return NULL;
   }
 
+  imb_exr_update_thread_count();
+
   colorspace_set_default_role(colorspace, IM_MAX_SPACE, COLOR_ROLE_DEFAULT_FLOAT);
 
   try {
@@ -1963,10 +2074,12 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
 
         /* Only enters with IB_multilayer flag set. */
         if (is_multi && ((flags & IB_thumbnail) == 0)) {
-          /* constructs channels for reading, allocates memory in channels */
+          /* Constructs channels for reading, pixels of the passes the caller uses
+           * are read by #IMB_exr_multilayer_convert. That happens after `mem` may be gone, so
+           * the handle reads from a copy. */
+          membuf->copy_buffer();
           ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height);
           if (handle) {
-            IMB_exr_read_channels(handle);
             ibuf->userdata = handle; /* potential danger, the caller has to check for this! */
           }
         }
@@ -2087,6 +2200,69 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
   }
 }
 
+/* Whether both files have the same parts and channels, so a handle can read from either. */
+static bool imb_exr_same_layout(MultiPartInputFile &file_a, MultiPartInputFile &file_b)
+{
+  if (file_a.parts() != file_b.parts()) {
+    return false;
+  }
+
+  for (int i = 0; i < file_a.parts(); i++) {
+    const Header &header_a = file_a.header(i);
+    const Header &header_b = file_b.header(i);
+
+    if (header_a.hasName() != header_b.hasName() ||
+        (header_a.hasName() && header_a.name() != header_b.name())) {
+      return false;
+    }
+    if (header_a.dataWindow() != header_b.dataWindow()) {
+      return false;
+    }
+
+    const ChannelList &channels_a = header_a.channels();
+    const ChannelList &channels_b = header_b.channels();
+    ChannelList::ConstIterator it_a = channels_a.begin();
+    ChannelList::ConstIterator it_b = channels_b.begin();
+    for (; it_a != channels_a.end() && it_b != channels_b.end(); ++it_a, ++it_b) {
+      if (!STREQ(it_a.name(), it_b.name()) || it_a.channel().type != it_b.channel().type) {
+        return false;
+      }
+    }
+    if (it_a != channels_a.end() || it_b != channels_b.end()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void imb_exr_multilayer_reopen(struct ImBuf *ibuf, const char *filepath)
+{
+  ExrHandle *data = (ExrHandle *)ibuf->userdata;
+  IStream *file_stream = NULL;
+  MultiPartInputFile *file = NULL;
+
+  try {
+    file_stream = new IFileStream(filepath);
+    file = new MultiPartInputFile(*file_stream);
+    if (!imb_exr_same_layout(*file, *data->ifile)) {
+      throw Iex::InputExc("file changed on disk");
+    }
+  }
+  catch (const std::exception &exc) {
+    /* Keep reading from the copy of the file in memory. */
+    std::cerr << "OpenEXR-reopen: " << exc.what() << std::endl;
+    delete file;
+    delete file_stream;
+    return;
+  }
+
+  delete data->ifile;
+  delete data->ifile_stream;
+  data->ifile = file;
+  data->ifile_stream = file_stream;
+}
+
 void imb_initopenexr(void)
 {
   int num_threads = BLI_system_thread_count();
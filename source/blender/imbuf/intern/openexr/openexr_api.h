@@ -37,6 +37,9 @@ int imb_is_a_openexr(const unsigned char *mem);
 int imb_save_openexr(struct ImBuf *ibuf, const char *name, int flags);
 
 struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags, char *colorspace);
+/* Let a multilayer ImBuf read its pixels from `filepath` instead of its copy of the file in
+ * memory, if the file still has the same layout. */
+void imb_exr_multilayer_reopen(struct ImBuf *ibuf, const char *filepath);
 
 #ifdef __cplusplus
 }
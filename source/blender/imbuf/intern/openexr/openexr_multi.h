@@ -77,6 +77,8 @@ void IMB_exrtile_write_channels(
     void *handle, int partx, int party, int level, const char *viewname, bool empty);
 void IMB_exr_clear_channels(void *handle);
 
+/* Only passes accepted by `testpass` are decoded, the others are handed to `addpass` with a NULL
+ * `rect`. Pass NULL to decode all of them. */
 void IMB_exr_multilayer_convert(void *handle,
                                 void *base,
                                 void *(*addview)(void *base, const char *str),
@@ -87,7 +89,12 @@ void IMB_exr_multilayer_convert(void *handle,
                                                 float *rect,
                                                 int totchan,
                                                 const char *chan_id,
-                                                const char *view));
+                                                const char *view),
+                                bool (*testpass)(void *base,
+                                                 const char *layname,
+                                                 const char *passname,
+                                                 const char *chan_id,
+                                                 const char *view));
 
 void IMB_exr_close(void *handle);
 
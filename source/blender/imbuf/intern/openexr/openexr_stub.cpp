@@ -113,7 +113,12 @@ void IMB_exr_multilayer_convert(void * /*handle*/,
                                                     float *rect,
                                                     int totchan,
                                                     const char *chan_id,
-                                                    const char *view))
+                                                    const char *view),
+                                bool (*/*testpass*/)(void *base,
+                                                     const char *layname,
+                                                     const char *passname,
+                                                     const char *chan_id,
+                                                     const char *view))
 {
 }
 
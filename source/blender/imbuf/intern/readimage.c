@@ -44,6 +44,10 @@
 #include "IMB_colormanagement.h"
 #include "IMB_colormanagement_intern.h"
 
+#ifdef WITH_OPENEXR
+#  include "openexr/openexr_api.h"
+#endif
+
 static void imb_handle_alpha(ImBuf *ibuf,
                              int flags,
                              char colorspace[IM_MAX_SPACE],
@@ -196,6 +200,14 @@ ImBuf *IMB_loadifffile(
 
   ibuf = IMB_ibImageFromMemory(mem, size, flags, colorspace, descr);
 
+#ifdef WITH_OPENEXR
+  /* Passes of multilayer files are read on demand, read them from the file instead of keeping
+   * a copy of it in memory. */
+  if (ibuf && ibuf->ftype == IMB_FTYPE_OPENEXR && ibuf->userdata) {
+    imb_exr_multilayer_reopen(ibuf, filepath);
+  }
+#endif
+
   imb_mmap_lock();
   if (munmap(mem, size)) {
     fprintf(stderr, "%s: couldn't unmap file %s\n", __func__, descr);
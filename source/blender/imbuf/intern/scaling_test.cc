@@ -0,0 +1,291 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cmath>
+#include <vector>
+
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+namespace blender::imbuf::tests {
+
+/* -------------------------------------------------------------------- */
+/** \name Reference Scaler
+ *
+ * Separable passes of the scaler #IMB_scaleImBuf used before filtered scaling, operating on
+ * rows of RGBA floats. Byte images were rounded to bytes after every pass.
+ * \{ */
+
+using Image = std::vector<float>;
+
+/* Average of the source pixels covered by every output pixel. */
+static Image reference_scale_down_x(const Image &src, int x, int y, int newx, bool round)
+{
+  const double add = (x - 0.01) / newx;
+  Image dst((size_t)newx * y * 4);
+
+  for (int j = 0; j < y; j++) {
+    for (int i = 0; i < newx; i++) {
+      const double start = i * add, end = (i + 1) * add;
+      for (int c = 0; c < 4; c++) {
+        double sum = 0.0;
+        for (int k = (int)start; k < x && k < end; k++) {
+          const double coverage = std::min(k + 1.0, end) - std::max((double)k, start);
+          sum += coverage * src[((size_t)j * x + k) * 4 + c];
+        }
+        const float value = (float)(sum / add);
+        dst[((size_t)j * newx + i) * 4 + c] = round ? (float)(int)(value + 0.5f) : value;
+      }
+    }
+  }
+  return dst;
+}
+
+/* Linear interpolation with the first and last pixels aligned to the image corners. */
+static Image reference_scale_up_x(const Image &src, int x, int y, int newx, bool round)
+{
+  const double add = (x - 1.001) / (newx - 1.0);
+  Image dst((size_t)newx * y * 4);
+
+  for (int j = 0; j < y; j++) {
+    for (int i = 0; i < newx; i++) {
+      const double sample = i * add;
+      const int k = (int)sample;
+      const float fac = (float)(sample - k);
+      for (int c = 0; c < 4; c++) {
+        const float a = src[((size_t)j * x + k) * 4 + c];
+        const float b = src[((size_t)j * x + k + 1) * 4 + c];
+        const float value = a + fac * (b - a);
+        dst[((size_t)j * newx + i) * 4 + c] = round ? (float)(int)(value + 0.5f) : value;
+      }
+    }
+  }
+  return dst;
+}
+
+static Image reference_transpose(const Image &src, int x, int y)
+{
+  Image dst(src.size());
+  for (int j = 0; j < y; j++) {
+    for (int i = 0; i < x; i++) {
+      for (int c = 0; c < 4; c++) {
+        dst[((size_t)i * y + j) * 4 + c] = src[((size_t)j * x + i) * 4 + c];
+      }
+    }
+  }
+  return dst;
+}
+
+/* Scale down both axes first, then scale up, like the old scaler did. */
+static Image reference_scale(Image image, int x, int y, int newx, int newy, bool round)
+{
+  if (newx < x) {
+    image = reference_scale_down_x(image, x, y, newx, round);
+    x = newx;
+  }
+  if (newy < y) {
+    const Image transposed = reference_transpose(image, x, y);
+    image = reference_transpose(reference_scale_down_x(transposed, y, x, newy, round), newy, x);
+    y = newy;
+  }
+  if (newx > x) {
+    image = reference_scale_up_x(image, x, y, newx, round);
+    x = newx;
+  }
+  if (newy > y) {
+    const Image transposed = reference_transpose(image, x, y);
+    image = reference_transpose(reference_scale_up_x(transposed, y, x, newy, round), newy, x);
+    y = newy;
+  }
+  return image;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Test Images
+ * \{ */
+
+enum class Pattern { Noise, Ramp, Constant };
+
+static float pattern_value(Pattern pattern, RNG *rng, int x, int y, int c)
+{
+  switch (pattern) {
+    case Pattern::Noise:
+      return BLI_rng_get_float(rng);
+    case Pattern::Ramp:
+      /* A few levels per pixel, so bytes are smooth but not flat. */
+      return ((x * 2 + y * 2 + c * 10) + 0.25f) / 255.0f;
+    case Pattern::Constant:
+      return (40.0f + c * 50.0f) / 255.0f;
+  }
+  return 0.0f;
+}
+
+static ImBuf *create_test_ibuf(int x, int y, bool is_float, Pattern pattern)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, is_float ? IB_rectfloat : IB_rect);
+  RNG *rng = BLI_rng_new(x * 31 + y);
+
+  for (int j = 0; j < y; j++) {
+    for (int i = 0; i < x; i++) {
+      for (int c = 0; c < 4; c++) {
+        const float value = pattern_value(pattern, rng, i, j, c);
+        const size_t index = ((size_t)j * x + i) * 4 + c;
+        if (is_float) {
+          ibuf->rect_float[index] = value;
+        }
+        else {
+          ((unsigned char *)ibuf->rect)[index] = (unsigned char)(value * 255.0f + 0.5f);
+        }
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+  return ibuf;
+}
+
+static Image ibuf_to_image(const ImBuf *ibuf)
+{
+  const size_t size = (size_t)ibuf->x * ibuf->y * 4;
+  Image image(size);
+  for (size_t i = 0; i < size; i++) {
+    image[i] = ibuf->rect_float ? ibuf->rect_float[i] : ((unsigned char *)ibuf->rect)[i];
+  }
+  return image;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Tests
+ * \{ */
+
+class imbuf_scaling : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+  }
+};
+
+/* Compare #IMB_scaleImBuf against the old scaler. Upscaling samples pixel centers now instead
+ * of aligning the image corners, so smooth images are compared there. */
+static void test_scale_matches_reference(
+    int x, int y, int newx, int newy, bool is_float, Pattern pattern, float tolerance)
+{
+  ImBuf *ibuf = create_test_ibuf(x, y, is_float, pattern);
+  const Image expected = reference_scale(ibuf_to_image(ibuf), x, y, newx, newy, !is_float);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, newx, newy));
+  EXPECT_EQ(ibuf->x, newx);
+  EXPECT_EQ(ibuf->y, newy);
+
+  const Image result = ibuf_to_image(ibuf);
+  ASSERT_EQ(result.size(), expected.size());
+  for (size_t i = 0; i < result.size(); i++) {
+    EXPECT_NEAR(result[i], expected[i], tolerance)
+        << "at pixel " << i / 4 << " channel " << i % 4;
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(imbuf_scaling, ScaleDownByte)
+{
+  test_scale_matches_reference(97, 61, 40, 23, false, Pattern::Noise, 1.0f);
+  test_scale_matches_reference(64, 64, 32, 16, false, Pattern::Noise, 1.0f);
+}
+
+TEST_F(imbuf_scaling, ScaleDownFloat)
+{
+  test_scale_matches_reference(97, 61, 40, 23, true, Pattern::Noise, 0.01f);
+  test_scale_matches_reference(64, 64, 32, 16, true, Pattern::Noise, 0.01f);
+}
+
+TEST_F(imbuf_scaling, ScaleUpByte)
+{
+  test_scale_matches_reference(32, 24, 77, 53, false, Pattern::Ramp, 3.0f);
+}
+
+TEST_F(imbuf_scaling, ScaleUpFloat)
+{
+  test_scale_matches_reference(32, 24, 77, 53, true, Pattern::Ramp, 3.0f / 255.0f);
+}
+
+TEST_F(imbuf_scaling, ScaleMixed)
+{
+  test_scale_matches_reference(80, 20, 33, 45, false, Pattern::Ramp, 3.0f);
+  test_scale_matches_reference(80, 20, 33, 45, true, Pattern::Ramp, 3.0f / 255.0f);
+}
+
+TEST_F(imbuf_scaling, ScaleZeroKeepsSize)
+{
+  ImBuf *ibuf = create_test_ibuf(40, 30, false, Pattern::Noise);
+
+  EXPECT_FALSE(IMB_scaleImBuf(ibuf, 40, 30));
+  EXPECT_FALSE(IMB_scaleImBuf(ibuf, 0, 0));
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 0, 15));
+  EXPECT_EQ(ibuf->x, 40);
+  EXPECT_EQ(ibuf->y, 15);
+
+  IMB_freeImBuf(ibuf);
+}
+
+/* Every filter has weights summing to one, so a constant image stays constant. */
+TEST_F(imbuf_scaling, FilterKeepsConstant)
+{
+  const eIMBScaleFilter filters[] = {IMB_SCALE_FILTER_BOX,
+                                     IMB_SCALE_FILTER_BILINEAR,
+                                     IMB_SCALE_FILTER_MITCHELL,
+                                     IMB_SCALE_FILTER_LANCZOS};
+  const int sizes[][2] = {{17, 9}, {150, 71}};
+
+  for (const eIMBScaleFilter filter : filters) {
+    for (const bool is_float : {false, true}) {
+      for (const auto &size : sizes) {
+        ImBuf *ibuf = create_test_ibuf(50, 40, is_float, Pattern::Constant);
+        const Image expected = ibuf_to_image(ibuf);
+
+        EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, size[0], size[1], filter));
+
+        const Image result = ibuf_to_image(ibuf);
+        for (size_t i = 0; i < result.size(); i++) {
+          EXPECT_NEAR(result[i], expected[i % 4], is_float ? 1e-5f : 0.0f)
+              << "filter " << filter << " pixel " << i / 4 << " channel " << i % 4;
+        }
+
+        IMB_freeImBuf(ibuf);
+      }
+    }
+  }
+}
+
+/** \} */
+
+}  // namespace blender::imbuf::tests
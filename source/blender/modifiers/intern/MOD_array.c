@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -119,44 +120,90 @@ static void updateDepsgraph(ModifierData *md, const ModifierUpdateDepsgraphConte
   }
 }
 
-BLI_INLINE float sum_v3(const float v[3])
+/* Spatial hash of vertices, used when processing doubles.
+ * Cells are at least twice as big as the merge distance, so that doubles of a vertex can only be
+ * found in its own cell and the neighbor cells it is within merge distance of. */
+typedef struct VertsHash {
+  float min[3];
+  float cell_size_inv;
+  uint mask;
+  /* Vertices sorted by bucket, bucket `b` spans `[bucket_offsets[b], bucket_offsets[b + 1])`. */
+  int *bucket_offsets;
+  int *verts;
+  float (*cos)[3];
+} VertsHash;
+
+BLI_INLINE void verts_hash_cell(const VertsHash *vhash, const float co[3], int r_cell[3])
 {
-  return v[0] + v[1] + v[2];
+  for (int i = 0; i < 3; i++) {
+    r_cell[i] = (int)floorf((co[i] - vhash->min[i]) * vhash->cell_size_inv);
+  }
 }
 
-/* Structure used for sorting vertices, when processing doubles */
-typedef struct SortVertsElem {
-  int vertex_num; /* The original index of the vertex, prior to sorting */
-  float co[3];    /* Its coordinates */
-  float sum_co;   /* sum_v3(co), just so we don't do the sum many times.  */
-} SortVertsElem;
-
-static int svert_sum_cmp(const void *e1, const void *e2)
+BLI_INLINE uint verts_hash_bucket(const VertsHash *vhash, const int cell[3])
 {
-  const SortVertsElem *sv1 = e1;
-  const SortVertsElem *sv2 = e2;
+  return (((uint)cell[0] * 73856093u) ^ ((uint)cell[1] * 19349663u) ^
+          ((uint)cell[2] * 83492791u)) &
+         vhash->mask;
+}
 
-  if (sv1->sum_co > sv2->sum_co) {
-    return 1;
+static void verts_hash_build(VertsHash *vhash,
+                             const MVert *mverts,
+                             const int start,
+                             const int num_verts,
+                             const float dist,
+                             const float bounds_min[3],
+                             const float bounds_max[3])
+{
+  float extent = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    extent = max_ff(extent, bounds_max[i] - bounds_min[i]);
   }
-  if (sv1->sum_co < sv2->sum_co) {
-    return -1;
+  /* Bigger cells are still correct, this keeps cell coordinates
+   * within integer range for tiny (or zero) merge distances. */
+  float cell_size = max_ff(2.0f * dist, extent * 1e-6f);
+  if (cell_size == 0.0f) {
+    cell_size = 1.0f;
   }
 
-  return 0;
+  copy_v3_v3(vhash->min, bounds_min);
+  vhash->cell_size_inv = 1.0f / cell_size;
+
+  uint buckets_len = 1;
+  while (buckets_len < (uint)num_verts) {
+    buckets_len <<= 1;
+  }
+  vhash->mask = buckets_len - 1;
+  vhash->bucket_offsets = MEM_calloc_arrayN(buckets_len + 1, sizeof(int), __func__);
+  vhash->verts = MEM_malloc_arrayN(num_verts, sizeof(int), __func__);
+  vhash->cos = MEM_malloc_arrayN(num_verts, sizeof(float[3]), __func__);
+
+  uint *vert_buckets = MEM_malloc_arrayN(num_verts, sizeof(uint), __func__);
+  for (int i = 0; i < num_verts; i++) {
+    int cell[3];
+    verts_hash_cell(vhash, mverts[start + i].co, cell);
+    vert_buckets[i] = verts_hash_bucket(vhash, cell);
+    vhash->bucket_offsets[vert_buckets[i] + 1]++;
+  }
+  for (uint b = 0; b < buckets_len; b++) {
+    vhash->bucket_offsets[b + 1] += vhash->bucket_offsets[b];
+  }
+  /* Counting sort, buckets keep vertices by increasing index. */
+  int *bucket_fill = MEM_dupallocN(vhash->bucket_offsets);
+  for (int i = 0; i < num_verts; i++) {
+    const int dst = bucket_fill[vert_buckets[i]]++;
+    vhash->verts[dst] = start + i;
+    copy_v3_v3(vhash->cos[dst], mverts[start + i].co);
+  }
+  MEM_freeN(bucket_fill);
+  MEM_freeN(vert_buckets);
 }
 
-static void svert_from_mvert(SortVertsElem *sv,
-                             const MVert *mv,
-                             const int i_begin,
-                             const int i_end)
+static void verts_hash_free(VertsHash *vhash)
 {
-  int i;
-  for (i = i_begin; i < i_end; i++, sv++, mv++) {
-    sv->vertex_num = i;
-    copy_v3_v3(sv->co, mv->co);
-    sv->sum_co = sum_v3(mv->co);
-  }
+  MEM_freeN(vhash->bucket_offsets);
+  MEM_freeN(vhash->verts);
+  MEM_freeN(vhash->cos);
 }
 
 /**
@@ -174,110 +221,85 @@ static void dm_mvert_map_doubles(int *doubles_map,
                                  const int source_num_verts,
                                  const float dist)
 {
-  const float dist3 = ((float)M_SQRT3 + 0.00005f) * dist; /* Just above sqrt(3) */
-  int i_source, i_target, i_target_low_bound, target_end, source_end;
-  SortVertsElem *sorted_verts_target, *sorted_verts_source;
-  SortVertsElem *sve_source, *sve_target, *sve_target_low_bound;
-  bool target_scan_completed;
-
-  target_end = target_start + target_num_verts;
-  source_end = source_start + source_num_verts;
-
-  /* build array of MVerts to be tested for merging */
-  sorted_verts_target = MEM_malloc_arrayN(target_num_verts, sizeof(SortVertsElem), __func__);
-  sorted_verts_source = MEM_malloc_arrayN(source_num_verts, sizeof(SortVertsElem), __func__);
+  const float dist_sq = dist * dist;
+  float target_min[3], target_max[3];
+  VertsHash vhash;
 
-  /* Copy target vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_target, mverts + target_start, target_start, target_end);
-
-  /* Copy source vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_source, mverts + source_start, source_start, source_end);
+  if (target_num_verts == 0) {
+    return;
+  }
 
-  /* sort arrays according to sum of vertex coordinates (sumco) */
-  qsort(sorted_verts_target, target_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-  qsort(sorted_verts_source, source_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
+  INIT_MINMAX(target_min, target_max);
+  for (int i = target_start; i < target_start + target_num_verts; i++) {
+    minmax_v3v3_v3(target_min, target_max, mverts[i].co);
+  }
 
-  sve_target_low_bound = sorted_verts_target;
-  i_target_low_bound = 0;
-  target_scan_completed = false;
+  /* build spatial hash of target vertices to be tested for merging */
+  verts_hash_build(
+      &vhash, mverts, target_start, target_num_verts, dist, target_min, target_max);
 
-  /* Scan source vertices, in SortVertsElem sorted array, */
-  /* all the while maintaining the lower bound of possible doubles in target vertices */
-  for (i_source = 0, sve_source = sorted_verts_source; i_source < source_num_verts;
-       i_source++, sve_source++) {
+  for (int i_source = source_start; i_source < source_start + source_num_verts; i_source++) {
+    const float *co = mverts[i_source].co;
     int best_target_vertex = -1;
-    float best_dist_sq = dist * dist;
-    float sve_source_sumco;
+    float best_dist_sq = dist_sq;
+    float co_min[3], co_max[3];
+    int cell_min[3], cell_max[3], cell_iter[3];
 
     /* If source has already been assigned to a target (in an earlier call, with other chunks) */
-    if (doubles_map[sve_source->vertex_num] != -1) {
+    if (doubles_map[i_source] != -1) {
       continue;
     }
 
-    /* If target fully scanned already, then all remaining source vertices cannot have a double */
-    if (target_scan_completed) {
-      doubles_map[sve_source->vertex_num] = -1;
+    /* Source vertices out of the target bounds cannot have a double */
+    if (co[0] < target_min[0] - dist || co[0] > target_max[0] + dist ||
+        co[1] < target_min[1] - dist || co[1] > target_max[1] + dist ||
+        co[2] < target_min[2] - dist || co[2] > target_max[2] + dist) {
       continue;
     }
 
-    sve_source_sumco = sum_v3(sve_source->co);
-
-    /* Skip all target vertices that are more than dist3 lower in terms of sumco */
-    /* and advance the overall lower bound, applicable to all remaining vertices as well. */
-    while ((i_target_low_bound < target_num_verts) &&
-           (sve_target_low_bound->sum_co < sve_source_sumco - dist3)) {
-      i_target_low_bound++;
-      sve_target_low_bound++;
-    }
-    /* If end of target list reached, then no more possible doubles */
-    if (i_target_low_bound >= target_num_verts) {
-      doubles_map[sve_source->vertex_num] = -1;
-      target_scan_completed = true;
-      continue;
-    }
-    /* Test target candidates starting at the low bound of possible doubles,
-     * ordered in terms of sumco. */
-    i_target = i_target_low_bound;
-    sve_target = sve_target_low_bound;
-
-    /* i_target will scan vertices in the
-     * [v_source_sumco - dist3;  v_source_sumco + dist3] range */
-
-    while ((i_target < target_num_verts) && (sve_target->sum_co <= sve_source_sumco + dist3)) {
-      /* Testing distance for candidate double in target */
-      /* v_target is within dist3 of v_source in terms of sumco;  check real distance */
-      float dist_sq;
-      if ((dist_sq = len_squared_v3v3(sve_source->co, sve_target->co)) <= best_dist_sq) {
-        /* Potential double found */
-        best_dist_sq = dist_sq;
-        best_target_vertex = sve_target->vertex_num;
-
-        /* If target is already mapped, we only follow that mapping if final target remains
-         * close enough from current vert (otherwise no mapping at all).
-         * Note that if we later find another target closer than this one, then we check it.
-         * But if other potential targets are farther,
-         * then there will be no mapping at all for this source. */
-        while (best_target_vertex != -1 &&
-               !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
-          if (compare_len_v3v3(mverts[sve_source->vertex_num].co,
-                               mverts[doubles_map[best_target_vertex]].co,
-                               dist)) {
-            best_target_vertex = doubles_map[best_target_vertex];
-          }
-          else {
-            best_target_vertex = -1;
+    copy_v3_v3(co_min, co);
+    copy_v3_v3(co_max, co);
+    add_v3_fl(co_min, -dist);
+    add_v3_fl(co_max, dist);
+    verts_hash_cell(&vhash, co_min, cell_min);
+    verts_hash_cell(&vhash, co_max, cell_max);
+
+    for (cell_iter[0] = cell_min[0]; cell_iter[0] <= cell_max[0]; cell_iter[0]++) {
+      for (cell_iter[1] = cell_min[1]; cell_iter[1] <= cell_max[1]; cell_iter[1]++) {
+        for (cell_iter[2] = cell_min[2]; cell_iter[2] <= cell_max[2]; cell_iter[2]++) {
+          const uint bucket = verts_hash_bucket(&vhash, cell_iter);
+          for (int i = vhash.bucket_offsets[bucket]; i < vhash.bucket_offsets[bucket + 1]; i++) {
+            /* Testing distance for candidate double in target */
+            float dist_sq_test;
+            if ((dist_sq_test = len_squared_v3v3(co, vhash.cos[i])) <= best_dist_sq) {
+              /* Potential double found */
+              best_dist_sq = dist_sq_test;
+              best_target_vertex = vhash.verts[i];
+
+              /* If target is already mapped, we only follow that mapping if final target
+               * remains close enough from current vert (otherwise no mapping at all).
+               * Note that if we later find another target closer than this one, then we check
+               * it. But if other potential targets are farther,
+               * then there will be no mapping at all for this source. */
+              while (best_target_vertex != -1 &&
+                     !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
+                if (compare_len_v3v3(co, mverts[doubles_map[best_target_vertex]].co, dist)) {
+                  best_target_vertex = doubles_map[best_target_vertex];
+                }
+                else {
+                  best_target_vertex = -1;
+                }
+              }
+            }
           }
         }
       }
-      i_target++;
-      sve_target++;
     }
     /* End of candidate scan: if none found then no doubles */
-    doubles_map[sve_source->vertex_num] = best_target_vertex;
+    doubles_map[i_source] = best_target_vertex;
   }
 
-  MEM_freeN(sorted_verts_source);
-  MEM_freeN(sorted_verts_target);
+  verts_hash_free(&vhash);
 }
 
 static void mesh_merge_transform(Mesh *result,
@@ -362,16 +384,104 @@ static void mesh_merge_transform(Mesh *result,
   }
 }
 
+typedef struct ArrayChunkCopyData {
+  const ArrayModifierData *amd;
+  const Mesh *mesh;
+  Mesh *result;
+  const float (*chunk_offsets)[4][4];
+  int chunk_nverts, chunk_nedges, chunk_nloops, chunk_npolys;
+  bool use_recalc_normals;
+} ArrayChunkCopyData;
+
+/**
+ * Generates copy `c` of the source mesh: custom data, transformed vertices,
+ * offset indices and UVs. Copies only write to their own range of the result.
+ */
+static void array_chunk_copy_cb(void *__restrict userdata,
+                                const int c,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunkCopyData *data = userdata;
+  const ArrayModifierData *amd = data->amd;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  const float(*current_offset)[4] = data->chunk_offsets[c];
+  const int chunk_nverts = data->chunk_nverts;
+  const int chunk_nedges = data->chunk_nedges;
+  const int chunk_nloops = data->chunk_nloops;
+  const int chunk_npolys = data->chunk_npolys;
+  MVert *mv;
+  MEdge *me;
+  MLoop *ml;
+  MPoly *mp;
+  int i;
+
+  /* copy customdata to new geometry */
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
+
+  /* apply offset to all new verts */
+  mv = result->mvert + c * chunk_nverts;
+  for (i = 0; i < chunk_nverts; i++, mv++) {
+    mul_m4_v3(current_offset, mv->co);
+
+    /* We have to correct normals too, if we do not tag them as dirty! */
+    if (!data->use_recalc_normals) {
+      float no[3];
+      normal_short_to_float_v3(no, mv->no);
+      mul_mat3_m4_v3(current_offset, no);
+      normalize_v3(no);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  /* adjust edge vertex indices */
+  me = result->medge + c * chunk_nedges;
+  for (i = 0; i < chunk_nedges; i++, me++) {
+    me->v1 += c * chunk_nverts;
+    me->v2 += c * chunk_nverts;
+  }
+
+  mp = result->mpoly + c * chunk_npolys;
+  for (i = 0; i < chunk_npolys; i++, mp++) {
+    mp->loopstart += c * chunk_nloops;
+  }
+
+  /* adjust loop vertex and edge indices */
+  ml = result->mloop + c * chunk_nloops;
+  for (i = 0; i < chunk_nloops; i++, ml++) {
+    ml->v += c * chunk_nverts;
+    ml->e += c * chunk_nedges;
+  }
+
+  /* handle UVs */
+  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
+    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
+    const float uv_offset[2] = {
+        amd->uv_offset[0] * (float)c,
+        amd->uv_offset[1] * (float)c,
+    };
+    for (i = 0; i < totuv; i++) {
+      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
+      dmloopuv += c * chunk_nloops;
+      int l_index = chunk_nloops;
+      for (; l_index-- != 0; dmloopuv++) {
+        dmloopuv->uv[0] += uv_offset[0];
+        dmloopuv->uv[1] += uv_offset[1];
+      }
+    }
+  }
+}
+
 static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
                                    const ModifierEvalContext *ctx,
                                    Mesh *mesh)
 {
   const MVert *src_mvert;
-  MVert *mv, *mv_prev, *result_dm_verts;
+  MVert *result_dm_verts;
 
-  MEdge *me;
-  MLoop *ml;
-  MPoly *mp;
   int i, j, c, count;
   float length = amd->length;
   /* offset matrix */
@@ -380,6 +490,7 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   bool offset_has_scale;
   float current_offset[4][4];
   float final_offset[4][4];
+  float(*chunk_offsets)[4][4];
   int *full_doubles_map = NULL;
   int tot_doubles;
 
@@ -576,55 +687,38 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   first_chunk_start = 0;
   first_chunk_nverts = chunk_nverts;
 
-  unit_m4(current_offset);
+  /* Cumulative offsets of all copies, so that copies can be generated independently. */
+  chunk_offsets = MEM_malloc_arrayN(count, sizeof(*chunk_offsets), "mod array offsets");
+  unit_m4(chunk_offsets[0]);
   for (c = 1; c < count; c++) {
-    /* copy customdata to new geometry */
-    CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
-    CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
-    CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
-    CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
-
-    mv_prev = result_dm_verts;
-    mv = mv_prev + c * chunk_nverts;
-
-    /* recalculate cumulative offset here */
-    mul_m4_m4m4(current_offset, current_offset, offset);
-
-    /* apply offset to all new verts */
-    for (i = 0; i < chunk_nverts; i++, mv++, mv_prev++) {
-      mul_m4_v3(current_offset, mv->co);
-
-      /* We have to correct normals too, if we do not tag them as dirty! */
-      if (!use_recalc_normals) {
-        float no[3];
-        normal_short_to_float_v3(no, mv->no);
-        mul_mat3_m4_v3(current_offset, no);
-        normalize_v3(no);
-        normal_float_to_short_v3(mv->no, no);
-      }
-    }
-
-    /* adjust edge vertex indices */
-    me = result->medge + c * chunk_nedges;
-    for (i = 0; i < chunk_nedges; i++, me++) {
-      me->v1 += c * chunk_nverts;
-      me->v2 += c * chunk_nverts;
-    }
-
-    mp = result->mpoly + c * chunk_npolys;
-    for (i = 0; i < chunk_npolys; i++, mp++) {
-      mp->loopstart += c * chunk_nloops;
-    }
+    mul_m4_m4m4(chunk_offsets[c], chunk_offsets[c - 1], offset);
+  }
+  copy_m4_m4(current_offset, chunk_offsets[count - 1]);
+
+  {
+    ArrayChunkCopyData data = {
+        .amd = amd,
+        .mesh = mesh,
+        .result = result,
+        .chunk_offsets = (const float(*)[4][4])chunk_offsets,
+        .chunk_nverts = chunk_nverts,
+        .chunk_nedges = chunk_nedges,
+        .chunk_nloops = chunk_nloops,
+        .chunk_npolys = chunk_npolys,
+        .use_recalc_normals = use_recalc_normals,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    /* Copies of small meshes are cheap, group them to amortize threading overhead. */
+    settings.min_iter_per_thread = max_ii(1, 1024 / max_ii(1, chunk_nverts + chunk_nloops));
+    BLI_task_parallel_range(1, count, &data, array_chunk_copy_cb, &settings);
+  }
 
-    /* adjust loop vertex and edge indices */
-    ml = result->mloop + c * chunk_nloops;
-    for (i = 0; i < chunk_nloops; i++, ml++) {
-      ml->v += c * chunk_nverts;
-      ml->e += c * chunk_nedges;
-    }
+  MEM_freeN(chunk_offsets);
 
+  for (c = 1; c < count; c++) {
     /* Handle merge between chunk n and n-1 */
-    if (use_merge && (c >= 1)) {
+    if (use_merge) {
       if (!offset_has_scale && (c >= 2)) {
         /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
          * ... that is except if scaling makes the distance grow */
@@ -663,26 +757,6 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
     }
   }
 
-  /* handle UVs */
-  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
-    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
-    for (i = 0; i < totuv; i++) {
-      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
-      dmloopuv += chunk_nloops;
-      for (c = 1; c < count; c++) {
-        const float uv_offset[2] = {
-            amd->uv_offset[0] * (float)c,
-            amd->uv_offset[1] * (float)c,
-        };
-        int l_index = chunk_nloops;
-        for (; l_index-- != 0; dmloopuv++) {
-          dmloopuv->uv[0] += uv_offset[0];
-          dmloopuv->uv[1] += uv_offset[1];
-        }
-      }
-    }
-  }
-
   last_chunk_start = (count - 1) * chunk_nverts;
   last_chunk_nverts = chunk_nverts;
 
@@ -73,6 +73,9 @@ static void freeData(ModifierData *md)
   }
   psmd->totdmvert = psmd->totdmedge = psmd->totdmface = 0;
 
+  psys_distribution_cache_free(psmd->modifier.runtime);
+  psmd->modifier.runtime = NULL;
+
   /* ED_object_modifier_remove may have freed this first before calling
    * BKE_modifier_free (which calls this function) */
   if (psmd->psys) {
@@ -80,6 +83,11 @@ static void freeData(ModifierData *md)
   }
 }
 
+static void freeRuntimeData(void *runtime_data_v)
+{
+  psys_distribution_cache_free(runtime_data_v);
+}
+
 static void copyData(const ModifierData *md, ModifierData *target, const int flag)
 {
 #if 0
@@ -341,7 +349,7 @@ ModifierTypeInfo modifierType_ParticleSystem = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ blendRead,
@@ -84,6 +84,8 @@ typedef struct SDefBindCalcData {
   const MLoop *const mloop;
   float (*const targetCos)[3];
   float (*const vertexCos)[3];
+  /* Nearest target looptri of every vertex. */
+  BVHTreeNearest *nearest;
   float imat[4][4];
   const float falloff;
   int success;
@@ -334,26 +336,18 @@ BLI_INLINE void sortPolyVertsTri(uint *indices,
   }
 }
 
-BLI_INLINE uint nearestVert(SDefBindCalcData *const data, const float point_co[3])
+BLI_INLINE uint nearestVert(SDefBindCalcData *const data,
+                            const float point_co[3],
+                            const int looptri_index)
 {
-  BVHTreeNearest nearest = {
-      .dist_sq = FLT_MAX,
-      .index = -1,
-  };
   const MPoly *poly;
   const MEdge *edge;
   const MLoop *loop;
-  float t_point[3];
   float max_dist = FLT_MAX;
   float dist;
   uint index = 0;
 
-  mul_v3_m4v3(t_point, data->imat, point_co);
-
-  BLI_bvhtree_find_nearest(
-      data->treeData->tree, t_point, &nearest, data->treeData->nearest_callback, data->treeData);
-
-  poly = &data->mpoly[data->looptri[nearest.index].poly];
+  poly = &data->mpoly[data->looptri[looptri_index].poly];
   loop = &data->mloop[poly->loopstart];
 
   for (int i = 0; i < poly->totloop; i++, loop++) {
@@ -436,9 +430,10 @@ BLI_INLINE float computeAngularWeight(const float point_angle, const float edgem
 }
 
 BLI_INLINE SDefBindWeightData *computeBindWeights(SDefBindCalcData *const data,
-                                                  const float point_co[3])
+                                                  const float point_co[3],
+                                                  const int looptri_index)
 {
-  const uint nearest = nearestVert(data, point_co);
+  const uint nearest = nearestVert(data, point_co, looptri_index);
   const SDefAdjacency *const vert_edges = data->vert_edges[nearest].first;
   const SDefEdgePolys *const edge_polys = data->edge_polys;
 
@@ -844,7 +839,7 @@ static void bindVert(void *__restrict userdata,
   }
 
   copy_v3_v3(point_co, data->vertexCos[index]);
-  bwdata = computeBindWeights(data, point_co);
+  bwdata = computeBindWeights(data, point_co, data->nearest[index].index);
 
   if (bwdata == NULL) {
     sdvert->binds = NULL;
@@ -1108,11 +1103,41 @@ static bool surfacedeformBind(SurfaceDeformModifierData *smd_orig,
     mul_v3_m4v3(data.targetCos[i], smd_orig->mat, mvert[i].co);
   }
 
+  /* Find the nearest looptri of all vertices at once, nearby vertices are searched together. */
+  float(*tree_cos)[3] = MEM_malloc_arrayN(numverts, sizeof(*tree_cos), "SDefBindTreeCos");
+  data.nearest = MEM_malloc_arrayN(numverts, sizeof(*data.nearest), "SDefBindNearest");
+  if (tree_cos == NULL || data.nearest == NULL) {
+    BKE_modifier_set_error((ModifierData *)smd_eval, "Out of memory");
+    MEM_SAFE_FREE(tree_cos);
+    MEM_SAFE_FREE(data.nearest);
+    MEM_freeN(data.targetCos);
+    freeAdjacencyMap(vert_edges, adj_array, edge_polys);
+    free_bvhtree_from_mesh(&treeData);
+    MEM_freeN(smd_orig->verts);
+    smd_orig->verts = NULL;
+    return false;
+  }
+
+  for (int i = 0; i < numverts; i++) {
+    mul_v3_m4v3(tree_cos[i], data.imat, vertexCos[i]);
+    data.nearest[i].index = -1;
+    data.nearest[i].dist_sq = FLT_MAX;
+  }
+  BLI_bvhtree_find_nearest_batch(treeData.tree,
+                                 (const float(*)[3])tree_cos,
+                                 (int)numverts,
+                                 data.nearest,
+                                 treeData.nearest_callback,
+                                 &treeData,
+                                 0);
+  MEM_freeN(tree_cos);
+
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.use_threading = (numverts > 10000);
   BLI_task_parallel_range(0, numverts, &data, bindVert, &settings);
 
+  MEM_freeN(data.nearest);
   MEM_freeN(data.targetCos);
 
   if (data.success == MOD_SDEF_BIND_RESULT_MEM_ERR) {
@@ -319,8 +319,14 @@ bool RE_WriteRenderResult(struct ReportList *reports,
                           struct ImageFormatData *imf,
                           const char *view,
                           int layer);
-struct RenderResult *RE_MultilayerConvert(
-    void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
+/* Passes of the converted render result have no pixels yet,
+ * they are read per layer with RE_MultilayerLoadLayer(). */
+struct RenderResult *RE_MultilayerConvert(void *exrhandle, int rectx, int recty);
+void RE_MultilayerLoadLayer(struct RenderResult *rr,
+                            void *exrhandle,
+                            const char *colorspace,
+                            bool predivide,
+                            const char *layername);
 
 /* display and event callbacks */
 void RE_display_init_cb(struct Render *re,
@@ -56,8 +56,12 @@ struct RenderResult *render_result_new(struct Render *re,
                                        const char *layername,
                                        const char *viewname);
 
-struct RenderResult *render_result_new_from_exr(
-    void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
+struct RenderResult *render_result_new_from_exr(void *exrhandle, int rectx, int recty);
+void render_result_exr_load_layer(struct RenderResult *rr,
+                                  void *exrhandle,
+                                  const char *colorspace,
+                                  bool predivide,
+                                  const char *layername);
 
 void render_result_view_new(struct RenderResult *rr, const char *viewname);
 void render_result_views_new(struct RenderResult *rr, const struct RenderData *rd);
@@ -290,10 +290,18 @@ bool RE_HasSingleLayer(Render *re)
   return (re->r.scemode & R_SINGLE_LAYER);
 }
 
-RenderResult *RE_MultilayerConvert(
-    void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty)
+RenderResult *RE_MultilayerConvert(void *exrhandle, int rectx, int recty)
 {
-  return render_result_new_from_exr(exrhandle, colorspace, predivide, rectx, recty);
+  return render_result_new_from_exr(exrhandle, rectx, recty);
+}
+
+void RE_MultilayerLoadLayer(RenderResult *rr,
+                            void *exrhandle,
+                            const char *colorspace,
+                            bool predivide,
+                            const char *layername)
+{
+  render_result_exr_load_layer(rr, exrhandle, colorspace, predivide, layername);
 }
 
 RenderLayer *render_get_active_layer(Render *re, RenderResult *rr)
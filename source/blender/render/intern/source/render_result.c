@@ -744,21 +744,29 @@ static int order_render_passes(const void *a, const void *b)
   return (rpa->view_id < rpb->view_id);
 }
 
+static bool ml_testpass_none_cb(void *UNUSED(base),
+                                const char *UNUSED(layname),
+                                const char *UNUSED(passname),
+                                const char *UNUSED(chan_id),
+                                const char *UNUSED(view))
+{
+  return false;
+}
+
 /* From imbuf, if a handle was returned and
- * it's not a singlelayer multiview we convert this to render result. */
-RenderResult *render_result_new_from_exr(
-    void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty)
+ * it's not a singlelayer multiview we convert this to render result.
+ * Passes are added without pixels, they are read per layer by render_result_exr_load_layer. */
+RenderResult *render_result_new_from_exr(void *exrhandle, int rectx, int recty)
 {
   RenderResult *rr = MEM_callocN(sizeof(RenderResult), __func__);
   RenderLayer *rl;
   RenderPass *rpass;
-  const char *to_colorspace = IMB_colormanagement_role_colorspace_name_get(
-      COLOR_ROLE_SCENE_LINEAR);
 
   rr->rectx = rectx;
   rr->recty = recty;
 
-  IMB_exr_multilayer_convert(exrhandle, rr, ml_addview_cb, ml_addlayer_cb, ml_addpass_cb);
+  IMB_exr_multilayer_convert(
+      exrhandle, rr, ml_addview_cb, ml_addlayer_cb, ml_addpass_cb, ml_testpass_none_cb);
 
   for (rl = rr->layers.first; rl; rl = rl->next) {
     rl->rectx = rectx;
@@ -769,22 +777,106 @@ RenderResult *render_result_new_from_exr(
     for (rpass = rl->passes.first; rpass; rpass = rpass->next) {
       rpass->rectx = rectx;
       rpass->recty = recty;
-
-      if (rpass->channels >= 3) {
-        IMB_colormanagement_transform(rpass->rect,
-                                      rpass->rectx,
-                                      rpass->recty,
-                                      rpass->channels,
-                                      colorspace,
-                                      to_colorspace,
-                                      predivide);
-      }
     }
   }
 
   return rr;
 }
 
+/* callbacks for render_result_exr_load_layer */
+typedef struct MultilayerLoadContext {
+  RenderResult *rr;
+  const char *layername;
+  const char *colorspace;
+  bool predivide;
+} MultilayerLoadContext;
+
+static void *ml_load_view_cb(void *UNUSED(base), const char *UNUSED(str))
+{
+  return NULL;
+}
+
+static void *ml_load_layer_cb(void *base, const char *str)
+{
+  MultilayerLoadContext *ctx = base;
+  return BLI_findstring(&ctx->rr->layers, str, offsetof(RenderLayer, name));
+}
+
+static void ml_load_pass_cb(void *base,
+                            void *lay,
+                            const char *name,
+                            float *rect,
+                            int totchan,
+                            const char *UNUSED(chan_id),
+                            const char *view)
+{
+  MultilayerLoadContext *ctx = base;
+  RenderLayer *rl = lay;
+  RenderPass *rpass;
+
+  if (rect == NULL) {
+    return;
+  }
+  if (rl == NULL) {
+    MEM_freeN(rect);
+    return;
+  }
+
+  for (rpass = rl->passes.first; rpass; rpass = rpass->next) {
+    if (rpass->rect == NULL && rpass->channels == totchan && STREQ(rpass->name, name) &&
+        STREQ(rpass->view, view)) {
+      break;
+    }
+  }
+
+  if (rpass == NULL) {
+    MEM_freeN(rect);
+    return;
+  }
+
+  rpass->rect = rect;
+
+  if (rpass->channels >= 3) {
+    IMB_colormanagement_transform(rpass->rect,
+                                  rpass->rectx,
+                                  rpass->recty,
+                                  rpass->channels,
+                                  ctx->colorspace,
+                                  IMB_colormanagement_role_colorspace_name_get(
+                                      COLOR_ROLE_SCENE_LINEAR),
+                                  ctx->predivide);
+  }
+}
+
+static bool ml_load_testpass_cb(void *base,
+                                const char *layname,
+                                const char *UNUSED(passname),
+                                const char *UNUSED(chan_id),
+                                const char *UNUSED(view))
+{
+  MultilayerLoadContext *ctx = base;
+  return (ctx->layername == NULL) || STREQ(layname, ctx->layername);
+}
+
+/* Read the pixels of the passes of a render result from render_result_new_from_exr, only of
+ * the layer named `layername` or of all layers when it is NULL. Passes which already have
+ * pixels are kept. */
+void render_result_exr_load_layer(RenderResult *rr,
+                                  void *exrhandle,
+                                  const char *colorspace,
+                                  bool predivide,
+                                  const char *layername)
+{
+  MultilayerLoadContext ctx = {rr, layername, colorspace, predivide};
+
+  IMB_exr_multilayer_convert(exrhandle,
+                             &ctx,
+                             ml_load_view_cb,
+                             ml_load_layer_cb,
+                             ml_load_pass_cb,
+                             ml_load_testpass_cb);
+}
+
 void render_result_view_new(RenderResult *rr, const char *viewname)
 {
   RenderView *rv = MEM_callocN(sizeof(RenderView), "new render view");
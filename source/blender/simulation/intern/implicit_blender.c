@@ -34,6 +34,7 @@
 #  include "DNA_texture_types.h"
 
 #  include "BLI_math.h"
+#  include "BLI_task.h"
 #  include "BLI_utildefines.h"
 
 #  include "BKE_cloth.h"
@@ -656,6 +657,203 @@ DO_INLINE void subadd_bfmatrixS_bfmatrixS(
   }
 }
 
+///////////////////////////
+// Block compressed sparse row matrix
+///////////////////////////
+
+/* Number of vertices in a chunk of work for the parallel matrix and vector operations. */
+#  define CLOTH_CHUNK_SIZE 1024
+
+/* Set in #BlockCSR.blocks for entries that use the transposed block of the big matrix. */
+#  define BLOCK_TRANSPOSED (1u << 31)
+
+/* Row-wise copy of a SPARSE SYMMETRIC big matrix. The big matrix stores only one off-diagonal
+ * block for each pair of vertices, here every block is stored in both of its rows so that rows
+ * can be multiplied with a long vector independently of each other. */
+typedef struct BlockCSR {
+  unsigned int rows;
+  unsigned int *row_offsets; /* first entry of each row, rows + 1 items */
+  unsigned int *cols;        /* column of each entry */
+  unsigned int *blocks;      /* big matrix block of each entry, optionally #BLOCK_TRANSPOSED */
+  float (*values)[3][3];     /* row major blocks, as in #fmatrix3x3 */
+} BlockCSR;
+
+static void cloth_parallel_chunks(unsigned int verts, void *userdata, TaskParallelRangeFunc func)
+{
+  const unsigned int chunks_len = (verts + CLOTH_CHUNK_SIZE - 1) / CLOTH_CHUNK_SIZE;
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = chunks_len > 1;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)chunks_len, userdata, func, &settings);
+}
+
+static BlockCSR *create_blockcsr(unsigned int verts, unsigned int springs)
+{
+  const unsigned int entries = verts + 2 * springs;
+  BlockCSR *csr = (BlockCSR *)MEM_callocN(sizeof(BlockCSR), "cloth_implicit_alloc_csr");
+
+  csr->rows = verts;
+  csr->row_offsets = (unsigned int *)MEM_mallocN(sizeof(unsigned int) * (verts + 1),
+                                                 "cloth_implicit_csr_rows");
+  csr->cols = (unsigned int *)MEM_mallocN(sizeof(unsigned int) * entries,
+                                          "cloth_implicit_csr_cols");
+  csr->blocks = (unsigned int *)MEM_mallocN(sizeof(unsigned int) * entries,
+                                            "cloth_implicit_csr_blocks");
+  csr->values = (float(*)[3][3])MEM_mallocN(sizeof(*csr->values) * entries,
+                                            "cloth_implicit_csr_values");
+  return csr;
+}
+
+static void del_blockcsr(BlockCSR *csr)
+{
+  if (csr != NULL) {
+    MEM_freeN(csr->row_offsets);
+    MEM_freeN(csr->cols);
+    MEM_freeN(csr->blocks);
+    MEM_freeN(csr->values);
+    MEM_freeN(csr);
+  }
+}
+
+/* Build the rows from the layout of the first blocks_len blocks of a big matrix.
+ * Entries of a row are in block order, so the diagonal block comes first. */
+static void init_blockcsr(BlockCSR *csr, const fmatrix3x3 *matrix, unsigned int blocks_len)
+{
+  unsigned int *offsets = csr->row_offsets;
+  unsigned int i;
+
+  /* Count entries per row, then make offsets[r] the end of row r. */
+  memset(offsets, 0, sizeof(*offsets) * (csr->rows + 1));
+  for (i = 0; i < matrix[0].vcount; i++) {
+    offsets[i]++;
+  }
+  for (i = matrix[0].vcount; i < blocks_len; i++) {
+    offsets[matrix[i].r]++;
+    offsets[matrix[i].c]++;
+  }
+  for (i = 1; i <= csr->rows; i++) {
+    offsets[i] += offsets[i - 1];
+  }
+
+  /* Fill rows back to front, which leaves offsets[r] at the start of row r. */
+  for (i = blocks_len; i-- > matrix[0].vcount;) {
+    unsigned int e = --offsets[matrix[i].c];
+    csr->cols[e] = matrix[i].r;
+    csr->blocks[e] = i | BLOCK_TRANSPOSED;
+
+    e = --offsets[matrix[i].r];
+    csr->cols[e] = matrix[i].c;
+    csr->blocks[e] = i;
+  }
+  for (i = matrix[0].vcount; i-- > 0;) {
+    const unsigned int e = --offsets[i];
+    csr->cols[e] = i;
+    csr->blocks[e] = i;
+  }
+}
+
+typedef struct BlockCSRAssembleData {
+  BlockCSR *csr;
+  const fmatrix3x3 *M, *dFdV, *dFdX;
+  float dt;
+  lfVector *V;
+  lfVector *dFdXmV;
+} BlockCSRAssembleData;
+
+static void assemble_blockcsr_cb(void *__restrict userdata,
+                                 const int chunk,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BlockCSRAssembleData *data = (BlockCSRAssembleData *)userdata;
+  BlockCSR *csr = data->csr;
+  const unsigned int start = (unsigned int)chunk * CLOTH_CHUNK_SIZE;
+  const unsigned int end = MIN2(start + CLOTH_CHUNK_SIZE, csr->rows);
+  const float dt = data->dt;
+
+  for (unsigned int i = start; i < end; i++) {
+    /* Sum the transposed blocks separately, in the order #mul_bfmatrix_lfvector does. */
+    float dfdxmv[3] = {0.0f, 0.0f, 0.0f}, dfdxmv_t[3] = {0.0f, 0.0f, 0.0f};
+
+    for (unsigned int e = csr->row_offsets[i]; e < csr->row_offsets[i + 1]; e++) {
+      const unsigned int block = csr->blocks[e] & ~BLOCK_TRANSPOSED;
+      const float(*dfdx)[3] = data->dFdX[block].m;
+      float a[3][3];
+
+      cp_fmatrix(a, data->M[block].m);
+      subadd_fmatrixS_fmatrixS(a, data->dFdV[block].m, dt, dfdx, (dt * dt));
+
+      if (csr->blocks[e] & BLOCK_TRANSPOSED) {
+        transpose_m3_m3(csr->values[e], a);
+        muladd_fmatrixT_fvector(dfdxmv_t, dfdx, data->V[csr->cols[e]]);
+      }
+      else {
+        cp_fmatrix(csr->values[e], a);
+        muladd_fmatrix_fvector(dfdxmv, dfdx, data->V[csr->cols[e]]);
+      }
+    }
+
+    add_v3_v3v3(data->dFdXmV[i], dfdxmv_t, dfdxmv);
+  }
+}
+
+/* Fill the rows with A = M - dt * dFdV - dt^2 * dFdX, the big matrices must have the layout the
+ * rows were initialized with. Also computes dFdX * V. */
+static void assemble_blockcsr(BlockCSR *csr,
+                              const fmatrix3x3 *M,
+                              const fmatrix3x3 *dFdV,
+                              const fmatrix3x3 *dFdX,
+                              float dt,
+                              lfVector *V,
+                              lfVector *dFdXmV)
+{
+  BlockCSRAssembleData data = {csr, M, dFdV, dFdX, dt, V, dFdXmV};
+  cloth_parallel_chunks(csr->rows, &data, assemble_blockcsr_cb);
+}
+
+typedef struct BlockCSRMulData {
+  const BlockCSR *csr;
+  lfVector *to;
+  lfVector *from;
+  fmatrix3x3 *S;
+} BlockCSRMulData;
+
+static void mul_blockcsr_lfvector_cb(void *__restrict userdata,
+                                     const int chunk,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BlockCSRMulData *data = (BlockCSRMulData *)userdata;
+  const BlockCSR *csr = data->csr;
+  const unsigned int start = (unsigned int)chunk * CLOTH_CHUNK_SIZE;
+  const unsigned int end = MIN2(start + CLOTH_CHUNK_SIZE, csr->rows);
+  const unsigned int *row_offsets = csr->row_offsets;
+  const unsigned int *cols = csr->cols;
+  const unsigned int *blocks = csr->blocks;
+  const float(*values)[3][3] = (const float(*)[3][3])csr->values;
+  const lfVector *from = data->from;
+
+  for (unsigned int i = start; i < end; i++) {
+    /* Sum the transposed blocks separately, in the order #mul_bfmatrix_lfvector does, so the
+     * result is the same. */
+    float sum[3] = {0.0f, 0.0f, 0.0f}, sum_t[3] = {0.0f, 0.0f, 0.0f};
+    for (unsigned int e = row_offsets[i]; e < row_offsets[i + 1]; e++) {
+      float *to = (blocks[e] & BLOCK_TRANSPOSED) ? sum_t : sum;
+      muladd_fmatrix_fvector(to, values[e], from[cols[e]]);
+    }
+    add_v3_v3v3(data->to[i], sum_t, sum);
+    if (data->S) {
+      mul_m3_v3(data->S[i].m, data->to[i]);
+    }
+  }
+}
+
+/* to = filter(A * from, S), S may be NULL */
+static void mul_blockcsr_lfvector(lfVector *to, const BlockCSR *csr, lfVector *from, fmatrix3x3 *S)
+{
+  BlockCSRMulData data = {csr, to, from, S};
+  cloth_parallel_chunks(csr->rows, &data, mul_blockcsr_lfvector_cb);
+}
+
 ///////////////////////////////////////////////////////////////////
 // simulator start
 ///////////////////////////////////////////////////////////////////
@@ -675,7 +873,7 @@ typedef struct Implicit_Data {
 
   /* internal solver data */
   lfVector *B;   /* B for A*dV = B */
-  fmatrix3x3 *A; /* A for A*dV = B */
+  BlockCSR *A;   /* A for A*dV = B, rows assembled for parallel multiplication */
 
   lfVector *dV;         /* velocity change (solution of A*dV = B) */
   lfVector *z;          /* target velocity in constrained directions */
@@ -689,7 +887,7 @@ Implicit_Data *SIM_mass_spring_solver_create(int numverts, int numsprings)
 
   /* process diagonal elements */
   id->tfm = create_bfmatrix(numverts, 0);
-  id->A = create_bfmatrix(numverts, numsprings);
+  id->A = create_blockcsr(numverts, numsprings);
   id->dFdV = create_bfmatrix(numverts, numsprings);
   id->dFdX = create_bfmatrix(numverts, numsprings);
   id->S = create_bfmatrix(numverts, 0);
@@ -714,7 +912,7 @@ Implicit_Data *SIM_mass_spring_solver_create(int numverts, int numsprings)
 void SIM_mass_spring_solver_free(Implicit_Data *id)
 {
   del_bfmatrix(id->tfm);
-  del_bfmatrix(id->A);
+  del_blockcsr(id->A);
   del_bfmatrix(id->dFdV);
   del_bfmatrix(id->dFdX);
   del_bfmatrix(id->S);
@@ -848,8 +1046,76 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 }
 #  endif
 
+typedef struct CGUpdateData {
+  lfVector *dV, *r, *c, *q;
+  float alpha;
+  unsigned int numverts;
+} CGUpdateData;
+
+static void cg_update_cb(void *__restrict userdata,
+                         const int chunk,
+                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGUpdateData *data = (CGUpdateData *)userdata;
+  const unsigned int start = (unsigned int)chunk * CLOTH_CHUNK_SIZE;
+  const unsigned int end = MIN2(start + CLOTH_CHUNK_SIZE, data->numverts);
+  const float alpha = data->alpha;
+
+  /* Flat loop over the components, simple enough to be vectorized. */
+  float *__restrict dV = data->dV[0];
+  float *__restrict r = data->r[0];
+  const float *__restrict c = data->c[0];
+  const float *__restrict q = data->q[0];
+  for (unsigned int k = start * 3; k < end * 3; k++) {
+    dV[k] += c[k] * alpha;
+    r[k] += q[k] * -alpha;
+  }
+}
+
+/* dV += alpha * c, r -= alpha * q */
+static void cg_update(
+    lfVector *dV, lfVector *r, lfVector *c, lfVector *q, float alpha, unsigned int numverts)
+{
+  CGUpdateData data = {dV, r, c, q, alpha, numverts};
+  cloth_parallel_chunks(numverts, &data, cg_update_cb);
+}
+
+typedef struct CGDirectionData {
+  lfVector *c, *s;
+  fmatrix3x3 *S;
+  float beta;
+  unsigned int numverts;
+} CGDirectionData;
+
+static void cg_direction_cb(void *__restrict userdata,
+                            const int chunk,
+                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGDirectionData *data = (CGDirectionData *)userdata;
+  const unsigned int start = (unsigned int)chunk * CLOTH_CHUNK_SIZE;
+  const unsigned int end = MIN2(start + CLOTH_CHUNK_SIZE, data->numverts);
+  const float beta = data->beta;
+
+  float *__restrict c = data->c[0];
+  const float *__restrict s = data->s[0];
+  for (unsigned int k = start * 3; k < end * 3; k++) {
+    c[k] = s[k] + c[k] * beta;
+  }
+  for (unsigned int i = start; i < end; i++) {
+    mul_m3_v3(data->S[i].m, data->c[i]);
+  }
+}
+
+/* c = filter(s + beta * c) */
+static void cg_direction(
+    lfVector *c, lfVector *s, fmatrix3x3 *S, float beta, unsigned int numverts)
+{
+  CGDirectionData data = {c, s, S, beta, numverts};
+  cloth_parallel_chunks(numverts, &data, cg_direction_cb);
+}
+
 static int cg_filtered(lfVector *ldV,
-                       fmatrix3x3 *lA,
+                       BlockCSR *lA,
                        lfVector *lB,
                        lfVector *z,
                        fmatrix3x3 *S,
@@ -859,13 +1125,12 @@ static int cg_filtered(lfVector *ldV,
   unsigned int conjgrad_loopcount = 0, conjgrad_looplimit = 100;
   float conjgrad_epsilon = 0.01f;
 
-  unsigned int numverts = lA[0].vcount;
+  unsigned int numverts = lA->rows;
   lfVector *fB = create_lfvector(numverts);
   lfVector *AdV = create_lfvector(numverts);
   lfVector *r = create_lfvector(numverts);
   lfVector *c = create_lfvector(numverts);
   lfVector *q = create_lfvector(numverts);
-  lfVector *s = create_lfvector(numverts);
   float bnorm2, delta_new, delta_old, delta_target, alpha;
 
   cp_lfvector(ldV, z, numverts);
@@ -877,7 +1142,7 @@ static int cg_filtered(lfVector *ldV,
   delta_target = conjgrad_epsilon * conjgrad_epsilon * bnorm2;
 
   /* r = filter(B - A * dV) */
-  mul_bfmatrix_lfvector(AdV, lA, ldV);
+  mul_blockcsr_lfvector(AdV, lA, ldV, NULL);
   sub_lfvector_lfvector(r, lB, AdV, numverts);
   filter(r, S);
 
@@ -889,8 +1154,6 @@ static int cg_filtered(lfVector *ldV,
   delta_new = dot_lfvector(r, c, numverts);
 
 #  ifdef IMPLICIT_PRINT_SOLVER_INPUT_OUTPUT
-  printf("==== A ====\n");
-  print_bfmatrix(lA);
   printf("==== z ====\n");
   print_lvector(z, numverts);
   printf("==== B ====\n");
@@ -899,23 +1162,21 @@ static int cg_filtered(lfVector *ldV,
   print_bfmatrix(S);
 #  endif
 
+  /* Dot products stay serial, summed in vertex order, so results don't depend on threads. */
   while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-    mul_bfmatrix_lfvector(q, lA, c);
-    filter(q, S);
+    /* q = filter(A * c) */
+    mul_blockcsr_lfvector(q, lA, c, S);
 
     alpha = delta_new / dot_lfvector(c, q, numverts);
 
-    add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
-
-    add_lfvector_lfvectorS(r, r, q, -alpha, numverts);
+    /* dV += alpha * c, r -= alpha * q */
+    cg_update(ldV, r, c, q, alpha, numverts);
 
-    /* s = P^-1 * r */
-    cp_lfvector(s, r, numverts);
+    /* s = P^-1 * r, the identity preconditioner makes s = r */
     delta_old = delta_new;
-    delta_new = dot_lfvector(r, s, numverts);
+    delta_new = dot_lfvector(r, r, numverts);
 
-    add_lfvector_lfvectorS(c, s, c, delta_new / delta_old, numverts);
-    filter(c, S);
+    cg_direction(c, r, S, delta_new / delta_old, numverts);
 
     conjgrad_loopcount++;
   }
@@ -931,7 +1192,6 @@ static int cg_filtered(lfVector *ldV,
   del_lfvector(r);
   del_lfvector(c);
   del_lfvector(q);
-  del_lfvector(s);
   // printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
   result->status = conjgrad_loopcount < conjgrad_looplimit ? SIM_SOLVER_SUCCESS :
@@ -1156,11 +1416,10 @@ bool SIM_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
   lfVector *dFdXmV = create_lfvector(numverts);
   zero_lfvector(data->dV, numverts);
 
-  cp_bfmatrix(data->A, data->M);
-
-  subadd_bfmatrixS_bfmatrixS(data->A, data->dFdV, dt, data->dFdX, (dt * dt));
+  /* All big matrices share the layout of the springs added since clearing the forces. */
+  init_blockcsr(data->A, data->M, data->M[0].vcount + data->num_blocks);
 
-  mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->V);
+  assemble_blockcsr(data->A, data->M, data->dFdV, data->dFdX, dt, data->V, dFdXmV);
 
   add_lfvectorS_lfvectorS(data->B, data->F, dt, dFdXmV, (dt * dt), numverts);
 
@@ -1294,7 +1553,6 @@ static int SIM_mass_spring_add_block(Implicit_Data *data, int v1, int v2)
   init_fmatrix(data->M + s, v1, v2);
   init_fmatrix(data->dFdX + s, v1, v2);
   init_fmatrix(data->dFdV + s, v1, v2);
-  init_fmatrix(data->A + s, v1, v2);
   init_fmatrix(data->P + s, v1, v2);
   init_fmatrix(data->Pinv + s, v1, v2);
 
@@ -54,6 +54,7 @@
 
 #include "BKE_blender.h"
 #include "BKE_blendfile.h"
+#include "BKE_bvhutils.h"
 #include "BKE_callbacks.h"
 #include "BKE_context.h"
 #include "BKE_font.h"
@@ -580,6 +581,7 @@ void WM_exit_ex(bContext *C, const bool do_python)
 
   BKE_blender_free(); /* blender.c, does entire library and spacetypes */
                       //  BKE_material_copybuf_free();
+  bvhcache_shared_free(); /* after meshes released their trees */
   ANIM_fcurves_copybuf_free();
   ANIM_drivers_copybuf_free();
   ANIM_driver_vars_copybuf_free();
@@ -20,6 +20,7 @@
 
 import os
 import sys
+import time
 
 import bpy
 
@@ -27,6 +28,35 @@ sys.path.append(os.path.dirname(os.path.realpath(__file__)))
 from modules.mesh_test import ModifierTest, PhysicsSpec
 
 
+def benchmark(subdivisions, frame_end):
+    """
+    Time the cloth simulation of a pinned grid with subdivisions^2 vertices,
+    mostly spent in the solver of implicit_blender.c.
+    """
+    scene = bpy.context.scene
+    scene.frame_set(1)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=subdivisions, y_subdivisions=subdivisions, size=2.0)
+    obj = bpy.context.active_object
+
+    pin_group = obj.vertex_groups.new(name="Pin")
+    pin_group.add([v.index for v in obj.data.vertices if v.co.y > 0.999], 1.0, 'REPLACE')
+
+    modifier = obj.modifiers.new("Cloth", 'CLOTH')
+    modifier.settings.quality = 5
+    modifier.settings.vertex_group_mass = pin_group.name
+    modifier.point_cache.frame_end = frame_end
+
+    start = time.perf_counter()
+    for frame in range(2, frame_end + 1):
+        scene.frame_set(frame)
+    elapsed = time.perf_counter() - start
+
+    print("Cloth benchmark: {} vertices, {} frames, {:.3f}s ({:.3f}s per frame)".format(
+        len(obj.data.vertices), frame_end - 1, elapsed, elapsed / (frame_end - 1)))
+
+    bpy.data.objects.remove(obj)
+
+
 def main():
     test = [
         ["testCloth", "expectedCloth",
@@ -45,6 +75,12 @@ def main():
             index = int(command[i + 1])
             cloth_test.run_test(index)
             break
+        elif cmd == "--benchmark":
+            # Not part of the regression tests, run manually with:
+            # blender --background --factory-startup --python physics_cloth.py -- --benchmark 200
+            subdivisions = int(command[i + 1]) if i + 1 < len(command) else 100
+            benchmark(subdivisions, 35)
+            break
 
 
 if __name__ == "__main__":
@@ -0,0 +1,73 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Benchmark of SPH particle fluids, the scene is created by the script. Not part of the
+# regression tests, run manually with:
+# blender --background --factory-startup --python physics_particle_fluid.py -- 50000 CLASSICAL
+
+import sys
+import time
+
+import bpy
+
+
+def benchmark(count, solver, frame_end):
+    """
+    Time the SPH simulation of count particles emitted at once from the volume of a cube,
+    mostly spent in neighbor searches of particle_system.c.
+    """
+    scene = bpy.context.scene
+    scene.frame_set(1)
+    bpy.ops.mesh.primitive_cube_add(size=2.0)
+    obj = bpy.context.active_object
+
+    modifier = obj.modifiers.new("Fluid Particles", 'PARTICLE_SYSTEM')
+    psys = modifier.particle_system
+    part = psys.settings
+    part.count = count
+    part.frame_start = 1.0
+    part.frame_end = 1.0
+    part.lifetime = frame_end + 1
+    part.emit_from = 'VOLUME'
+    part.physics_type = 'FLUID'
+    part.particle_size = 0.05
+    part.fluid.solver = solver
+    psys.point_cache.frame_end = frame_end
+
+    start = time.perf_counter()
+    for frame in range(2, frame_end + 1):
+        scene.frame_set(frame)
+    elapsed = time.perf_counter() - start
+
+    print("SPH {} benchmark: {} particles, {} frames, {:.3f}s ({:.3f}s per frame)".format(
+        solver, count, frame_end - 1, elapsed, elapsed / (frame_end - 1)))
+
+    bpy.data.objects.remove(obj)
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    count = int(argv[0]) if len(argv) > 0 else 20000
+    solver = argv[1] if len(argv) > 1 else 'DDR'
+    benchmark(count, solver, 25)
+
+
+if __name__ == "__main__":
+    main()